@@ -1,19 +1,38 @@
+import os
+
 import numpy as np
 import matplotlib.pyplot as plt
 
-# Lê o arquivo CSV (pulando o cabeçalho)
-data = np.loadtxt("imu_data.csv", delimiter=",", skiprows=1)
+# Metadados "# chave=valor" do início do CSV: escalas do IMU configuradas
+# no firmware (sem eles, o padrão do MPU6050: +-2 g e +-250 graus/s)
+meta = {}
+if os.path.exists("imu_data.csv"):
+    with open("imu_data.csv") as f:
+        for line in f:
+            if not line.startswith("#"):
+                break
+            chave, _, valor = line[1:].strip().partition("=")
+            meta[chave] = valor
+accel_lsb_g = float(meta.get("imu_accel_lsb_g", 16384))
+gyro_lsb_dps = float(meta.get("imu_giro_lsb_dps", 131))
+
+# Usa o .npy gerado por imulog_convert quando existir (muito mais rápido em
+# logs grandes); senão lê o CSV (pulando metadados e cabeçalho)
+if os.path.exists("imu_data.npy"):
+    data = np.load("imu_data.npy")
+else:
+    data = np.loadtxt("imu_data.csv", delimiter=",", skiprows=len(meta) + 1)
 
 # Extrai os dados por coluna
 amostra = data[:, 0]  # eixo X comum a todos os gráficos
 
-accel_x = data[:, 1]
-accel_y = data[:, 2]
-accel_z = data[:, 3]
+accel_x = data[:, 1] / accel_lsb_g
+accel_y = data[:, 2] / accel_lsb_g
+accel_z = data[:, 3] / accel_lsb_g
 
-gyro_x = data[:, 4]
-gyro_y = data[:, 5]
-gyro_z = data[:, 6]
+gyro_x = data[:, 4] / gyro_lsb_dps
+gyro_y = data[:, 5] / gyro_lsb_dps
+gyro_z = data[:, 6] / gyro_lsb_dps
 
 # Cria o gráfico da aceleração
 plt.figure(figsize=(10, 4))
@@ -22,7 +41,7 @@ plt.plot(amostra, accel_y, label="Accel Y", color='g')
 plt.plot(amostra, accel_z, label="Accel Z", color='b')
 plt.title("Dados de Aceleração")
 plt.xlabel("Amostra")
-plt.ylabel("Aceleração (raw)")
+plt.ylabel("Aceleração (g)")
 plt.grid()
 plt.legend()
 plt.tight_layout()
@@ -35,7 +54,7 @@ plt.plot(amostra, gyro_y, label="Gyro Y", color='g')
 plt.plot(amostra, gyro_z, label="Gyro Z", color='b')
 plt.title("Dados do Giroscópio")
 plt.xlabel("Amostra")
-plt.ylabel("Velocidade Angular (raw)")
+plt.ylabel("Velocidade Angular (graus/s)")
 plt.grid()
 plt.legend()
 plt.tight_layout()
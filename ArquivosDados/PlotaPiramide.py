@@ -0,0 +1,83 @@
+import struct
+import sys
+
+import numpy as np
+import matplotlib.pyplot as plt
+
+# Visualizador da pirâmide gerada por imulog_pyramid (host/): a cada zoom
+# escolhe o nível mais fino com no máximo PONTOS baldes visíveis e desenha
+# a faixa mínimo-máximo e a média de cada eixo. Os níveis são lidos com
+# memmap, então o custo não depende do tamanho do log.
+# Uso: python PlotaPiramide.py IMU_DATA.CSV.pyr
+
+PONTOS = 2000
+
+
+def carrega_piramide(caminho):
+    with open(caminho, "rb") as f:
+        magic, _, eixos, niveis, _, _, _ = struct.unpack("<8sIHHIIQ", f.read(32))
+        if magic != b"IMUPYR01":
+            raise ValueError("não é um arquivo de pirâmide: " + caminho)
+        nomes = [f.read(16).rstrip(b"\0").decode() for _ in range(eixos)]
+        tabela = [struct.unpack("<QQQ", f.read(24)) for _ in range(niveis)]
+    dtype = np.dtype([("amostra", "<u4"), ("n", "<u4"),
+                      ("min", "<i4", (eixos,)), ("max", "<i4", (eixos,)), ("media", "<f4", (eixos,))])
+    baldes = [np.memmap(caminho, dtype=dtype, mode="r", offset=offset, shape=(n,))
+              for offset, n, _ in tabela]
+    spans = [span for _, _, span in tabela]
+    return nomes, baldes, spans
+
+
+class Visualizador:
+    def __init__(self, nomes, baldes, spans):
+        self.nomes, self.baldes, self.spans = nomes, baldes, spans
+        self.fig, eixos = plt.subplots(2, 1, figsize=(10, 6), sharex=True)
+        self.ax = eixos
+        # Acelerômetro em cima, giroscópio embaixo
+        self.grupos = [(eixos[0], range(0, 3), "Aceleração (raw)"),
+                       (eixos[1], range(3, len(nomes)), "Velocidade Angular (raw)")]
+        self.artistas = []
+
+        x0 = float(baldes[0]["amostra"][0])
+        x1 = float(baldes[0]["amostra"][-1])
+        self.desenha(x0, x1)
+        for ax, _, rotulo in self.grupos:
+            ax.set_ylabel(rotulo)
+            ax.grid()
+            ax.legend(loc="upper right")
+        eixos[1].set_xlabel("Amostra")
+        eixos[0].set_xlim(x0, x1)
+        eixos[0].callbacks.connect("xlim_changed", self.ao_mudar_zoom)
+        plt.tight_layout()
+
+    def escolhe_nivel(self, x0, x1):
+        for nivel, dados in enumerate(self.baldes):
+            amostra = dados["amostra"]
+            i0 = max(int(np.searchsorted(amostra, x0)) - 1, 0)
+            i1 = int(np.searchsorted(amostra, x1)) + 1
+            if i1 - i0 <= PONTOS or nivel == len(self.baldes) - 1:
+                return nivel, dados[i0:i1]
+
+    def desenha(self, x0, x1):
+        for artista in self.artistas:
+            artista.remove()
+        self.artistas = []
+
+        nivel, dados = self.escolhe_nivel(x0, x1)
+        x = dados["amostra"]
+        for ax, indices, _ in self.grupos:
+            for cor, i in zip("rgb", indices):
+                self.artistas.append(ax.fill_between(x, dados["min"][:, i], dados["max"][:, i],
+                                                     color=cor, alpha=0.25, linewidth=0))
+                self.artistas += ax.plot(x, dados["media"][:, i], color=cor, label=self.nomes[i])
+        self.ax[0].set_title("Nível %d (%d amostras por ponto)" % (nivel, self.spans[nivel]))
+
+    def ao_mudar_zoom(self, ax):
+        self.desenha(*ax.get_xlim())
+        self.fig.canvas.draw_idle()
+
+
+if __name__ == "__main__":
+    caminho = sys.argv[1] if len(sys.argv) > 1 else "imu_data.csv.pyr"
+    Visualizador(*carrega_piramide(caminho))
+    plt.show()
@@ -0,0 +1,3 @@
+/* Substituto de host para <hardware/gpio.h>; ver pico_host.h */
+#pragma once
+#include "pico_host.h"
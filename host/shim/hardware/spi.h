@@ -0,0 +1,3 @@
+/* Substituto de host para <hardware/spi.h>; ver pico_host.h */
+#pragma once
+#include "pico_host.h"
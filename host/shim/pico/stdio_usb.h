@@ -0,0 +1,9 @@
+/* Substituto de host para <pico/stdio_usb.h>; ver pico_host.h e ../tusb.h */
+#pragma once
+#include "pico_host.h"
+
+typedef struct stdio_driver stdio_driver_t;
+extern stdio_driver_t stdio_usb;
+
+void stdio_set_driver_enabled(stdio_driver_t *driver, bool enabled);
+void stdio_flush(void);
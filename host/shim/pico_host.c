@@ -0,0 +1,141 @@
+/* pico_host.c
+Implementação de host das funções declaradas em pico_host.h.
+*/
+#define _POSIX_C_SOURCE 200809L
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pico_host.h"
+#include "ff.h"
+#include "my_debug.h"
+
+#define HOST_GPIO_COUNT 30
+
+static uint64_t virtual_us = 0;
+static uint64_t epoch_ns = 0;
+static bool gpio_level[HOST_GPIO_COUNT];
+static datetime_t rtc_now = { 2024, 1, 1, 1, 0, 0, 0 };
+
+spi_inst_t host_spi_instances[2];
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+//Microssegundos desde a primeira chamada, somados ao tempo virtual
+uint64_t time_us_64(void) {
+    uint64_t now = monotonic_ns();
+    if (epoch_ns == 0) epoch_ns = now;
+    return (now - epoch_ns) / 1000u + virtual_us;
+}
+
+//Avança o relógio sem esperar (latências simuladas de dispositivos)
+void host_clock_advance_us(uint64_t us) {
+    virtual_us += us;
+}
+
+uint64_t host_clock_virtual_us(void) {
+    return virtual_us;
+}
+
+void sleep_us(uint64_t us) {
+    struct timespec ts = { (time_t)(us / 1000000u), (long)(us % 1000000u) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t)ms * 1000u);
+}
+
+void busy_wait_us(uint64_t us) {
+    host_clock_advance_us(us);
+}
+
+int getchar_timeout_us(uint32_t timeout_us) {
+    (void)timeout_us;
+    return PICO_ERROR_TIMEOUT;
+}
+
+void gpio_init(uint gpio) { (void)gpio; }
+void gpio_set_dir(uint gpio, bool out) { (void)gpio; (void)out; }
+void gpio_pull_up(uint gpio) { (void)gpio; }
+void gpio_set_function(uint gpio, enum gpio_function fn) { (void)gpio; (void)fn; }
+void gpio_set_drive_strength(uint gpio, enum gpio_drive_strength drive) { (void)gpio; (void)drive; }
+
+void gpio_put(uint gpio, bool value) {
+    if (gpio < HOST_GPIO_COUNT) gpio_level[gpio] = value;
+}
+
+bool gpio_get(uint gpio) {
+    return gpio < HOST_GPIO_COUNT ? gpio_level[gpio] : false;
+}
+
+uint spi_set_baudrate(spi_inst_t *spi, uint baudrate) {
+    spi->baudrate = baudrate;
+    return baudrate;
+}
+
+uint spi_get_baudrate(const spi_inst_t *spi) {
+    return spi->baudrate;
+}
+
+void host_spi_attach(spi_inst_t *spi, host_spi_device_fn device, void *ctx) {
+    spi->device = device;
+    spi->device_ctx = ctx;
+}
+
+//Troca um byte com o dispositivo; sem dispositivo, MISO fica em 1 (0xFF)
+uint8_t host_spi_exchange(spi_inst_t *spi, uint8_t mosi) {
+    if (spi->baudrate) {
+        uint32_t ns = spi->ns_remainder + (uint32_t)(8000000000ull / spi->baudrate);
+        host_clock_advance_us(ns / 1000u);
+        spi->ns_remainder = ns % 1000u;
+    }
+    return spi->device ? spi->device(spi->device_ctx, mosi) : 0xFF;
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len) {
+    for (size_t i = 0; i < len; i++) host_spi_exchange(spi, src[i]);
+    return (int)len;
+}
+
+int spi_write_read_blocking(spi_inst_t *spi, const uint8_t *src, uint8_t *dst, size_t len) {
+    for (size_t i = 0; i < len; i++) dst[i] = host_spi_exchange(spi, src[i]);
+    return (int)len;
+}
+
+bool rtc_set_datetime(datetime_t *t) {
+    rtc_now = *t;
+    return true;
+}
+
+bool rtc_get_datetime(datetime_t *t) {
+    *t = rtc_now;
+    return true;
+}
+
+// Chamada pela FatFs (no alvo vem de rtc.c)
+DWORD get_fattime(void) {
+    return ((DWORD)(rtc_now.year - 1980) << 25) | ((DWORD)rtc_now.month << 21) |
+           ((DWORD)rtc_now.day << 16) | ((DWORD)rtc_now.hour << 11) |
+           ((DWORD)rtc_now.min << 5) | ((DWORD)rtc_now.sec / 2);
+}
+
+// Substitutos de my_debug.c (que usa instruções ARM)
+void my_printf(const char *pcFormat, ...) {
+    va_list xArgs;
+    va_start(xArgs, pcFormat);
+    vprintf(pcFormat, xArgs);
+    va_end(xArgs);
+    fflush(stdout);
+}
+
+void my_assert_func(const char *file, int line, const char *func, const char *pred) {
+    fprintf(stderr, "assertion \"%s\" failed: file \"%s\", line %d, function: %s\n",
+            pred, file, line, func);
+    abort();
+}
@@ -0,0 +1,129 @@
+/* pico_host.h
+Substitutos mínimos do Pico SDK para compilar a pilha de log (FatFs,
+sdlogger.c, glue.c) no Linux. Apenas o que esses módulos usam.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef unsigned int uint;
+
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+#define __not_in_flash_func(f) f
+#define __time_critical_func(f) f
+
+#ifndef PICO_ERROR_TIMEOUT
+#define PICO_ERROR_TIMEOUT -1
+#endif
+
+/* Tempo: relógio monotônico real + deslocamento virtual (latências simuladas) */
+typedef uint64_t absolute_time_t;
+
+uint64_t time_us_64(void);
+static inline uint32_t time_us_32(void) { return (uint32_t)time_us_64(); }
+static inline absolute_time_t get_absolute_time(void) { return time_us_64(); }
+static inline uint32_t to_ms_since_boot(absolute_time_t t) { return (uint32_t)(t / 1000u); }
+static inline uint64_t to_us_since_boot(absolute_time_t t) { return t; }
+static inline absolute_time_t from_us_since_boot(uint64_t us) { return us; }
+static inline absolute_time_t make_timeout_time_us(uint64_t us) { return time_us_64() + us; }
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) { return time_us_64() + (uint64_t)ms * 1000u; }
+static inline absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) { return t + us; }
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+    return (int64_t)(to - from);
+}
+static inline bool time_reached(absolute_time_t t) { return time_us_64() >= t; }
+
+void host_clock_advance_us(uint64_t us);
+uint64_t host_clock_virtual_us(void);
+
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+void busy_wait_us(uint64_t us);
+static inline void busy_wait_us_32(uint32_t us) { busy_wait_us(us); }
+static inline void tight_loop_contents(void) {}
+int getchar_timeout_us(uint32_t timeout_us);
+
+/* GPIO: sem efeito, exceto pelo registro do nível para o simulador de SD */
+enum gpio_function { GPIO_FUNC_SPI = 1, GPIO_FUNC_I2C = 3, GPIO_FUNC_PWM = 4, GPIO_FUNC_SIO = 5, GPIO_FUNC_NULL = 0x1f };
+enum gpio_drive_strength {
+    GPIO_DRIVE_STRENGTH_2MA = 0,
+    GPIO_DRIVE_STRENGTH_4MA = 1,
+    GPIO_DRIVE_STRENGTH_8MA = 2,
+    GPIO_DRIVE_STRENGTH_12MA = 3
+};
+#define GPIO_OUT 1
+#define GPIO_IN 0
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+bool gpio_get(uint gpio);
+void gpio_pull_up(uint gpio);
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_set_drive_strength(uint gpio, enum gpio_drive_strength drive);
+
+/* Sincronização (processo de uma thread só) */
+typedef struct {
+    bool initialized;
+    int depth;
+} mutex_t;
+typedef struct {
+    int permits;
+} semaphore_t;
+static inline void mutex_init(mutex_t *m) { m->initialized = true; m->depth = 0; }
+static inline bool mutex_is_initialized(mutex_t *m) { return m->initialized; }
+static inline void mutex_enter_blocking(mutex_t *m) { m->depth++; }
+static inline void mutex_exit(mutex_t *m) { m->depth--; }
+#define auto_init_mutex(name) static mutex_t name = { true, 0 }
+
+/* SPI: cada byte trocado passa pelo dispositivo conectado (simulador de SD)
+e avança o relógio virtual pelo tempo de barramento (8 bits / baudrate) */
+typedef uint8_t (*host_spi_device_fn)(void *ctx, uint8_t mosi);
+typedef struct spi_inst {
+    uint baudrate;
+    uint32_t ns_remainder;
+    host_spi_device_fn device;
+    void *device_ctx;
+} spi_inst_t;
+extern spi_inst_t host_spi_instances[2];
+#define spi0 (&host_spi_instances[0])
+#define spi1 (&host_spi_instances[1])
+uint spi_set_baudrate(spi_inst_t *spi, uint baudrate);
+uint spi_get_baudrate(const spi_inst_t *spi);
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+int spi_write_read_blocking(spi_inst_t *spi, const uint8_t *src, uint8_t *dst, size_t len);
+void host_spi_attach(spi_inst_t *spi, host_spi_device_fn device, void *ctx);
+uint8_t host_spi_exchange(spi_inst_t *spi, uint8_t mosi);
+
+/* DMA / IRQ: apenas os tipos usados em spi_t */
+typedef struct {
+    uint32_t ctrl;
+} dma_channel_config;
+typedef void (*irq_handler_t)(void);
+
+/* RTC */
+typedef struct {
+    int16_t year;
+    int8_t month;
+    int8_t day;
+    int8_t dotw;
+    int8_t hour;
+    int8_t min;
+    int8_t sec;
+} datetime_t;
+bool rtc_set_datetime(datetime_t *t);
+bool rtc_get_datetime(datetime_t *t);
+
+/* ADC (não usado no host) */
+static inline void adc_select_input(uint input) { (void)input; }
+static inline uint16_t adc_read(void) { return 0; }
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,11 @@
+/* Substituto de host para <tusb.h>: só o CDC que src/xfer.c usa. Quem linka
+xfer.c implementa estas funções (xfer_loopback.c as serve sobre um pty). */
+#pragma once
+#include "pico_host.h"
+
+void tud_task(void);
+bool tud_mounted(void);
+bool tud_cdc_connected(void);
+uint32_t tud_cdc_read(void *buffer, uint32_t bufsize);
+uint32_t tud_cdc_write(const void *buffer, uint32_t bufsize);
+uint32_t tud_cdc_write_flush(void);
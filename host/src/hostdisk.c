@@ -0,0 +1,200 @@
+/* hostdisk.c
+Backend de bloco em RAM ou arquivo para o build de host. Implementa a parte
+de sd_card.c usada por glue.c (sd_init_driver, sd_card_detect, sd_sectors e
+os ponteiros init/read_blocks/write_blocks do sd_card_t).
+*/
+#define _XOPEN_SOURCE 700
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ff.h"
+//
+#include "diskio.h"
+#include "hw_config.h"
+#include "pico/stdlib.h"
+#include "sd_card.h"
+
+#include "hostdisk.h"
+
+static uint8_t *ram_image = NULL;
+static int image_fd = -1;
+static uint64_t image_sectors = 0;
+static hostdisk_stats_t stats;
+
+static bool latency_enabled = false;
+static hostdisk_latency_t latency;
+static uint32_t rng_state = 1;
+static int64_t sectors_until_stall = 0;
+
+static uint32_t rng_next(void) {
+    // xorshift32
+    uint32_t x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rng_state = x;
+}
+
+static uint32_t rng_range(uint32_t lo, uint32_t hi) {
+    if (hi <= lo) return lo;
+    return lo + rng_next() % (hi - lo + 1);
+}
+
+static void schedule_next_stall(void) {
+    uint32_t mean = latency.stall_mean_sectors;
+    sectors_until_stall = rng_range(mean / 2, mean + mean / 2);
+}
+
+static void charge(uint64_t us) {
+    stats.busy_us += us;
+    host_clock_advance_us(us);
+}
+
+static void charge_read(uint32_t sectors) {
+    if (!latency_enabled) return;
+    charge(latency.command_us + (uint64_t)latency.read_sector_us * sectors);
+}
+
+static void charge_write(uint32_t sectors) {
+    if (!latency_enabled) return;
+    uint64_t us = latency.command_us + (uint64_t)latency.write_sector_us * sectors;
+    if (latency.stall_mean_sectors) {
+        sectors_until_stall -= sectors;
+        if (sectors_until_stall <= 0) {
+            us += rng_range(latency.stall_min_us, latency.stall_max_us);
+            stats.stalls++;
+            schedule_next_stall();
+        }
+    }
+    charge(us);
+}
+
+static int hostdisk_init(sd_card_t *pSD) {
+    if (image_sectors == 0) {
+        pSD->m_Status |= STA_NOINIT | STA_NODISK;
+        return pSD->m_Status;
+    }
+    pSD->sectors = image_sectors;
+    pSD->m_Status &= ~(STA_NOINIT | STA_NODISK);
+    return pSD->m_Status;
+}
+
+static int hostdisk_read_blocks(sd_card_t *pSD, uint8_t *buffer, uint64_t ulSectorNumber,
+                                uint32_t ulSectorCount) {
+    (void)pSD;
+    if (ulSectorNumber + ulSectorCount > image_sectors) return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    size_t len = (size_t)ulSectorCount * HOSTDISK_SECTOR_SIZE;
+    off_t off = (off_t)(ulSectorNumber * HOSTDISK_SECTOR_SIZE);
+    if (ram_image) {
+        memcpy(buffer, ram_image + off, len);
+    } else if (pread(image_fd, buffer, len, off) != (ssize_t)len) {
+        return SD_BLOCK_DEVICE_ERROR_NO_RESPONSE;
+    }
+    stats.read_calls++;
+    stats.sectors_read += ulSectorCount;
+    charge_read(ulSectorCount);
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+static int hostdisk_write_blocks(sd_card_t *pSD, const uint8_t *buffer, uint64_t ulSectorNumber,
+                                 uint32_t blockCnt) {
+    (void)pSD;
+    if (ulSectorNumber + blockCnt > image_sectors) return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    size_t len = (size_t)blockCnt * HOSTDISK_SECTOR_SIZE;
+    off_t off = (off_t)(ulSectorNumber * HOSTDISK_SECTOR_SIZE);
+    if (ram_image) {
+        memcpy(ram_image + off, buffer, len);
+    } else if (pwrite(image_fd, buffer, len, off) != (ssize_t)len) {
+        return SD_BLOCK_DEVICE_ERROR_WRITE;
+    }
+    stats.write_calls++;
+    stats.sectors_written += blockCnt;
+    charge_write(blockCnt);
+    return SD_BLOCK_DEVICE_ERROR_NONE;
+}
+
+static bool hostdisk_test_com(sd_card_t *pSD) {
+    (void)pSD;
+    return image_sectors != 0;
+}
+
+bool hostdisk_open(const char *image_path, uint64_t size_bytes) {
+    hostdisk_close();
+    if (image_path) {
+        image_fd = open(image_path, O_RDWR | O_CREAT, 0644);
+        if (image_fd < 0) return false;
+        struct stat st;
+        if (fstat(image_fd, &st) != 0) {
+            hostdisk_close();
+            return false;
+        }
+        if ((uint64_t)st.st_size < size_bytes && ftruncate(image_fd, (off_t)size_bytes) != 0) {
+            hostdisk_close();
+            return false;
+        }
+        if ((uint64_t)st.st_size > size_bytes) size_bytes = (uint64_t)st.st_size;
+    } else {
+        ram_image = calloc(1, (size_t)size_bytes);
+        if (!ram_image) return false;
+    }
+    image_sectors = size_bytes / HOSTDISK_SECTOR_SIZE;
+    hostdisk_reset_stats();
+
+    sd_card_t *pSD = sd_get_by_num(0);
+    pSD->m_Status = STA_NOINIT;
+    pSD->init = hostdisk_init;
+    pSD->read_blocks = hostdisk_read_blocks;
+    pSD->write_blocks = hostdisk_write_blocks;
+    pSD->sd_test_com = hostdisk_test_com;
+    return true;
+}
+
+void hostdisk_close(void) {
+    free(ram_image);
+    ram_image = NULL;
+    if (image_fd >= 0) close(image_fd);
+    image_fd = -1;
+    image_sectors = 0;
+}
+
+uint64_t hostdisk_sectors(void) {
+    return image_sectors;
+}
+
+hostdisk_stats_t hostdisk_get_stats(void) {
+    return stats;
+}
+
+void hostdisk_reset_stats(void) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+void hostdisk_set_latency(const hostdisk_latency_t *model) {
+    latency_enabled = (model != NULL);
+    if (!model) return;
+    latency = *model;
+    rng_state = latency.seed ? latency.seed : 1;
+    schedule_next_stall();
+}
+
+/* Interface de sd_card.h usada por glue.c */
+bool sd_init_driver() {
+    return true;
+}
+
+bool sd_card_detect(sd_card_t *pSD) {
+    if (image_sectors == 0) {
+        pSD->m_Status |= STA_NODISK | STA_NOINIT;
+        return false;
+    }
+    pSD->m_Status &= ~STA_NODISK;
+    return true;
+}
+
+uint64_t sd_sectors(sd_card_t *pSD) {
+    (void)pSD;
+    return image_sectors;
+}
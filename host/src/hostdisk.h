@@ -0,0 +1,56 @@
+/* hostdisk.h
+Disco de host para a pilha de log: substitui sd_card.c/hw_config.c por uma
+imagem em RAM ou em arquivo, exposta como o cartão "0:".
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HOSTDISK_SECTOR_SIZE 512
+
+typedef struct {
+    uint64_t read_calls;
+    uint64_t write_calls;
+    uint64_t sectors_read;
+    uint64_t sectors_written;
+    uint64_t busy_us;   // tempo virtual gasto no modelo de latência
+    uint64_t stalls;    // pausas longas de "cartão ocupado"
+} hostdisk_stats_t;
+
+// Modelo de latência do cartão em SPI. O custo de cada comando avança o
+// relógio virtual do shim (host_clock_advance_us), então time_us_64() no
+// código sob teste enxerga o cartão como lento sem dormir de verdade.
+typedef struct {
+    uint32_t command_us;          // custo fixo por comando de leitura/escrita
+    uint32_t read_sector_us;      // transferência por setor lido
+    uint32_t write_sector_us;     // transferência + programação por setor escrito
+    uint32_t stall_mean_sectors;  // média de setores escritos entre pausas (0 = sem pausas)
+    uint32_t stall_min_us;        // duração da pausa, sorteada em [min, max]
+    uint32_t stall_max_us;
+    uint32_t seed;
+} hostdisk_latency_t;
+
+// Valores típicos de um cartão SDHC classe 10 em SPI a 12,5 MHz
+#define HOSTDISK_LATENCY_SD_DEFAULT \
+    { .command_us = 600, .read_sector_us = 360, .write_sector_us = 420, \
+      .stall_mean_sectors = 4096, .stall_min_us = 100000, .stall_max_us = 250000, .seed = 1 }
+
+// image_path == NULL: imagem em RAM. Arquivos menores que size_bytes são estendidos.
+bool hostdisk_open(const char *image_path, uint64_t size_bytes);
+void hostdisk_close(void);
+uint64_t hostdisk_sectors(void);
+
+hostdisk_stats_t hostdisk_get_stats(void);
+void hostdisk_reset_stats(void);
+
+// model == NULL: sem latência (padrão)
+void hostdisk_set_latency(const hostdisk_latency_t *model);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,28 @@
+/* hw_config_host.c
+Configuração de hardware do build de host: um "cartão" 0: no spi0, servido
+por hostdisk.c (acesso direto a blocos) ou por sdsim.c (protocolo SPI).
+*/
+#include "hw_config.h"
+
+static spi_t spis[] = {
+    {
+        .hw_inst = spi0,
+        .baud_rate = 12500 * 1000,
+    }};
+
+static sd_card_t sd_cards[] = {
+    {
+        .pcName = "0:",
+        .spi = &spis[0],
+        .ss_gpio = 17,
+        .use_card_detect = false,
+    }};
+
+size_t sd_get_num() { return count_of(sd_cards); }
+sd_card_t *sd_get_by_num(size_t num) {
+    return num < sd_get_num() ? &sd_cards[num] : NULL;
+}
+size_t spi_get_num() { return count_of(spis); }
+spi_t *spi_get_by_num(size_t num) {
+    return num < spi_get_num() ? &spis[num] : NULL;
+}
@@ -0,0 +1,676 @@
+/* imulog_reader.cpp
+Implementação de imulog_reader.hpp. O CSV é dividido em blocos alinhados a
+fim de linha, cada thread converte o seu bloco em colunas locais e no fim
+as colunas são concatenadas. Os números são convertidos 8 dígitos por vez
+(SWAR sobre um uint64_t), com fallback escalar perto do fim do mapa e para
+números com mais de 8 dígitos.
+*/
+#include "imulog_reader.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include "imucodec.h"
+#include "sdlogger_format.h"
+
+namespace imulog {
+
+namespace {
+
+constexpr uint64_t kOnes = 0x0101010101010101ull;
+
+// 8 dígitos (0-9 por byte, o mais significativo no byte de menor endereço)
+inline uint32_t swar_combine8(uint64_t x) {
+    x = (x * 10 + (x >> 8)) & 0x00FF00FF00FF00FFull;
+    x = (x * 100 + (x >> 16)) & 0x0000FFFF0000FFFFull;
+    x = (x * 10000 + (x >> 32)) & 0x00000000FFFFFFFFull;
+    return static_cast<uint32_t>(x);
+}
+
+// Converte um inteiro decimal com sinal; devolve o ponteiro após os dígitos ou nullptr
+inline const char *parse_int(const char *p, const char *end, int32_t &out) {
+    bool neg = false;
+    if (p < end && *p == '-') {
+        neg = true;
+        ++p;
+    }
+    uint64_t value = 0;
+    const char *start = p;
+    if (end - p >= 8) {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+        uint64_t x = v ^ (kOnes * '0');
+        // bit 7 de cada byte ligado se o byte não é dígito (x >= 10)
+        uint64_t nondigit = (((x & (kOnes * 0x7F)) + kOnes * 0x76) | x) & (kOnes * 0x80);
+        if (nondigit) {
+            unsigned len = static_cast<unsigned>(__builtin_ctzll(nondigit)) >> 3;
+            if (len == 0) return nullptr;
+            value = swar_combine8(x << (8 * (8 - len)));
+            p += len;
+        } else {
+            value = swar_combine8(x);
+            p += 8;
+        }
+    }
+    while (p < end && static_cast<unsigned>(*p - '0') < 10) {
+        value = value * 10 + static_cast<unsigned>(*p - '0');
+        if (value > 0xFFFFFFFFull) return nullptr;
+        ++p;
+    }
+    if (p == start) return nullptr;
+    if (neg) {
+        if (value > 0x80000000ull) return nullptr;
+        out = static_cast<int32_t>(-static_cast<int64_t>(value));
+    } else {
+        // numero_amostra é uint32; acima de INT32_MAX guardamos o padrão de bits
+        out = static_cast<int32_t>(static_cast<uint32_t>(value));
+    }
+    return p;
+}
+
+inline const char *next_line(const char *p, const char *end) {
+    const void *nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return nl ? static_cast<const char *>(nl) + 1 : end;
+}
+
+struct Chunk {
+    std::vector<std::vector<int32_t>> columns;
+    uint64_t comment_lines = 0;
+    uint64_t bad_lines = 0;
+};
+
+void parse_chunk(const char *p, const char *end, size_t ncols, Chunk &chunk) {
+    chunk.columns.assign(ncols, {});
+    // Estimativa grosseira para evitar realocações: ~6 bytes por campo
+    size_t guess = static_cast<size_t>(end - p) / (ncols * 6 + 1) + 16;
+    for (auto &c : chunk.columns) c.reserve(guess);
+
+    std::vector<int32_t> row(ncols);
+    while (p < end) {
+        if (*p == '#') {
+            chunk.comment_lines++;
+            p = next_line(p, end);
+            continue;
+        }
+        if (*p == '\n' || *p == '\r') {
+            p = next_line(p, end);
+            continue;
+        }
+        size_t c = 0;
+        const char *q = p;
+        bool ok = true;
+        for (; c < ncols; c++) {
+            q = parse_int(q, end, row[c]);
+            if (!q) {
+                ok = false;
+                break;
+            }
+            if (c + 1 < ncols) {
+                if (q >= end || *q != ',') {
+                    ok = false;
+                    break;
+                }
+                ++q;
+            }
+        }
+        if (ok && q < end && *q == '\r') ++q;
+        if (ok && (q == end || *q == '\n')) {
+            for (size_t i = 0; i < ncols; i++) chunk.columns[i].push_back(row[i]);
+            p = q < end ? q + 1 : end;
+        } else {
+            chunk.bad_lines++;
+            p = next_line(p, end);
+        }
+    }
+}
+
+std::vector<std::string> split_header(const char *p, const char *end) {
+    std::vector<std::string> names;
+    std::string cur;
+    for (; p < end && *p != '\n'; ++p) {
+        if (*p == '\r') continue;
+        if (*p == ',') {
+            names.push_back(cur);
+            cur.clear();
+        } else {
+            cur += *p;
+        }
+    }
+    names.push_back(cur);
+    return names;
+}
+
+unsigned thread_count(const ReadOptions &options) {
+    unsigned n = options.threads ? options.threads : std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+// Linhas de metadados "# chave=valor" a partir de p; devolve o fim delas
+const char *parse_metadata(const char *p, const char *end, Table &table) {
+    while (p < end && *p == '#') {
+        const char *nl = next_line(p, end);
+        const char *b = p + 1;
+        while (b < nl && *b == ' ') b++;
+        std::string line(b, nl);
+        while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) line.pop_back();
+        table.metadata.push_back(line);
+        p = nl;
+    }
+    return p;
+}
+
+// Metadados e o cabeçalho; devolve o início dos dados
+const char *parse_csv_header(const char *p, const char *end, Table &table) {
+    table.format = Format::Csv;
+    p = std::min(parse_metadata(p, end, table), end);  // min: o GCC não prova p <= end (-Wstringop-overread)
+    if (p < end && *p != '-' && static_cast<unsigned>(*p - '0') >= 10) {
+        table.names = split_header(p, end);
+        p = next_line(p, end);
+    } else {
+        // Sem cabeçalho: o número de colunas vem da primeira linha
+        size_t n = 1 + static_cast<size_t>(std::count(p, next_line(p, end), ','));
+        for (size_t i = 0; i < n; i++) table.names.push_back("col" + std::to_string(i));
+    }
+    return p;
+}
+
+// Concatena as colunas dos blocos em table, uma thread por coluna
+void concat_chunks(std::vector<Chunk> &chunks, Table &table) {
+    const size_t ncols = table.names.size();
+    size_t rows = 0;
+    for (auto &ch : chunks) {
+        if (!ch.columns.empty()) rows += ch.columns[0].size();
+        table.comment_lines += ch.comment_lines;
+        table.bad_lines += ch.bad_lines;
+    }
+    table.columns.assign(ncols, {});
+    std::vector<std::thread> workers;
+    for (size_t c = 0; c < ncols; c++) {
+        workers.emplace_back([&, c] {
+            auto &dst = table.columns[c];
+            if (chunks.size() == 1) {
+                dst = std::move(chunks[0].columns[c]);
+                return;
+            }
+            dst.resize(rows);
+            size_t at = 0;
+            for (auto &ch : chunks) {
+                auto &src = ch.columns[c];
+                std::copy(src.begin(), src.end(), dst.begin() + static_cast<ptrdiff_t>(at));
+                at += src.size();
+                std::vector<int32_t>().swap(src);
+            }
+        });
+    }
+    for (auto &w : workers) w.join();
+}
+
+Table parse_csv(const char *data, size_t size, const ReadOptions &options) {
+    Table table;
+    const char *end = data + std::min<uint64_t>(options.end, size);
+    const char *p = parse_csv_header(data, end, table);
+    if (options.begin > static_cast<uint64_t>(p - data)) p = data + std::min<uint64_t>(options.begin, size);
+    if (p > end) p = end;
+    const size_t ncols = table.names.size();
+
+    // Blocos de pelo menos 1 MiB, alinhados ao início de uma linha
+    unsigned nthreads = thread_count(options);
+    size_t body = static_cast<size_t>(end - p);
+    size_t nchunks = std::max<size_t>(1, std::min<size_t>(nthreads, body / (1u << 20)));
+    std::vector<const char *> bounds{p};
+    for (size_t i = 1; i < nchunks; i++) {
+        const char *cut = p + body * i / nchunks;
+        cut = next_line(std::max(cut, bounds.back()), end);
+        bounds.push_back(cut);
+    }
+    bounds.push_back(end);
+
+    std::vector<Chunk> chunks(nchunks);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < nchunks; i++) {
+        workers.emplace_back(parse_chunk, bounds[i], bounds[i + 1], ncols, std::ref(chunks[i]));
+    }
+    for (auto &w : workers) w.join();
+
+    concat_chunks(chunks, table);
+    return table;
+}
+
+Format detect_format(const char *data, size_t size) {
+    if (size >= SDLOGGER_BIN_MAGIC_LEN) {
+        if (std::memcmp(data, SDLOGGER_BIN_MAGIC, SDLOGGER_BIN_MAGIC_LEN) == 0) return Format::Binary;
+        if (std::memcmp(data, SDLOGGER_RICE_MAGIC, SDLOGGER_BIN_MAGIC_LEN) == 0) return Format::Compressed;
+    }
+    return Format::Csv;
+}
+
+// Cabeçalho dos formatos binário e comprimido e os metadados que o seguem;
+// devolve o início dos registros
+const char *check_binary_header(const char *data, size_t size, sdlogger_bin_header_t &header, Table &table) {
+    if (size < sizeof header) throw std::runtime_error("arquivo binário truncado");
+    std::memcpy(&header, data, sizeof header);
+    bool compressed = detect_format(data, size) == Format::Compressed;
+    if ((compressed ? header.record_size != IMUCODEC_BLOCK_SIZE : header.record_size < sizeof(sdlogger_bin_record_t)) ||
+        header.header_size < sizeof header || header.header_size > size) {
+        throw std::runtime_error("cabeçalho binário inválido");
+    }
+    const char *text = data + sizeof header;
+    const char *end = data + header.header_size;
+    parse_metadata(text, std::find(text, end, '\0'), table);
+    return end;
+}
+
+const char *const kBinaryNames[] = {"numero_amostra", "accel_x", "accel_y", "accel_z", "giro_x", "giro_y", "giro_z"};
+
+// Colunas do formato binário: "sensor" só nos registros que o trazem
+void binary_names(const sdlogger_bin_header_t &header, Format format, Table &table) {
+    table.names.assign(std::begin(kBinaryNames), std::end(kBinaryNames));
+    if (format == Format::Binary && header.record_size >= sizeof(sdlogger_bin_sensor_record_t)) {
+        table.names.push_back("sensor");
+    }
+}
+
+// Registros [from, to) para columns[c][at + r - from]
+void decode_records(const char *base, size_t record_size, size_t from, size_t to,
+                    std::vector<std::vector<int32_t>> &columns, size_t at) {
+    const bool with_sensor = columns.size() > 7;
+    for (size_t r = from; r < to; r++, at++) {
+        sdlogger_bin_sensor_record_t rec;
+        std::memcpy(&rec, base + r * record_size, with_sensor ? sizeof rec : sizeof rec.base);
+        columns[0][at] = static_cast<int32_t>(rec.base.sample);
+        for (int i = 0; i < 3; i++) {
+            columns[1 + i][at] = rec.base.accel[i];
+            columns[4 + i][at] = rec.base.gyro[i];
+        }
+        if (with_sensor) columns[7][at] = rec.sensor;
+    }
+}
+
+// Blocos comprimidos; um bloco inválido conta como uma linha descartada
+void decode_blocks(const char *p, size_t nblocks, Chunk &chunk) {
+    chunk.columns.assign(1 + IMUCODEC_AXES, {});
+    for (auto &c : chunk.columns) c.reserve(nblocks * 96);
+    imucodec_sample_t samples[IMUCODEC_MAX_SAMPLES];
+    for (size_t b = 0; b < nblocks; b++, p += IMUCODEC_BLOCK_SIZE) {
+        int n = imucodec_decode(reinterpret_cast<const uint8_t *>(p), samples, IMUCODEC_MAX_SAMPLES);
+        if (n < 0) {
+            chunk.bad_lines++;
+            continue;
+        }
+        for (int i = 0; i < n; i++) {
+            chunk.columns[0].push_back(static_cast<int32_t>(samples[i].sample));
+            for (int a = 0; a < IMUCODEC_AXES; a++) chunk.columns[1 + a].push_back(samples[i].axis[a]);
+        }
+    }
+}
+
+Table parse_binary(const char *data, size_t size, const ReadOptions &options) {
+    Table table;
+    sdlogger_bin_header_t header;
+    check_binary_header(data, size, header, table);
+
+    size_t from = std::max<uint64_t>(options.begin, header.header_size);
+    size_t to = std::min<uint64_t>(options.end, size);
+    if (from > to || (from - header.header_size) % header.record_size) {
+        throw std::runtime_error("faixa fora do início de um registro");
+    }
+    const char *base = data + from;
+
+    table.format = detect_format(data, size);
+    binary_names(header, table.format, table);
+    size_t rows = (to - from) / header.record_size;
+    if ((to - from) % header.record_size) table.bad_lines = 1;  // registro final incompleto
+
+    if (table.format == Format::Compressed) {
+        // Blocos independentes: cada thread decodifica uma faixa deles
+        size_t nchunks = std::max<size_t>(1, std::min<size_t>(thread_count(options), rows / 256 + 1));
+        std::vector<Chunk> chunks(nchunks);
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < nchunks; t++) {
+            size_t b0 = rows * t / nchunks, b1 = rows * (t + 1) / nchunks;
+            workers.emplace_back(decode_blocks, base + b0 * IMUCODEC_BLOCK_SIZE, b1 - b0, std::ref(chunks[t]));
+        }
+        for (auto &w : workers) w.join();
+        concat_chunks(chunks, table);
+        return table;
+    }
+    table.columns.assign(table.names.size(), std::vector<int32_t>(rows));
+
+    unsigned nthreads = std::max<unsigned>(1, std::min<unsigned>(thread_count(options),
+                                                                 static_cast<unsigned>(rows / 65536 + 1)));
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < nthreads; t++) {
+        size_t from = rows * t / nthreads, to = rows * (t + 1) / nthreads;
+        workers.emplace_back(decode_records, base, static_cast<size_t>(header.record_size), from, to, std::ref(table.columns), from);
+    }
+    for (auto &w : workers) w.join();
+    return table;
+}
+
+/* .npy */
+
+struct Dtype {
+    const char *descr;
+    size_t size;
+};
+
+Dtype narrowest(const std::vector<int32_t> &v, bool is_unsigned) {
+    if (is_unsigned) return {"<u4", 4};
+    int32_t lo = 0, hi = 0;
+    if (!v.empty()) {
+        auto mm = std::minmax_element(v.begin(), v.end());
+        lo = *mm.first;
+        hi = *mm.second;
+    }
+    if (lo >= INT16_MIN && hi <= INT16_MAX) return {"<i2", 2};
+    return {"<i4", 4};
+}
+
+void write_npy_header(FILE *f, const char *descr, const std::string &shape) {
+    std::string dict = std::string("{'descr': '") + descr + "', 'fortran_order': False, 'shape': " + shape + ", }";
+    // magic(6) + versão(2) + tamanho(2) + dict + '\n' múltiplo de 64
+    size_t total = 10 + dict.size() + 1;
+    dict.append((64 - total % 64) % 64, ' ');
+    dict += '\n';
+    const unsigned char preamble[8] = {0x93, 'N', 'U', 'M', 'P', 'Y', 1, 0};
+    uint16_t len = static_cast<uint16_t>(dict.size());
+    fwrite(preamble, 1, sizeof preamble, f);
+    fwrite(&len, sizeof len, 1, f);
+    fwrite(dict.data(), 1, dict.size(), f);
+}
+
+FILE *open_output(const std::string &path) {
+    FILE *f = fopen(path.c_str(), "wb");
+    if (!f) throw std::runtime_error("não foi possível criar " + path + ": " + std::strerror(errno));
+    return f;
+}
+
+void close_output(FILE *f, const std::string &path) {
+    bool ok = !ferror(f);
+    if (fclose(f) != 0 || !ok) throw std::runtime_error("falha ao gravar " + path);
+}
+
+}  // namespace
+
+MappedFile::MappedFile(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("não foi possível abrir " + path + ": " + std::strerror(errno));
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("fstat falhou em " + path);
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+        void *m = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("mmap falhou em " + path + ": " + std::strerror(errno));
+        }
+        madvise(m, size_, MADV_SEQUENTIAL | MADV_WILLNEED);
+        data_ = static_cast<const char *>(m);
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_) munmap(const_cast<char *>(data_), size_);
+}
+
+int Table::column_index(const std::string &name) const {
+    auto it = std::find(names.begin(), names.end(), name);
+    return it == names.end() ? -1 : static_cast<int>(it - names.begin());
+}
+
+std::string Table::meta(const std::string &key) const {
+    for (const auto &line : metadata) {
+        if (line.size() > key.size() && line.compare(0, key.size(), key) == 0 && line[key.size()] == '=') {
+            return line.substr(key.size() + 1);
+        }
+    }
+    return {};
+}
+
+Units log_units(const Table &table) {
+    Units units;
+    std::string accel = table.meta("imu_accel_lsb_g"), gyro = table.meta("imu_giro_lsb_dps");
+    double a = accel.empty() ? 0.0 : std::strtod(accel.c_str(), nullptr);
+    double g = gyro.empty() ? 0.0 : std::strtod(gyro.c_str(), nullptr);
+    if (a > 0.0 && g > 0.0) {
+        units.accel_lsb_per_g = a;
+        units.gyro_lsb_per_dps = g;
+        units.from_metadata = true;
+    }
+    return units;
+}
+
+Table parse_log(const char *data, size_t size, const ReadOptions &options) {
+    if (detect_format(data, size) != Format::Csv) return parse_binary(data, size, options);
+    return parse_csv(data, size, options);
+}
+
+Table read_log(const std::string &path, const ReadOptions &options) {
+    MappedFile file(path);
+    return parse_log(file.data(), file.size(), options);
+}
+
+BlockReader::BlockReader(const MappedFile &file, const ReadOptions &options, size_t block_bytes)
+    : data_(file.data()), pos_(file.data()), end_(file.data() + file.size()), released_(file.data()),
+      threads_(thread_count(options)), block_bytes_(std::max<size_t>(block_bytes, 4096)) {
+    info_.format = detect_format(data_, file.size());
+    if (info_.format != Format::Csv) {
+        sdlogger_bin_header_t header;
+        pos_ = check_binary_header(data_, file.size(), header, info_);
+        record_size_ = header.record_size;
+        binary_names(header, info_.format, info_);
+        if (static_cast<size_t>(end_ - pos_) % record_size_) info_.bad_lines = 1;
+    } else {
+        pos_ = parse_csv_header(data_, end_, info_);
+    }
+}
+
+bool BlockReader::next_batch(std::vector<Block> &batch) {
+    batch.clear();
+    const size_t ncols = info_.names.size();
+    std::vector<std::thread> workers;
+    if (info_.format == Format::Binary) {
+        const size_t per_block = std::max<size_t>(1, block_bytes_ / record_size_);
+        size_t left = static_cast<size_t>(end_ - pos_) / record_size_;
+        for (unsigned t = 0; t < threads_ && left > 0; t++) {
+            size_t n = std::min(per_block, left);
+            batch.emplace_back();
+            batch.back().first_row = rows_read_;
+            batch.back().columns.assign(ncols, std::vector<int32_t>(n));
+            rows_read_ += n;
+            left -= n;
+        }
+        const char *base = pos_;
+        for (auto &b : batch) {
+            size_t from = b.first_row - batch[0].first_row;
+            workers.emplace_back(decode_records, base, record_size_, from, from + b.rows(), std::ref(b.columns), 0);
+        }
+        for (auto &w : workers) w.join();
+        for (auto &b : batch) pos_ += b.rows() * record_size_;
+        if (left == 0) pos_ = end_;  // sobra menor que um registro: já contada em bad_lines
+    } else if (info_.format == Format::Compressed) {
+        const size_t per_chunk = std::max<size_t>(1, block_bytes_ / IMUCODEC_BLOCK_SIZE);
+        size_t left = static_cast<size_t>(end_ - pos_) / IMUCODEC_BLOCK_SIZE;
+        std::vector<Chunk> chunks;
+        std::vector<size_t> counts;
+        while (chunks.size() < threads_ && left > 0) {
+            counts.push_back(std::min(per_chunk, left));
+            left -= counts.back();
+            chunks.emplace_back();
+        }
+        const char *p = pos_;
+        for (size_t i = 0; i < chunks.size(); i++) {
+            workers.emplace_back(decode_blocks, p, counts[i], std::ref(chunks[i]));
+            p += counts[i] * IMUCODEC_BLOCK_SIZE;
+        }
+        for (auto &w : workers) w.join();
+        for (auto &ch : chunks) {
+            info_.bad_lines += ch.bad_lines;
+            if (ch.columns[0].empty()) continue;
+            batch.emplace_back();
+            batch.back().first_row = rows_read_;
+            batch.back().columns = std::move(ch.columns);
+            rows_read_ += batch.back().rows();
+        }
+        pos_ = p;
+        if (left == 0) pos_ = end_;  // sobra menor que um bloco: já contada em bad_lines
+    } else {
+        std::vector<const char *> bounds{pos_};
+        for (unsigned t = 0; t < threads_ && bounds.back() < end_; t++) {
+            const char *from = bounds.back();
+            bounds.push_back(static_cast<size_t>(end_ - from) > block_bytes_ ? next_line(from + block_bytes_ - 1, end_)
+                                                                              : end_);
+        }
+        std::vector<Chunk> chunks(bounds.size() - 1);
+        for (size_t i = 0; i < chunks.size(); i++) {
+            workers.emplace_back(parse_chunk, bounds[i], bounds[i + 1], ncols, std::ref(chunks[i]));
+        }
+        for (auto &w : workers) w.join();
+        for (auto &ch : chunks) {
+            info_.comment_lines += ch.comment_lines;
+            info_.bad_lines += ch.bad_lines;
+            if (ch.columns.empty() || ch.columns[0].empty()) continue;
+            batch.emplace_back();
+            batch.back().first_row = rows_read_;
+            batch.back().columns = std::move(ch.columns);
+            rows_read_ += batch.back().rows();
+        }
+        pos_ = bounds.back();
+    }
+    release_consumed();
+    return !batch.empty() || pos_ < end_;
+}
+
+// As linhas já foram copiadas para os blocos: as páginas lidas podem sair da memória
+void BlockReader::release_consumed() {
+    const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    const char *upto = data_ + ((static_cast<uintptr_t>(pos_ - data_)) & ~(page - 1));
+    if (upto > released_) {
+        madvise(const_cast<char *>(released_), static_cast<size_t>(upto - released_), MADV_DONTNEED);
+        released_ = upto;
+    }
+}
+
+std::string index_path(const std::string &log_path) { return log_path + SDLOGGER_IDX_EXT; }
+
+bool read_index(const std::string &log_path, SampleIndex &index) {
+    const std::string path = index_path(log_path);
+    if (access(path.c_str(), F_OK) != 0) return false;
+    MappedFile file(path);
+    sdlogger_idx_header_t header;
+    if (file.size() < sizeof header) throw std::runtime_error("índice truncado: " + path);
+    std::memcpy(&header, file.data(), sizeof header);
+    if (std::memcmp(header.magic, SDLOGGER_IDX_MAGIC, SDLOGGER_BIN_MAGIC_LEN) != 0 ||
+        header.header_size < sizeof header || header.entry_size < sizeof(sdlogger_idx_entry_t) ||
+        header.header_size + static_cast<uint64_t>(header.count) * header.entry_size > file.size()) {
+        throw std::runtime_error("índice inválido: " + path);
+    }
+    // O índice vale só para o log com que foi gravado
+    MappedFile log(log_path);
+    char magic[SDLOGGER_BIN_MAGIC_LEN] = {};
+    if (log.size() >= sizeof magic && (std::memcmp(log.data(), SDLOGGER_BIN_MAGIC, sizeof magic) == 0 ||
+                                       std::memcmp(log.data(), SDLOGGER_RICE_MAGIC, sizeof magic) == 0)) {
+        std::memcpy(magic, log.data(), sizeof magic);
+    }
+    if (std::memcmp(header.log_magic, magic, sizeof magic) != 0 || header.log_size != log.size()) {
+        throw std::runtime_error("índice de outro log (formato ou tamanho diferente): " + path);
+    }
+    index.interval = header.interval;
+    index.entries.resize(header.count);
+    for (uint32_t i = 0; i < header.count; i++) {
+        std::memcpy(&index.entries[i], file.data() + header.header_size + static_cast<size_t>(i) * header.entry_size,
+                    sizeof(sdlogger_idx_entry_t));
+    }
+    return true;
+}
+
+std::pair<uint64_t, uint64_t> index_range(const SampleIndex &index, uint32_t first, uint32_t last) {
+    const auto &e = index.entries;
+    auto by_sample = [](uint32_t sample, const sdlogger_idx_entry_t &entry) { return sample < entry.sample; };
+    // Última entrada com amostra <= first e primeira com amostra > last
+    auto lo = std::upper_bound(e.begin(), e.end(), first, by_sample);
+    auto hi = std::upper_bound(e.begin(), e.end(), last, by_sample);
+    uint64_t begin = lo == e.begin() ? 0 : std::prev(lo)->offset;
+    uint64_t end = hi == e.end() ? UINT64_MAX : hi->offset;
+    return {begin, end};
+}
+
+void write_npy_matrix(const Table &table, const std::string &path) {
+    const size_t rows = table.rows(), cols = table.columns.size();
+    FILE *f = open_output(path);
+    write_npy_header(f, "<i4", "(" + std::to_string(rows) + ", " + std::to_string(cols) + ")");
+    // Transpõe em blocos de linhas para um buffer e grava
+    constexpr size_t kBlockRows = 16384;
+    std::vector<int32_t> buf(kBlockRows * cols);
+    for (size_t r0 = 0; r0 < rows; r0 += kBlockRows) {
+        size_t n = std::min(kBlockRows, rows - r0);
+        for (size_t c = 0; c < cols; c++) {
+            const int32_t *src = table.columns[c].data() + r0;
+            for (size_t r = 0; r < n; r++) buf[r * cols + c] = src[r];
+        }
+        fwrite(buf.data(), sizeof(int32_t), n * cols, f);
+    }
+    close_output(f, path);
+}
+
+void write_npy_units(const Table &table, const Units &units, const std::string &path) {
+    const size_t rows = table.rows(), cols = table.columns.size();
+    std::vector<double> scale(cols, 1.0);
+    for (size_t c = 0; c < cols; c++) {
+        if (table.names[c].compare(0, 6, "accel_") == 0) scale[c] = 1.0 / units.accel_lsb_per_g;
+        if (table.names[c].compare(0, 5, "giro_") == 0) scale[c] = 1.0 / units.gyro_lsb_per_dps;
+    }
+    FILE *f = open_output(path);
+    write_npy_header(f, "<f8", "(" + std::to_string(rows) + ", " + std::to_string(cols) + ")");
+    constexpr size_t kBlockRows = 16384;
+    std::vector<double> buf(kBlockRows * cols);
+    for (size_t r0 = 0; r0 < rows; r0 += kBlockRows) {
+        size_t n = std::min(kBlockRows, rows - r0);
+        for (size_t c = 0; c < cols; c++) {
+            const int32_t *src = table.columns[c].data() + r0;
+            // numero_amostra é uint32 guardado em int32
+            bool is_unsigned = table.names[c] == "numero_amostra";
+            for (size_t r = 0; r < n; r++) {
+                buf[r * cols + c] = is_unsigned ? static_cast<double>(static_cast<uint32_t>(src[r])) : src[r] * scale[c];
+            }
+        }
+        fwrite(buf.data(), sizeof(double), n * cols, f);
+    }
+    close_output(f, path);
+}
+
+void write_npy_columns(const Table &table, const std::string &dir) {
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw std::runtime_error("não foi possível criar " + dir + ": " + std::strerror(errno));
+    }
+    for (size_t c = 0; c < table.columns.size(); c++) {
+        const auto &col = table.columns[c];
+        Dtype dt = narrowest(col, table.names[c] == "numero_amostra");
+        std::string path = dir + "/" + table.names[c] + ".npy";
+        FILE *f = open_output(path);
+        write_npy_header(f, dt.descr, "(" + std::to_string(col.size()) + ",)");
+        if (dt.size == 4) {
+            fwrite(col.data(), sizeof(int32_t), col.size(), f);
+        } else {
+            std::vector<int16_t> narrow(col.begin(), col.end());
+            fwrite(narrow.data(), sizeof(int16_t), narrow.size(), f);
+        }
+        close_output(f, path);
+    }
+}
+
+}  // namespace imulog
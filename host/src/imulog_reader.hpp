@@ -0,0 +1,126 @@
+/* imulog_reader.hpp
+Leitura rápida de logs do IMU no host: mapeia o arquivo (mmap), detecta CSV
+(cabeçalho numero_amostra,...; linhas "#" ignoradas), binário
+(SDLOGGER_BIN_MAGIC) ou comprimido (SDLOGGER_RICE_MAGIC, blocos de
+imucodec.c) e converte em colunas int32 em várias threads (CSV com um
+parser de inteiros SWAR). Erros são lançados como std::runtime_error.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sdlogger_format.h"
+
+namespace imulog {
+
+// Arquivo mapeado somente leitura (RAII)
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+enum class Format { Csv, Binary, Compressed };
+
+struct Table {
+    Format format = Format::Csv;
+    std::vector<std::string> names;             // nomes das colunas (cabeçalho)
+    std::vector<std::vector<int32_t>> columns;  // columns[c][linha]
+    std::vector<std::string> metadata;          // linhas "# ..." antes do cabeçalho, sem o "# "
+    uint64_t comment_lines = 0;                 // linhas "#" no meio dos dados
+    uint64_t bad_lines = 0;                     // linhas malformadas descartadas
+
+    size_t rows() const { return columns.empty() ? 0 : columns[0].size(); }
+    int column_index(const std::string &name) const;
+    // Valor do metadado "chave=valor" (vazio se ausente)
+    std::string meta(const std::string &key) const;
+};
+
+// Escalas do sensor nos metadados do firmware (imu_accel_lsb_g,
+// imu_giro_lsb_dps); logs sem elas usam o padrão do MPU6050 (+-2 g, +-250 graus/s)
+struct Units {
+    double accel_lsb_per_g = 16384.0;
+    double gyro_lsb_per_dps = 131.0;
+    bool from_metadata = false;
+};
+
+Units log_units(const Table &table);
+
+struct ReadOptions {
+    unsigned threads = 0;  // 0 = std::thread::hardware_concurrency()
+    // Faixa de bytes convertida por parse_log (início de registro), p.ex. de index_range()
+    uint64_t begin = 0;
+    uint64_t end = UINT64_MAX;
+};
+
+// Índice esparso gravado pelo sdlogger ao lado do log (nome do log + .idx)
+struct SampleIndex {
+    uint32_t interval = 0;
+    std::vector<sdlogger_idx_entry_t> entries;
+};
+
+std::string index_path(const std::string &log_path);
+// false se não há índice; lança std::runtime_error se o índice é inválido ou
+// se foi gravado para outro log (formato ou tamanho diferente)
+bool read_index(const std::string &log_path, SampleIndex &index);
+// Faixa de bytes [begin, end) que contém as amostras [first, last], com até
+// um intervalo do índice sobrando em cada ponta (busca binária nas entradas)
+std::pair<uint64_t, uint64_t> index_range(const SampleIndex &index, uint32_t first, uint32_t last);
+
+Table read_log(const std::string &path, const ReadOptions &options = {});
+Table parse_log(const char *data, size_t size, const ReadOptions &options = {});
+
+// Bloco de linhas consecutivas devolvido por BlockReader
+struct Block {
+    size_t first_row = 0;                       // índice global da primeira linha
+    std::vector<std::vector<int32_t>> columns;  // columns[c][linha]
+
+    size_t rows() const { return columns.empty() ? 0 : columns[0].size(); }
+};
+
+// Leitura em lotes com memória limitada, para arquivos maiores que a RAM:
+// cada next_batch() converte em paralelo os próximos blocos de ~block_bytes
+// (um por thread) e devolve ao kernel as páginas do mapa já consumidas.
+class BlockReader {
+public:
+    BlockReader(const MappedFile &file, const ReadOptions &options = {}, size_t block_bytes = 4u << 20);
+
+    // Formato, nomes e metadados; comment_lines e bad_lines acumulam a cada lote
+    const Table &info() const { return info_; }
+    unsigned threads() const { return threads_; }
+    // Próximo lote, em ordem; false quando o arquivo acabou
+    bool next_batch(std::vector<Block> &batch);
+
+private:
+    void release_consumed();
+
+    const char *data_, *pos_, *end_, *released_;
+    Table info_;
+    unsigned threads_;
+    size_t block_bytes_;
+    size_t rows_read_ = 0;
+    size_t record_size_ = 0;  // binário
+};
+
+// Escrita em .npy (formato 1.0, little-endian, C order)
+// Matriz N x C de int32: np.load() substitui np.loadtxt(..., skiprows=1)
+void write_npy_matrix(const Table &table, const std::string &path);
+// Um .npy por coluna em dir/<nome>.npy, com o menor dtype que comporta a coluna
+void write_npy_columns(const Table &table, const std::string &dir);
+// Matriz N x C de float64 com accel_* em g e giro_* em graus/s (demais colunas sem conversão)
+void write_npy_units(const Table &table, const Units &units, const std::string &path);
+
+}  // namespace imulog
@@ -0,0 +1,272 @@
+/* imupyramid.cpp
+Implementação de imupyramid.hpp. Cada lote do BlockReader é reduzido em
+paralelo (uma thread por bloco) a baldes do nível 0 alinhados ao índice
+global da linha; os baldes das pontas de cada bloco saem parciais e são
+completados na fusão serial, que sobe os níveis seguintes. Cada nível vai
+para um arquivo temporário ao lado da saída, concatenados no fim.
+*/
+#include "imupyramid.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace imulog {
+
+namespace {
+
+constexpr size_t kMaxAxes = 16;
+constexpr size_t kMaxLevels = 32;
+
+struct Acc {
+    uint64_t count;
+    uint32_t first_sample;
+    int32_t min[kMaxAxes];
+    int32_t max[kMaxAxes];
+    int64_t sum[kMaxAxes];
+};
+
+void merge(Acc &dst, const Acc &src, size_t axes) {
+    for (size_t a = 0; a < axes; a++) {
+        dst.min[a] = std::min(dst.min[a], src.min[a]);
+        dst.max[a] = std::max(dst.max[a], src.max[a]);
+        dst.sum[a] += src.sum[a];
+    }
+    dst.count += src.count;
+}
+
+// Baldes do nível 0 de um bloco; o primeiro e o último podem ser parciais
+void reduce_block(const Block &block, int sample_col, const std::vector<int> &axis_cols, uint32_t base,
+                  std::vector<Acc> &out) {
+    out.clear();
+    const size_t n = block.rows();
+    for (size_t r = 0; r < n;) {
+        const size_t take = std::min<size_t>(n - r, base - (block.first_row + r) % base);
+        Acc acc;
+        acc.count = take;
+        acc.first_sample = sample_col >= 0 ? static_cast<uint32_t>(block.columns[sample_col][r])
+                                           : static_cast<uint32_t>(block.first_row + r);
+        for (size_t a = 0; a < axis_cols.size(); a++) {
+            const int32_t *v = block.columns[axis_cols[a]].data() + r;
+            int32_t lo = v[0], hi = v[0];
+            int64_t sum = 0;
+            for (size_t i = 0; i < take; i++) {
+                lo = std::min(lo, v[i]);
+                hi = std::max(hi, v[i]);
+                sum += v[i];
+            }
+            acc.min[a] = lo;
+            acc.max[a] = hi;
+            acc.sum[a] = sum;
+        }
+        out.push_back(acc);
+        r += take;
+    }
+}
+
+// Mantém só as linhas de um sensor (logs com vários sensores intercalados)
+void keep_sensor(Block &block, int sensor_col, uint32_t sensor) {
+    const auto &ids = block.columns[sensor_col];
+    size_t out = 0;
+    for (size_t r = 0; r < ids.size(); r++) {
+        if (static_cast<uint32_t>(ids[r]) != sensor) continue;
+        for (auto &col : block.columns) col[out] = col[r];
+        out++;
+    }
+    for (auto &col : block.columns) col.resize(out);
+}
+
+class Builder {
+public:
+    Builder(const std::string &out_path, size_t axes, uint32_t base, uint32_t factor)
+        : out_path_(out_path), axes_(axes), base_(base), factor_(factor) {
+        levels_.reserve(kMaxLevels);
+        add_level(base);
+    }
+
+    ~Builder() {
+        for (auto &lv : levels_) {
+            if (lv.tmp) fclose(lv.tmp);
+        }
+    }
+
+    void push(size_t l, const Acc &acc) {
+        Level &lv = levels_[l];
+        if (lv.cur.count == 0) {
+            lv.cur = acc;
+        } else {
+            merge(lv.cur, acc, axes_);
+        }
+        if (lv.cur.count == lv.span) emit(l, true);
+    }
+
+    // Fecha os baldes parciais; um nível que só teria esse balde é o topo
+    void finish() {
+        for (size_t l = 0; l < levels_.size(); l++) {
+            if (levels_[l].cur.count) emit(l, levels_[l].count > 0);
+        }
+        size_t keep = 0;
+        while (keep < levels_.size() && levels_[keep].count > 1) keep++;
+        keep = std::min(keep + 1, levels_.size());
+        if (levels_[0].count == 0) keep = 0;
+        for (size_t l = keep; l < levels_.size(); l++) fclose(levels_[l].tmp);
+        levels_.resize(keep);
+    }
+
+    std::vector<PyramidLevel> write(const std::vector<std::string> &names, uint64_t rows) {
+        const size_t bucket = bucket_size();
+        PyramidHeader h{};
+        std::memcpy(h.magic, IMUPYR_MAGIC, sizeof h.magic);
+        h.header_size = static_cast<uint32_t>(sizeof h + axes_ * IMUPYR_NAME_LEN + levels_.size() * sizeof(PyramidLevel));
+        h.axes = static_cast<uint16_t>(axes_);
+        h.levels = static_cast<uint16_t>(levels_.size());
+        h.base = base_;
+        h.factor = factor_;
+        h.rows = rows;
+
+        std::vector<PyramidLevel> table;
+        uint64_t offset = h.header_size;
+        for (auto &lv : levels_) {
+            table.push_back({offset, lv.count, lv.span});
+            offset += lv.count * bucket;
+        }
+
+        FILE *f = fopen(out_path_.c_str(), "wb");
+        if (!f) throw std::runtime_error("não foi possível criar " + out_path_ + ": " + std::strerror(errno));
+        fwrite(&h, sizeof h, 1, f);
+        for (const auto &name : names) {
+            char buf[IMUPYR_NAME_LEN] = {0};
+            std::strncpy(buf, name.c_str(), sizeof buf - 1);
+            fwrite(buf, sizeof buf, 1, f);
+        }
+        fwrite(table.data(), sizeof(PyramidLevel), table.size(), f);
+
+        std::vector<char> copy(1u << 20);
+        for (auto &lv : levels_) {
+            rewind(lv.tmp);
+            size_t n;
+            while ((n = fread(copy.data(), 1, copy.size(), lv.tmp)) > 0) fwrite(copy.data(), 1, n, f);
+            if (ferror(lv.tmp)) f = (fclose(f), nullptr);
+            if (!f) break;
+        }
+        bool ok = f && !ferror(f);
+        if (f && fclose(f) != 0) ok = false;
+        if (!ok) throw std::runtime_error("falha ao gravar " + out_path_);
+        return table;
+    }
+
+private:
+    struct Level {
+        uint64_t span = 0;
+        uint64_t count = 0;
+        Acc cur{};
+        FILE *tmp = nullptr;
+    };
+
+    size_t bucket_size() const { return 8 + axes_ * 12; }
+
+    // Temporário no mesmo sistema de arquivos da saída, já desvinculado
+    void add_level(uint64_t span) {
+        std::string name = out_path_ + ".tmpXXXXXX";
+        int fd = mkstemp(&name[0]);
+        if (fd < 0) throw std::runtime_error("não foi possível criar " + name + ": " + std::strerror(errno));
+        unlink(name.c_str());
+        Level lv;
+        lv.span = span;
+        lv.tmp = fdopen(fd, "w+b");
+        levels_.push_back(lv);
+    }
+
+    void emit(size_t l, bool propagate) {
+        Acc acc = levels_[l].cur;
+        levels_[l].cur.count = 0;
+        levels_[l].count++;
+
+        uint32_t head[2] = {acc.first_sample, static_cast<uint32_t>(acc.count)};
+        float mean[kMaxAxes];
+        for (size_t a = 0; a < axes_; a++) {
+            mean[a] = static_cast<float>(static_cast<double>(acc.sum[a]) / static_cast<double>(acc.count));
+        }
+        FILE *f = levels_[l].tmp;
+        fwrite(head, sizeof head, 1, f);
+        fwrite(acc.min, sizeof(int32_t), axes_, f);
+        fwrite(acc.max, sizeof(int32_t), axes_, f);
+        fwrite(mean, sizeof(float), axes_, f);
+        if (ferror(f)) throw std::runtime_error("falha ao gravar o temporário de " + out_path_);
+
+        if (!propagate) return;
+        if (l + 1 == levels_.size()) {
+            // count do balde é uint32: níveis acima disso não são criados
+            uint64_t span = levels_[l].span * factor_;
+            if (levels_.size() == kMaxLevels || span > UINT32_MAX) return;
+            add_level(span);
+        }
+        push(l + 1, acc);
+    }
+
+    std::string out_path_;
+    size_t axes_;
+    uint32_t base_, factor_;
+    std::vector<Level> levels_;
+};
+
+}  // namespace
+
+PyramidStats build_pyramid(const std::string &log_path, const std::string &out_path, const PyramidOptions &options) {
+    if (options.base < 1 || options.factor < 2) throw std::runtime_error("base >= 1 e fator >= 2");
+    MappedFile file(log_path);
+    BlockReader reader(file, options.read, options.block_bytes);
+
+    // Eixos: todas as colunas menos numero_amostra e sensor
+    const Table &info = reader.info();
+    const int sample_col = info.column_index("numero_amostra");
+    const int sensor_col = info.column_index("sensor");
+    std::vector<int> axis_cols;
+    std::vector<std::string> axis_names;
+    for (size_t c = 0; c < info.names.size(); c++) {
+        if (static_cast<int>(c) == sample_col || static_cast<int>(c) == sensor_col) continue;
+        axis_cols.push_back(static_cast<int>(c));
+        axis_names.push_back(info.names[c]);
+    }
+    if (axis_cols.empty() || axis_cols.size() > kMaxAxes) {
+        throw std::runtime_error("número de eixos não suportado: " + std::to_string(axis_cols.size()));
+    }
+
+    Builder builder(out_path, axis_cols.size(), options.base, options.factor);
+    PyramidStats stats;
+    std::vector<Block> batch;
+    std::vector<std::vector<Acc>> reduced;
+    size_t kept = 0;  // linhas do sensor escolhido antes do bloco (alinha os baldes)
+    while (reader.next_batch(batch)) {
+        if (sensor_col >= 0) {
+            for (auto &b : batch) {
+                keep_sensor(b, sensor_col, options.sensor);
+                b.first_row = kept;
+                kept += b.rows();
+            }
+        }
+        reduced.resize(batch.size());
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < batch.size(); i++) {
+            workers.emplace_back(reduce_block, std::cref(batch[i]), sample_col, std::cref(axis_cols), options.base,
+                                 std::ref(reduced[i]));
+        }
+        for (auto &w : workers) w.join();
+        for (size_t i = 0; i < batch.size(); i++) {
+            stats.rows += batch[i].rows();
+            for (const Acc &acc : reduced[i]) builder.push(0, acc);
+        }
+    }
+    builder.finish();
+    stats.levels = builder.write(axis_names, stats.rows);
+    stats.info = reader.info();
+    return stats;
+}
+
+}  // namespace imulog
@@ -0,0 +1,65 @@
+/* imupyramid.hpp
+Pirâmide de pré-visualização de um log do IMU: para cada nível, baldes de
+base*fator^nível linhas consecutivas com mínimo, máximo e média de cada eixo.
+Gerada em uma única passada com memória limitada (BlockReader + um arquivo
+temporário por nível) e gravada num arquivo lateral "<log>.pyr", que um
+visualizador lê com memmap escolhendo o nível pelo zoom.
+
+Formato (little-endian):
+  PyramidHeader
+  axes  x char[16]      nomes dos eixos (NUL no fim)
+  levels x PyramidLevel
+  baldes de cada nível, na ordem da tabela:
+    uint32 first_sample, uint32 count, int32 min[axes], int32 max[axes], float mean[axes]
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "imulog_reader.hpp"
+
+namespace imulog {
+
+#define IMUPYR_MAGIC "IMUPYR01"
+#define IMUPYR_NAME_LEN 16
+
+#pragma pack(push, 1)
+struct PyramidHeader {
+    char magic[8];
+    uint32_t header_size;  // até o primeiro balde
+    uint16_t axes;
+    uint16_t levels;
+    uint32_t base;    // linhas por balde no nível 0
+    uint32_t factor;  // baldes do nível n por balde do nível n+1
+    uint64_t rows;
+};
+
+struct PyramidLevel {
+    uint64_t offset;  // em bytes, desde o início do arquivo
+    uint64_t count;   // baldes
+    uint64_t span;    // linhas por balde (o último pode ter menos)
+};
+#pragma pack(pop)
+
+struct PyramidOptions {
+    uint32_t base = 16;
+    uint32_t factor = 4;
+    size_t block_bytes = 4u << 20;  // por thread
+    uint32_t sensor = 0;            // logs com a coluna "sensor": o sensor resumido
+    ReadOptions read;
+};
+
+struct PyramidStats {
+    Table info;  // formato, nomes, metadados e linhas descartadas (sem colunas)
+    uint64_t rows = 0;
+    std::vector<PyramidLevel> levels;
+};
+
+// Lê log_path e grava a pirâmide em out_path; lança std::runtime_error em erro
+PyramidStats build_pyramid(const std::string &log_path, const std::string &out_path,
+                           const PyramidOptions &options = {});
+
+}  // namespace imulog
@@ -0,0 +1,540 @@
+/* sdsim.c
+Cartão SD simulado no nível do barramento SPI (ver sdsim.h). Cada byte
+trocado em host_spi_exchange chega em sdsim_exchange: o byte de MISO é
+decidido antes de interpretar o de MOSI, como num barramento full-duplex.
+Tempos são medidos em time_us_64(), que avança com o próprio barramento
+(8 bits / baudrate por byte) e com os custos do shim.
+*/
+#include <stdlib.h>
+#include <string.h>
+
+#include "crc.h"
+#include "pico/stdlib.h"
+
+#include "sdsim.h"
+
+/* R1 */
+#define R1_IDLE_STATE (1 << 0)
+#define R1_ILLEGAL_COMMAND (1 << 2)
+#define R1_COM_CRC_ERROR (1 << 3)
+#define R1_ADDRESS_ERROR (1 << 5)
+#define R1_PARAMETER_ERROR (1 << 6)
+
+/* Segundo byte do R2 (CMD13) */
+#define R2_ERROR (1 << 2)
+#define R2_OUT_OF_RANGE (1 << 7)
+
+/* Tokens */
+#define TOKEN_START_BLOCK 0xFE
+#define TOKEN_START_MULTI_WRITE 0xFC
+#define TOKEN_STOP_TRAN 0xFD
+#define TOKEN_ERROR_ECC 0x04
+#define TOKEN_ERROR_OUT_OF_RANGE 0x08
+#define DATA_ACCEPTED 0x05
+#define DATA_CRC_ERROR 0x0B
+#define DATA_WRITE_ERROR 0x0D
+
+#define OCR_POWER_UP_DONE (1u << 31)
+#define OCR_CCS (1u << 30)
+#define OCR_VOLTAGE_WINDOW 0x00FF8000u  // 2,7-3,6 V
+
+#define POWER_UP_CLOCKS 74
+
+typedef enum {
+    ST_POWER_ON,    // modo SD: só sai com CMD0 (CRC válido) após 74 clocks
+    ST_READY,       // aceita comandos
+    ST_READ_WAIT,   // tempo de acesso antes do próximo token de leitura
+    ST_WRITE_WAIT,  // aguarda token de dados (CMD24/CMD25)
+    ST_WRITE_DATA,  // recebendo bloco + CRC16
+} sdsim_state_t;
+
+typedef enum { READ_BLOCKS, READ_CSD, READ_CID } read_source_t;
+
+static sdsim_config_t cfg;
+static sdsim_stats_t stats;
+static uint8_t *image = NULL;
+static sd_card_t *card = NULL;
+static uint32_t fault_armed[SDSIM_FAULT_COUNT];
+
+static sdsim_state_t state = ST_POWER_ON;
+static uint32_t power_up_clocks = 0;
+static bool in_idle = true;
+static bool app_cmd = false;
+static bool crc_enabled = false;
+static bool acmd41_started = false;
+static uint64_t init_done_at = 0;
+static uint8_t status_r2 = 0;  // erros pendentes para o próximo CMD13
+
+static uint8_t cmd_buf[6];
+static int cmd_len = 0;
+
+static bool multi = false;
+static read_source_t read_source = READ_BLOCKS;
+static uint32_t block = 0;
+static uint64_t data_ready_at = 0;
+static uint64_t busy_until = 0;
+
+static uint8_t rx_buf[SDSIM_BLOCK_SIZE + 2];
+static int rx_len = 0;
+
+static uint8_t out_buf[SDSIM_BLOCK_SIZE + 16];
+static int out_pos = 0, out_len = 0;
+
+static uint8_t csd[16], cid[16];
+
+static uint64_t now_us(void) {
+    return time_us_64();
+}
+
+static bool take_fault(sdsim_fault_t fault) {
+    if (fault_armed[fault] == 0) return false;
+    fault_armed[fault]--;
+    stats.faults++;
+    return true;
+}
+
+static void queue_byte(uint8_t b) {
+    if (out_len < (int)sizeof(out_buf)) out_buf[out_len++] = b;
+}
+
+static void queue_reset(void) {
+    out_pos = out_len = 0;
+}
+
+static uint8_t r1_bits(void) {
+    return in_idle ? R1_IDLE_STATE : 0;
+}
+
+// Ncr bytes de espera seguidos do R1
+static void respond_r1(uint8_t r1) {
+    queue_reset();
+    for (int i = 0; i < cfg.ncr_bytes; i++) queue_byte(0xFF);
+    queue_byte(r1);
+}
+
+static void respond_u32(uint8_t r1, uint32_t v) {
+    respond_r1(r1);
+    queue_byte((uint8_t)(v >> 24));
+    queue_byte((uint8_t)(v >> 16));
+    queue_byte((uint8_t)(v >> 8));
+    queue_byte((uint8_t)v);
+}
+
+/* Registradores */
+
+static void set_bits(uint8_t *reg, int msb, int lsb, uint32_t value) {
+    for (int pos = lsb; pos <= msb; pos++) {
+        int byte = 15 - (pos >> 3);
+        int bit = pos & 7;
+        if (value & (1u << (pos - lsb))) reg[byte] |= (uint8_t)(1u << bit);
+        else reg[byte] &= (uint8_t)~(1u << bit);
+    }
+}
+
+static void seal_register(uint8_t *reg) {
+    reg[15] = (uint8_t)((crc7((const char *)reg, 15) << 1) | 1);
+}
+
+// Monta CSD/CID e ajusta cfg.sectors ao que o CSD consegue representar
+static void build_registers(void) {
+    memset(csd, 0, sizeof csd);
+    set_bits(csd, 119, 112, 0x0E);   // TAAC
+    set_bits(csd, 103, 96, 0x32);    // TRAN_SPEED: 25 MHz
+    set_bits(csd, 95, 84, 0x5B5);    // CCC
+    set_bits(csd, 83, 80, 9);        // READ_BL_LEN: 512
+    set_bits(csd, 46, 46, 1);        // ERASE_BLK_EN
+    set_bits(csd, 45, 39, 0x7F);     // SECTOR_SIZE
+    set_bits(csd, 25, 22, 9);        // WRITE_BL_LEN
+    if (cfg.type == SDSIM_SDHC) {
+        // CSD 2.0: blocos = (C_SIZE + 1) * 1024
+        uint32_t c_size = cfg.sectors / 1024u;
+        if (c_size == 0) c_size = 1;
+        cfg.sectors = c_size * 1024u;
+        set_bits(csd, 127, 126, 1);
+        set_bits(csd, 69, 48, c_size - 1);
+    } else {
+        // CSD 1.0: blocos = (C_SIZE + 1) * 2^(C_SIZE_MULT + 2), até 1 GiB com 512 B
+        uint32_t c_size = cfg.sectors / 512u;
+        if (c_size == 0) c_size = 1;
+        if (c_size > 4096) c_size = 4096;
+        cfg.sectors = c_size * 512u;
+        set_bits(csd, 127, 126, 0);
+        set_bits(csd, 73, 62, c_size - 1);
+        set_bits(csd, 49, 47, 7);
+    }
+    seal_register(csd);
+
+    memset(cid, 0, sizeof cid);
+    cid[0] = 0x03;  // MID
+    memcpy(&cid[1], "SD", 2);
+    memcpy(&cid[3], "SDSIM", 5);
+    cid[8] = 0x10;  // PRV 1.0
+    cid[9] = 0x12, cid[10] = 0x34, cid[11] = 0x56, cid[12] = 0x78;
+    cid[13] = 0x01, cid[14] = 0x8A;  // MDT
+    seal_register(cid);
+}
+
+/* Leitura */
+
+static void start_read(read_source_t source) {
+    read_source = source;
+    state = ST_READ_WAIT;
+    data_ready_at = now_us() + cfg.read_access_us;
+}
+
+// Coloca na fila o próximo token + dados + CRC16
+static void load_read_data(void) {
+    const uint8_t *src;
+    int len;
+    if (read_source == READ_BLOCKS) {
+        if (block >= cfg.sectors) {
+            queue_byte(TOKEN_ERROR_OUT_OF_RANGE);
+            status_r2 |= R2_OUT_OF_RANGE;
+            state = ST_READY;
+            multi = false;
+            return;
+        }
+        if (take_fault(SDSIM_FAULT_READ_TOKEN)) {
+            queue_byte(TOKEN_ERROR_ECC);
+            state = ST_READY;
+            multi = false;
+            return;
+        }
+        src = image + (size_t)block * SDSIM_BLOCK_SIZE;
+        len = SDSIM_BLOCK_SIZE;
+        stats.blocks_read++;
+    } else {
+        src = read_source == READ_CSD ? csd : cid;
+        len = 16;
+    }
+    uint16_t crc = crc16((const char *)src, len);
+    if (read_source == READ_BLOCKS && take_fault(SDSIM_FAULT_READ_CRC)) crc ^= 0x5A5A;
+    queue_reset();
+    queue_byte(TOKEN_START_BLOCK);
+    memcpy(out_buf + 1, src, (size_t)len);
+    out_len += len;
+    queue_byte((uint8_t)(crc >> 8));
+    queue_byte((uint8_t)crc);
+
+    if (read_source == READ_BLOCKS && multi) {
+        block++;
+        data_ready_at = 0;  // contado quando a fila esvaziar
+    } else {
+        state = ST_READY;
+    }
+}
+
+/* Escrita */
+
+static void finish_write_block(void) {
+    uint16_t crc_rx = (uint16_t)(rx_buf[SDSIM_BLOCK_SIZE] << 8 | rx_buf[SDSIM_BLOCK_SIZE + 1]);
+    uint8_t response;
+    uint32_t busy = 0;
+
+    if (crc_enabled && crc16((const char *)rx_buf, SDSIM_BLOCK_SIZE) != crc_rx) {
+        stats.crc_errors++;
+        response = DATA_CRC_ERROR;
+    } else if (take_fault(SDSIM_FAULT_WRITE_CRC)) {
+        response = DATA_CRC_ERROR;
+    } else if (block >= cfg.sectors) {
+        status_r2 |= R2_OUT_OF_RANGE;
+        response = DATA_WRITE_ERROR;
+    } else if (take_fault(SDSIM_FAULT_WRITE_ERROR)) {
+        status_r2 |= R2_ERROR;
+        response = DATA_WRITE_ERROR;
+        busy = cfg.write_busy_us;
+    } else {
+        memcpy(image + (size_t)block * SDSIM_BLOCK_SIZE, rx_buf, SDSIM_BLOCK_SIZE);
+        stats.blocks_written++;
+        response = DATA_ACCEPTED;
+        busy = multi ? cfg.multi_busy_us : cfg.write_busy_us;
+        if (take_fault(SDSIM_FAULT_BUSY_STALL)) busy = cfg.stall_us;
+        block++;
+    }
+    queue_reset();
+    queue_byte(0xE0 | response);
+    busy_until = now_us() + busy;
+    state = multi ? ST_WRITE_WAIT : ST_READY;
+}
+
+/* Comandos */
+
+// Traduz o argumento de CMD17/18/24/25; devolve o R1 (0 = aceito)
+static uint8_t decode_address(uint32_t arg) {
+    if (cfg.type == SDSIM_SDHC) {
+        block = arg;
+    } else {
+        if (arg % SDSIM_BLOCK_SIZE) return R1_ADDRESS_ERROR;
+        block = arg / SDSIM_BLOCK_SIZE;
+    }
+    return block < cfg.sectors ? 0 : R1_PARAMETER_ERROR;
+}
+
+static void execute_command(void) {
+    uint8_t idx = cmd_buf[0] & 0x3F;
+    uint32_t arg = (uint32_t)cmd_buf[1] << 24 | (uint32_t)cmd_buf[2] << 16 | (uint32_t)cmd_buf[3] << 8 | cmd_buf[4];
+    bool is_app = app_cmd;
+    bool crc_ok = cmd_buf[5] == (uint8_t)((crc7((const char *)cmd_buf, 5) << 1) | 1);
+    app_cmd = false;
+
+    stats.commands++;
+    if (is_app) stats.acmd[idx]++;
+    else stats.cmd[idx]++;
+
+    // Em modo SD o cartão só entende CMD0, que sempre confere o CRC
+    if (state == ST_POWER_ON) {
+        if (idx != 0 || !crc_ok || power_up_clocks < POWER_UP_CLOCKS) return;
+    }
+    if (take_fault(SDSIM_FAULT_NO_RESPONSE)) return;
+    if (!crc_ok && (crc_enabled || idx == 0 || idx == 8)) {
+        stats.crc_errors++;
+        respond_r1(r1_bits() | R1_COM_CRC_ERROR);
+        return;
+    }
+    if (take_fault(SDSIM_FAULT_CMD_CRC)) {
+        respond_r1(r1_bits() | R1_COM_CRC_ERROR);
+        return;
+    }
+
+    // CMD12 durante CMD18: descarta o bloco em curso, byte de enchimento, R1b
+    if (idx == 12) {
+        bool streaming = (state == ST_READ_WAIT && multi);
+        if (streaming) {
+            state = ST_READY;
+            multi = false;
+        }
+        queue_reset();
+        queue_byte(0xFF);
+        for (int i = 0; i < cfg.ncr_bytes; i++) queue_byte(0xFF);
+        queue_byte(r1_bits());
+        if (streaming) busy_until = now_us() + cfg.stop_busy_us;
+        return;
+    }
+
+    // No estado idle só os comandos de inicialização são aceitos
+    bool init_cmd = (idx == 0 || idx == 8 || idx == 13 || idx == 55 || idx == 58 || idx == 59 ||
+                     (is_app && idx == 41));
+    if (in_idle && !init_cmd) {
+        respond_r1(R1_IDLE_STATE | R1_ILLEGAL_COMMAND);
+        return;
+    }
+
+    switch (idx) {
+        case 0:
+            state = ST_READY;
+            in_idle = true;
+            crc_enabled = false;
+            acmd41_started = false;
+            multi = false;
+            status_r2 = 0;
+            respond_r1(R1_IDLE_STATE);
+            break;
+        case 8:
+            if (cfg.type == SDSIM_SDSC_V1) {
+                respond_r1(r1_bits() | R1_ILLEGAL_COMMAND);
+            } else {
+                respond_u32(r1_bits(), arg & 0xFFFu);  // R7: eco de VHS + padrão
+            }
+            break;
+        case 9:
+            respond_r1(r1_bits());
+            start_read(READ_CSD);
+            break;
+        case 10:
+            respond_r1(r1_bits());
+            start_read(READ_CID);
+            break;
+        case 13: {
+            uint8_t r2 = status_r2;
+            status_r2 = 0;
+            respond_r1(r1_bits());
+            queue_byte(r2);
+            break;
+        }
+        case 16:
+            if (cfg.type != SDSIM_SDHC && arg != SDSIM_BLOCK_SIZE) {
+                respond_r1(r1_bits() | R1_PARAMETER_ERROR);
+            } else {
+                respond_r1(r1_bits());
+            }
+            break;
+        case 17:
+        case 18:
+        case 24:
+        case 25: {
+            uint8_t err = decode_address(arg);
+            if (err) {
+                status_r2 |= R2_OUT_OF_RANGE;
+                respond_r1(r1_bits() | err);
+                break;
+            }
+            respond_r1(r1_bits());
+            multi = (idx == 18 || idx == 25);
+            if (idx == 17 || idx == 18) {
+                start_read(READ_BLOCKS);
+            } else {
+                state = ST_WRITE_WAIT;
+            }
+            break;
+        }
+        case 23:
+            // ACMD23 (pré-apagamento) é só uma dica; CMD23 não existe em SPI
+            respond_r1(r1_bits() | (is_app ? 0 : R1_ILLEGAL_COMMAND));
+            break;
+        case 41:
+            if (!is_app) {
+                respond_r1(r1_bits() | R1_ILLEGAL_COMMAND);
+                break;
+            }
+            if (!acmd41_started) {
+                acmd41_started = true;
+                init_done_at = now_us() + cfg.init_us;
+            }
+            // SDHC nunca sai de idle se o host não anunciar HCS
+            if (now_us() >= init_done_at && (cfg.type != SDSIM_SDHC || (arg & OCR_CCS))) {
+                in_idle = false;
+            }
+            respond_r1(r1_bits());
+            break;
+        case 55:
+            app_cmd = true;
+            respond_r1(r1_bits());
+            break;
+        case 58: {
+            uint32_t ocr = OCR_VOLTAGE_WINDOW;
+            if (!in_idle) {
+                ocr |= OCR_POWER_UP_DONE;
+                if (cfg.type == SDSIM_SDHC) ocr |= OCR_CCS;
+            }
+            respond_u32(r1_bits(), ocr);
+            break;
+        }
+        case 59:
+            crc_enabled = arg & 1;
+            respond_r1(r1_bits());
+            break;
+        default:
+            respond_r1(r1_bits() | R1_ILLEGAL_COMMAND);
+            break;
+    }
+}
+
+/* Barramento */
+
+static uint8_t next_output(void) {
+    if (out_pos < out_len) return out_buf[out_pos++];
+    queue_reset();
+    uint64_t now = now_us();
+    if (state == ST_READ_WAIT) {
+        if (data_ready_at == 0) data_ready_at = now + cfg.read_access_us;
+        if (now >= data_ready_at) {
+            load_read_data();
+            return out_pos < out_len ? out_buf[out_pos++] : 0xFF;
+        }
+        stats.wait_bytes++;
+        return 0xFF;
+    }
+    if (now < busy_until) {
+        stats.busy_bytes++;
+        return 0x00;
+    }
+    return 0xFF;
+}
+
+static void handle_input(uint8_t mosi) {
+    switch (state) {
+        case ST_WRITE_WAIT:
+            if (now_us() < busy_until) return;
+            if ((!multi && mosi == TOKEN_START_BLOCK) || (multi && mosi == TOKEN_START_MULTI_WRITE)) {
+                state = ST_WRITE_DATA;
+                rx_len = 0;
+            } else if (multi && mosi == TOKEN_STOP_TRAN) {
+                state = ST_READY;
+                multi = false;
+                queue_reset();
+                queue_byte(0xFF);
+                busy_until = now_us() + cfg.stop_busy_us;
+            }
+            return;
+        case ST_WRITE_DATA:
+            rx_buf[rx_len++] = mosi;
+            if (rx_len == (int)sizeof(rx_buf)) finish_write_block();
+            return;
+        default:
+            break;
+    }
+    if (cmd_len == 0 && (mosi & 0xC0) != 0x40) return;
+    cmd_buf[cmd_len++] = mosi;
+    if (cmd_len == (int)sizeof(cmd_buf)) {
+        cmd_len = 0;
+        execute_command();
+    }
+}
+
+static uint8_t sdsim_exchange(void *ctx, uint8_t mosi) {
+    (void)ctx;
+    // CS em nível alto: MISO em alta impedância, comando parcial descartado
+    if (gpio_get(card->ss_gpio)) {
+        if (power_up_clocks < POWER_UP_CLOCKS) power_up_clocks += 8;
+        cmd_len = 0;
+        return 0xFF;
+    }
+    stats.bytes++;
+    uint8_t miso = next_output();
+    handle_input(mosi);
+    return miso;
+}
+
+bool sdsim_attach(sd_card_t *pSD, const sdsim_config_t *config) {
+    sdsim_detach();
+    cfg = *config;
+    if (cfg.ncr_bytes < 1) cfg.ncr_bytes = 1;
+    if (cfg.ncr_bytes > 8) cfg.ncr_bytes = 8;
+    build_registers();
+    image = calloc(cfg.sectors, SDSIM_BLOCK_SIZE);
+    if (!image) return false;
+
+    card = pSD;
+    state = ST_POWER_ON;
+    power_up_clocks = 0;
+    in_idle = true;
+    app_cmd = false;
+    crc_enabled = false;
+    acmd41_started = false;
+    status_r2 = 0;
+    cmd_len = 0;
+    multi = false;
+    busy_until = 0;
+    queue_reset();
+    memset(fault_armed, 0, sizeof fault_armed);
+    sdsim_reset_stats();
+    host_spi_attach(pSD->spi->hw_inst, sdsim_exchange, NULL);
+    return true;
+}
+
+void sdsim_detach(void) {
+    if (card) host_spi_attach(card->spi->hw_inst, NULL, NULL);
+    card = NULL;
+    free(image);
+    image = NULL;
+}
+
+uint32_t sdsim_sectors(void) {
+    return image ? cfg.sectors : 0;
+}
+
+uint8_t *sdsim_image(void) {
+    return image;
+}
+
+void sdsim_inject(sdsim_fault_t fault, uint32_t count) {
+    if (fault < SDSIM_FAULT_COUNT) fault_armed[fault] = count;
+}
+
+sdsim_stats_t sdsim_get_stats(void) {
+    return stats;
+}
+
+void sdsim_reset_stats(void) {
+    memset(&stats, 0, sizeof(stats));
+}
@@ -0,0 +1,82 @@
+/* sdsim.h
+Simulador comportamental de cartão SD em modo SPI. Fica ligado ao spi_inst_t
+do cartão e responde byte a byte ao que sd_card.c envia: CMD0/8/9/10/12/13/
+16/17/18/24/25/55/58/59 e ACMD23/41, com tempos de acesso e de "busy" no
+relógio virtual, verificação de CRC7/CRC16, endereçamento por byte (SDSC) ou
+por bloco (SDHC) e injeção de falhas.
+*/
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sd_card.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SDSIM_BLOCK_SIZE 512
+
+typedef enum {
+    SDSIM_SDSC_V1 = 0,  // não reconhece CMD8; endereço em bytes
+    SDSIM_SDSC_V2,      // CMD8, CCS=0; endereço em bytes
+    SDSIM_SDHC          // CMD8, CCS=1; endereço em blocos
+} sdsim_card_type_t;
+
+typedef enum {
+    SDSIM_FAULT_NO_RESPONSE = 0,  // comando ignorado (R1 nunca chega)
+    SDSIM_FAULT_CMD_CRC,          // R1 com erro de CRC de comando
+    SDSIM_FAULT_READ_CRC,         // bloco lido sai com CRC16 corrompido
+    SDSIM_FAULT_READ_TOKEN,       // leitura responde token de erro (ECC)
+    SDSIM_FAULT_WRITE_CRC,        // bloco escrito rejeitado com 0x0B
+    SDSIM_FAULT_WRITE_ERROR,      // bloco escrito rejeitado com 0x0D
+    SDSIM_FAULT_BUSY_STALL,       // bloco escrito fica busy por stall_us
+    SDSIM_FAULT_COUNT
+} sdsim_fault_t;
+
+typedef struct {
+    sdsim_card_type_t type;
+    uint32_t sectors;           // capacidade em blocos (arredondada para o CSD)
+    uint32_t init_us;           // ACMD41 responde "idle" até este tempo passar
+    uint32_t read_access_us;    // comando de leitura -> token de dados
+    uint32_t write_busy_us;     // programação após CMD24
+    uint32_t multi_busy_us;     // busy entre blocos de CMD25
+    uint32_t stop_busy_us;      // busy após Stop Tran / CMD12
+    uint32_t stall_us;          // duração de SDSIM_FAULT_BUSY_STALL
+    uint8_t ncr_bytes;          // bytes 0xFF antes da resposta (1..8)
+} sdsim_config_t;
+
+#define SDSIM_CONFIG_DEFAULT                                                                      \
+    { .type = SDSIM_SDHC, .sectors = 64u * 2048u, .init_us = 50000, .read_access_us = 300,        \
+      .write_busy_us = 700, .multi_busy_us = 250, .stop_busy_us = 500, .stall_us = 150000,        \
+      .ncr_bytes = 1 }
+
+typedef struct {
+    uint64_t bytes;             // bytes trocados com CS ativo
+    uint64_t busy_bytes;        // 0x00 devolvidos enquanto ocupado
+    uint64_t wait_bytes;        // 0xFF devolvidos esperando dados de leitura
+    uint64_t commands;
+    uint64_t cmd[64];           // contagem por índice de comando
+    uint64_t acmd[64];
+    uint64_t blocks_read;
+    uint64_t blocks_written;
+    uint64_t crc_errors;        // CRC de comando ou de dados rejeitado
+    uint64_t faults;            // falhas injetadas que dispararam
+} sdsim_stats_t;
+
+// Cria a imagem (zerada) e liga o cartão ao SPI e ao CS de pSD
+bool sdsim_attach(sd_card_t *pSD, const sdsim_config_t *config);
+void sdsim_detach(void);
+uint32_t sdsim_sectors(void);
+uint8_t *sdsim_image(void);
+
+// Arma count ocorrências da falha (0 desarma)
+void sdsim_inject(sdsim_fault_t fault, uint32_t count);
+
+sdsim_stats_t sdsim_get_stats(void);
+void sdsim_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
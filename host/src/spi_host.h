@@ -0,0 +1,25 @@
+/* spi_host.h
+Controle do spi_transfer de host (spi_host.c).
+*/
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint64_t calls;  // chamadas de spi_transfer (sd_spi_write inclusive)
+    uint64_t bytes;
+} spi_host_stats_t;
+
+// Custo fixo por chamada de spi_transfer (preparação de DMA no RP2040)
+void spi_host_set_call_overhead_ns(uint32_t ns);
+
+spi_host_stats_t spi_host_get_stats(void);
+void spi_host_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,33 @@
+/* synthetic_imu.c
+Gerador de amostras sintéticas: 1 g em Z, vibração senoidal e ruído.
+*/
+#include <math.h>
+
+#include "synthetic_imu.h"
+
+void synthetic_imu_init(synthetic_imu_t *g, uint32_t seed) {
+    g->rng = seed ? seed : 1u;
+    g->n = 0;
+}
+
+static int16_t synthetic_noise(synthetic_imu_t *g, int amplitude) {
+    g->rng = g->rng * 1664525u + 1013904223u;
+    return (int16_t)((int)((g->rng >> 16) % (2u * amplitude + 1u)) - amplitude);
+}
+
+static int16_t synthetic_clip(double v) {
+    if (v > 32767.0) return 32767;
+    if (v < -32768.0) return -32768;
+    return (int16_t)v;
+}
+
+void synthetic_imu_next(synthetic_imu_t *g, int16_t accel[3], int16_t gyro[3]) {
+    double t = g->n++ * 0.001;
+    double vib = sin(2.0 * M_PI * 37.0 * t);
+    accel[0] = synthetic_clip(1200.0 * vib + synthetic_noise(g, 40));
+    accel[1] = synthetic_clip(-600.0 * vib + synthetic_noise(g, 40));
+    accel[2] = synthetic_clip(16384.0 + 300.0 * vib + synthetic_noise(g, 40));
+    gyro[0] = synthetic_clip(250.0 * sin(2.0 * M_PI * 1.3 * t) + synthetic_noise(g, 8));
+    gyro[1] = synthetic_clip(-35.0 + synthetic_noise(g, 8));
+    gyro[2] = synthetic_clip(12.0 + synthetic_noise(g, 8));
+}
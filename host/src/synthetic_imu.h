@@ -0,0 +1,23 @@
+/* synthetic_imu.h
+Gerador determinístico de amostras do MPU6050 (vibração + ruído) para
+ferramentas de host.
+*/
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t rng;
+    uint32_t n;
+} synthetic_imu_t;
+
+void synthetic_imu_init(synthetic_imu_t *g, uint32_t seed);
+void synthetic_imu_next(synthetic_imu_t *g, int16_t accel[3], int16_t gyro[3]);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,332 @@
+/* xfer_client.cpp
+Implementação de xfer_client.hpp sobre termios e poll(2). Os bytes da serial
+se acumulam num buffer: procura XFER_MAGIC, espera o quadro inteiro e confere
+o CRC; o que não fecha (texto do shell, quadro corrompido) custa um byte e
+uma nova busca.
+*/
+#include "xfer_client.hpp"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include "crc32.h"
+
+namespace imulog {
+
+namespace {
+
+constexpr size_t kHeaderSize = sizeof(xfer_header_t);
+constexpr int kHelloIntervalMs = 300;  // o shell leva alguns ms para trocar de modo
+constexpr size_t kNoiseMax = 256;
+constexpr int kListAttempts = 3;
+
+using Clock = std::chrono::steady_clock;
+
+Clock::time_point after_ms(int ms) {
+    return Clock::now() + std::chrono::milliseconds(ms);
+}
+
+int ms_until(Clock::time_point deadline) {
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+    return left > 0 ? static_cast<int>(left) : 0;
+}
+
+std::string errno_text(const std::string &what) {
+    return what + ": " + strerror(errno);
+}
+
+std::vector<uint8_t> path_payload(const std::string &path, size_t prefix = 0) {
+    if (prefix + path.size() > XFER_MAX_REQUEST) throw std::runtime_error(path + ": caminho longo demais");
+    std::vector<uint8_t> payload(prefix + path.size());
+    memcpy(payload.data() + prefix, path.data(), path.size());
+    return payload;
+}
+
+RemoteEntry to_entry(const xfer_entry_t &e, std::string name) {
+    RemoteEntry entry;
+    entry.name = std::move(name);
+    entry.size = e.size;
+    entry.fdate = e.fdate;
+    entry.ftime = e.ftime;
+    entry.attrib = e.attrib;
+    return entry;
+}
+
+}  // namespace
+
+const char *xfer_status_text(uint8_t status) {
+    switch (status) {
+        case XFER_ST_OK: return "ok";
+        case XFER_ST_EOF: return "fim";
+        case XFER_ST_NOT_FOUND: return "arquivo ou diretório inexistente";
+        case XFER_ST_IO_ERROR: return "erro de leitura no SD";
+        case XFER_ST_BAD_REQUEST: return "pedido inválido";
+        default: return "status desconhecido";
+    }
+}
+
+XferClient::XferClient(const std::string &port, int timeout_ms) : timeout_ms_(timeout_ms) {
+    fd_ = open(port.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (fd_ < 0) throw TransportError(errno_text(port));
+    termios tio{};
+    if (tcgetattr(fd_, &tio) != 0) {
+        std::string msg = errno_text(port);
+        close(fd_);
+        throw TransportError(msg);
+    }
+    cfmakeraw(&tio);
+    // HUPCL: o DTR cai ao fechar a porta, e o firmware volta ao shell
+    tio.c_cflag |= CLOCAL | CREAD | HUPCL;
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    cfsetspeed(&tio, B115200);  // ignorado pelo CDC
+    tcsetattr(fd_, TCSANOW, &tio);
+    tcflush(fd_, TCIOFLUSH);
+    try {
+        enter();
+    } catch (...) {
+        close(fd_);
+        throw;
+    }
+}
+
+XferClient::~XferClient() {
+    try {
+        bye();
+    } catch (const std::exception &) {
+        // O firmware também encerra a sessão quando o DTR cai
+    }
+    close(fd_);
+}
+
+//O comando vai pelo shell; o HELLO se repete até o firmware responder
+void XferClient::enter() {
+    static const char kCommand[] = "\r\nxfer\r\n";
+    if (write(fd_, kCommand, sizeof kCommand - 1) < 0) throw TransportError(errno_text("escrita na serial"));
+
+    const uint16_t seq = ++seq_;
+    const auto deadline = after_ms(timeout_ms_);
+    Frame frame;
+    while (ms_until(deadline) > 0) {
+        send_frame(XFER_HELLO, seq, 0, nullptr, 0);
+        const auto retry = std::min(deadline, after_ms(kHelloIntervalMs));
+        while (next_frame(frame, ms_until(retry))) {
+            if (frame.header.type != (XFER_HELLO | XFER_REPLY) || frame.header.seq != seq) continue;
+            if (frame.payload.size() < sizeof hello_) throw std::runtime_error("resposta HELLO curta");
+            memcpy(&hello_, frame.payload.data(), sizeof hello_);
+            if (hello_.version != XFER_VERSION) {
+                throw std::runtime_error("firmware com protocolo v" + std::to_string(hello_.version) +
+                                         ", cliente v" + std::to_string(XFER_VERSION));
+            }
+            in_session_ = true;
+            return;
+        }
+    }
+    std::string msg = "o datalogger não entrou no modo xfer";
+    if (!noise_.empty()) msg += " (resposta: \"" + noise_ + "\")";
+    throw TransportError(msg);
+}
+
+void XferClient::send_frame(uint8_t type, uint16_t seq, uint64_t offset, const void *payload, size_t len) {
+    std::vector<uint8_t> buf(kHeaderSize + len + XFER_CRC_SIZE);
+    xfer_header_t h{};
+    h.magic = XFER_MAGIC;
+    h.type = type;
+    h.seq = seq;
+    h.length = static_cast<uint16_t>(len);
+    h.offset = offset;
+    memcpy(buf.data(), &h, kHeaderSize);
+    if (len) memcpy(buf.data() + kHeaderSize, payload, len);
+    const uint32_t crc = crc32_update(0, buf.data(), kHeaderSize + len);
+    memcpy(buf.data() + kHeaderSize + len, &crc, XFER_CRC_SIZE);
+
+    const uint8_t *p = buf.data();
+    size_t left = buf.size();
+    while (left > 0) {
+        ssize_t n = write(fd_, p, left);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw TransportError(errno_text("escrita na serial"));
+        }
+        p += n;
+        left -= static_cast<size_t>(n);
+    }
+}
+
+bool XferClient::next_frame(Frame &frame, int timeout_ms) {
+    const auto deadline = after_ms(timeout_ms);
+    auto skip_byte = [this]() {
+        const char c = static_cast<char>(rx_[rx_start_++]);
+        if (std::isprint(static_cast<unsigned char>(c)) || c == ' ') {
+            if (noise_.size() >= kNoiseMax) noise_.erase(0, 1);
+            noise_ += c;
+        }
+    };
+    for (;;) {
+        while (rx_.size() - rx_start_ >= kHeaderSize) {
+            const uint8_t *p = rx_.data() + rx_start_;
+            xfer_header_t h;
+            memcpy(&h, p, kHeaderSize);
+            if (h.magic != XFER_MAGIC || h.length > XFER_MAX_PAYLOAD) {
+                skip_byte();
+                continue;
+            }
+            const size_t total = kHeaderSize + h.length + XFER_CRC_SIZE;
+            if (rx_.size() - rx_start_ < total) break;
+            uint32_t crc;
+            memcpy(&crc, p + kHeaderSize + h.length, XFER_CRC_SIZE);
+            if (crc != crc32_update(0, p, kHeaderSize + h.length)) {
+                stats_.crc_errors++;
+                skip_byte();
+                continue;
+            }
+            frame.header = h;
+            frame.payload.assign(p + kHeaderSize, p + kHeaderSize + h.length);
+            rx_start_ += total;
+            return true;
+        }
+        if (rx_start_ > 0 && rx_start_ * 2 >= rx_.size()) {
+            rx_.erase(rx_.begin(), rx_.begin() + static_cast<std::ptrdiff_t>(rx_start_));
+            rx_start_ = 0;
+        }
+
+        const int wait = ms_until(deadline);
+        if (wait == 0) return false;
+        pollfd pfd{fd_, POLLIN, 0};
+        int r = poll(&pfd, 1, wait);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            throw TransportError(errno_text("poll na serial"));
+        }
+        if (r == 0) return false;
+        if (!(pfd.revents & POLLIN)) throw TransportError("porta serial fechada (datalogger desconectado?)");
+        uint8_t buf[16384];
+        ssize_t n = ::read(fd_, buf, sizeof buf);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            throw TransportError(errno_text("leitura da serial"));
+        }
+        if (n == 0) throw TransportError("porta serial fechada (datalogger desconectado?)");
+        rx_.insert(rx_.end(), buf, buf + n);
+    }
+}
+
+XferClient::Frame XferClient::transact(uint8_t type, uint64_t offset, const std::vector<uint8_t> &payload) {
+    const uint16_t seq = ++seq_;
+    const auto deadline = after_ms(timeout_ms_);
+    Frame frame;
+    while (ms_until(deadline) > 0) {
+        send_frame(type, seq, offset, payload.data(), payload.size());
+        const auto retry = std::min(deadline, after_ms(XFER_RETRY_MS));
+        while (next_frame(frame, ms_until(retry))) {
+            if (frame.header.type == (type | XFER_REPLY) && frame.header.seq == seq) return frame;
+        }
+    }
+    throw TransportError("sem resposta do datalogger");
+}
+
+//Quadros da listagem numerados pelo offset; um perdido repete o pedido
+std::vector<RemoteEntry> XferClient::list(const std::string &dir) {
+    const std::vector<uint8_t> payload = path_payload(dir);
+    for (int attempt = 0; attempt < kListAttempts; attempt++) {
+        std::vector<RemoteEntry> entries;
+        Frame frame = transact(XFER_LIST, 0, payload);
+        const uint16_t seq = frame.header.seq;
+        for (uint64_t index = 0;; index++) {
+            const xfer_header_t &h = frame.header;
+            if (h.status != XFER_ST_OK && h.status != XFER_ST_EOF) {
+                throw std::runtime_error((dir.empty() ? "/" : dir) + ": " + xfer_status_text(h.status));
+            }
+            if (h.offset != index) break;
+            for (size_t pos = 0; pos < frame.payload.size();) {
+                xfer_entry_t e;
+                if (frame.payload.size() - pos < sizeof e) throw std::runtime_error("entrada de listagem truncada");
+                memcpy(&e, frame.payload.data() + pos, sizeof e);
+                pos += sizeof e;
+                if (frame.payload.size() - pos < e.name_len) throw std::runtime_error("entrada de listagem truncada");
+                entries.push_back(to_entry(e, std::string(reinterpret_cast<const char *>(frame.payload.data() + pos),
+                                                          e.name_len)));
+                pos += e.name_len;
+            }
+            if (h.status == XFER_ST_EOF) return entries;
+
+            bool got = false;
+            while ((got = next_frame(frame, timeout_ms_))) {
+                if (frame.header.type == (XFER_LIST | XFER_REPLY) && frame.header.seq == seq) break;
+            }
+            if (!got) break;
+        }
+    }
+    throw TransportError("listagem com quadros perdidos");
+}
+
+RemoteEntry XferClient::stat(const std::string &path) {
+    Frame frame = transact(XFER_STAT, 0, path_payload(path));
+    if (frame.header.status != XFER_ST_OK) throw std::runtime_error(path + ": " + xfer_status_text(frame.header.status));
+    xfer_entry_t e;
+    if (frame.payload.size() < sizeof e) throw std::runtime_error("resposta STAT curta");
+    memcpy(&e, frame.payload.data(), sizeof e);
+    return to_entry(e, path);
+}
+
+//Confirma cada quadro em ordem. Um quadro adiante do esperado (o anterior se
+//perdeu ou falhou no CRC) gera um NAK por lacuna; se o NAK também se perder,
+//o firmware volta ao último ACK depois de XFER_RETRY_MS. Quadros repetidos
+//são descartados e reconfirmados.
+uint64_t XferClient::read(const std::string &path, uint64_t offset, uint64_t length, const Sink &sink) {
+    std::vector<uint8_t> payload = path_payload(path, sizeof(xfer_read_t));
+    xfer_read_t req{length};
+    memcpy(payload.data(), &req, sizeof req);
+
+    Frame frame = transact(XFER_READ, offset, payload);
+    const uint16_t seq = frame.header.seq;
+    uint64_t expected = offset;
+    uint64_t nak_offset = XFER_READ_TO_END;  // lacuna já pedida
+    for (;;) {
+        const xfer_header_t &h = frame.header;
+        if (h.type == (XFER_READ | XFER_REPLY) && h.seq == seq) {
+            if (h.status != XFER_ST_OK && h.status != XFER_ST_EOF) {
+                throw std::runtime_error(path + ": " + xfer_status_text(h.status));
+            }
+            if (h.offset == expected) {
+                if (h.status == XFER_ST_EOF) {
+                    send_frame(XFER_ACK, seq, expected, nullptr, 0);
+                    return expected;
+                }
+                sink(expected, frame.payload.data(), frame.payload.size());
+                expected += frame.payload.size();
+                stats_.bytes += frame.payload.size();
+                send_frame(XFER_ACK, seq, expected, nullptr, 0);
+                nak_offset = XFER_READ_TO_END;
+            } else if (h.offset > expected) {
+                if (nak_offset != expected) {
+                    send_frame(XFER_NAK, seq, expected, nullptr, 0);
+                    nak_offset = expected;
+                    stats_.naks++;
+                }
+            } else {
+                stats_.duplicates++;
+                send_frame(XFER_ACK, seq, expected, nullptr, 0);
+            }
+        }
+        if (!next_frame(frame, timeout_ms_)) {
+            throw TransportError("leitura interrompida no byte " + std::to_string(expected));
+        }
+    }
+}
+
+void XferClient::bye() {
+    if (!in_session_) return;
+    in_session_ = false;
+    transact(XFER_BYE, 0, {});
+}
+
+}  // namespace imulog
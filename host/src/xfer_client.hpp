@@ -0,0 +1,95 @@
+/* xfer_client.hpp
+Cliente do protocolo de transferência do firmware (inc/xfer_protocol.h) pela
+serial USB (CDC, /dev/ttyACM*): manda "xfer" ao shell, e então lista,
+consulta e lê faixas de arquivos do SD conferindo o CRC de cada quadro,
+confirmando com ACK e pedindo reenvio com NAK. Falhas de transporte (porta
+fechada, datalogger mudo) são lançadas como TransportError, para quem chama
+reabrir a porta e retomar a leitura do último offset salvo; as demais, como
+std::runtime_error.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "xfer_protocol.h"
+
+namespace imulog {
+
+class TransportError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+struct RemoteEntry {
+    std::string name;
+    uint64_t size = 0;
+    uint16_t fdate = 0;  // formato do FAT
+    uint16_t ftime = 0;
+    uint8_t attrib = 0;
+
+    bool is_dir() const { return attrib & 0x10; }
+};
+
+struct XferStats {
+    uint64_t bytes = 0;        // dados entregues em ordem
+    uint32_t crc_errors = 0;   // quadros descartados pelo CRC
+    uint32_t naks = 0;
+    uint32_t duplicates = 0;   // quadros reenviados que já tinham chegado
+};
+
+class XferClient {
+public:
+    // Abre a porta em modo raw e inicia a sessão; timeout_ms é o tempo sem
+    // resposta do datalogger até desistir
+    explicit XferClient(const std::string &port, int timeout_ms = 3000);
+    ~XferClient();  // encerra a sessão (BYE) e fecha a porta
+    XferClient(const XferClient &) = delete;
+    XferClient &operator=(const XferClient &) = delete;
+
+    std::vector<RemoteEntry> list(const std::string &dir);
+    RemoteEntry stat(const std::string &path);
+
+    // Recebe os dados de [offset, offset + length) em ordem, em pedaços de
+    // até max_payload bytes; length = XFER_READ_TO_END lê até o fim.
+    // Retorna o offset depois do último byte entregue.
+    using Sink = std::function<void(uint64_t offset, const uint8_t *data, size_t len)>;
+    uint64_t read(const std::string &path, uint64_t offset, uint64_t length, const Sink &sink);
+
+    void bye();
+
+    const xfer_hello_t &hello() const { return hello_; }
+    const XferStats &stats() const { return stats_; }
+
+private:
+    struct Frame {
+        xfer_header_t header;
+        std::vector<uint8_t> payload;
+    };
+
+    void enter();
+    void send_frame(uint8_t type, uint16_t seq, uint64_t offset, const void *payload, size_t len);
+    // Próximo quadro válido em até timeout_ms; false se o tempo acabou
+    bool next_frame(Frame &frame, int timeout_ms);
+    // Envia o pedido e espera a resposta, reenviando a cada XFER_RETRY_MS
+    Frame transact(uint8_t type, uint64_t offset, const std::vector<uint8_t> &payload);
+
+    int fd_ = -1;
+    int timeout_ms_;
+    bool in_session_ = false;
+    uint16_t seq_ = 0;
+    std::vector<uint8_t> rx_;
+    size_t rx_start_ = 0;
+    std::string noise_;        // texto fora de quadros (resposta do shell), para diagnóstico
+    xfer_hello_t hello_{};
+    XferStats stats_;
+};
+
+// Descrição de um xfer_status_t
+const char *xfer_status_text(uint8_t status);
+
+}  // namespace imulog
@@ -0,0 +1,248 @@
+/* host_logger.c
+Executa uma sessão de log completa (mkfs, mount, sdlogger_start/log/stop)
+sobre uma imagem de disco no host e mede o custo por registro.
+
+Uso: host_logger [-i imagem] [-s MiB] [-n amostras] [-f arquivo] [-k] [-p amostra] [-e gatilho] [-w pre:pos]
+                   [-F pontos] [-O quat|euler] [-D fator]
+  -i  imagem em arquivo (padrão: RAM)
+  -s  tamanho da imagem em MiB (padrão: 64)
+  -n  número de amostras sintéticas (padrão: 100000)
+  -f  nome do arquivo de log (padrão: imu_data.csv)
+  -k  mantém o sistema de arquivos existente (não formata)
+  -p  depois do log, busca a amostra pelo índice (sdlogger_seek) e mede o custo
+  -e  captura por eventos (capture.c) em vez do log contínuo; gatilho
+      eixo<n>:limiar, mag:limiar ou giro:limiar (ex.: eixo3:240)
+  -w  janela do evento em amostras antes e depois do disparo (padrão: 500:1000)
+  -F  espectro (spectrum.c) junto com o log, FFT de 256 ou 512 pontos; o sinal
+      sintético é tratado como amostrado a 1 kHz
+  -O  orientação (orientation.c) junto com o log, a cada 10 amostras
+  -D  decimação (decimator.c) antes do log: grava 1 de cada 'fator' amostras
+      filtradas
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ff.h"
+#include "f_util.h"
+#include "hw_config.h"
+#include "pico/stdlib.h"
+
+#include "../../inc/capture.h"
+#include "../../inc/decimator.h"
+#include "../../inc/sdlogger.h"
+#include "../../inc/orientation.h"
+#include "../../inc/spectrum.h"
+#include "hostdisk.h"
+#include "synthetic_imu.h"
+
+int main(int argc, char *argv[]) {
+    const char *image = NULL;
+    const char *filename = "imu_data.csv";
+    uint64_t size_mib = 64;
+    uint32_t samples = 100000;
+    bool keep = false;
+    uint32_t seek_sample = 0;
+    bool events = false;
+    capture_trigger_t trigger = *capture_get_trigger();
+    uint32_t pre = CAPTURE_PRE_DEFAULT, post = CAPTURE_POST_DEFAULT;
+    const char *usage = "Uso: %s [-i imagem] [-s MiB] [-n amostras] [-f arquivo] [-k] [-p amostra] "
+                        "[-e gatilho] [-w pre:pos] [-F pontos] [-O quat|euler] [-D fator]\n";
+    uint16_t fft_points = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "i:s:n:f:kp:e:w:F:O:D:")) != -1) {
+        switch (opt) {
+            case 'i': image = optarg; break;
+            case 's': size_mib = strtoull(optarg, NULL, 10); break;
+            case 'n': samples = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'f': filename = optarg; break;
+            case 'k': keep = true; break;
+            case 'p': seek_sample = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'e': {
+                const char *colon = strchr(optarg, ':');
+                events = true;
+                trigger.threshold = colon ? (uint16_t)strtoul(colon + 1, NULL, 10) : 0;
+                if (strncmp(optarg, "eixo", 4) == 0) {
+                    trigger.type = CAPTURE_TRIGGER_AXIS;
+                    trigger.axis = (uint8_t)strtoul(optarg + 4, NULL, 10);
+                } else if (strncmp(optarg, "mag", 3) == 0) {
+                    trigger.type = CAPTURE_TRIGGER_ACCEL_MAG;
+                } else if (strncmp(optarg, "giro", 4) == 0) {
+                    trigger.type = CAPTURE_TRIGGER_GYRO_MAG;
+                } else {
+                    trigger.threshold = 0;
+                }
+                if (trigger.threshold == 0) {
+                    fprintf(stderr, "Gatilho inválido: %s\n", optarg);
+                    return 2;
+                }
+                break;
+            }
+            case 'w':
+                pre = (uint32_t)strtoul(optarg, NULL, 10);
+                post = strchr(optarg, ':') ? (uint32_t)strtoul(strchr(optarg, ':') + 1, NULL, 10) : post;
+                break;
+            case 'F': fft_points = (uint16_t)strtoul(optarg, NULL, 10); break;
+            case 'O':
+                orientation_set_output(strcmp(optarg, "quat") == 0 ? ORIENT_QUATERNION : ORIENT_EULER);
+                break;
+            case 'D':
+                if (!decimator_set_factor((uint8_t)strtoul(optarg, NULL, 10))) return 2;
+                break;
+            default:
+                fprintf(stderr, usage, argv[0]);
+                return 2;
+        }
+    }
+    if (events && (!capture_set_trigger(&trigger) || !capture_set_window(pre, post))) return 2;
+    if (fft_points && (!spectrum_set_points(fft_points) || !spectrum_set_mode(SPECTRUM_WITH_RAW))) return 2;
+
+    if (!hostdisk_open(image, size_mib * 1024u * 1024u)) {
+        fprintf(stderr, "Falha ao abrir a imagem de disco\n");
+        return 1;
+    }
+
+    const char *drive = sd_get_by_num(0)->pcName;
+    FATFS *fs = &sd_get_by_num(0)->fatfs;
+    if (!keep) {
+        static BYTE work[FF_MAX_SS * 4];
+        FRESULT fr = f_mkfs(drive, 0, work, sizeof work);
+        if (fr != FR_OK) {
+            fprintf(stderr, "f_mkfs: %s (%d)\n", FRESULT_str(fr), fr);
+            return 1;
+        }
+    }
+    FRESULT fr = f_mount(fs, drive, 1);
+    if (fr != FR_OK) {
+        fprintf(stderr, "f_mount: %s (%d)\n", FRESULT_str(fr), fr);
+        return 1;
+    }
+
+    if (!events) decimator_start();
+    if (events ? !capture_arm(filename) : !sdlogger_start(filename)) return 1;
+    if (fft_points && !spectrum_start(filename, 1000)) return 1;
+    if (orientation_get_output() != ORIENT_OFF && !orientation_start(filename, 1000)) return 1;
+    uint64_t spectrum_us = 0, orientation_us = 0, decimator_us = 0;
+    uint32_t logged_samples = 0;
+    hostdisk_reset_stats();
+
+    synthetic_imu_t gen;
+    synthetic_imu_init(&gen, 1);
+    int16_t accel[3], gyro[3];
+
+    uint64_t start = time_us_64();
+    for (uint32_t i = 1; i <= samples; i++) {
+        synthetic_imu_next(&gen, accel, gyro);
+        bool ok = true;
+        if (events) {
+            ok = capture_process(i, accel, gyro);
+        } else if (decimator_is_active()) {
+            int16_t out_accel[3], out_gyro[3];
+            uint64_t t0 = time_us_64();
+            bool ready = decimator_process(0, accel, gyro, out_accel, out_gyro);
+            decimator_us += time_us_64() - t0;
+            if (ready) {
+                ok = sdlogger_log_sample(i, out_accel, out_gyro);
+                logged_samples++;
+            }
+        } else {
+            ok = sdlogger_log_sample(i, accel, gyro);
+            logged_samples++;
+        }
+        if (fft_points) {
+            uint64_t t0 = time_us_64();
+            ok = spectrum_process(i, accel) && ok;
+            spectrum_us += time_us_64() - t0;
+        }
+        if (orientation_is_active()) {
+            uint64_t t0 = time_us_64();
+            ok = orientation_process(i, accel, gyro) && ok;
+            orientation_us += time_us_64() - t0;
+        }
+        if (!ok) {
+            fprintf(stderr, "Falha na amostra %u\n", i);
+            break;
+        }
+    }
+    uint64_t logged = time_us_64();
+    if (events) {
+        capture_disarm();
+    } else {
+        sdlogger_stop();
+    }
+    bool decimated = decimator_is_active();
+    decimator_stop();
+    spectrum_stop();
+    bool orientation = orientation_is_active();
+    if (orientation) orientation_print_status();
+    orientation_stop();
+    uint64_t stopped = time_us_64();
+
+    hostdisk_stats_t st = hostdisk_get_stats();
+    FILINFO fno;
+    f_stat(filename, &fno);
+    if (events) {
+        // Soma dos arquivos de evento (<base>_eNNN<ext>)
+        DIR dj;
+        FSIZE_t total = 0;
+        FRESULT res = f_findfirst(&dj, &fno, "", "*_e*");
+        while (res == FR_OK && fno.fname[0]) {
+            total += fno.fsize;
+            res = f_findnext(&dj, &fno);
+        }
+        f_closedir(&dj);
+        fno.fsize = total;
+        printf("eventos:             %u\n", capture_event_count());
+    }
+
+    printf("amostras:            %u\n", samples);
+    if (decimated) {
+        printf("gravadas:            %u (decimação 1:%u)\n", logged_samples, decimator_get_factor());
+        printf("decimação:           %.0f ns/amostra de entrada\n", samples ? decimator_us * 1000.0 / samples : 0.0);
+    }
+    printf("bytes no arquivo:    %llu (%.1f B/amostra)\n", (unsigned long long)fno.fsize,
+           samples ? (double)fno.fsize / samples : 0.0);
+    printf("tempo de log:        %.3f ms (%.0f ns/amostra)\n", (logged - start) / 1000.0,
+           samples ? (logged - start) * 1000.0 / samples : 0.0);
+    printf("tempo de stop:       %.3f ms\n", (stopped - logged) / 1000.0);
+    printf("escritas no disco:   %llu chamadas, %llu setores (%.2f setores/1000 amostras)\n",
+           (unsigned long long)st.write_calls, (unsigned long long)st.sectors_written,
+           samples ? st.sectors_written * 1000.0 / samples : 0.0);
+    printf("leituras do disco:   %llu chamadas, %llu setores\n",
+           (unsigned long long)st.read_calls, (unsigned long long)st.sectors_read);
+
+    if (fft_points) {
+        printf("espectro:            %.0f ns/amostra\n", samples ? spectrum_us * 1000.0 / samples : 0.0);
+        spectrum_print_status();
+    }
+
+    if (orientation) {
+        printf("orientação:          %.0f ns/amostra\n", samples ? orientation_us * 1000.0 / samples : 0.0);
+    }
+
+    if (seek_sample) {
+        // Custo de chegar a uma amostra: índice + fast seek + no máximo um intervalo lido
+        FIL f;
+        char line[128] = "";
+        hostdisk_reset_stats();
+        uint64_t t0 = time_us_64();
+        fr = f_open(&f, filename, FA_READ);
+        if (fr == FR_OK) fr = sdlogger_seek(&f, filename, SDLOGGER_SEEK_SAMPLE, seek_sample);
+        if (fr == FR_OK && !f_gets(line, sizeof line, &f)) strcpy(line, "(fim do arquivo)\n");
+        uint64_t t1 = time_us_64();
+        f_close(&f);
+        st = hostdisk_get_stats();
+        if (fr != FR_OK) {
+            fprintf(stderr, "sdlogger_seek: %s (%d)\n", FRESULT_str(fr), fr);
+            return 1;
+        }
+        printf("busca da amostra %u: %.3f ms, %llu setores lidos -> %s", seek_sample, (t1 - t0) / 1000.0,
+               (unsigned long long)st.sectors_read, line);
+    }
+
+    f_unmount(drive);
+    hostdisk_close();
+    return 0;
+}
@@ -0,0 +1,185 @@
+/* imucodec_roundtrip.c
+Confere que imucodec_decode devolve exatamente o que imucodec_encode
+recebeu, em sequências escolhidas para passar pelos caminhos raros do
+codificador: o escape de 24 uns com o valor em binário (17 bits nos eixos,
+32 no número da amostra), o bloco que fecha sem a amostra que não coube
+(e a reabre no próximo), o fechamento em IMUCODEC_MAX_SAMPLES e lacunas e
+repetições na numeração. Cada cenário também confere que o caminho que ele
+deveria exercitar apareceu nos blocos; a saída é 1 se algum divergir.
+
+Uso: imucodec_roundtrip [-n amostras]
+  -n  amostras por cenário (padrão: 20000)
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../../inc/imucodec.h"
+
+// O que cada cenário precisa exercitar, conferido pelos blocos gerados
+enum {
+    EXPECT_FULL = 1 << 0,      // bloco fechado em IMUCODEC_MAX_SAMPLES
+    EXPECT_ROLLBACK = 1 << 1,  // bloco fechado antes por falta de espaço
+};
+
+typedef struct {
+    const char *name;
+    void (*generate)(uint32_t i, imucodec_sample_t *s);
+    unsigned expect;
+} scenario_t;
+
+static uint32_t next_sample;
+
+static int16_t random_int16(void) {
+    return (int16_t)(lrand48() & 0xFFFF);
+}
+
+// Sensor parado: diferenças nulas, o bloco enche em IMUCODEC_MAX_SAMPLES
+static void gen_still(uint32_t i, imucodec_sample_t *s) {
+    s->sample = i;
+    for (int a = 0; a < IMUCODEC_AXES; a++) s->axis[a] = (int16_t)(100 * a - 250);
+}
+
+// Degraus de fundo de escala: diferenças de ±65535 só cabem no escape de 17 bits
+static void gen_full_scale(uint32_t i, imucodec_sample_t *s) {
+    s->sample = i;
+    for (int a = 0; a < IMUCODEC_AXES; a++) {
+        bool high = ((i >> (a % 3)) ^ (uint32_t)a) & 1;
+        s->axis[a] = high ? 32767 : -32768;
+    }
+}
+
+// Ruído uniforme em int16: blocos curtos, que fecham sem a última amostra
+static void gen_noise(uint32_t i, imucodec_sample_t *s) {
+    s->sample = i;
+    for (int a = 0; a < IMUCODEC_AXES; a++) s->axis[a] = random_int16();
+}
+
+// Quase parado com rajadas: blocos cheios entre elas e curtos durante
+static void gen_bursts(uint32_t i, imucodec_sample_t *s) {
+    s->sample = i;
+    bool burst = (i / 500) % 4 == 3;
+    for (int a = 0; a < IMUCODEC_AXES; a++) {
+        int32_t v = 20 * a + (int32_t)((i / 32) & 1);
+        if (burst) v += (int32_t)(lrand48() % 60001) - 30000;
+        s->axis[a] = (int16_t)v;
+    }
+}
+
+// Numeração com lacunas (pequenas, além de 24 uns e de 2^31), repetições e
+// volta por cima de 2^32: o canal 0 passa pelo escape de 32 bits
+static void gen_sample_gaps(uint32_t i, imucodec_sample_t *s) {
+    static const uint32_t steps[] = { 1, 1, 2, 0, 1, 30, 1, 70000, 1, 0x7FFFFFFFu, 1, 0x80000001u, 1, 5 };
+    if (i == 0) next_sample = 0xFFFFFF00u;
+    s->sample = next_sample;
+    next_sample += steps[i % (sizeof steps / sizeof steps[0])];
+    for (int a = 0; a < IMUCODEC_AXES; a++) s->axis[a] = (int16_t)(((i / 7) % 2) ? -1000 * a : 1000 * a);
+}
+
+static const scenario_t scenarios[] = {
+    { "parado", gen_still, EXPECT_FULL },
+    { "fundo de escala", gen_full_scale, EXPECT_ROLLBACK },
+    { "ruído int16", gen_noise, EXPECT_ROLLBACK },
+    { "rajadas", gen_bursts, EXPECT_FULL | EXPECT_ROLLBACK },
+    { "lacunas na numeração", gen_sample_gaps, EXPECT_ROLLBACK },
+};
+
+// Nome alinhado em colunas, contando caracteres UTF-8 e não bytes
+static void print_name(const char *name, int width) {
+    int chars = 0;
+    for (const char *p = name; *p; p++) chars += ((unsigned char)*p & 0xC0) != 0x80;
+    printf("%s%*s", name, width > chars ? width - chars : 0, "");
+}
+
+static bool same_sample(const imucodec_sample_t *a, const imucodec_sample_t *b) {
+    return a->sample == b->sample && memcmp(a->axis, b->axis, sizeof(a->axis)) == 0;
+}
+
+// Decodifica um bloco e compara com a entrada a partir de *pos
+static bool check_block(const uint8_t *block, const imucodec_sample_t *input, uint32_t total, uint32_t *pos,
+                        uint32_t *full, uint32_t *short_blocks) {
+    static imucodec_sample_t decoded[IMUCODEC_MAX_SAMPLES];
+    int n = imucodec_decode(block, decoded, IMUCODEC_MAX_SAMPLES);
+    if (n <= 0 || *pos + (uint32_t)n > total) {
+        printf("  bloco inválido na amostra %lu (decode = %d)\n", (unsigned long)*pos, n);
+        return false;
+    }
+    for (int i = 0; i < n; i++) {
+        if (!same_sample(&decoded[i], &input[*pos + i])) {
+            printf("  amostra %lu: decodificada #%lu, esperada #%lu\n", (unsigned long)(*pos + i),
+                   (unsigned long)decoded[i].sample, (unsigned long)input[*pos + i].sample);
+            return false;
+        }
+    }
+    *pos += (uint32_t)n;
+    if (n == IMUCODEC_MAX_SAMPLES) {
+        (*full)++;
+    } else if (*pos < total) {
+        (*short_blocks)++;  // não é o bloco do flush: fechou por falta de espaço
+    }
+    return true;
+}
+
+static bool run_scenario(const scenario_t *sc, imucodec_sample_t *input, uint32_t total) {
+    static imucodec_encoder_t enc;
+    srand48(37);
+    for (uint32_t i = 0; i < total; i++) sc->generate(i, &input[i]);
+
+    imucodec_encoder_init(&enc);
+    uint32_t pos = 0, blocks = 0, full = 0, short_blocks = 0;
+    bool ok = true;
+    for (uint32_t i = 0; ok && i <= total; i++) {
+        // O bloco devolvido vale até a próxima chamada: confere na hora
+        const uint8_t *block;
+        if (i < total) {
+            const int16_t *axis = input[i].axis;
+            block = imucodec_encode(&enc, input[i].sample, axis, axis + 3);
+        } else {
+            block = imucodec_flush(&enc);
+        }
+        if (!block) continue;
+        blocks++;
+        ok = check_block(block, input, total, &pos, &full, &short_blocks);
+    }
+    if (ok && pos != total) {
+        printf("  %lu de %lu amostras decodificadas\n", (unsigned long)pos, (unsigned long)total);
+        ok = false;
+    }
+    bool covered = (!(sc->expect & EXPECT_FULL) || full > 0) &&
+                   (!(sc->expect & EXPECT_ROLLBACK) || short_blocks > 0);
+    print_name(sc->name, 22);
+    printf("%lu amostras em %lu blocos (%lu cheios, %lu fechados sem espaço)%s%s\n", (unsigned long)total,
+           (unsigned long)blocks, (unsigned long)full, (unsigned long)short_blocks, ok ? "" : "  [DIVERGENTE]",
+           ok && !covered ? "  [CAMINHO NÃO EXERCITADO]" : "");
+    return ok && covered;
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t total = 20000;
+    int c;
+    while ((c = getopt(argc, argv, "n:")) != -1) {
+        switch (c) {
+            case 'n': total = (uint32_t)strtoul(optarg, NULL, 0); break;
+            default:
+                fprintf(stderr, "Uso: %s [-n amostras]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (total < 2 * IMUCODEC_MAX_SAMPLES) {
+        fprintf(stderr, "[ERRO] Use ao menos %d amostras por cenário\n", 2 * IMUCODEC_MAX_SAMPLES);
+        return 2;
+    }
+
+    imucodec_sample_t *input = malloc(total * sizeof(*input));
+    if (!input) {
+        fprintf(stderr, "[ERRO] Sem memória para %lu amostras\n", (unsigned long)total);
+        return 1;
+    }
+    int failures = 0;
+    for (size_t i = 0; i < sizeof scenarios / sizeof scenarios[0]; i++) {
+        if (!run_scenario(&scenarios[i], input, total)) failures++;
+    }
+    free(input);
+    return failures ? 1 : 0;
+}
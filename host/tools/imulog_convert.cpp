@@ -0,0 +1,131 @@
+/* imulog_convert.cpp
+Converte um log do IMU (CSV, binário ou comprimido) para .npy.
+
+Uso: imulog_convert [-o saida.npy] [-u saida.npy] [-c dir] [-s inicio[:fim]] [-t threads] <log>
+  -o  matriz N x 7 int32 (np.load no lugar de np.loadtxt)
+  -u  matriz N x 7 float64 em g e graus/s, com as escalas dos metadados do log
+  -c  um .npy por coluna em dir/, com o menor dtype (int16/uint32) possível
+  -s  só as amostras de inicio a fim; com o índice (<log>.idx) lê só essa parte do log
+  -t  número de threads (padrão: todos os núcleos)
+Sem -o nem -c apenas lê o arquivo e imprime o resumo.
+*/
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <stdexcept>
+#include <string>
+
+#include "imulog_reader.hpp"
+
+namespace {
+
+// Mantém só as linhas com numero_amostra em [first, last]
+void keep_samples(imulog::Table &table, uint32_t first, uint32_t last) {
+    int sc = table.column_index("numero_amostra");
+    if (sc < 0) throw std::runtime_error("-s exige a coluna numero_amostra");
+    const auto &samples = table.columns[sc];
+    size_t out = 0;
+    for (size_t r = 0; r < samples.size(); r++) {
+        uint32_t s = static_cast<uint32_t>(samples[r]);
+        if (s < first || s > last) continue;
+        for (auto &col : table.columns) col[out] = col[r];
+        out++;
+    }
+    for (auto &col : table.columns) col.resize(out);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    std::string matrix_path, units_path, columns_dir;
+    imulog::ReadOptions options;
+    bool range = false;
+    uint32_t first = 0, last = UINT32_MAX;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "o:u:c:s:t:")) != -1) {
+        switch (opt) {
+            case 'o': matrix_path = optarg; break;
+            case 'u': units_path = optarg; break;
+            case 'c': columns_dir = optarg; break;
+            case 's': {
+                char *colon;
+                range = true;
+                first = static_cast<uint32_t>(strtoul(optarg, &colon, 10));
+                if (*colon == ':') last = static_cast<uint32_t>(strtoul(colon + 1, nullptr, 10));
+                break;
+            }
+            case 't': options.threads = static_cast<unsigned>(strtoul(optarg, nullptr, 10)); break;
+            default:
+                fprintf(stderr, "Uso: %s [-o saida.npy] [-u saida.npy] [-c dir] [-s inicio[:fim]] [-t threads] <log>\n", argv[0]);
+                return 2;
+        }
+    }
+    if (optind != argc - 1) {
+        fprintf(stderr, "Uso: %s [-o saida.npy] [-u saida.npy] [-c dir] [-s inicio[:fim]] [-t threads] <log>\n", argv[0]);
+        return 2;
+    }
+    const std::string path = argv[optind];
+
+    try {
+        auto t0 = std::chrono::steady_clock::now();
+        imulog::MappedFile file(path);
+        imulog::SampleIndex index;
+        if (range) {
+            if (imulog::read_index(path, index)) {
+                auto r = imulog::index_range(index, first, last);
+                options.begin = r.first;
+                options.end = r.second;
+            } else {
+                fprintf(stderr, "[AVISO] %s não existe, lendo o log inteiro\n", imulog::index_path(path).c_str());
+            }
+        }
+        imulog::Table table = imulog::parse_log(file.data(), file.size(), options);
+        if (range) keep_samples(table, first, last);
+        auto t1 = std::chrono::steady_clock::now();
+        double secs = std::chrono::duration<double>(t1 - t0).count();
+        double mib = (std::min<uint64_t>(options.end, file.size()) - std::min<uint64_t>(options.begin, file.size())) /
+                     1048576.0;
+
+        const char *format = table.format == imulog::Format::Binary       ? "binário"
+                             : table.format == imulog::Format::Compressed ? "comprimido"
+                                                                          : "CSV";
+        printf("arquivo:        %s (%s, %.1f MiB)\n", path.c_str(), format, file.size() / 1048576.0);
+        printf("linhas:         %zu (%llu descartadas, %llu comentários)\n", table.rows(),
+               static_cast<unsigned long long>(table.bad_lines),
+               static_cast<unsigned long long>(table.comment_lines));
+        printf("colunas:       ");
+        for (const auto &name : table.names) printf(" %s", name.c_str());
+        printf("\n");
+        for (const auto &meta : table.metadata) printf("metadado:       %s\n", meta.c_str());
+        imulog::Units units = imulog::log_units(table);
+        printf("escalas:        %.0f LSB/g, %.1f LSB/(graus/s)%s\n", units.accel_lsb_per_g, units.gyro_lsb_per_dps,
+               units.from_metadata ? "" : " (padrão: o log não traz a configuração do IMU)");
+        if (!index.entries.empty()) {
+            printf("índice:         %zu entradas a cada %lu amostras, lidos %.0f KiB\n", index.entries.size(),
+                   static_cast<unsigned long>(index.interval), mib * 1024.0);
+        }
+        printf("leitura:        %.3f s (%.0f MiB/s)\n", secs, secs > 0 ? mib / secs : 0.0);
+
+        if (!matrix_path.empty()) {
+            imulog::write_npy_matrix(table, matrix_path);
+            printf("gravado:        %s\n", matrix_path.c_str());
+        }
+        if (!units_path.empty()) {
+            imulog::write_npy_units(table, units, units_path);
+            printf("gravado:        %s (g, graus/s)\n", units_path.c_str());
+        }
+        if (!columns_dir.empty()) {
+            imulog::write_npy_columns(table, columns_dir);
+            printf("gravado:        %s/<coluna>.npy\n", columns_dir.c_str());
+        }
+    } catch (const std::exception &e) {
+        fprintf(stderr, "[ERRO] %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,181 @@
+/* imulog_fetch.cpp
+Baixa logs do SD pela serial USB do datalogger, sem tirar o cartão e sem o
+modo disco: usa o protocolo binário do comando "xfer" do shell (quadros com
+CRC, janela de ACKs). Se a conexão cair no meio (cabo, reset, reenumeração),
+reabre a porta e retoma do último byte salvo.
+
+Uso: imulog_fetch [-p porta] [-t tentativas] ls [dir]
+     imulog_fetch [-p porta] [-t tentativas] stat <arquivo>
+     imulog_fetch [-p porta] [-t tentativas] [-c] get <arquivo> [destino]
+  -p  porta serial (padrão: /dev/ttyACM0)
+  -t  reconexões depois de uma queda (padrão: 5)
+  -c  continua um download anterior: mantém o destino e pede só o que falta
+*/
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "xfer_client.hpp"
+
+namespace {
+
+constexpr const char *kDefaultPort = "/dev/ttyACM0";
+constexpr int kDefaultRetries = 5;
+constexpr unsigned kReconnectDelayS = 2;        // tempo para o USB reenumerar
+constexpr uint64_t kProgressStep = 256 * 1024;
+
+struct Options {
+    std::string port = kDefaultPort;
+    int retries = kDefaultRetries;
+    bool resume = false;
+};
+
+void usage(const char *prog) {
+    fprintf(stderr,
+            "Uso: %s [-p porta] [-t tentativas] ls [dir]\n"
+            "     %s [-p porta] [-t tentativas] stat <arquivo>\n"
+            "     %s [-p porta] [-t tentativas] [-c] get <arquivo> [destino]\n",
+            prog, prog, prog);
+}
+
+// Data e hora no formato do FAT (FILINFO)
+std::string fat_time(uint16_t fdate, uint16_t ftime) {
+    char buf[32];
+    snprintf(buf, sizeof buf, "%04u-%02u-%02u %02u:%02u", 1980u + (fdate >> 9), (fdate >> 5) & 15u, fdate & 31u,
+             ftime >> 11, (ftime >> 5) & 63u);
+    return buf;
+}
+
+void print_entry(const imulog::RemoteEntry &e) {
+    printf("%12" PRIu64 "  %s  %s%s\n", e.size, fat_time(e.fdate, e.ftime).c_str(), e.name.c_str(),
+           e.is_dir() ? "/" : "");
+}
+
+std::string basename_of(const std::string &path) {
+    size_t slash = path.find_last_of("/:");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// Reabre a porta depois de quedas, até esgotar as tentativas
+template <typename Fn>
+void with_reconnect(const Options &opt, Fn &&fn) {
+    for (int failures = 0;; failures++) {
+        try {
+            imulog::XferClient client(opt.port);
+            fn(client);
+            return;
+        } catch (const imulog::TransportError &e) {
+            if (failures >= opt.retries) throw;
+            fprintf(stderr, "\n[AVISO] %s; reconectando (%d de %d)\n", e.what(), failures + 1, opt.retries);
+            sleep(kReconnectDelayS);
+        }
+    }
+}
+
+void run_get(const Options &opt, const std::string &remote, std::string local) {
+    if (local.empty()) local = basename_of(remote);
+    FILE *out = fopen(local.c_str(), opt.resume ? "ab" : "wb");
+    if (!out) throw std::runtime_error(local + ": " + strerror(errno));
+    uint64_t done = opt.resume ? static_cast<uint64_t>(ftello(out)) : 0;
+    const uint64_t start = done;
+
+    uint64_t size = 0;
+    bool have_size = false;
+    uint32_t naks = 0, crc_errors = 0, reconnects = 0;
+    uint64_t next_progress = done + kProgressStep;
+    const auto t0 = std::chrono::steady_clock::now();
+
+    try {
+        with_reconnect(opt, [&](imulog::XferClient &client) {
+            if (have_size) {
+                reconnects++;
+                fprintf(stderr, "Retomando %s do byte %" PRIu64 "\n", remote.c_str(), done);
+            } else {
+                size = client.stat(remote).size;
+                have_size = true;
+                if (done > size) throw std::runtime_error(local + " é maior que o arquivo no SD; baixe sem -c");
+            }
+            try {
+                if (done < size) {
+                    client.read(remote, done, XFER_READ_TO_END, [&](uint64_t, const uint8_t *data, size_t len) {
+                        if (fwrite(data, 1, len, out) != len) throw std::runtime_error(local + ": " + strerror(errno));
+                        done += len;
+                        if (done >= next_progress) {
+                            fprintf(stderr, "\r%" PRIu64 " / %" PRIu64 " KiB", done / 1024, size / 1024);
+                            next_progress = done + kProgressStep;
+                        }
+                    });
+                }
+            } catch (...) {
+                naks += client.stats().naks;
+                crc_errors += client.stats().crc_errors;
+                fflush(out);
+                throw;
+            }
+            naks += client.stats().naks;
+            crc_errors += client.stats().crc_errors;
+        });
+    } catch (...) {
+        fclose(out);
+        throw;
+    }
+    if (fclose(out) != 0) throw std::runtime_error(local + ": " + strerror(errno));
+
+    const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    const double kib = static_cast<double>(done - start) / 1024.0;
+    fprintf(stderr, "\r%s -> %s: %.0f KiB em %.1f s (%.0f KiB/s)", remote.c_str(), local.c_str(), kib, secs,
+            secs > 0 ? kib / secs : 0.0);
+    fprintf(stderr, ", %u NAKs, %u quadros com CRC inválido, %u reconexões\n", naks, crc_errors, reconnects);
+    if (done != size) {
+        throw std::runtime_error("recebidos " + std::to_string(done) + " de " + std::to_string(size) + " bytes");
+    }
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    Options opt;
+    int c;
+    while ((c = getopt(argc, argv, "p:t:c")) != -1) {
+        switch (c) {
+            case 'p': opt.port = optarg; break;
+            case 't': opt.retries = atoi(optarg); break;
+            case 'c': opt.resume = true; break;
+            default: usage(argv[0]); return 2;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 2;
+    }
+    const std::string cmd = argv[optind];
+    std::vector<std::string> args(argv + optind + 1, argv + argc);
+
+    try {
+        if (cmd == "ls" && args.size() <= 1) {
+            with_reconnect(opt, [&](imulog::XferClient &client) {
+                for (const auto &e : client.list(args.empty() ? "" : args[0])) print_entry(e);
+            });
+        } else if (cmd == "stat" && args.size() == 1) {
+            with_reconnect(opt, [&](imulog::XferClient &client) { print_entry(client.stat(args[0])); });
+        } else if (cmd == "get" && (args.size() == 1 || args.size() == 2)) {
+            run_get(opt, args[0], args.size() == 2 ? args[1] : "");
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    } catch (const std::exception &e) {
+        fprintf(stderr, "[ERRO] %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
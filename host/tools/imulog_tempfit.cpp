@@ -0,0 +1,180 @@
+/* imulog_tempfit.cpp
+Ajusta os coeficientes da compensação térmica (tempcomp) a partir de uma
+varredura de temperatura gravada com "tempcomp registro on" (<base>_temp.csv:
+médias por janela da temperatura do die e das leituras brutas, IMU parado).
+
+Para cada eixo, mínimos quadrados de
+    leitura(T) = b0 + c1 dT + c2 dT^2 + c3 dT^3,   dT = T - Tref
+O termo constante b0 fica para a calibração ("calib medir"); c1..c3 vão para
+o firmware. A saída são os comandos do shell, prontos para colar.
+
+Uso: imulog_tempfit [-n ordem] [-r ref_graus] <base>_temp.csv
+  -n  grau do polinômio, 1 a 3 (padrão: 3)
+  -r  temperatura de referência em graus C (padrão: média da varredura)
+*/
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "imulog_reader.hpp"
+
+namespace {
+
+constexpr int kMaxOrder = 3;
+constexpr double kMinSpanC = 5.0;  // abaixo disso os termos de ordem alta não são confiáveis
+
+const char *const kAxisColumns[6] = {"accel_x", "accel_y", "accel_z", "giro_x", "giro_y", "giro_z"};
+const char *const kAxisNames[6] = {"ax", "ay", "az", "gx", "gy", "gz"};
+
+// Resolve A x = b (n x n) por eliminação de Gauss com pivoteamento parcial
+std::vector<double> solve(std::vector<std::vector<double>> a, std::vector<double> b) {
+    const size_t n = b.size();
+    for (size_t col = 0; col < n; col++) {
+        size_t pivot = col;
+        for (size_t r = col + 1; r < n; r++) {
+            if (std::fabs(a[r][col]) > std::fabs(a[pivot][col])) pivot = r;
+        }
+        if (std::fabs(a[pivot][col]) < 1e-12) throw std::runtime_error("sistema singular: varredura sem variação de temperatura suficiente");
+        std::swap(a[pivot], a[col]);
+        std::swap(b[pivot], b[col]);
+        for (size_t r = col + 1; r < n; r++) {
+            double f = a[r][col] / a[col][col];
+            for (size_t c = col; c < n; c++) a[r][c] -= f * a[col][c];
+            b[r] -= f * b[col];
+        }
+    }
+    std::vector<double> x(n);
+    for (size_t r = n; r-- > 0;) {
+        double s = b[r];
+        for (size_t c = r + 1; c < n; c++) s -= a[r][c] * x[c];
+        x[r] = s / a[r][r];
+    }
+    return x;
+}
+
+// Polinômio b0 + c1 dT + ... ajustado; coef[0] = b0
+std::vector<double> fit(const std::vector<double> &dt, const std::vector<double> &y, int order) {
+    const size_t n = static_cast<size_t>(order) + 1;
+    std::vector<std::vector<double>> ata(n, std::vector<double>(n, 0.0));
+    std::vector<double> aty(n, 0.0);
+    for (size_t i = 0; i < dt.size(); i++) {
+        double p[kMaxOrder + 1];
+        p[0] = 1.0;
+        for (size_t k = 1; k < n; k++) p[k] = p[k - 1] * dt[i];
+        for (size_t r = 0; r < n; r++) {
+            aty[r] += p[r] * y[i];
+            for (size_t c = 0; c < n; c++) ata[r][c] += p[r] * p[c];
+        }
+    }
+    return solve(ata, aty);
+}
+
+double rms_about(const std::vector<double> &dt, const std::vector<double> &y, const std::vector<double> &coef) {
+    double sum = 0.0;
+    for (size_t i = 0; i < dt.size(); i++) {
+        double model = 0.0;
+        for (size_t k = coef.size(); k-- > 0;) model = model * dt[i] + coef[k];
+        sum += (y[i] - model) * (y[i] - model);
+    }
+    return std::sqrt(sum / static_cast<double>(dt.size()));
+}
+
+void usage(const char *prog) {
+    fprintf(stderr, "Uso: %s [-n ordem] [-r ref_graus] <base>_temp.csv\n", prog);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    int order = kMaxOrder;
+    bool have_ref = false;
+    double ref_c = 0.0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:r:")) != -1) {
+        switch (opt) {
+            case 'n': order = atoi(optarg); break;
+            case 'r':
+                ref_c = strtod(optarg, nullptr);
+                have_ref = true;
+                break;
+            default: usage(argv[0]); return 2;
+        }
+    }
+    if (optind != argc - 1 || order < 1 || order > kMaxOrder) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    try {
+        imulog::Table table = imulog::read_log(argv[optind]);
+        int temp_col = table.column_index("temp_cc");
+        if (temp_col < 0) throw std::runtime_error("coluna temp_cc ausente: não é um arquivo _temp.csv");
+        const size_t rows = table.rows();
+        if (rows <= static_cast<size_t>(order) + 1) {
+            throw std::runtime_error("poucas linhas (" + std::to_string(rows) + ") para um polinômio de grau " +
+                                     std::to_string(order));
+        }
+
+        std::vector<double> temp(rows);
+        double t_min = 1e9, t_max = -1e9, t_sum = 0.0;
+        for (size_t i = 0; i < rows; i++) {
+            temp[i] = table.columns[temp_col][i] / 100.0;
+            t_min = std::min(t_min, temp[i]);
+            t_max = std::max(t_max, temp[i]);
+            t_sum += temp[i];
+        }
+        if (!have_ref) ref_c = t_sum / static_cast<double>(rows);
+        std::vector<double> dt(rows);
+        for (size_t i = 0; i < rows; i++) dt[i] = temp[i] - ref_c;
+
+        printf("linhas:       %zu (janelas de %s amostras)\n", rows, table.meta("janela").c_str());
+        printf("temperatura:  %.2f a %.2f graus, referência %.2f\n", t_min, t_max, ref_c);
+        if (t_max - t_min < kMinSpanC) {
+            fprintf(stderr, "[AVISO] Variação de só %.1f graus: prefira ordem 1 ou uma varredura maior.\n",
+                    t_max - t_min);
+        }
+        printf("escalas:      %s LSB/g, %s LSB/(graus/s) (configure o sensor assim antes de colar)\n",
+               table.meta("accel_lsb_g").c_str(), table.meta("giro_lsb_dps").c_str());
+        printf("eixo    RMS antes   RMS depois   (LSB)\n");
+
+        std::vector<std::string> commands;
+        char line[160];
+        snprintf(line, sizeof line, "tempcomp ref %.2f", ref_c);
+        commands.push_back(line);
+        for (int axis = 0; axis < 6; axis++) {
+            int col = table.column_index(kAxisColumns[axis]);
+            if (col < 0) throw std::runtime_error(std::string("coluna ausente: ") + kAxisColumns[axis]);
+            std::vector<double> y(rows);
+            double mean = 0.0;
+            for (size_t i = 0; i < rows; i++) {
+                y[i] = table.columns[col][i];
+                mean += y[i];
+            }
+            mean /= static_cast<double>(rows);
+
+            std::vector<double> coef = fit(dt, y, order);
+            printf("%-6s %10.2f %12.2f\n", kAxisNames[axis], rms_about(dt, y, {mean}), rms_about(dt, y, coef));
+
+            int n = snprintf(line, sizeof line, "tempcomp eixo %s", kAxisNames[axis]);
+            for (int k = 1; k <= order; k++) n += snprintf(line + n, sizeof line - n, " %.6g", coef[k]);
+            commands.push_back(line);
+        }
+        commands.push_back("tempcomp on");
+        commands.push_back("tempcomp salvar");
+        commands.push_back("calib medir");
+
+        printf("\nComandos:\n");
+        for (const std::string &c : commands) printf("%s\n", c.c_str());
+    } catch (const std::exception &e) {
+        fprintf(stderr, "[ERRO] %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
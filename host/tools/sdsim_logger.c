@@ -0,0 +1,198 @@
+/* sdsim_logger.c
+Executa a pilha completa do firmware (sdlogger.c -> FatFs -> sd_card.c ->
+sd_spi.c -> spi_transfer) contra o cartão simulado em sdsim.c e relata o
+custo do protocolo: comandos enviados, bytes no barramento, chamadas de
+spi_transfer e tempo de barramento por setor. Com -e, injeta falhas durante
+a gravação para exercitar os caminhos de erro do driver.
+
+Uso: sdsim_logger [-t tipo] [-s MiB] [-n amostras] [-F csv|bin] [-b]
+                  [-o ns] [-e falha[=n]]...
+  -t  sdsc1, sdsc2 ou sdhc (padrão: sdhc)
+  -s  capacidade do cartão em MiB (padrão: 64)
+  -n  número de amostras sintéticas (padrão: 20000)
+  -F  formato do log (padrão: csv)
+  -b  escrita bufferizada (sdlogger_set_buffered)
+  -o  custo fixo por chamada de spi_transfer em ns (padrão: 0)
+  -e  falha a injetar após o início do log, n vezes (padrão: 1):
+      noresp, cmdcrc, readcrc, readtoken, writecrc, writeerr, stall
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "ff.h"
+//
+#include "diskio.h"
+#include "f_util.h"
+#include "hw_config.h"
+#include "pico/stdlib.h"
+
+#include "../../inc/sdlogger.h"
+#include "sdsim.h"
+#include "spi_host.h"
+#include "synthetic_imu.h"
+
+static const char *const fault_names[SDSIM_FAULT_COUNT] = {
+    "noresp", "cmdcrc", "readcrc", "readtoken", "writecrc", "writeerr", "stall",
+};
+
+static const char *const card_names[] = { "sdsc1", "sdsc2", "sdhc" };
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Uso: %s [-t sdsc1|sdsc2|sdhc] [-s MiB] [-n amostras] [-F csv|bin] [-b] [-o ns] [-e falha[=n]]...\n",
+            prog);
+}
+
+static void print_commands(const sdsim_stats_t *st) {
+    printf("comandos:           ");
+    for (int i = 0; i < 64; i++) {
+        if (st->cmd[i]) printf(" CMD%d=%llu", i, (unsigned long long)st->cmd[i]);
+    }
+    for (int i = 0; i < 64; i++) {
+        if (st->acmd[i]) printf(" ACMD%d=%llu", i, (unsigned long long)st->acmd[i]);
+    }
+    printf("\n");
+}
+
+// Relê o arquivo (CMD17/CMD18) e conta os registros
+static long count_records(const char *filename, sdlogger_format_t format) {
+    FIL f;
+    FRESULT fr = f_open(&f, filename, FA_READ);
+    if (fr != FR_OK) {
+        printf("f_open: %s (%d)\n", FRESULT_str(fr), fr);
+        return -1;
+    }
+    static uint8_t buf[4096];
+    UINT br;
+    long lines = 0;
+    FSIZE_t size = f_size(&f);
+    while (f_read(&f, buf, sizeof buf, &br) == FR_OK && br > 0) {
+        for (UINT i = 0; i < br; i++) lines += (buf[i] == '\n');
+    }
+    f_close(&f);
+    if (format == SDLOGGER_FORMAT_BINARY) {
+        if (size < sizeof(sdlogger_bin_header_t)) return 0;
+        return (long)((size - sizeof(sdlogger_bin_header_t)) / sizeof(sdlogger_bin_record_t));
+    }
+    return lines > 0 ? lines - 1 : 0;  // cabeçalho; um log sem nada gravado fica vazio
+}
+
+int main(int argc, char *argv[]) {
+    sdsim_config_t cfg = SDSIM_CONFIG_DEFAULT;
+    uint32_t size_mib = 64;
+    uint32_t samples = 20000;
+    sdlogger_format_t format = SDLOGGER_FORMAT_CSV;
+    bool buffered = false;
+    uint32_t overhead_ns = 0;
+    uint32_t faults[SDSIM_FAULT_COUNT] = { 0 };
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:s:n:F:bo:e:")) != -1) {
+        switch (opt) {
+            case 't': {
+                size_t i;
+                for (i = 0; i < count_of(card_names) && strcmp(optarg, card_names[i]) != 0; i++) {
+                }
+                if (i == count_of(card_names)) return usage(argv[0]), 2;
+                cfg.type = (sdsim_card_type_t)i;
+                break;
+            }
+            case 's': size_mib = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'n': samples = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'F': format = strcmp(optarg, "bin") == 0 ? SDLOGGER_FORMAT_BINARY : SDLOGGER_FORMAT_CSV; break;
+            case 'b': buffered = true; break;
+            case 'o': overhead_ns = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'e': {
+                char *eq = strchr(optarg, '=');
+                uint32_t n = eq ? (uint32_t)strtoul(eq + 1, NULL, 10) : 1;
+                if (eq) *eq = '\0';
+                int i;
+                for (i = 0; i < SDSIM_FAULT_COUNT && strcmp(optarg, fault_names[i]) != 0; i++) {
+                }
+                if (i == SDSIM_FAULT_COUNT) return usage(argv[0]), 2;
+                faults[i] = n;
+                break;
+            }
+            default: usage(argv[0]); return 2;
+        }
+    }
+
+    sd_card_t *pSD = sd_get_by_num(0);
+    cfg.sectors = size_mib * 2048u;
+    if (!sdsim_attach(pSD, &cfg)) {
+        fprintf(stderr, "Falha ao criar o cartão simulado\n");
+        return 1;
+    }
+    spi_host_set_call_overhead_ns(overhead_ns);
+
+    // Inicialização do cartão (CMD0 ... CMD16) e formatação
+    const char *drive = pSD->pcName;
+    uint64_t t0 = time_us_64();
+    DSTATUS ds = disk_initialize(0);
+    uint64_t t_init = time_us_64() - t0;
+    if (ds & STA_NOINIT) {
+        fprintf(stderr, "Cartão não inicializou\n");
+        return 1;
+    }
+    sdsim_stats_t st = sdsim_get_stats();
+    printf("cartão:              %s, %lu setores\n", card_names[cfg.type], (unsigned long)sdsim_sectors());
+    printf("inicialização:       %.3f ms, %llu comandos\n", t_init / 1000.0, (unsigned long long)st.commands);
+
+    static BYTE work[FF_MAX_SS * 4];
+    FRESULT fr = f_mkfs(drive, 0, work, sizeof work);
+    if (fr == FR_OK) fr = f_mount(&pSD->fatfs, drive, 1);
+    if (fr != FR_OK) {
+        fprintf(stderr, "f_mkfs/f_mount: %s (%d)\n", FRESULT_str(fr), fr);
+        return 1;
+    }
+
+    const char *filename = format == SDLOGGER_FORMAT_BINARY ? "sim.bin" : "sim.csv";
+    sdlogger_set_format(format);
+    sdlogger_set_buffered(buffered);
+    if (!sdlogger_start(filename)) return 1;
+    for (int i = 0; i < SDSIM_FAULT_COUNT; i++) sdsim_inject((sdsim_fault_t)i, faults[i]);
+    sdsim_reset_stats();
+    spi_host_reset_stats();
+
+    synthetic_imu_t gen;
+    synthetic_imu_init(&gen, 1);
+    int16_t accel[3], gyro[3];
+    uint32_t failures = 0;
+    t0 = time_us_64();
+    for (uint32_t i = 1; i <= samples; i++) {
+        synthetic_imu_next(&gen, accel, gyro);
+        if (!sdlogger_log_sample(i, accel, gyro)) failures++;
+    }
+    sdlogger_stop();
+    uint64_t t_log = time_us_64() - t0;
+    st = sdsim_get_stats();
+    spi_host_stats_t sp = spi_host_get_stats();
+
+    double per_sector = st.blocks_written ? 1.0 / st.blocks_written : 0.0;
+    uint32_t written = sdlogger_records_written();
+    printf("amostras:            %lu, %lu gravadas (%lu escritas com falha)\n", (unsigned long)samples,
+           (unsigned long)written, (unsigned long)failures);
+    printf("tempo de log:        %.3f ms (%.1f us/amostra)\n", t_log / 1000.0,
+           samples ? (double)t_log / samples : 0.0);
+    printf("setores escritos:    %llu, lidos: %llu\n", (unsigned long long)st.blocks_written,
+           (unsigned long long)st.blocks_read);
+    print_commands(&st);
+    printf("barramento:          %llu bytes (%.0f/setor), %llu busy, %llu espera de leitura\n",
+           (unsigned long long)st.bytes, st.bytes * per_sector, (unsigned long long)st.busy_bytes,
+           (unsigned long long)st.wait_bytes);
+    printf("spi_transfer:        %llu chamadas (%.1f/setor)\n", (unsigned long long)sp.calls, sp.calls * per_sector);
+    printf("tempo por setor:     %.1f us\n", st.blocks_written ? (double)t_log / st.blocks_written : 0.0);
+    printf("erros de CRC:        %llu, falhas injetadas disparadas: %llu\n", (unsigned long long)st.crc_errors,
+           (unsigned long long)st.faults);
+
+    // Sem falhas armadas, o arquivo relido tem que bater com o que foi gravado
+    for (int i = 0; i < SDSIM_FAULT_COUNT; i++) sdsim_inject((sdsim_fault_t)i, 0);
+    long records = count_records(filename, format);
+    printf("releitura:           %ld registros%s\n", records, records == (long)written ? "" : "  [DIVERGENTE]");
+
+    f_unmount(drive);
+    sdsim_detach();
+    return records == (long)written ? 0 : 1;
+}
@@ -0,0 +1,358 @@
+/* storage_bench.cpp
+Benchmark do caminho de gravação (sdlogger.c + FatFs) com fluxos sintéticos
+do IMU e um cartão emulado com latência de SPI e pausas longas de "busy".
+
+A aquisição é simulada em tempo virtual: amostras chegam a cada 1/taxa s
+numa FIFO de profundidade fixa (como a tarefa de amostragem no firmware) e o
+logger as consome uma a uma. O custo de cada chamada é o tempo de CPU no
+host (multiplicado por -c, para aproximar o RP2040) somado ao tempo virtual
+cobrado pelo modelo de latência do hostdisk. Amostras que encontram a FIFO
+cheia são descartadas.
+
+Uso: storage_bench [-r taxas] [-F formatos] [-b modos] [-t s] [-q prof]
+                   [-c fator] [-S setores] [-m ms] [-M ms] [-L] [-j arquivo]
+  -r  taxas em Hz, separadas por vírgula (padrão: 100,500,1000,2000)
+  -F  formatos: csv,bin,rice (padrão: todos)
+  -b  modos de escrita: direto,buffer (padrão: ambos)
+  -t  duração simulada de cada execução em segundos (padrão: 60)
+  -q  profundidade da FIFO de amostras (padrão: 32)
+  -c  fator aplicado ao tempo de CPU do host (padrão: 40)
+  -S  média de setores entre pausas longas, 0 = sem pausas (padrão: 4096)
+  -m  duração mínima da pausa em ms (padrão: 100)
+  -M  duração máxima da pausa em ms (padrão: 250)
+  -L  desliga o modelo de latência do cartão
+  -j  grava os resultados em JSON ("-" = stdout; o log vai para stderr)
+*/
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "f_util.h"
+#include "ff.h"
+#include "hw_config.h"
+#include "pico/stdlib.h"
+
+#include "../../inc/sdlogger.h"
+#include "hostdisk.h"
+#include "synthetic_imu.h"
+
+namespace {
+
+struct BenchConfig {
+    uint32_t rate_hz;
+    sdlogger_format_t format;
+    bool buffered;
+};
+
+struct Percentiles {
+    double p50 = 0, p90 = 0, p99 = 0, p999 = 0, max = 0, mean = 0;
+};
+
+struct BenchResult {
+    BenchConfig cfg;
+    uint64_t generated = 0;
+    uint64_t written = 0;
+    uint64_t dropped = 0;
+    uint32_t max_fifo = 0;
+    uint64_t file_bytes = 0;
+    double sim_seconds = 0;
+    double busy_seconds = 0;
+    double stop_ms = 0;
+    Percentiles call_us;   // custo de sdlogger_log_sample
+    Percentiles queue_us;  // chegada da amostra -> fim da gravação
+    hostdisk_stats_t disk{};
+    bool ok = true;
+};
+
+const char *format_name(sdlogger_format_t f) {
+    switch (f) {
+        case SDLOGGER_FORMAT_BINARY: return "bin";
+        case SDLOGGER_FORMAT_COMPRESSED: return "rice";
+        default: return "csv";
+    }
+}
+
+Percentiles summarize(std::vector<double> &v) {
+    Percentiles p;
+    if (v.empty()) return p;
+    std::sort(v.begin(), v.end());
+    auto at = [&](double q) { return v[std::min(v.size() - 1, static_cast<size_t>(q * v.size()))]; };
+    p.p50 = at(0.50);
+    p.p90 = at(0.90);
+    p.p99 = at(0.99);
+    p.p999 = at(0.999);
+    p.max = v.back();
+    double sum = 0;
+    for (double x : v) sum += x;
+    p.mean = sum / v.size();
+    return p;
+}
+
+std::vector<std::string> split(const char *s) {
+    std::vector<std::string> out;
+    std::string cur;
+    for (; *s; s++) {
+        if (*s == ',') {
+            if (!cur.empty()) out.push_back(cur);
+            cur.clear();
+        } else {
+            cur += *s;
+        }
+    }
+    if (!cur.empty()) out.push_back(cur);
+    return out;
+}
+
+// Executa uma chamada e devolve o custo em us: CPU do host * cpu_scale + tempo virtual
+template <typename F>
+double timed_call(double cpu_scale, F &&fn, bool &ok) {
+    uint64_t v0 = host_clock_virtual_us();
+    auto t0 = std::chrono::steady_clock::now();
+    ok = fn();
+    auto t1 = std::chrono::steady_clock::now();
+    uint64_t v1 = host_clock_virtual_us();
+    double cpu_us = std::chrono::duration<double, std::micro>(t1 - t0).count();
+    return cpu_us * cpu_scale + static_cast<double>(v1 - v0);
+}
+
+BenchResult run_one(const BenchConfig &cfg, double seconds, uint32_t fifo_depth, double cpu_scale,
+                    const hostdisk_latency_t *latency) {
+    BenchResult r;
+    r.cfg = cfg;
+
+    const char *drive = sd_get_by_num(0)->pcName;
+    FATFS *fs = &sd_get_by_num(0)->fatfs;
+    const std::string filename = std::string("bench.") + format_name(cfg.format);
+
+    // Cartão novo a cada execução; formatação e montagem sem latência
+    hostdisk_set_latency(nullptr);
+    static BYTE work[FF_MAX_SS * 4];
+    if (!hostdisk_open(nullptr, 256ull * 1024 * 1024) || f_mkfs(drive, 0, work, sizeof work) != FR_OK ||
+        f_mount(fs, drive, 1) != FR_OK) {
+        r.ok = false;
+        return r;
+    }
+    sdlogger_set_format(cfg.format);
+    sdlogger_set_buffered(cfg.buffered);
+    if (!sdlogger_start(filename.c_str())) {
+        r.ok = false;
+        return r;
+    }
+    hostdisk_reset_stats();
+    hostdisk_set_latency(latency);
+
+    synthetic_imu_t gen;
+    synthetic_imu_init(&gen, 1);
+    int16_t accel[3], gyro[3];
+
+    const double period_us = 1e6 / cfg.rate_hz;
+    const uint64_t total = static_cast<uint64_t>(seconds * cfg.rate_hz);
+    std::deque<double> fifo;  // instantes de chegada (us) das amostras pendentes
+    std::vector<double> call_us, queue_us;
+    call_us.reserve(total);
+    queue_us.reserve(total);
+    double logger_free_at = 0;  // instante em que o logger termina a chamada atual
+    double busy = 0;
+    uint32_t seq = 0;
+
+    auto service = [&](double until) {
+        while (!fifo.empty()) {
+            double start = std::max(logger_free_at, fifo.front());
+            if (start > until) break;
+            double arrival = fifo.front();
+            fifo.pop_front();
+            synthetic_imu_next(&gen, accel, gyro);
+            bool ok;
+            double cost = timed_call(cpu_scale, [&] { return sdlogger_log_sample(++seq, accel, gyro); }, ok);
+            if (!ok) r.ok = false;
+            logger_free_at = start + cost;
+            busy += cost;
+            call_us.push_back(cost);
+            queue_us.push_back(logger_free_at - arrival);
+            r.written++;
+        }
+    };
+
+    for (uint64_t i = 0; i < total && r.ok; i++) {
+        double arrival = i * period_us;
+        service(arrival);
+        r.generated++;
+        if (fifo.size() >= fifo_depth) {
+            r.dropped++;
+        } else {
+            fifo.push_back(arrival);
+            r.max_fifo = std::max<uint32_t>(r.max_fifo, static_cast<uint32_t>(fifo.size()));
+        }
+    }
+    service(1e300);
+
+    bool ok;
+    r.stop_ms = timed_call(cpu_scale, [] { sdlogger_stop(); return true; }, ok) / 1000.0;
+    r.disk = hostdisk_get_stats();
+    r.sim_seconds = std::max(logger_free_at, total * period_us) / 1e6;
+    r.busy_seconds = busy / 1e6;
+    r.call_us = summarize(call_us);
+    r.queue_us = summarize(queue_us);
+
+    hostdisk_set_latency(nullptr);
+    FILINFO fno;
+    if (f_stat(filename.c_str(), &fno) == FR_OK) r.file_bytes = fno.fsize;
+    f_unmount(drive);
+    hostdisk_close();
+    return r;
+}
+
+void print_table(const std::vector<BenchResult> &results) {
+    printf("\n%-6s %-4s %-7s %10s %8s %7s %9s %9s %9s %9s %9s %8s %6s\n", "taxa", "fmt", "modo", "amostras",
+           "perdas", "perda%", "KiB/s", "p50 us", "p99 us", "p99.9 us", "max us", "capac/s", "pausas");
+    for (const auto &r : results) {
+        double kib_s = r.sim_seconds > 0 ? r.file_bytes / 1024.0 / r.sim_seconds : 0;
+        double capacity = r.busy_seconds > 0 ? r.written / r.busy_seconds : 0;
+        printf("%-6u %-4s %-7s %10llu %8llu %6.2f%% %9.1f %9.0f %9.0f %9.0f %9.0f %8.0f %6llu%s\n", r.cfg.rate_hz,
+               format_name(r.cfg.format), r.cfg.buffered ? "buffer" : "direto", (unsigned long long)r.written,
+               (unsigned long long)r.dropped, r.generated ? 100.0 * r.dropped / r.generated : 0.0, kib_s,
+               r.call_us.p50, r.call_us.p99, r.call_us.p999, r.call_us.max, capacity,
+               (unsigned long long)r.disk.stalls, r.ok ? "" : "  [ERRO]");
+    }
+}
+
+void json_percentiles(FILE *f, const char *name, const Percentiles &p) {
+    fprintf(f, "\"%s\": {\"mean\": %.1f, \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"p999\": %.1f, \"max\": %.1f}",
+            name, p.mean, p.p50, p.p90, p.p99, p.p999, p.max);
+}
+
+void write_json(FILE *f, const std::vector<BenchResult> &results, double seconds, uint32_t fifo_depth,
+                double cpu_scale, const hostdisk_latency_t *latency) {
+    fprintf(f, "{\n  \"duration_s\": %.3f,\n  \"fifo_depth\": %u,\n  \"cpu_scale\": %.2f,\n", seconds, fifo_depth,
+            cpu_scale);
+    if (latency) {
+        fprintf(f,
+                "  \"latency_model\": {\"command_us\": %u, \"read_sector_us\": %u, \"write_sector_us\": %u, "
+                "\"stall_mean_sectors\": %u, \"stall_min_us\": %u, \"stall_max_us\": %u},\n",
+                latency->command_us, latency->read_sector_us, latency->write_sector_us, latency->stall_mean_sectors,
+                latency->stall_min_us, latency->stall_max_us);
+    } else {
+        fprintf(f, "  \"latency_model\": null,\n");
+    }
+    fprintf(f, "  \"runs\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto &r = results[i];
+        fprintf(f,
+                "    {\"rate_hz\": %u, \"format\": \"%s\", \"buffered\": %s, \"ok\": %s, "
+                "\"generated\": %llu, \"written\": %llu, \"dropped\": %llu, \"max_fifo\": %u, "
+                "\"file_bytes\": %llu, \"sim_s\": %.3f, \"busy_s\": %.3f, \"bytes_per_s\": %.1f, "
+                "\"stop_ms\": %.3f, ",
+                r.cfg.rate_hz, format_name(r.cfg.format), r.cfg.buffered ? "true" : "false", r.ok ? "true" : "false",
+                (unsigned long long)r.generated, (unsigned long long)r.written, (unsigned long long)r.dropped,
+                r.max_fifo, (unsigned long long)r.file_bytes, r.sim_seconds, r.busy_seconds,
+                r.sim_seconds > 0 ? r.file_bytes / r.sim_seconds : 0.0, r.stop_ms);
+        json_percentiles(f, "call_us", r.call_us);
+        fprintf(f, ", ");
+        json_percentiles(f, "queue_us", r.queue_us);
+        fprintf(f,
+                ", \"disk\": {\"write_calls\": %llu, \"sectors_written\": %llu, \"read_calls\": %llu, "
+                "\"sectors_read\": %llu, \"busy_us\": %llu, \"stalls\": %llu}}%s\n",
+                (unsigned long long)r.disk.write_calls, (unsigned long long)r.disk.sectors_written,
+                (unsigned long long)r.disk.read_calls, (unsigned long long)r.disk.sectors_read,
+                (unsigned long long)r.disk.busy_us, (unsigned long long)r.disk.stalls,
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+void usage(const char *prog) {
+    fprintf(stderr,
+            "Uso: %s [-r taxas] [-F csv,bin,rice] [-b direto,buffer] [-t s] [-q prof] [-c fator]\n"
+            "          [-S setores] [-m ms] [-M ms] [-L] [-j arquivo|-]\n",
+            prog);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    std::vector<uint32_t> rates = {100, 500, 1000, 2000};
+    std::vector<sdlogger_format_t> formats = {SDLOGGER_FORMAT_CSV, SDLOGGER_FORMAT_BINARY, SDLOGGER_FORMAT_COMPRESSED};
+    std::vector<bool> modes = {false, true};
+    double seconds = 60;
+    uint32_t fifo_depth = 32;
+    double cpu_scale = 40;
+    hostdisk_latency_t latency = HOSTDISK_LATENCY_SD_DEFAULT;
+    bool use_latency = true;
+    const char *json_path = nullptr;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:F:b:t:q:c:S:m:M:Lj:")) != -1) {
+        switch (opt) {
+            case 'r':
+                rates.clear();
+                for (const auto &s : split(optarg)) rates.push_back(static_cast<uint32_t>(std::stoul(s)));
+                break;
+            case 'F':
+                formats.clear();
+                for (const auto &s : split(optarg)) {
+                    if (s == "csv") formats.push_back(SDLOGGER_FORMAT_CSV);
+                    else if (s == "bin") formats.push_back(SDLOGGER_FORMAT_BINARY);
+                    else if (s == "rice") formats.push_back(SDLOGGER_FORMAT_COMPRESSED);
+                    else return usage(argv[0]), 2;
+                }
+                break;
+            case 'b':
+                modes.clear();
+                for (const auto &s : split(optarg)) {
+                    if (s == "direto") modes.push_back(false);
+                    else if (s == "buffer") modes.push_back(true);
+                    else return usage(argv[0]), 2;
+                }
+                break;
+            case 't': seconds = atof(optarg); break;
+            case 'q': fifo_depth = static_cast<uint32_t>(strtoul(optarg, nullptr, 10)); break;
+            case 'c': cpu_scale = atof(optarg); break;
+            case 'S': latency.stall_mean_sectors = static_cast<uint32_t>(strtoul(optarg, nullptr, 10)); break;
+            case 'm': latency.stall_min_us = static_cast<uint32_t>(atof(optarg) * 1000); break;
+            case 'M': latency.stall_max_us = static_cast<uint32_t>(atof(optarg) * 1000); break;
+            case 'L': use_latency = false; break;
+            case 'j': json_path = optarg; break;
+            default: usage(argv[0]); return 2;
+        }
+    }
+    if (rates.empty() || formats.empty() || modes.empty() || seconds <= 0 || fifo_depth == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // Com "-j -" o JSON fica sozinho no stdout; as mensagens do sdlogger vão para stderr
+    FILE *json = nullptr;
+    if (json_path && strcmp(json_path, "-") == 0) {
+        json = fdopen(dup(STDOUT_FILENO), "w");
+        fflush(stdout);
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+    } else if (json_path) {
+        json = fopen(json_path, "w");
+    }
+    if (json_path && !json) {
+        fprintf(stderr, "Falha ao abrir %s\n", json_path);
+        return 1;
+    }
+
+    std::vector<BenchResult> results;
+    for (uint32_t rate : rates)
+        for (auto fmt : formats)
+            for (bool buffered : modes)
+                results.push_back(run_one({rate, fmt, buffered}, seconds, fifo_depth, cpu_scale,
+                                          use_latency ? &latency : nullptr));
+
+    print_table(results);
+    if (json) {
+        write_json(json, results, seconds, fifo_depth, cpu_scale, use_latency ? &latency : nullptr);
+        fclose(json);
+    }
+    bool ok = std::all_of(results.begin(), results.end(), [](const BenchResult &r) { return r.ok; });
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,396 @@
+/* xfer_loopback.c
+Roda o lado do firmware do "xfer" (src/xfer.c sobre o FatFs numa imagem em
+RAM) atrás de um pseudo-terminal e baixa arquivos com o imulog_fetch, como
+se o pty fosse a serial USB. O CDC do TinyUSB é substituído aqui (tud_cdc_*
+lendo e escrevendo no mestre do pty), com falhas injetadas: bytes trocados
+nos quadros enviados ou nos pedidos recebidos e uma queda da conexão no
+meio da leitura. Cada cenário confere o arquivo baixado byte a byte com o
+da imagem; a saída é 1 se algum divergir.
+
+Uso: xfer_loopback [-f imulog_fetch] [-s KiB] [-k]
+  -f  cliente a testar (padrão: imulog_fetch no diretório deste programa)
+  -s  tamanho do arquivo de teste em KiB (padrão: 3072)
+  -k  mantém o diretório temporário com os arquivos baixados
+*/
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <pty.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "ff.h"
+#include "f_util.h"
+#include "hostdisk.h"
+#include "hw_config.h"
+#include "pico/stdio_usb.h"
+#include "pico/stdlib.h"
+#include "tusb.h"
+
+#include "../../inc/xfer.h"
+
+#define LOOPBACK_FILE "voo.bin"
+#define LOOPBACK_DIR "logs"
+#define LOOPBACK_DIR_FILES 300      // nomes longos: a listagem ocupa vários quadros
+#define LOOPBACK_OFFLINE_US 200000  // duração da queda simulada
+#define LOOPBACK_TIMEOUT_US (120u * 1000000u)
+
+typedef struct {
+    const char *name;
+    double tx_corrupt;      // chance de trocar um byte em cada tud_cdc_write
+    double rx_corrupt;      // e em cada tud_cdc_read
+    uint32_t drop_after_kib;
+    bool resume;            // começa com metade do arquivo e usa -c
+} scenario_t;
+
+static const scenario_t scenarios[] = {
+    { "limpo", 0.0, 0.0, 0, false },
+    { "quadros corrompidos", 0.05, 0.0, 0, false },
+    { "pedidos corrompidos", 0.0, 0.05, 0, false },
+    { "queda no meio", 0.0, 0.0, 1024, false },
+    { "retomada (-c)", 0.0, 0.0, 0, true },
+};
+
+// CDC simulado sobre o mestre do pty
+struct stdio_driver {
+    int unused;
+};
+stdio_driver_t stdio_usb;
+
+static int master_fd = -1;
+static const scenario_t *current;
+static uint64_t sent_bytes;
+static bool connected = true;
+static bool dropped = false;
+static uint64_t reconnect_at_us;
+
+void stdio_set_driver_enabled(stdio_driver_t *driver, bool enabled) {
+    (void)driver;
+    (void)enabled;
+}
+
+void stdio_flush(void) {
+    fflush(stdout);
+}
+
+// Sem SPI no disco em RAM: não há espera de DMA para aproveitar
+void spi_set_wait_hook(void (*hook)(void)) {
+    (void)hook;
+}
+
+void tud_task(void) {
+    if (!connected && time_us_64() >= reconnect_at_us) connected = true;
+}
+
+bool tud_mounted(void) {
+    return true;
+}
+
+bool tud_cdc_connected(void) {
+    return connected;
+}
+
+uint32_t tud_cdc_read(void *buffer, uint32_t bufsize) {
+    if (!connected) return 0;
+    ssize_t n = read(master_fd, buffer, bufsize);
+    if (n <= 0) return 0;
+    if (current->rx_corrupt > 0 && drand48() < current->rx_corrupt) ((uint8_t *)buffer)[lrand48() % n] ^= 0x5a;
+    return (uint32_t)n;
+}
+
+uint32_t tud_cdc_write(const void *buffer, uint32_t bufsize) {
+    if (!connected) return bufsize;  // cabo fora: o que sai se perde
+    static uint8_t tmp[8192];
+    uint32_t len = bufsize < sizeof tmp ? bufsize : (uint32_t)sizeof tmp;
+    memcpy(tmp, buffer, len);
+    if (len && current->tx_corrupt > 0 && drand48() < current->tx_corrupt) tmp[lrand48() % len] ^= 0x01;
+    ssize_t n = write(master_fd, tmp, len);
+    if (n <= 0) return 0;
+    sent_bytes += (uint64_t)n;
+    if (current->drop_after_kib && !dropped && sent_bytes > (uint64_t)current->drop_after_kib * 1024) {
+        dropped = true;
+        connected = false;
+        reconnect_at_us = time_us_64() + LOOPBACK_OFFLINE_US;
+    }
+    return (uint32_t)n;
+}
+
+uint32_t tud_cdc_write_flush(void) {
+    return 0;
+}
+
+// Shell mínimo: fora da sessão, só "xfer" na linha importa
+static void serve(void) {
+    static char line[64];
+    static size_t len = 0;
+    if (xfer_is_active()) {
+        xfer_poll();
+        sleep_us(200);
+        return;
+    }
+    tud_task();
+    char c;
+    if (read(master_fd, &c, 1) != 1) {
+        sleep_us(1000);
+    } else if (c == '\r' || c == '\n') {
+        line[len] = '\0';
+        if (strcmp(line, "xfer") == 0) xfer_start();
+        len = 0;
+    } else if (len < sizeof line - 1) {
+        line[len++] = c;
+    }
+}
+
+// Executa o cliente servindo o pty até ele terminar; código de saída ou -1
+static int run_client(char *const argv[], const char *out_path, const char *err_path) {
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        int out = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        int err = open(err_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out < 0 || err < 0) _exit(127);
+        dup2(out, STDOUT_FILENO);
+        dup2(err, STDERR_FILENO);
+        execv(argv[0], argv);
+        _exit(127);
+    }
+    uint64_t deadline = time_us_64() + LOOPBACK_TIMEOUT_US;
+    int status;
+    while (waitpid(pid, &status, WNOHANG) == 0) {
+        if (time_us_64() > deadline) {
+            kill(pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            return -1;
+        }
+        serve();
+    }
+    // Termina uma sessão que o cliente não encerrou
+    for (uint64_t end = time_us_64() + 50000; time_us_64() < end;) serve();
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// Compara o arquivo baixado com o da imagem
+static bool same_as_image(const char *local, const char *remote) {
+    FILE *f = fopen(local, "rb");
+    FIL fil;
+    if (!f || f_open(&fil, remote, FA_READ) != FR_OK) {
+        if (f) fclose(f);
+        return false;
+    }
+    static uint8_t a[4096], b[4096];
+    bool same = true;
+    for (;;) {
+        UINT br = 0;
+        size_t n = fread(a, 1, sizeof a, f);
+        if (f_read(&fil, b, sizeof b, &br) != FR_OK || br != n || memcmp(a, b, n) != 0) {
+            same = false;
+            break;
+        }
+        if (n == 0) break;
+    }
+    f_close(&fil);
+    fclose(f);
+    return same;
+}
+
+// Copia os primeiros 'len' bytes do arquivo da imagem (download interrompido)
+static bool copy_prefix(const char *remote, const char *local, uint32_t len) {
+    FILE *f = fopen(local, "wb");
+    FIL fil;
+    if (!f || f_open(&fil, remote, FA_READ) != FR_OK) {
+        if (f) fclose(f);
+        return false;
+    }
+    static uint8_t buf[4096];
+    bool ok = true;
+    while (ok && len) {
+        UINT br = 0;
+        ok = f_read(&fil, buf, len < sizeof buf ? len : (UINT)sizeof buf, &br) == FR_OK && br > 0 &&
+             fwrite(buf, 1, br, f) == br;
+        len -= br;
+    }
+    f_close(&fil);
+    return fclose(f) == 0 && ok;
+}
+
+static long count_lines(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    long lines = 0;
+    int c;
+    while ((c = fgetc(f)) != EOF) lines += (c == '\n');
+    fclose(f);
+    return lines;
+}
+
+static void show_file(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return;
+    char line[256];
+    while (fgets(line, sizeof line, f)) fprintf(stderr, "    %s", line);
+    fclose(f);
+}
+
+// Arquivo de dados pseudoaleatórios (não comprime, CRC pega qualquer troca)
+// e um diretório com muitos nomes longos
+static bool make_image(uint32_t size_kib) {
+    static BYTE work[FF_MAX_SS * 4];
+    sd_card_t *pSD = sd_get_by_num(0);
+    FRESULT fr = f_mkfs(pSD->pcName, 0, work, sizeof work);
+    if (fr == FR_OK) fr = f_mount(&pSD->fatfs, pSD->pcName, 1);
+    FIL f;
+    UINT bw;
+    if (fr == FR_OK) fr = f_open(&f, LOOPBACK_FILE, FA_WRITE | FA_CREATE_ALWAYS);
+    if (fr != FR_OK) {
+        fprintf(stderr, "imagem: %s (%d)\n", FRESULT_str(fr), fr);
+        return false;
+    }
+    static uint8_t block[4096];
+    uint64_t left = (uint64_t)size_kib * 1024 + 1234;  // termina no meio de um quadro
+    while (fr == FR_OK && left) {
+        UINT n = left < sizeof block ? (UINT)left : (UINT)sizeof block;
+        for (UINT i = 0; i < n; i++) block[i] = (uint8_t)lrand48();
+        fr = f_write(&f, block, n, &bw);
+        left -= n;
+    }
+    f_close(&f);
+    if (fr == FR_OK) fr = f_mkdir(LOOPBACK_DIR);
+    for (int i = 0; fr == FR_OK && i < LOOPBACK_DIR_FILES; i++) {
+        char name[64];
+        snprintf(name, sizeof name, LOOPBACK_DIR "/imu_data_com_nome_longo_%03d.csv", i);
+        fr = f_open(&f, name, FA_WRITE | FA_CREATE_ALWAYS);
+        if (fr == FR_OK) fr = f_write(&f, name, (UINT)i, &bw);
+        f_close(&f);
+    }
+    if (fr != FR_OK) fprintf(stderr, "imagem: %s (%d)\n", FRESULT_str(fr), fr);
+    return fr == FR_OK;
+}
+
+static int usage(const char *prog) {
+    fprintf(stderr, "Uso: %s [-f imulog_fetch] [-s KiB] [-k]\n", prog);
+    return 2;
+}
+
+int main(int argc, char *argv[]) {
+    char fetch[PATH_MAX];
+    char self[PATH_MAX];
+    snprintf(self, sizeof self, "%s", argv[0]);
+    snprintf(fetch, sizeof fetch, "%s/imulog_fetch", dirname(self));
+    uint32_t size_kib = 3072;
+    bool keep = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:s:k")) != -1) {
+        switch (opt) {
+            case 'f': snprintf(fetch, sizeof fetch, "%s", optarg); break;
+            case 's': size_kib = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'k': keep = true; break;
+            default: return usage(argv[0]);
+        }
+    }
+    if (access(fetch, X_OK) != 0) {
+        fprintf(stderr, "%s: %s\n", fetch, strerror(errno));
+        return 2;
+    }
+
+    srand48(7);
+    if (!hostdisk_open(NULL, (size_kib / 1024 + 16) << 20) || !make_image(size_kib)) return 1;
+
+    // O escravo fica aberto aqui: o cliente pode fechar e reabrir a porta
+    int slave_fd;
+    char port[64];
+    if (openpty(&master_fd, &slave_fd, port, NULL, NULL) != 0) {
+        perror("openpty");
+        return 1;
+    }
+    struct termios t;
+    tcgetattr(slave_fd, &t);
+    cfmakeraw(&t);
+    tcsetattr(slave_fd, TCSANOW, &t);
+    fcntl(master_fd, F_SETFL, O_NONBLOCK);
+
+    char dir[] = "/tmp/xfer_loopbackXXXXXX";
+    if (!mkdtemp(dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    char local[PATH_MAX], out_path[PATH_MAX], err_path[PATH_MAX];
+    snprintf(local, sizeof local, "%s/%s", dir, LOOPBACK_FILE);
+    snprintf(out_path, sizeof out_path, "%s/saida.txt", dir);
+    snprintf(err_path, sizeof err_path, "%s/erros.txt", dir);
+    printf("pty:                 %s (%s, %lu KiB)\n", port, fetch, (unsigned long)size_kib);
+
+    int failures = 0;
+    static const scenario_t listing = { "listagem", 0.0, 0.0, 0, false };
+    current = &listing;
+    char *ls_argv[] = { fetch, "-p", port, "ls", LOOPBACK_DIR, NULL };
+    int rc = run_client(ls_argv, out_path, err_path);
+    long lines = count_lines(out_path);
+    bool ok = rc == 0 && lines == LOOPBACK_DIR_FILES;
+    printf("%-20s %ld de %d entradas%s\n", "listagem:", lines, LOOPBACK_DIR_FILES, ok ? "" : "  [FALHOU]");
+    if (!ok) {
+        show_file(err_path);
+        failures++;
+    }
+
+    for (size_t i = 0; i < count_of(scenarios); i++) {
+        current = &scenarios[i];
+        sent_bytes = 0;
+        connected = true;
+        dropped = false;
+        tcflush(slave_fd, TCIOFLUSH);
+        unlink(local);
+        if (current->resume && !copy_prefix(LOOPBACK_FILE, local, size_kib * 512)) {
+            fprintf(stderr, "Falha ao preparar %s\n", local);
+            return 1;
+        }
+        char *get_argv[10];
+        int n = 0;
+        get_argv[n++] = fetch;
+        get_argv[n++] = "-p";
+        get_argv[n++] = port;
+        if (current->resume) get_argv[n++] = "-c";
+        get_argv[n++] = "get";
+        get_argv[n++] = LOOPBACK_FILE;
+        get_argv[n++] = local;
+        get_argv[n] = NULL;
+        uint64_t t0 = time_us_64();
+        rc = run_client(get_argv, out_path, err_path);
+        double secs = (time_us_64() - t0) / 1e6;
+        ok = rc == 0 && same_as_image(local, LOOPBACK_FILE);
+        printf("%-20s %s em %.1f s%s\n", current->name, rc == 0 ? "baixado" : "cliente falhou", secs,
+               ok ? "" : "  [DIVERGENTE]");
+        // Resumo do cliente: NAKs, quadros com CRC inválido e reconexões
+        FILE *err = fopen(err_path, "r");
+        // (o progresso vem na mesma linha, separado por '\r')
+        char *line = NULL;
+        size_t cap = 0;
+        while (err && getline(&line, &cap, err) != -1) {
+            char *summary = strrchr(line, '\r');
+            if (strstr(line, "NAKs")) printf("  %s", summary ? summary + 1 : line);
+        }
+        free(line);
+        if (err) fclose(err);
+        if (!ok) {
+            show_file(err_path);
+            failures++;
+        }
+    }
+
+    if (keep) {
+        printf("arquivos em %s\n", dir);
+    } else {
+        unlink(local);
+        unlink(out_path);
+        unlink(err_path);
+        rmdir(dir);
+    }
+    return failures ? 1 : 0;
+}
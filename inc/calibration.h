@@ -0,0 +1,55 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+// Calibração de offset do IMU. A média de N amostras com o sensor parado dá
+// o bias do giroscópio (que deveria ler zero) e o do acelerômetro (que
+// deveria ler 1 g no eixo vertical e zero nos outros). Os offsets ficam no
+// último setor da flash, protegidos por CRC32, junto com as escalas (LSB por
+// unidade, de sensor_describe) em que foram medidos, e são convertidos para
+// a escala atual do sensor e subtraídos
+// de cada amostra em inteiros, antes do log. Também vão para os metadados
+// do log (sdlogger_set_metadata).
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CALIB_DEFAULT_SAMPLES 1000
+#define CALIB_MAX_SAMPLES 20000
+#define CALIB_INTERVAL_US 1000           // entre leituras (taxa de saída do MPU6050)
+// Limites em unidades físicas, convertidos para LSB na escala atual
+#define CALIB_GYRO_MAX_SPREAD_DPS 3.0f   // max - min por eixo em repouso
+#define CALIB_ACCEL_MAX_SPREAD_G 0.1f
+#define CALIB_LEVEL_TOLERANCE_G 0.1f     // eixos horizontais além disso: acelerômetro não é calibrado
+
+typedef struct {
+    int16_t accel[3];     // bias de cada eixo, em LSB da escala da medida
+    int16_t gyro[3];
+    uint32_t samples;     // amostras da média
+    float accel_lsb_per_g;   // escalas da medida
+    float gyro_lsb_per_dps;
+} calibration_t;
+
+// Lê a calibração gravada; false (e offsets zerados) se a flash não tem uma válida
+bool calibration_load(void);
+
+// Mede com o sensor parado e grava na flash; false se houve movimento ou erro de leitura
+bool calibration_run(uint32_t samples);
+
+// Chamada entre as leituras da medida, que bloqueia por ~1 s (p.ex. para atender o USB)
+void calibration_set_wait_hook(void (*hook)(void));
+
+// Zera os offsets e apaga a cópia da flash
+void calibration_clear(void);
+
+// Reconverte os offsets depois de uma troca de escala do sensor
+void calibration_refresh(void);
+
+bool calibration_is_valid(void);
+const calibration_t *calibration_get(void);
+
+// Subtrai os offsets, saturando em int16
+void calibration_apply(int16_t accel[3], int16_t gyro[3]);
+
+void calibration_print_status(void);
+
+#endif // CALIBRATION_H
@@ -0,0 +1,54 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+// Captura por eventos: as amostras passam por um anel em RAM e o gatilho é
+// avaliado em cada uma. Ao disparar, abre-se um arquivo novo com a história
+// anterior ao disparo (pré) e a janela seguinte (pós); fora dos eventos nada
+// é gravado no cartão.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Anel de amostras (potência de 2). A janela pré cabe na metade dele: o
+// restante é a folga enquanto a história é descarregada no arquivo
+#define CAPTURE_RING_SAMPLES 2048
+#define CAPTURE_PRE_MAX (CAPTURE_RING_SAMPLES / 2)
+#define CAPTURE_PRE_DEFAULT 500
+#define CAPTURE_POST_DEFAULT 1000
+
+// Amostras do anel gravadas por chamada de capture_process durante um
+// evento; acima de 1, o atraso da história diminui a cada amostra
+#define CAPTURE_DRAIN_PER_SAMPLE 8
+
+typedef enum {
+    CAPTURE_TRIGGER_AXIS = 0,   // |eixo| >= limiar (0-2 accel, 3-5 giro)
+    CAPTURE_TRIGGER_ACCEL_MAG,  // módulo da aceleração >= limiar
+    CAPTURE_TRIGGER_GYRO_MAG    // módulo da velocidade angular >= limiar
+} capture_trigger_type_t;
+
+typedef struct {
+    capture_trigger_type_t type;
+    uint8_t axis;        // só para CAPTURE_TRIGGER_AXIS
+    uint16_t threshold;  // em unidades brutas do sensor
+} capture_trigger_t;
+
+bool capture_set_trigger(const capture_trigger_t *trigger);
+const capture_trigger_t *capture_get_trigger(void);
+bool capture_set_window(uint32_t pre, uint32_t post);
+void capture_get_window(uint32_t *pre, uint32_t *post);
+
+// Arma a captura: os eventos vão para <base>_eNNN<ext> a partir do primeiro
+// número livre no cartão
+bool capture_arm(const char *log_filename);
+void capture_disarm(void);
+bool capture_is_armed(void);
+bool capture_in_event(void);
+uint32_t capture_event_count(void);
+
+// Chamada a cada amostra com a captura armada; false se a gravação falhou
+bool capture_process(uint32_t sample_num, const int16_t accel[3], const int16_t gyro[3]);
+
+const char *capture_trigger_name(capture_trigger_type_t type);
+void capture_print_status(void);
+
+#endif // CAPTURE_H
@@ -0,0 +1,23 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+// CRC-32 (polinômio 0x04C11DB7 refletido, o mesmo do zlib/Ethernet) com
+// tabela de 16 entradas: meio byte por consulta, 64 bytes de flash.
+// Não depende do SDK: o mesmo arquivo serve ao host.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Continua um CRC: crc32_update(0, ...) começa um novo, e o resultado de
+// uma chamada pode alimentar a seguinte para dados em partes
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CRC32_H
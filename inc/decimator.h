@@ -0,0 +1,51 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+// Decimação entre a aquisição e o log: o sensor roda rápido (menos aliasing
+// no próprio MPU6050) e o log grava 1 de cada 'fator' amostras, depois de
+// um FIR passa-baixas polifásico em Q15. O filtro tem DECIM_TAPS_PER_PHASE
+// coeficientes por fase (fator * 16 no total, janela de Blackman, corte na
+// metade da taxa de saída): banda passante até ~1/3 da taxa de saída e
+// rejeição de ~70 dB a partir de ~2/3, então só a faixa entre 1/3 e 1/2
+// recebe alias.
+// Cada entrada é multiplicada pelos 16 coeficientes da sua fase e somada nos
+// 16 acumuladores das saídas em andamento (forma transposta), então o custo
+// por amostra de entrada é o mesmo em toda amostra, inclusive as que geram
+// saída: 16 MACs de 32 bits por eixo, sem pico a cada 'fator' amostras.
+// O atraso de grupo é (16 * fator - 1) / 2 amostras de entrada.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DECIM_TAPS_PER_PHASE 16        // potência de 2 (índice circular por máscara)
+#define DECIM_MAX_FACTOR 32
+#define DECIM_AXES 6                   // accel x, y, z, giro x, y, z
+
+typedef struct {
+    int32_t acc[DECIM_AXES][DECIM_TAPS_PER_PHASE];  // saídas em andamento, Q15
+    int16_t last[DECIM_AXES];                       // última entrada (repetida em leituras perdidas)
+    uint8_t phase;     // fase da próxima entrada (fator - 1 ... 0)
+    uint8_t head;      // acumulador da próxima saída
+    bool primed;       // histórico anterior ao início preenchido com a 1ª amostra
+} decimator_t;
+
+// 1 desliga; projeta os coeficientes (float, fora do caminho da amostra)
+bool decimator_set_factor(uint8_t factor);
+uint8_t decimator_get_factor(void);
+
+void decimator_reset(decimator_t *d);
+// Empurra uma amostra (NULL repete a anterior, para manter a fase numa
+// leitura perdida); true quando sai uma amostra decimada em out_*
+bool decimator_push(decimator_t *d, const int16_t accel[3], const int16_t gyro[3], int16_t out_accel[3],
+                    int16_t out_gyro[3]);
+
+// Sessão de log: um filtro por sensor gravado. decimator_start publica os
+// metadados, então vem antes de sdlogger_start
+void decimator_start(void);
+void decimator_stop(void);
+bool decimator_is_active(void);
+bool decimator_process(uint8_t sensor, const int16_t accel[3], const int16_t gyro[3], int16_t out_accel[3],
+                       int16_t out_gyro[3]);
+void decimator_print_status(uint32_t sample_rate_hz);
+
+#endif // DECIMATOR_H
@@ -3,19 +3,108 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "hardware/i2c.h"
+#include "sensor.h"
+
+// Driver do MPU6050 para a interface de sensor.h (funções mpu6050_sensor_*).
+// Vários MPU6050 (até dois por barramento, AD0 em 0 ou 1) lidos no mesmo
+// tick: o sensor 0 é sempre o de 0x68 em I2C_PORT e os outros são
+// encontrados na inicialização. Cada leitura é um burst de 14 bytes (accel,
+// temperatura e giro) montado direto na FIFO do controlador, então os dois
+// barramentos transferem ao mesmo tempo. Todos usam a mesma configuração.
+// O que segue é específico do MPU6050: registradores, transporte do I2C e a
+// configuração completa (comando imu).
 
 // Definições padrão do sensor
 #define MPU6050_ADDR  0x68
+#define MPU6050_ADDR_ALT 0x69   // AD0 em nível alto
+#define MPU6050_REG_WHO_AM_I 0x75
+#define MPU6050_WHO_AM_I 0x68
+#define MPU6050_REG_SMPLRT_DIV   0x19
+#define MPU6050_REG_CONFIG       0x1A
+#define MPU6050_REG_GYRO_CONFIG  0x1B
+#define MPU6050_REG_ACCEL_CONFIG 0x1C
 #define MPU6050_REG_PWR_MGMT_1  0x6B
 #define MPU6050_REG_ACCEL_XOUT_H 0x3B
+#define MPU6050_REG_TEMP_OUT_H   0x41
 #define MPU6050_REG_GYRO_XOUT_H  0x43
+#define MPU6050_REG_FIFO_EN      0x23
+#define MPU6050_REG_USER_CTRL    0x6A
+#define MPU6050_REG_FIFO_COUNT_H 0x72
+#define MPU6050_REG_FIFO_R_W     0x74
+#define MPU6050_FIFO_SIZE 1024
+#define MPU6050_FIFO_SOURCES 0xF8          // TEMP, XG, YG, ZG e ACCEL: quadros na ordem do burst
+#define MPU6050_USER_CTRL_FIFO_EN 0x40
+#define MPU6050_USER_CTRL_FIFO_RESET 0x04
 
 #define I2C_PORT i2c0
 #define I2C_SDA  0
 #define I2C_SCL  1
+#define IMU_I2C_PORT_AUX i2c1    // barramento do display, iniciado por display_init
+#define IMU_I2C_AUX_SDA 14
+#define IMU_I2C_AUX_SCL 15
+#define IMU_I2C_BAUD (400 * 1000)
+
+// Recuperação de barramento travado (sensor_recover): pulsos de SCL a 100 kHz
+#define IMU_RECOVERY_HALF_PERIOD_US 5
+#define IMU_RECOVERY_PULSES 9
+
+// Transporte do barramento I2C_PORT: controlador I2C ou mestre em PIO com
+// DMA (src/pio_i2c.c), que lê em segundo plano e acorda a CPU no fim
+typedef enum {
+    IMU_TRANSPORT_HW = 0,
+    IMU_TRANSPORT_PIO
+} imu_transport_t;
+
+#define IMU_PIO_I2C_HZ (400 * 1000)   // o MPU6050 é especificado até 400 kHz
+
+#define IMU_MAX_DEVICES SENSOR_MAX_DEVICES   // 0x68 e 0x69 em cada barramento
+#define IMU_BURST_LEN 14         // ACCEL_XOUT_H (0x3B) até GYRO_ZOUT_L (0x48); também um quadro da FIFO
+#define IMU_BURST_TIMEOUT_US 2000
+#define IMU_FIFO_CHUNK_FRAMES 4  // quadros da FIFO por transação no controlador (o PIO lê um por vez)
+
+typedef struct {
+    i2c_inst_t *bus;
+    uint8_t addr;
+} imu_dev_t;
 
-void imu_init(void);
-bool imu_read_raw(int16_t accel[3], int16_t gyro[3]);
+// Fonte de clock do MPU6050 (CLKSEL de PWR_MGMT_1)
+typedef enum {
+    IMU_CLOCK_INTERNAL = 0,  // oscilador interno de 8 MHz
+    IMU_CLOCK_PLL_GYRO_X = 1 // PLL do giroscópio X: mais estável (recomendado no datasheet)
+} imu_clock_t;
+
+// Configuração do sensor; os campos são os valores dos registradores
+typedef struct {
+    uint8_t accel_range;  // AFS_SEL: 0..3 = +-2/4/8/16 g
+    uint8_t gyro_range;   // FS_SEL: 0..3 = +-250/500/1000/2000 graus/s
+    uint8_t dlpf;         // DLPF_CFG: 0 = sem filtro (260 Hz), 6 = 5 Hz
+    uint8_t sample_div;   // SMPLRT_DIV: taxa de saída = 8 kHz (DLPF 0) ou 1 kHz / (1 + div)
+    imu_clock_t clock;
+} imu_config_t;
+
+#define IMU_CONFIG_DEFAULT { .accel_range = 0, .gyro_range = 0, .dlpf = 0, .sample_div = 0, .clock = IMU_CLOCK_PLL_GYRO_X }
+
+// sensor_recover destrava os barramentos (SDA presa em 0: até 9 pulsos de
+// SCL e um STOP), reinicia o controlador (ou o PIO) e chama imu_reset.
+// Bloqueia ~110 ms.
 void imu_reset(void);
+const imu_dev_t *imu_device(int sensor);
+
+// Troca o transporte de I2C_PORT (só fora da gravação); hz vale para o PIO
+bool imu_set_transport(imu_transport_t transport, uint32_t hz);
+imu_transport_t imu_get_transport(void);
+void imu_clock_changed(void);   // após trocar clk_sys
+
+// Grava e confere os registradores de todos os sensores; em caso de falha a
+// configuração anterior continua valendo
+bool imu_set_config(const imu_config_t *config);
+const imu_config_t *imu_get_config(void);
+
+// Escalas e taxa de saída da configuração atual
+float imu_accel_lsb_per_g(void);
+float imu_gyro_lsb_per_dps(void);
+uint32_t imu_output_rate_hz(void);
+void imu_print_config(void);
 
 #endif
@@ -0,0 +1,79 @@
+#ifndef IMUCODEC_H
+#define IMUCODEC_H
+
+// Compressão sem perdas de amostras do IMU em blocos de tamanho fixo,
+// decodificáveis de forma independente. Cada bloco guarda a primeira
+// amostra inteira; as seguintes vão como diferença para a anterior (por
+// canal), mapeada em zigzag e codificada em Rice com o parâmetro k adaptado
+// à média recente dos valores do canal. O estado do codificador recomeça em
+// cada bloco, então um bloco corrompido não afeta os outros.
+// Não depende do SDK: o mesmo arquivo é usado pelo decodificador do host.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IMUCODEC_BLOCK_SIZE 512        // um setor do cartão
+#define IMUCODEC_BLOCK_MAGIC 0x4349    // "IC"
+#define IMUCODEC_AXES 6                // accel X/Y/Z, giro X/Y/Z
+#define IMUCODEC_MAX_SAMPLES 256       // limita o buffer do decodificador
+
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint16_t count;         // amostras no bloco (1..IMUCODEC_MAX_SAMPLES)
+    uint16_t payload_bits;  // bits usados depois do cabeçalho
+    uint16_t reserved;
+    uint32_t first_sample;
+    int16_t first[IMUCODEC_AXES];
+} imucodec_block_header_t;
+
+typedef struct {
+    uint32_t sample;
+    int16_t axis[IMUCODEC_AXES];  // accel[0..2], gyro[0..2]
+} imucodec_sample_t;
+
+// Estado adaptativo de um canal: soma (A) e número (N) de valores recentes
+typedef struct {
+    uint32_t sum;
+    uint32_t n;
+} imucodec_rice_t;
+
+typedef struct {
+    uint8_t *out;
+    uint32_t acc;      // bits pendentes, alinhados à direita
+    uint8_t nbits;
+    uint16_t pos;      // próximo byte de out
+    bool overflow;
+    uint16_t count;
+    imucodec_sample_t first;
+    imucodec_sample_t prev;
+    imucodec_rice_t rice[IMUCODEC_AXES + 1];  // canal 0: número da amostra
+} imucodec_state_t;
+
+// Dois blocos: um sendo montado e o último completo, que continua válido
+// até a próxima chamada de imucodec_encode/imucodec_flush
+typedef struct {
+    uint8_t block[2][IMUCODEC_BLOCK_SIZE] __attribute__((aligned(4)));
+    uint8_t current;
+    imucodec_state_t st;
+} imucodec_encoder_t;
+
+void imucodec_encoder_init(imucodec_encoder_t *enc);
+// Acrescenta uma amostra; devolve o bloco que ficou completo, ou NULL
+const uint8_t *imucodec_encode(imucodec_encoder_t *enc, uint32_t sample, const int16_t accel[3],
+                               const int16_t gyro[3]);
+// Fecha o bloco parcial (fim do log); NULL se não há amostras pendentes
+const uint8_t *imucodec_flush(imucodec_encoder_t *enc);
+
+// Decodifica um bloco em out (até max amostras); devolve o número de
+// amostras ou -1 se o bloco é inválido
+int imucodec_decode(const uint8_t block[IMUCODEC_BLOCK_SIZE], imucodec_sample_t *out, int max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // IMUCODEC_H
@@ -17,7 +17,8 @@ typedef enum {
     STATE_RECORDING,
     STATE_ERROR,
     STATE_MOUNTING_SD,   
-    STATE_UNMOUNTING_SD  
+    STATE_UNMOUNTING_SD,
+    STATE_USB_MSC        // SD exposto ao PC como disco USB
 } system_state_t;
 
 // Sequências de buzzer
@@ -30,12 +31,60 @@ typedef enum {
     BUZZER_SD_UNMOUNT
 } buzzer_sequence_t;
 
+// Padrões do LED RGB (avançados por interrupção de timer)
+typedef enum {
+    LED_PATTERN_OFF,
+    LED_PATTERN_SOLID,      // Cor fixa
+    LED_PATTERN_BLINK,      // Pisca com ciclo de trabalho configurável
+    LED_PATTERN_BREATHE,    // Brilho sobe e desce suavemente
+    LED_PATTERN_ALTERNATE   // Alterna entre cor principal e secundária
+} led_pattern_type_t;
+
+typedef struct {
+    led_pattern_type_t type;
+    uint8_t r, g, b;          // Cor principal (0-255)
+    uint8_t r2, g2, b2;       // Cor secundária (apenas ALTERNATE)
+    uint16_t period_ms;       // Período do padrão
+    uint8_t duty_percent;     // Fração do período com a cor principal
+    bool rate_follows_level;  // Período encurta conforme o nível de telemetria
+} led_pattern_t;
+
+// Status exibidos pelo LED (índices da tabela de padrões)
+typedef enum {
+    LED_STATUS_OFF,
+    LED_STATUS_INITIALIZING,
+    LED_STATUS_READY,
+    LED_STATUS_NO_SD,
+    LED_STATUS_SD_BUSY,
+    LED_STATUS_RECORDING,
+    LED_STATUS_SD_ACCESS,
+    LED_STATUS_ERROR,
+    LED_STATUS_USB_MSC,
+    LED_STATUS_COUNT
+} led_status_t;
+
+#define LED_TICK_MS 10
+#define LED_PWM_WRAP 4095
+
 // Funções da interface
 void interface_init(void);
 
 // Botões
 bool button_a_get_pressed(void);
 bool button_b_get_pressed(void);
+
+// A e B apertados com até BUTTON_CHORD_WINDOW_MS de diferença formam um
+// acorde; um aperto isolado só é entregue depois dessa janela
+#define BUTTON_CHORD_WINDOW_MS 150
+
+typedef enum {
+    BUTTON_EVENT_NONE,
+    BUTTON_EVENT_A,
+    BUTTON_EVENT_B,
+    BUTTON_EVENT_AB
+} button_event_t;
+
+button_event_t button_get_event(void);
 void button_irq_handler(uint gpio, uint32_t events);
 
 // Buzzer
@@ -49,4 +98,10 @@ void interface_sd_access_indication(bool accessing);
 // Atualização do estado geral da interface (LEDs)
 void interface_update_state(system_state_t state, bool sd_mounted, bool recording_active);
 
+// Recalcula divisores PWM após troca da frequência do sistema
+void interface_clock_changed(void);
+
+// Telemetria codificada no LED: 0-100%, acelera o padrão de gravação
+void interface_set_level(uint8_t percent);
+
 #endif // INTERFACE_H
\ No newline at end of file
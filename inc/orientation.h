@@ -0,0 +1,58 @@
+#ifndef ORIENTATION_H
+#define ORIENTATION_H
+
+// Estimativa de orientação (filtro complementar de Mahony, só acelerômetro e
+// giroscópio) em ponto fixo, para o Cortex-M0+ sem FPU. O quatérnio fica em
+// Q30 e as constantes do filtro são convertidas uma vez em orientation_init;
+// a atualização usa só multiplicações inteiras. Sem magnetômetro, o yaw
+// deriva com o erro do giroscópio.
+// A sessão de log grava quatérnios ou ângulos de Euler em <base>_ori.csv,
+// uma linha a cada 'decimação' amostras.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ORIENT_Q_ONE (1 << 30)          // 1,0 em Q30
+#define ORIENT_KP 1.0f                  // ganho proporcional (1/s)
+#define ORIENT_KI 0.05f                 // ganho integral (1/s^2): estima o bias do giroscópio
+#define ORIENT_GYRO_LSB_PER_DPS 131.0f  // padrão: MPU6050 em +-250 graus/s
+#define ORIENT_ACCEL_LSB_PER_G 16384.0f // padrão: MPU6050 em +-2 g
+#define ORIENT_DECIMATION 10
+
+typedef struct {
+    int32_t q[4];          // w, x, y, z em Q30
+    int32_t integral[3];   // correção integral, rad/s em Q30
+    bool aligned;          // q já inicializado pela gravidade
+
+    // Constantes de orientation_init
+    int32_t gyro_half_dt;  // rad por LSB * dt/2, em Q40
+    int32_t kp_half_dt;    // Kp * dt/2, em Q30
+    int32_t ki_dt;         // Ki * dt, em Q30
+    int32_t half_dt;       // dt/2, em Q30
+    uint32_t accel_min_sq; // fora de [0,5 g; 1,5 g] o acelerômetro não corrige
+    uint32_t accel_max_sq;
+} orientation_t;
+
+typedef enum {
+    ORIENT_OFF = 0,
+    ORIENT_QUATERNION,  // qw, qx, qy, qz em Q30
+    ORIENT_EULER        // roll, pitch, yaw em centésimos de grau
+} orientation_output_t;
+
+void orientation_init(orientation_t *o, uint32_t rate_hz, float gyro_lsb_per_dps, float accel_lsb_per_g);
+void orientation_update(orientation_t *o, const int16_t accel[3], const int16_t gyro[3]);
+void orientation_euler_cdeg(const orientation_t *o, int32_t euler[3]);
+
+// Sessão de log
+bool orientation_set_output(orientation_output_t output);
+orientation_output_t orientation_get_output(void);
+bool orientation_set_decimation(uint16_t decimation);
+bool orientation_set_scale(float gyro_lsb_per_dps, float accel_lsb_per_g);
+bool orientation_start(const char *log_filename, uint32_t sample_rate_hz);
+void orientation_stop(void);
+bool orientation_is_active(void);
+bool orientation_process(uint32_t sample_num, const int16_t accel[3], const int16_t gyro[3]);
+const orientation_t *orientation_current(void);
+void orientation_print_status(void);
+
+#endif // ORIENTATION_H
@@ -0,0 +1,43 @@
+#ifndef PIO_I2C_H
+#define PIO_I2C_H
+
+// Mestre I2C alternativo em PIO (pio0), para o barramento do IMU: uma
+// transação inteira (START, endereço, registrador, RESTART, leitura, STOP)
+// vira uma lista de palavras que o DMA entrega à máquina de estados, e
+// outro canal de DMA recolhe os bytes recebidos. O fim da transação gera
+// uma interrupção (DMA_IRQ_1) e um NAK inesperado outra (PIO0_IRQ_0), então
+// a CPU não toca em nenhum byte e pode dormir (WFE) enquanto espera.
+// Uma transação por vez; não usar de interrupções.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "pico/stdlib.h"
+
+#define PIO_I2C_MAX_LEN 16                 // bytes por leitura ou escrita
+#define PIO_I2C_MIN_HZ (100 * 1000)
+#define PIO_I2C_MAX_HZ (1000 * 1000)       // Fast-mode Plus
+#define PIO_I2C_TIMEOUT_US 5000            // leitura de 16 bytes a 100 kHz: ~2 ms
+
+// Toma os pinos (SCL = SDA + 1) e os recursos de PIO/DMA
+bool pio_i2c_init(uint pin_sda, uint pin_scl, uint32_t hz);
+void pio_i2c_deinit(void);
+bool pio_i2c_is_active(void);
+
+// Frequência do barramento; chamar de novo após trocar clk_sys
+void pio_i2c_set_baudrate(uint32_t hz);
+uint32_t pio_i2c_get_baudrate(void);
+
+// Leitura de registradores em segundo plano: inicia e depois espera (WFE) e
+// copia os bytes. false em pio_i2c_read_finish = NAK ou prazo esgotado.
+bool pio_i2c_read_start(uint8_t addr, uint8_t reg, size_t len);
+bool pio_i2c_busy(void);
+bool pio_i2c_read_finish(uint8_t *dst, absolute_time_t deadline);
+
+// Versões bloqueantes, para configuração e sondagem
+bool pio_i2c_read_reg(uint8_t addr, uint8_t reg, uint8_t *dst, size_t len);
+bool pio_i2c_write(uint8_t addr, const uint8_t *src, size_t len);
+
+uint32_t pio_i2c_errors(void);
+
+#endif
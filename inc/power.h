@@ -0,0 +1,23 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Frequências do sistema: plena durante a gravação, reduzida em repouso
+#define POWER_CLOCK_ACTIVE_KHZ 125000
+#define POWER_CLOCK_IDLE_KHZ   48000
+
+void power_init(void);
+void power_set_active(bool active);
+bool power_is_active(void);
+
+// Dorme (WFE) até o instante dado; retorna true se acordado por evento
+bool power_idle_until(uint64_t deadline_us);
+void power_notify_wakeup(void);
+
+uint32_t power_duty_permille(void);
+void power_print_stats(void);
+void power_reset_stats(void);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SCHED_MAX_TASKS 12
+#define SCHED_INVALID_TASK (-1)
+
+typedef void (*sched_task_fn_t)(void);
+
+// Tarefa periódica com prioridade, orçamento e estatísticas de execução
+typedef struct {
+    const char *name;
+    sched_task_fn_t fn;
+    uint32_t period_us;
+    uint8_t priority;           // Maior valor = maior prioridade
+    uint32_t budget_us;         // Tempo de execução esperado por ativação
+    bool enabled;
+    uint64_t release_us;        // Próxima liberação (a deadline é release + período)
+
+    // Estatísticas
+    uint32_t runs;
+    uint32_t last_us;
+    uint32_t wcet_us;           // Pior tempo de execução observado
+    uint64_t total_us;
+    uint32_t max_latency_us;    // Maior atraso entre liberação e início
+    uint32_t overruns;          // Execuções acima do orçamento
+    uint32_t deadline_misses;   // Execuções concluídas após a deadline
+    uint32_t skipped;           // Liberações perdidas por atraso acumulado
+} sched_task_t;
+
+int sched_add_task(const char *name, sched_task_fn_t fn, uint32_t period_ms,
+                   uint8_t priority, uint32_t budget_us);
+void sched_set_period_ms(int id, uint32_t period_ms);
+void sched_set_period_us(int id, uint32_t period_us);
+void sched_set_enabled(int id, bool enabled);
+void sched_release_now(int id);
+void sched_set_wakeup_task(int id);
+const sched_task_t *sched_get_task(int id);
+int sched_task_count(void);
+
+bool sched_run_once(void);
+void sched_run(void);
+
+void sched_print_stats(void);
+void sched_reset_stats(void);
+
+#endif
@@ -2,14 +2,56 @@
 #define SDLOGGER_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "ff.h" 
 #include "sd_card.h"
+#include "sdlogger_format.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Formato do arquivo de log
+typedef enum {
+    SDLOGGER_FORMAT_CSV = 0,   // texto, uma linha por amostra (padrão)
+    SDLOGGER_FORMAT_BINARY,    // cabeçalho + registros fixos little-endian
+    SDLOGGER_FORMAT_COMPRESSED // cabeçalho + blocos delta/Rice de imucodec.h
+} sdlogger_format_t;
+
+// Buffer em RAM do modo bufferizado: múltiplo do setor, gravado em f_write
+// alinhados a setor (FatFs escreve direto no cartão, em multi-bloco)
+#define SDLOGGER_BUFFER_SIZE 4096
+
+// Novas tentativas de uma escrita que falhou no cartão antes de perder os dados
+#define SDLOGGER_WRITE_RETRIES 2
+
+// Índice esparso mantido em RAM durante o log: uma entrada a cada
+// SDLOGGER_INDEX_INTERVAL registros; quando a tabela enche, metade das
+// entradas é descartada e o intervalo dobra
+#define SDLOGGER_INDEX_ENTRIES 512
+#define SDLOGGER_INDEX_INTERVAL 1000
+
+// Entradas da tabela de fast seek (FF_USE_FASTSEEK) dos leitores: 2 por
+// fragmento do arquivo + 1
+#define SDLOGGER_CLMT_LEN 64
+
+// Metadados "chave=valor" gravados no início de cada log novo: linhas
+// "# chave=valor" antes do cabeçalho CSV; nos formatos binário e comprimido,
+// as mesmas linhas ficam entre o cabeçalho e o primeiro registro
+#define SDLOGGER_METADATA_SIZE 384
+
+// Vários sensores no mesmo log: as linhas de uma amostra (mesmo número, um
+// sensor por linha) ficam seguidas, com a coluna extra "sensor" no CSV e no
+// binário; o formato comprimido grava um sensor só
+#define SDLOGGER_MAX_SENSORS 4
+
+// Chave de busca de sdlogger_seek
+typedef enum {
+    SDLOGGER_SEEK_SAMPLE = 0,  // primeiro registro com amostra >= valor
+    SDLOGGER_SEEK_TIME_MS      // entrada do índice com tempo <= valor (ms desde o início)
+} sdlogger_seek_by_t;
+
 // Funções de ajuda
 sd_card_t *sd_get_by_name(const char *const name);
 FATFS *sd_get_fs_by_name(const char *name);
@@ -28,7 +70,23 @@ void capture_adc_data_and_save();
 void read_file(const char *filename);
 bool sdlogger_start(const char *log_filename); 
 bool sdlogger_log_sample(uint32_t sample_num, int16_t accel[3], int16_t gyro[3]); 
+bool sdlogger_log_sensor(uint32_t sample_num, uint8_t sensor, int16_t accel[3], int16_t gyro[3]);
+// Linha "# texto" no meio dos dados (só CSV; nos binários não há onde pôr)
+bool sdlogger_log_note(const char *text);
 void sdlogger_stop();
+// Amostras do último log que chegaram ao arquivo (sem as perdidas em falhas)
+uint32_t sdlogger_records_written(void);
+uint8_t sdlogger_buffer_fill_percent(void);
+bool sdlogger_set_format(sdlogger_format_t format);
+sdlogger_format_t sdlogger_get_format(void);
+const char *sdlogger_format_name(sdlogger_format_t format);
+bool sdlogger_set_buffered(bool buffered);
+bool sdlogger_is_buffered(void);
+bool sdlogger_flush(void);
+bool sdlogger_set_metadata(const char *key, const char *value);
+bool sdlogger_set_sensors(uint8_t count);
+bool sdlogger_index_path(const char *log_filename, char *out, size_t len);
+FRESULT sdlogger_seek(FIL *fp, const char *log_filename, sdlogger_seek_by_t by, uint32_t value);
 
 // Função de ajuda do CLI
 void run_help();
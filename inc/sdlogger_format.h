@@ -0,0 +1,67 @@
+#ifndef SDLOGGER_FORMAT_H
+#define SDLOGGER_FORMAT_H
+
+// Layout do arquivo de log binário e do índice, compartilhado entre o
+// firmware (sdlogger.c) e as ferramentas de host. Não depende de FatFs nem do SDK.
+
+#include <stdint.h>
+
+// Formato binário: sdlogger_bin_header_t seguido de sdlogger_bin_record_t.
+// Entre o cabeçalho e header_size pode haver metadados em texto, linhas
+// "# chave=valor\n" (completadas com zeros no formato comprimido)
+#define SDLOGGER_BIN_MAGIC "IMUBIN01"
+#define SDLOGGER_BIN_MAGIC_LEN 8
+
+typedef struct __attribute__((packed)) {
+    char magic[SDLOGGER_BIN_MAGIC_LEN];
+    uint16_t header_size;  // bytes até o primeiro registro
+    uint16_t record_size;  // sizeof(sdlogger_bin_record_t)
+    uint32_t reserved;
+} sdlogger_bin_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t sample;
+    int16_t accel[3];
+    int16_t gyro[3];
+} sdlogger_bin_record_t;
+
+// Com mais de um sensor (sdlogger_set_sensors) o registro leva o índice do
+// sensor depois dos campos de sdlogger_bin_record_t e record_size passa a
+// sizeof(sdlogger_bin_sensor_record_t): quem lê só os 16 primeiros bytes de
+// cada registro continua funcionando
+typedef struct __attribute__((packed)) {
+    sdlogger_bin_record_t base;
+    uint8_t sensor;
+    uint8_t reserved;
+} sdlogger_bin_sensor_record_t;
+
+// Formato comprimido: sdlogger_bin_header_t com SDLOGGER_RICE_MAGIC ocupando
+// um bloco inteiro (header_size = record_size = IMUCODEC_BLOCK_SIZE), seguido
+// de blocos de imucodec.h alinhados a setor
+#define SDLOGGER_RICE_MAGIC "IMURIC01"
+
+// Índice esparso, gravado em sdlogger_stop num arquivo lateral com o nome do
+// log seguido de SDLOGGER_IDX_EXT (imu_data.csv.idx): sdlogger_idx_header_t
+// seguido de 'count' entradas em ordem crescente de amostra, uma a cada
+// 'interval' registros. log_magic e log_size identificam o log indexado; um
+// índice que não bate com o arquivo é ignorado
+#define SDLOGGER_IDX_MAGIC "IMUIDX02"
+#define SDLOGGER_IDX_EXT ".idx"
+
+typedef struct __attribute__((packed)) {
+    char magic[SDLOGGER_BIN_MAGIC_LEN];
+    uint16_t header_size;  // bytes até a primeira entrada
+    uint16_t entry_size;   // sizeof(sdlogger_idx_entry_t)
+    uint32_t interval;     // registros entre entradas consecutivas
+    uint32_t count;        // número de entradas
+    char log_magic[SDLOGGER_BIN_MAGIC_LEN];  // magic do log (zeros para CSV)
+    uint64_t log_size;     // tamanho do log em bytes
+} sdlogger_idx_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t sample;   // número da amostra do registro
+    uint32_t time_ms;  // desde sdlogger_start
+    uint64_t offset;   // início do registro no arquivo de log, em bytes
+} sdlogger_idx_entry_t;
+
+#endif // SDLOGGER_FORMAT_H
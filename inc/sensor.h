@@ -0,0 +1,142 @@
+#ifndef SENSOR_H
+#define SENSOR_H
+
+// Interface do sensor inercial usada pela aquisição (main.c) e pela
+// calibração: iniciar, configurar, ler todos os sensores no tick, esvaziar a
+// FIFO e descrever os canais. O driver é escolhido na compilação
+// (SENSOR_DRIVER, padrão mpu6050) e cada sensor_<nome> é um inline que chama
+// <driver>_sensor_<nome> direto, então o caminho da amostra não passa por
+// ponteiro de função e o compilador vê a chamada concreta.
+// Um driver novo implementa as funções declaradas abaixo com o seu prefixo e
+// preenche sensor_sample_t com valores brutos em int16; log, display e
+// análises não mudam.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef SENSOR_DRIVER
+#define SENSOR_DRIVER mpu6050
+#endif
+
+#define SENSOR_MAX_DEVICES 4
+#define SENSOR_CHANNELS 7        // accel x, y, z, giro x, y, z, temperatura
+#define SENSOR_CH_ACCEL 0        // primeiro canal do acelerômetro em sensor_info_t
+#define SENSOR_CH_GYRO 3         // primeiro canal do giroscópio
+
+// Uma amostra bruta de um sensor
+typedef struct {
+    int16_t accel[3];
+    int16_t gyro[3];
+    int16_t temp;
+    bool ok;
+} sensor_sample_t;
+
+typedef enum {
+    SENSOR_UNIT_G = 0,
+    SENSOR_UNIT_DPS,
+    SENSOR_UNIT_CELSIUS
+} sensor_unit_t;
+
+// valor físico = bruto / lsb_per_unit + offset
+typedef struct {
+    const char *name;
+    sensor_unit_t unit;
+    float lsb_per_unit;
+    float offset;
+} sensor_channel_t;
+
+typedef struct {
+    const char *model;
+    uint8_t devices;                            // sensores encontrados
+    uint8_t channel_count;
+    sensor_channel_t channel[SENSOR_CHANNELS];  // na escala atual
+    uint32_t output_rate_hz;                    // taxa de saída de dados do sensor
+    uint16_t fifo_frames;                       // capacidade da FIFO em amostras (0 = sem FIFO)
+    uint32_t fifo_overflows;
+} sensor_info_t;
+
+// Configuração comum a qualquer driver; 0 mantém o valor atual. O driver
+// escolhe a escala e a taxa suportadas mais próximas (acima do pedido).
+typedef struct {
+    uint16_t accel_g;
+    uint16_t gyro_dps;
+    uint32_t output_rate_hz;
+} sensor_config_t;
+
+#define SENSOR_PASTE_(driver, name) driver##_sensor_##name
+#define SENSOR_PASTE(driver, name) SENSOR_PASTE_(driver, name)
+#define SENSOR_FN(name) SENSOR_PASTE(SENSOR_DRIVER, name)
+
+// Implementadas pelo driver
+bool SENSOR_FN(init)(void);
+bool SENSOR_FN(configure)(const sensor_config_t *config);
+int SENSOR_FN(count)(void);
+bool SENSOR_FN(read)(sensor_sample_t out[SENSOR_MAX_DEVICES]);
+bool SENSOR_FN(read_primary)(sensor_sample_t *out);
+bool SENSOR_FN(fifo_enable)(bool on);
+int SENSOR_FN(fifo_drain)(sensor_sample_t *out, int max);
+bool SENSOR_FN(recover)(void);
+const sensor_info_t *SENSOR_FN(describe)(void);
+
+// Detecta os sensores e aplica a configuração padrão; false se o principal não responde
+static inline bool sensor_init(void) {
+    return SENSOR_FN(init)();
+}
+
+static inline bool sensor_configure(const sensor_config_t *config) {
+    return SENSOR_FN(configure)(config);
+}
+
+static inline int sensor_count(void) {
+    return SENSOR_FN(count)();
+}
+
+// Todos os sensores no mesmo tick; true se todas as leituras deram certo
+static inline bool sensor_read(sensor_sample_t out[SENSOR_MAX_DEVICES]) {
+    return SENSOR_FN(read)(out);
+}
+
+static inline bool sensor_read_primary(sensor_sample_t *out) {
+    return SENSOR_FN(read_primary)(out);
+}
+
+// FIFO do sensor principal: ligar zera o conteúdo. drain copia até 'max'
+// amostras na ordem de chegada; -1 em erro de barramento. Num transbordo a
+// FIFO é zerada e fifo_overflows em sensor_describe aumenta.
+static inline bool sensor_fifo_enable(bool on) {
+    return SENSOR_FN(fifo_enable)(on);
+}
+
+static inline int sensor_fifo_drain(sensor_sample_t *out, int max) {
+    return SENSOR_FN(fifo_drain)(out, max);
+}
+
+// Destrava o barramento e reinicia os sensores (e a FIFO, se ligada)
+static inline bool sensor_recover(void) {
+    return SENSOR_FN(recover)();
+}
+
+static inline const sensor_info_t *sensor_describe(void) {
+    return SENSOR_FN(describe)();
+}
+
+// LSB por g e por grau/s na escala atual
+static inline float sensor_accel_lsb_per_g(void) {
+    return sensor_describe()->channel[SENSOR_CH_ACCEL].lsb_per_unit;
+}
+
+static inline float sensor_gyro_lsb_per_dps(void) {
+    return sensor_describe()->channel[SENSOR_CH_GYRO].lsb_per_unit;
+}
+
+// Valor medido numa escala de from_lsb LSB por unidade expresso em outra de
+// to_lsb, arredondado e saturado em int16 (offsets que acompanham uma troca
+// de escala)
+static inline int16_t sensor_rescale(int32_t v, float from_lsb, float to_lsb) {
+    float r = from_lsb > 0.0f ? (float)v * (to_lsb / from_lsb) : (float)v;
+    if (r >= (float)INT16_MAX) return INT16_MAX;
+    if (r <= (float)INT16_MIN) return INT16_MIN;
+    return (int16_t)(r >= 0.0f ? r + 0.5f : r - 0.5f);
+}
+
+#endif // SENSOR_H
@@ -0,0 +1,26 @@
+#ifndef SHELL_H
+#define SHELL_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#define SHELL_LINE_MAX 128
+#define SHELL_MAX_CHARS_PER_POLL 64
+
+// Os argumentos são obtidos pelo próprio handler com strtok(NULL, " "),
+// como nas funções run_* de sdlogger.c
+typedef void (*shell_handler_t)(void);
+
+typedef struct {
+    const char *name;
+    const char *alias;     // Atalho de uma letra (pode ser NULL)
+    shell_handler_t handler;
+    const char *help;
+} shell_command_t;
+
+void shell_init(const shell_command_t *commands, size_t count);
+void shell_poll(void);
+void shell_execute(char *line);
+void shell_print_help(void);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+// Espectro de vibração no dispositivo: FFT em ponto fixo (Q15, 256 ou 512
+// pontos, janela de Hann) sobre cada eixo do acelerômetro. Os quadros são
+// acumulados em buffer duplo e a FFT do quadro anterior avança um passo
+// (janela, um estágio de borboletas ou acúmulo) a cada amostra nova, então o
+// custo por amostra fica limitado. A cada intervalo, a média dos espectros
+// vira uma linha por eixo em <base>_fft.csv: pico, RMS e RMS por banda.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SPECTRUM_MAX_POINTS 512
+#define SPECTRUM_AXES 3
+#define SPECTRUM_BANDS 8             // faixas iguais entre 0 e a frequência de Nyquist
+#define SPECTRUM_INTERVAL_MS 1000    // padrão do intervalo entre linhas do arquivo
+
+typedef enum {
+    SPECTRUM_OFF = 0,
+    SPECTRUM_WITH_RAW,   // espectro junto com o log das amostras
+    SPECTRUM_ONLY        // só o espectro: nenhuma amostra vai para o cartão
+} spectrum_mode_t;
+
+// Resultado de um intervalo; RMS em unidades brutas do acelerômetro
+typedef struct {
+    uint32_t sample;                       // última amostra do intervalo
+    uint32_t peak_mhz[SPECTRUM_AXES];      // frequência de pico (mHz, interpolada)
+    uint32_t peak_rms[SPECTRUM_AXES];      // RMS na raia do pico
+    uint32_t rms[SPECTRUM_AXES];           // RMS sem a componente contínua
+    uint32_t band_rms[SPECTRUM_AXES][SPECTRUM_BANDS];
+} spectrum_report_t;
+
+bool spectrum_set_mode(spectrum_mode_t mode);
+spectrum_mode_t spectrum_get_mode(void);
+bool spectrum_set_points(uint16_t points);
+uint16_t spectrum_get_points(void);
+bool spectrum_set_interval_ms(uint32_t ms);
+
+// Sessão: abre <base>_fft.csv ao lado do log e zera os quadros
+bool spectrum_start(const char *log_filename, uint32_t sample_rate_hz);
+void spectrum_stop(void);
+bool spectrum_is_active(void);
+
+// Chamada a cada amostra; false se a escrita do arquivo falhou
+bool spectrum_process(uint32_t sample_num, const int16_t accel[3]);
+
+// Último intervalo concluído (NULL antes do primeiro) e eixo de maior pico
+const spectrum_report_t *spectrum_last_report(void);
+bool spectrum_dominant(uint8_t *axis, uint32_t *peak_mhz);
+
+void spectrum_print_status(void);
+
+#endif // SPECTRUM_H
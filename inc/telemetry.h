@@ -0,0 +1,45 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Métricas de tempo coletadas em histogramas log2 (microssegundos)
+typedef enum {
+    TELEM_SAMPLE_JITTER,   // |intervalo real - intervalo nominal| entre amostras
+    TELEM_IMU_READ,        // Latência de leitura do IMU
+    TELEM_SD_WRITE,        // Latência de cada chamada de escrita no SD
+    TELEM_DISPLAY,         // Atualização do display OLED
+    TELEM_BUZZER,          // Sequências do buzzer (bloqueantes)
+    TELEM_LOOP,            // Iteração do laço principal (tarefa executada)
+    TELEM_SPECTRUM,        // Passo da FFT/espectro feito em cada amostra
+    TELEM_I2C_RECOVERY,    // Recuperação de barramento I2C travado (sensor_recover)
+    TELEM_METRIC_COUNT
+} telem_metric_t;
+
+// Bucket 0 = 0 us; bucket i (i >= 1) = [2^(i-1), 2^i) us; o último acumula o excedente
+#define TELEM_BUCKETS 24
+
+typedef struct {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t buckets[TELEM_BUCKETS];
+} telem_hist_t;
+
+void telemetry_init(void);
+void telemetry_record(telem_metric_t metric, uint32_t us);
+void telemetry_count_dropped(uint32_t samples);
+uint32_t telemetry_dropped(void);
+void telemetry_count_i2c_recovery(bool ok);
+const telem_hist_t *telemetry_get(telem_metric_t metric);
+uint32_t telemetry_percentile(telem_metric_t metric, uint8_t percent);
+
+uint32_t telemetry_free_heap(void);
+uint32_t telemetry_stack_high_water(void);
+
+void telemetry_print(void);
+void telemetry_reset(void);
+
+#endif
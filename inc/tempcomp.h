@@ -0,0 +1,62 @@
+#ifndef TEMPCOMP_H
+#define TEMPCOMP_H
+
+// Compensação térmica dos offsets do sensor principal: para cada eixo um
+// polinômio sem termo constante na diferença para a temperatura de
+// referência, off(dT) = c1 dT + c2 dT^2 + c3 dT^3 (LSB), subtraído das
+// leituras brutas antes da calibração. A temperatura do die chega no mesmo
+// burst das leituras; a cada TEMPCOMP_WINDOW amostras a média dela refaz os
+// seis offsets (Horner em ponto fixo: coeficientes em Q24, dT em Q8 graus),
+// então por amostra só sobram as subtrações.
+// Os coeficientes são ajustados no host (imulog_tempfit) a partir de
+// <base>_temp.csv, gravado com "tempcomp registro on" durante uma variação
+// de temperatura com o IMU parado: médias por janela das leituras brutas e
+// da temperatura. Ficam na flash, no setor antes do da calibração.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TEMPCOMP_ORDER 3
+#define TEMPCOMP_WINDOW 100         // amostras por atualização e por linha de _temp.csv
+#define TEMPCOMP_COEF_FRAC 24       // coeficientes em Q24 (LSB/grau^k)
+#define TEMPCOMP_TEMP_FRAC 8        // temperaturas em Q8 graus C
+#define TEMPCOMP_MAX_DELTA_C 80     // dT saturado em +-80 graus
+#define TEMPCOMP_MAX_COEF 127.0f    // limite de |ck| em Q24
+
+// TEMP_OUT do MPU6050: graus C = bruto / 340 + 36,53
+#define TEMPCOMP_LSB_PER_C 340
+#define TEMPCOMP_OFFSET_CC 3653     // 36,53 graus em centésimos
+
+typedef struct {
+    int32_t ref_q8;                      // temperatura de referência
+    int32_t coef[6][TEMPCOMP_ORDER];     // ax, ay, az, gx, gy, gz; c1..c3
+    float accel_lsb_per_g;               // escalas em que os coeficientes valem
+    float gyro_lsb_per_dps;
+    uint8_t enabled;
+    uint8_t reserved[3];
+} tempcomp_t;
+
+bool tempcomp_load(void);
+bool tempcomp_save(void);
+void tempcomp_clear(void);
+bool tempcomp_set_ref(float celsius);
+// axis 0..5 = ax, ay, az, gx, gy, gz; coeficientes em LSB/grau^k na escala atual
+bool tempcomp_set_axis(int axis, const float coef[TEMPCOMP_ORDER]);
+int tempcomp_axis_index(const char *name);   // "ax".."gz"; -1 se inválido
+bool tempcomp_set_enabled(bool on);
+bool tempcomp_is_enabled(void);
+void tempcomp_refresh(void);   // após trocar a escala do sensor
+
+int32_t tempcomp_celsius_q8(int16_t temp_raw);
+// Offsets (LSB, escala atual) numa temperatura; false se a compensação está desligada
+bool tempcomp_offsets_at(int16_t temp_raw, int16_t offsets[6]);
+
+// Sessão: média da temperatura, offsets e, com o registro ligado, uma linha
+// em <base>_temp.csv por janela. tempcomp_process compensa accel/gyro.
+bool tempcomp_set_logging(bool on);
+bool tempcomp_start(const char *log_filename);
+void tempcomp_stop(void);
+bool tempcomp_process(uint32_t sample_num, int16_t temp_raw, int16_t accel[3], int16_t gyro[3]);
+void tempcomp_print_status(void);
+
+#endif // TEMPCOMP_H
@@ -0,0 +1,28 @@
+#ifndef TUSB_CONFIG_H
+#define TUSB_CONFIG_H
+
+// Configuração do TinyUSB: dispositivo composto com o CDC do shell (stdio,
+// interface 0, usada por pico_stdio_usb) e o disco USB (MSC) do modo "usb".
+// Os descritores estão em src/usb_descriptors.c.
+
+#define CFG_TUSB_RHPORT0_MODE OPT_MODE_DEVICE
+#define CFG_TUD_ENDPOINT0_SIZE 64
+
+#define CFG_TUD_CDC 1
+#define CFG_TUD_MSC 1
+#define CFG_TUD_HID 0
+#define CFG_TUD_MIDI 0
+#define CFG_TUD_VENDOR 0
+
+// A FIFO de saída comporta dois quadros do "xfer" (xfer_protocol.h): um
+// escoa enquanto o próximo é lido do SD. Os endpoints do CDC ficam em 64
+// bytes: com buffer maior, um pedido de tamanho múltiplo de 64 só chegaria
+// ao firmware junto com o seguinte (o host não manda pacote vazio).
+#define CFG_TUD_CDC_RX_BUFSIZE 512
+#define CFG_TUD_CDC_TX_BUFSIZE 8192
+#define CFG_TUD_CDC_EP_BUFSIZE 64
+
+// Bloco de dados de cada READ10/WRITE10 entregue aos callbacks: 8 setores
+#define CFG_TUD_MSC_EP_BUFSIZE 4096
+
+#endif // TUSB_CONFIG_H
@@ -0,0 +1,39 @@
+#ifndef USB_MSC_H
+#define USB_MSC_H
+
+// Modo disco USB: o SD aparece no PC como um pendrive (USB mass storage,
+// TinyUSB), para copiar logs grandes na velocidade do USB em vez de passar
+// por "cat" no shell. Fora do modo, o PC vê um leitor sem cartão; o shell
+// (CDC) funciona nos dois casos.
+// Quem entra no modo desmonta o FatFs antes: com o cartão exposto, o PC é o
+// único a escrever nele. As leituras usam sd_read_blocks_ahead (janela de
+// leitura antecipada com CMD18), então uma cópia sequencial paga o comando e
+// a latência do cartão uma vez a cada SD_READ_AHEAD_BLOCKS setores.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sd_card.h"
+
+#define USB_TASK_INTERVAL_MS 10     // só o shell
+#define USB_MSC_TASK_INTERVAL_MS 1  // com o disco exposto
+
+// Inicia o TinyUSB (CDC + MSC); chamar antes de stdio_init_all
+void usb_msc_init(void);
+// Atende o USB (tud_task); tarefa do escalonador
+void usb_msc_task(void);
+bool usb_msc_host_connected(void);
+// Espera até ms atendendo o USB. Antes do escalonador só ela chama tud_task
+// (o stdio não tem tarefa de fundo): sem isso o PC não enumera o dispositivo
+// e o printf da partida se perde. Com until_terminal, volta assim que um
+// terminal abre a porta serial
+void usb_msc_wait_ms(uint32_t ms, bool until_terminal);
+
+// Expõe o cartão ao PC; o FatFs já deve estar desmontado
+bool usb_msc_start(sd_card_t *pSD);
+void usb_msc_stop(void);
+bool usb_msc_is_active(void);
+// true uma vez depois que o PC ejetou o disco
+bool usb_msc_take_eject(void);
+void usb_msc_print_status(void);
+
+#endif // USB_MSC_H
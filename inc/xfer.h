@@ -0,0 +1,24 @@
+#ifndef XFER_H
+#define XFER_H
+
+// Sessão de transferência binária pelo CDC (protocolo em xfer_protocol.h):
+// listar, consultar e ler faixas de arquivos do SD com quadros de até 4 KiB,
+// CRC-32 por quadro, janela de confirmações e retomada por offset. Durante a
+// sessão o stdio USB fica desligado (printf não mistura texto nos quadros) e
+// o shell não lê a serial; ela termina com BYE, com a queda do host (DTR ou
+// cabo) ou depois de XFER_IDLE_TIMEOUT_MS sem pedidos.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "xfer_protocol.h"
+
+#define XFER_SLICE_US 4000   // tempo máximo por chamada de xfer_poll com dados a enviar
+
+// O FatFs deve estar montado e sem gravação em andamento
+bool xfer_start(void);
+bool xfer_is_active(void);
+// Atende pedidos e envia quadros; chamada pela tarefa do USB
+void xfer_poll(void);
+
+#endif // XFER_H
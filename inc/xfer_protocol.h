@@ -0,0 +1,86 @@
+#ifndef XFER_PROTOCOL_H
+#define XFER_PROTOCOL_H
+
+// Protocolo binário de transferência de arquivos pelo CDC (shell USB),
+// compartilhado entre o firmware (xfer.c) e o cliente de host. Não depende
+// de FatFs nem do SDK.
+//
+// O comando "xfer" do shell troca o CDC para quadros:
+//     xfer_header_t | payload (length bytes) | CRC-32 (crc32.h) do cabeçalho + payload
+// tudo little-endian. Quem recebe procura XFER_MAGIC, confere o tamanho e o
+// CRC e descarta o que não fecha, então lixo na linha (texto do shell,
+// quadro cortado) só custa uma ressincronização.
+//
+// Pedidos do host levam um seq; as respostas têm type | XFER_REPLY e o mesmo
+// seq. READ responde com quadros de dados (offset = posição no arquivo) e
+// termina com um quadro vazio de status XFER_ST_EOF. O firmware mantém até
+// XFER_WINDOW_FRAMES quadros sem confirmação: o host confirma com ACK
+// (offset = próximo byte esperado) e pede reenvio com NAK a partir do
+// primeiro byte que faltou; sem ACK por XFER_RETRY_MS, o firmware volta ao
+// último byte confirmado. Para retomar depois de uma queda, basta um READ
+// novo a partir do que já foi salvo.
+
+#include <stdint.h>
+
+#define XFER_MAGIC 0x4658            // bytes 'X' 'F'
+#define XFER_VERSION 1
+#define XFER_MAX_PAYLOAD 4096        // dados por quadro (o primeiro vai até a fronteira de 4 KiB)
+#define XFER_MAX_REQUEST 512         // payload máximo de um pedido do host
+#define XFER_WINDOW_FRAMES 8
+#define XFER_RETRY_MS 500
+#define XFER_IDLE_TIMEOUT_MS 15000   // sem pedidos do host: volta ao shell
+#define XFER_READ_TO_END UINT64_MAX
+
+typedef enum {
+    XFER_HELLO = 0x01,  // -> xfer_hello_t
+    XFER_LIST = 0x02,   // payload: diretório -> quadros de xfer_entry_t + nome, o último com XFER_ST_EOF
+    XFER_STAT = 0x03,   // payload: arquivo -> xfer_entry_t (sem nome)
+    XFER_READ = 0x04,   // offset: início; payload: xfer_read_t + arquivo -> dados
+    XFER_ACK = 0x05,    // offset: próximo byte esperado (sem resposta)
+    XFER_NAK = 0x06,    // offset: reenviar a partir daqui (sem resposta)
+    XFER_BYE = 0x07     // -> resposta vazia e volta ao shell
+} xfer_type_t;
+
+#define XFER_REPLY 0x80
+
+typedef enum {
+    XFER_ST_OK = 0,
+    XFER_ST_EOF,          // fim da listagem ou da faixa lida
+    XFER_ST_NOT_FOUND,
+    XFER_ST_IO_ERROR,
+    XFER_ST_BAD_REQUEST
+} xfer_status_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t magic;
+    uint8_t type;
+    uint8_t status;       // respostas: xfer_status_t; pedidos: 0
+    uint16_t seq;
+    uint16_t length;      // bytes de payload
+    uint64_t offset;
+} xfer_header_t;
+
+#define XFER_CRC_SIZE 4
+#define XFER_FRAME_OVERHEAD (sizeof(xfer_header_t) + XFER_CRC_SIZE)
+
+typedef struct __attribute__((packed)) {
+    uint16_t version;
+    uint16_t max_payload;
+    uint16_t window_frames;
+    uint16_t reserved;
+} xfer_hello_t;
+
+// Entrada de LIST (seguida de name_len bytes do nome) e resposta de STAT
+typedef struct __attribute__((packed)) {
+    uint64_t size;
+    uint16_t fdate;       // data e hora no formato do FAT (FILINFO)
+    uint16_t ftime;
+    uint8_t attrib;       // AM_DIR = 0x10
+    uint8_t name_len;
+} xfer_entry_t;
+
+typedef struct __attribute__((packed)) {
+    uint64_t length;      // bytes a ler; XFER_READ_TO_END = até o fim
+} xfer_read_t;
+
+#endif // XFER_PROTOCOL_H
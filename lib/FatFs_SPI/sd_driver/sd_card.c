@@ -898,6 +898,65 @@ int sd_read_blocks(sd_card_t *pSD, uint8_t *buffer, uint64_t ulSectorNumber,
     return status;
 }
 
+/* Read-ahead window for sequential readers (USB mass storage). A miss fills
+ * the whole window with one CMD18, so the command and access latency are paid
+ * once per SD_READ_AHEAD_BLOCKS blocks instead of once per request. */
+static struct {
+    sd_card_t *owner;  // NULL: window empty
+    uint64_t first;
+    uint32_t count;
+    uint8_t data[SD_READ_AHEAD_BLOCKS * BLOCK_SIZE_HC] __attribute__((aligned(4)));
+} read_ahead;
+
+static void in_sd_read_ahead_invalidate(sd_card_t *pSD) {
+    if (read_ahead.owner == pSD) read_ahead.owner = NULL;
+}
+
+void sd_read_ahead_invalidate(sd_card_t *pSD) {
+    sd_lock(pSD);
+    in_sd_read_ahead_invalidate(pSD);
+    sd_unlock(pSD);
+}
+
+int sd_read_blocks_ahead(sd_card_t *pSD, uint8_t *buffer, uint64_t ulSectorNumber,
+                         uint32_t ulSectorCount) {
+    if (ulSectorNumber + ulSectorCount > pSD->sectors)
+        return SD_BLOCK_DEVICE_ERROR_PARAMETER;
+    sd_acquire(pSD);
+    TRACE_PRINTF("sd_read_blocks_ahead(0x%p, 0x%llx, 0x%lx)\r\n", buffer,
+                 ulSectorNumber, ulSectorCount);
+    int status = SD_BLOCK_DEVICE_ERROR_NONE;
+    // Larger than the window: nothing to gain from caching it
+    if (ulSectorCount > SD_READ_AHEAD_BLOCKS) {
+        in_sd_read_ahead_invalidate(pSD);
+        status = in_sd_read_blocks(pSD, buffer, ulSectorNumber, ulSectorCount);
+        sd_release(pSD);
+        return status;
+    }
+    while (ulSectorCount) {
+        if (read_ahead.owner != pSD || ulSectorNumber < read_ahead.first ||
+            ulSectorNumber >= read_ahead.first + read_ahead.count) {
+            uint64_t left = pSD->sectors - ulSectorNumber;
+            uint32_t window = left < SD_READ_AHEAD_BLOCKS ? (uint32_t)left : SD_READ_AHEAD_BLOCKS;
+            read_ahead.owner = NULL;
+            status = in_sd_read_blocks(pSD, read_ahead.data, ulSectorNumber, window);
+            if (SD_BLOCK_DEVICE_ERROR_NONE != status) break;
+            read_ahead.owner = pSD;
+            read_ahead.first = ulSectorNumber;
+            read_ahead.count = window;
+        }
+        uint32_t index = (uint32_t)(ulSectorNumber - read_ahead.first);
+        uint32_t n = read_ahead.count - index;
+        if (n > ulSectorCount) n = ulSectorCount;
+        memcpy(buffer, read_ahead.data + index * _block_size, n * _block_size);
+        buffer += n * _block_size;
+        ulSectorNumber += n;
+        ulSectorCount -= n;
+    }
+    sd_release(pSD);
+    return status;
+}
+
 static uint8_t sd_write_block(sd_card_t *pSD, const uint8_t *buffer,
                               uint8_t token, uint32_t length) {
     uint16_t crc = (~0);
@@ -1010,7 +1069,10 @@ static int in_sd_write_blocks(sd_card_t *pSD, const uint8_t *buffer,
     uint32_t stat = 0;
     // Some SD cards want to be deselected between every bus transaction:
     sd_spi_deselect_pulse(pSD);
-    status = sd_cmd(pSD, CMD13_SEND_STATUS, 0, false, &stat);
+    // A rejected data block (e.g. data CRC error) is not reflected in the
+    // card status, so don't let CMD13 mask an earlier write failure.
+    int stat_status = sd_cmd(pSD, CMD13_SEND_STATUS, 0, false, &stat);
+    if (SD_BLOCK_DEVICE_ERROR_NONE == status) status = stat_status;
     return status;
 }
 
@@ -1019,6 +1081,7 @@ int sd_write_blocks(sd_card_t *pSD, const uint8_t *buffer,
     sd_acquire(pSD);
     TRACE_PRINTF("sd_write_blocks(0x%p, 0x%llx, 0x%lx)\r\n", buffer,
                  ulSectorNumber, blockCnt);
+    in_sd_read_ahead_invalidate(pSD);
     int status = in_sd_write_blocks(pSD, buffer, ulSectorNumber, blockCnt);
     sd_release(pSD);
     return status;
@@ -1227,8 +1290,9 @@ static int sd_init(sd_card_t *pSD) {
     // Set SCK for data transfer
     sd_spi_go_high_frequency(pSD);
 
-    // The card is now initialized
+    // The card is now initialized (possibly a different one)
     pSD->m_Status &= ~STA_NOINIT;
+    in_sd_read_ahead_invalidate(pSD);
 
     sd_spi_release(pSD);
     sd_unlock(pSD);
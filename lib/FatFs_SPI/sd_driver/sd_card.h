@@ -93,6 +93,18 @@ uint64_t sd_sectors(sd_card_t *pSD);
 bool sd_init_driver();
 bool sd_card_detect(sd_card_t *sd_card_p);
 
+// Blocks read ahead by sd_read_blocks_ahead() (512 bytes of RAM each)
+#ifndef SD_READ_AHEAD_BLOCKS
+#define SD_READ_AHEAD_BLOCKS 32
+#endif
+
+// Like read_blocks, but sequential requests are served from a window of
+// SD_READ_AHEAD_BLOCKS blocks filled by a single multi-block read (CMD18).
+// Writes through write_blocks invalidate the window.
+int sd_read_blocks_ahead(sd_card_t *sd_card_p, uint8_t *buffer, uint64_t ulSectorNumber,
+                         uint32_t ulSectorCount);
+void sd_read_ahead_invalidate(sd_card_t *sd_card_p);
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,6 +26,7 @@ specific language governing permissions and limitations under the License.
 
 static bool irqChannel1 = false;
 static bool irqShared = true;
+static void (*wait_hook)(void) = NULL;
 
 static void in_spi_irq_handler(const uint DMA_IRQ_num, io_rw_32 *dma_hw_ints_p) {
     for (size_t i = 0; i < spi_get_num(); ++i) {
@@ -113,8 +114,16 @@ bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
 
     /* Wait until master completes transfer or time out has occured. */
     uint32_t timeOut = 1000; /* Timeout 1 sec */
-    bool rc = sem_acquire_timeout_ms(
-        &spi_p->sem, timeOut);  // Wait for notification from ISR
+    bool rc;
+    if (wait_hook) {
+        // Let the caller do useful work instead of sleeping on the semaphore
+        absolute_time_t until = make_timeout_time_ms(timeOut);
+        while (!(rc = sem_try_acquire(&spi_p->sem)) && !time_reached(until))
+            wait_hook();
+    } else {
+        rc = sem_acquire_timeout_ms(
+            &spi_p->sem, timeOut);  // Wait for notification from ISR
+    }
     if (!rc) {
         // If the timeout is reached the function will return false
         DBG_PRINTF("Notification wait timed out in %s\n", __FUNCTION__);
@@ -131,6 +140,10 @@ bool spi_transfer(spi_t *spi_p, const uint8_t *tx, uint8_t *rx, size_t length) {
     return true;
 }
 
+void spi_set_wait_hook(void (*hook)(void)) {
+    wait_hook = hook;
+}
+
 void spi_lock(spi_t *spi_p) {
     assert(mutex_is_initialized(&spi_p->mutex));
     mutex_enter_blocking(&spi_p->mutex);
@@ -64,6 +64,10 @@ void spi_lock(spi_t *pSPI);
 void spi_unlock(spi_t *pSPI);
 bool my_spi_init(spi_t *pSPI);
 void set_spi_dma_irq_channel(bool useChannel1, bool shared);
+// Optional function called repeatedly while spi_transfer waits for the DMA,
+// instead of sleeping on the semaphore (e.g. to keep USB serviced during long
+// SD reads). It must not touch the SPI bus. NULL restores the blocking wait.
+void spi_set_wait_hook(void (*hook)(void));
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,240 @@
+#include "../inc/calibration.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "pico/stdlib.h"
+
+#include "../inc/crc32.h"
+#include "../inc/sdlogger.h"
+#include "../inc/sensor.h"
+#include "../inc/tempcomp.h"
+
+// Último setor da flash: fora do alcance do programa
+#define CALIB_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+#define CALIB_MAGIC 0x42494C43u  // "CLIB"
+#define CALIB_VERSION 3  // 3: escalas em LSB por unidade, não mais índices do MPU6050
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;       // sizeof(calibration_t)
+    calibration_t data;
+    uint32_t crc;        // CRC32 de tudo o que vem antes
+} calib_record_t;
+
+_Static_assert(sizeof(calib_record_t) <= FLASH_PAGE_SIZE, "registro de calibração maior que uma página");
+
+static calibration_t calib;
+static bool valid = false;
+static int16_t offset_accel[3];  // calib convertida para a escala atual
+static int16_t offset_gyro[3];
+static void (*wait_hook)(void) = NULL;
+
+//Publica os offsets aplicados nos metadados dos próximos logs
+static void publish_metadata(void) {
+    if (!valid) {
+        sdlogger_set_metadata("calib_accel", NULL);
+        sdlogger_set_metadata("calib_giro", NULL);
+        sdlogger_set_metadata("calib_amostras", NULL);
+        sdlogger_set_metadata("calib", "nenhuma");
+        return;
+    }
+    char value[40];
+    sdlogger_set_metadata("calib", NULL);
+    snprintf(value, sizeof value, "%d,%d,%d", offset_accel[0], offset_accel[1], offset_accel[2]);
+    sdlogger_set_metadata("calib_accel", value);
+    snprintf(value, sizeof value, "%d,%d,%d", offset_gyro[0], offset_gyro[1], offset_gyro[2]);
+    sdlogger_set_metadata("calib_giro", value);
+    snprintf(value, sizeof value, "%lu", (unsigned long)calib.samples);
+    sdlogger_set_metadata("calib_amostras", value);
+}
+
+void calibration_refresh(void) {
+    const float accel_lsb = sensor_accel_lsb_per_g(), gyro_lsb = sensor_gyro_lsb_per_dps();
+    for (int i = 0; i < 3; i++) {
+        offset_accel[i] = valid ? sensor_rescale(calib.accel[i], calib.accel_lsb_per_g, accel_lsb) : 0;
+        offset_gyro[i] = valid ? sensor_rescale(calib.gyro[i], calib.gyro_lsb_per_dps, gyro_lsb) : 0;
+    }
+    publish_metadata();
+}
+
+bool calibration_load(void) {
+    const calib_record_t *rec = (const calib_record_t *)(XIP_BASE + CALIB_FLASH_OFFSET);
+    valid = rec->magic == CALIB_MAGIC && rec->version == CALIB_VERSION && rec->size == sizeof(calibration_t) &&
+            rec->crc == crc32_update(0, rec, offsetof(calib_record_t, crc));
+    if (valid) {
+        calib = rec->data;
+    } else {
+        memset(&calib, 0, sizeof calib);
+    }
+    calibration_refresh();
+    return valid;
+}
+
+//Apaga o setor e grava o registro; o XIP fica desligado durante a operação,
+//então nenhuma interrupção pode executar código da flash
+static bool save(void) {
+    static uint8_t page[FLASH_PAGE_SIZE];
+    memset(page, 0xFF, sizeof page);
+    calib_record_t rec = {
+        .magic = CALIB_MAGIC,
+        .version = CALIB_VERSION,
+        .size = sizeof(calibration_t),
+        .data = calib,
+    };
+    rec.crc = crc32_update(0, &rec, offsetof(calib_record_t, crc));
+    memcpy(page, &rec, sizeof rec);
+
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_erase(CALIB_FLASH_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(CALIB_FLASH_OFFSET, page, FLASH_PAGE_SIZE);
+    restore_interrupts(irq);
+
+    if (memcmp((const void *)(XIP_BASE + CALIB_FLASH_OFFSET), page, sizeof rec) != 0) {
+        printf("[ERRO] Falha ao gravar a calibração na flash\n");
+        return false;
+    }
+    return true;
+}
+
+//Média arredondada de uma soma de n amostras
+static int16_t mean(int64_t sum, uint32_t n) {
+    return (int16_t)((sum >= 0 ? sum + n / 2 : sum - (int64_t)(n / 2)) / (int64_t)n);
+}
+
+bool calibration_run(uint32_t samples) {
+    if (samples == 0 || samples > CALIB_MAX_SAMPLES) {
+        printf("[ERRO] Número de amostras deve estar entre 1 e %d\n", CALIB_MAX_SAMPLES);
+        return false;
+    }
+    printf("Calibrando com %lu amostras: mantenha o IMU parado e nivelado...\n", (unsigned long)samples);
+    const float accel_lsb = sensor_accel_lsb_per_g(), gyro_lsb = sensor_gyro_lsb_per_dps();
+    const int32_t accel_1g = (int32_t)(accel_lsb + 0.5f);
+    const int32_t accel_spread = (int32_t)(CALIB_ACCEL_MAX_SPREAD_G * accel_lsb);
+    const int32_t gyro_spread = (int32_t)(CALIB_GYRO_MAX_SPREAD_DPS * gyro_lsb);
+    const int32_t level_tolerance = (int32_t)(CALIB_LEVEL_TOLERANCE_G * accel_lsb);
+
+    // Com a compensação térmica ligada o bias é medido já compensado, como
+    // as amostras da gravação; a calibração dura ~1 s, então uma leitura da
+    // temperatura basta
+    sensor_sample_t s;
+    int16_t temp_offsets[6] = { 0 };
+    if (sensor_read_primary(&s) && tempcomp_offsets_at(s.temp, temp_offsets)) {
+        printf("Compensação térmica a %.2f graus\n", tempcomp_celsius_q8(s.temp) / (double)(1 << TEMPCOMP_TEMP_FRAC));
+    }
+
+    int64_t sum[6] = { 0 };
+    int16_t min[6], max[6];
+    for (int i = 0; i < 6; i++) {
+        min[i] = INT16_MAX;
+        max[i] = INT16_MIN;
+    }
+    for (uint32_t n = 0; n < samples; n++) {
+        if (!sensor_read_primary(&s)) {
+            printf("[ERRO] Falha de leitura do IMU na amostra %lu\n", (unsigned long)n);
+            return false;
+        }
+        int16_t v[6] = { s.accel[0], s.accel[1], s.accel[2], s.gyro[0], s.gyro[1], s.gyro[2] };
+        for (int i = 0; i < 6; i++) {
+            v[i] = (int16_t)(v[i] - temp_offsets[i]);
+            sum[i] += v[i];
+            if (v[i] < min[i]) min[i] = v[i];
+            if (v[i] > max[i]) max[i] = v[i];
+        }
+        if (wait_hook) wait_hook();
+        sleep_us(CALIB_INTERVAL_US);
+    }
+
+    // Variação grande demais: o sensor se mexeu e a média não é o bias
+    for (int i = 0; i < 6; i++) {
+        int32_t spread = (int32_t)max[i] - min[i];
+        if (spread > (i < 3 ? accel_spread : gyro_spread)) {
+            printf("[ERRO] Movimento durante a calibração (%s %c variou %ld LSB)\n", i < 3 ? "accel" : "giro",
+                   'X' + i % 3, (long)spread);
+            return false;
+        }
+    }
+
+    calibration_t c = { .samples = samples, .accel_lsb_per_g = accel_lsb, .gyro_lsb_per_dps = gyro_lsb };
+    for (int i = 0; i < 3; i++) c.gyro[i] = mean(sum[3 + i], samples);
+
+    // O eixo de maior leitura é o vertical: espera-se +-1 g nele e zero nos outros
+    int16_t avg[3];
+    int up = 0;
+    for (int i = 0; i < 3; i++) {
+        avg[i] = mean(sum[i], samples);
+        if (abs(avg[i]) > abs(avg[up])) up = i;
+    }
+    bool level = true;
+    for (int i = 0; i < 3; i++) {
+        if (i != up && abs(avg[i]) > level_tolerance) level = false;
+    }
+    if (level) {
+        for (int i = 0; i < 3; i++) c.accel[i] = avg[i];
+        c.accel[up] = (int16_t)(avg[up] - (avg[up] < 0 ? -accel_1g : accel_1g));
+    } else {
+        printf("[AVISO] IMU inclinado: só o giroscópio foi calibrado.\n");
+    }
+
+    calib = c;
+    valid = true;
+    calibration_refresh();
+    bool ok = save();
+    calibration_print_status();
+    return ok;
+}
+
+void calibration_clear(void) {
+    memset(&calib, 0, sizeof calib);
+    valid = false;
+    calibration_refresh();
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_erase(CALIB_FLASH_OFFSET, FLASH_SECTOR_SIZE);
+    restore_interrupts(irq);
+    printf("Calibração apagada.\n");
+}
+
+void calibration_set_wait_hook(void (*hook)(void)) {
+    wait_hook = hook;
+}
+
+bool calibration_is_valid(void) {
+    return valid;
+}
+
+const calibration_t *calibration_get(void) {
+    return &calib;
+}
+
+static inline int16_t sub_sat(int16_t v, int16_t offset) {
+    int32_t r = (int32_t)v - offset;
+    if (r > INT16_MAX) return INT16_MAX;
+    if (r < INT16_MIN) return INT16_MIN;
+    return (int16_t)r;
+}
+
+void calibration_apply(int16_t accel[3], int16_t gyro[3]) {
+    if (!valid) return;
+    for (int i = 0; i < 3; i++) {
+        accel[i] = sub_sat(accel[i], offset_accel[i]);
+        gyro[i] = sub_sat(gyro[i], offset_gyro[i]);
+    }
+}
+
+void calibration_print_status(void) {
+    if (!valid) {
+        printf("Calibração: nenhuma (amostras sem correção)\n");
+        return;
+    }
+    const float gyro_lsb = sensor_gyro_lsb_per_dps();
+    printf("Calibração (%lu amostras, medida a %.0f LSB/g e %.1f LSB/(graus/s)), na escala atual:\n",
+           (unsigned long)calib.samples, (double)calib.accel_lsb_per_g, (double)calib.gyro_lsb_per_dps);
+    printf("  accel: %d %d %d LSB\n", offset_accel[0], offset_accel[1], offset_accel[2]);
+    printf("  giro:  %d %d %d LSB (%.2f %.2f %.2f graus/s)\n", offset_gyro[0], offset_gyro[1], offset_gyro[2],
+           offset_gyro[0] / gyro_lsb, offset_gyro[1] / gyro_lsb, offset_gyro[2] / gyro_lsb);
+}
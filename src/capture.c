@@ -0,0 +1,224 @@
+#include "../inc/capture.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ff.h"
+
+#include "../inc/sdlogger.h"
+
+#define RING_MASK (CAPTURE_RING_SAMPLES - 1u)
+
+typedef struct {
+    uint32_t sample;
+    int16_t accel[3];
+    int16_t gyro[3];
+} ring_entry_t;
+
+// Posições do anel são contagens absolutas de amostras (índice = pos & RING_MASK)
+static ring_entry_t ring[CAPTURE_RING_SAMPLES];
+static uint32_t ring_head = 0;     // próxima posição a escrever
+static uint32_t written_end = 0;   // fim do último evento: a história seguinte não o repete
+
+static capture_trigger_t trigger = { .type = CAPTURE_TRIGGER_ACCEL_MAG, .axis = 0, .threshold = 32000 };
+static uint32_t trigger_sq = 32000u * 32000u;
+static uint32_t pre_samples = CAPTURE_PRE_DEFAULT;
+static uint32_t post_samples = CAPTURE_POST_DEFAULT;
+
+static bool armed = false;
+static bool in_event = false;
+static uint32_t event_pos = 0;   // próxima posição do anel a gravar no arquivo
+static uint32_t event_end = 0;   // posição seguinte à última da janela pós
+static uint32_t event_count = 0;
+static uint32_t next_number = 1;
+static char base_name[FF_LFN_BUF];
+static char event_filename[FF_LFN_BUF];
+
+//Nome do arquivo do evento n: <base>_eNNN<ext>
+static void event_path(uint32_t n, char *out, size_t len) {
+    const char *dot = strrchr(base_name, '.');
+    const char *slash = strrchr(base_name, '/');
+    if (!dot || (slash && dot < slash)) dot = base_name + strlen(base_name);
+    snprintf(out, len, "%.*s_e%03lu%s", (int)(dot - base_name), base_name, (unsigned long)n, dot);
+}
+
+static inline uint32_t square(int16_t v) {
+    return (uint32_t)((int32_t)v * v);
+}
+
+//Avalia o gatilho; módulos comparados ao quadrado do limiar (sem raiz)
+static bool trigger_fired(const int16_t accel[3], const int16_t gyro[3]) {
+    switch (trigger.type) {
+        case CAPTURE_TRIGGER_AXIS: {
+            int32_t v = trigger.axis < 3 ? accel[trigger.axis] : gyro[trigger.axis - 3];
+            return (uint32_t)abs(v) >= trigger.threshold;
+        }
+        case CAPTURE_TRIGGER_ACCEL_MAG:
+            return square(accel[0]) + square(accel[1]) + square(accel[2]) >= trigger_sq;
+        case CAPTURE_TRIGGER_GYRO_MAG:
+            return square(gyro[0]) + square(gyro[1]) + square(gyro[2]) >= trigger_sq;
+    }
+    return false;
+}
+
+static void end_event(void) {
+    sdlogger_stop();
+    in_event = false;
+    written_end = event_pos;
+}
+
+//Abre o arquivo do evento; a janela vai de pré amostras antes do disparo
+//(sem repetir o evento anterior) até post_samples depois dele
+static bool begin_event(uint32_t trigger_pos, uint32_t sample_num) {
+    event_path(next_number, event_filename, sizeof event_filename);
+    if (!sdlogger_start(event_filename)) return false;
+    next_number++;
+    event_count++;
+
+    uint32_t history = trigger_pos - written_end;
+    if (history > pre_samples) history = pre_samples;
+    event_pos = trigger_pos - history;
+    event_end = trigger_pos + 1u + post_samples;
+    in_event = true;
+    printf("[EVENTO] %lu na amostra %lu: '%s'\n", (unsigned long)event_count, (unsigned long)sample_num,
+           event_filename);
+    return true;
+}
+
+//Grava até CAPTURE_DRAIN_PER_SAMPLE amostras pendentes do anel
+static bool drain(void) {
+    uint32_t limit = ring_head < event_end ? ring_head : event_end;
+    for (int n = 0; n < CAPTURE_DRAIN_PER_SAMPLE && event_pos != limit; n++, event_pos++) {
+        ring_entry_t *e = &ring[event_pos & RING_MASK];
+        if (!sdlogger_log_sample(e->sample, e->accel, e->gyro)) return false;
+    }
+    if (event_pos == event_end) end_event();
+    return true;
+}
+
+bool capture_process(uint32_t sample_num, const int16_t accel[3], const int16_t gyro[3]) {
+    if (!armed) return true;
+
+    uint32_t pos = ring_head;
+    ring_entry_t *e = &ring[pos & RING_MASK];
+    e->sample = sample_num;
+    memcpy(e->accel, accel, sizeof e->accel);
+    memcpy(e->gyro, gyro, sizeof e->gyro);
+    ring_head = pos + 1u;
+
+    // Disparos durante um evento já estão na janela dele
+    if (!in_event && trigger_fired(accel, gyro) && !begin_event(pos, sample_num)) {
+        armed = false;
+        return false;
+    }
+    if (in_event && !drain()) {
+        end_event();
+        armed = false;
+        return false;
+    }
+    return true;
+}
+
+bool capture_arm(const char *log_filename) {
+    if (armed) return true;
+    strncpy(base_name, log_filename, sizeof(base_name) - 1);
+    base_name[sizeof(base_name) - 1] = '\0';
+
+    // Primeiro número sem arquivo, para não sobrescrever eventos anteriores
+    FILINFO fno;
+    next_number = 1;
+    event_path(next_number, event_filename, sizeof event_filename);
+    while (f_stat(event_filename, &fno) == FR_OK) {
+        event_path(++next_number, event_filename, sizeof event_filename);
+    }
+
+    ring_head = 0;
+    written_end = 0;
+    event_count = 0;
+    in_event = false;
+    armed = true;
+    printf("Captura por eventos armada, arquivos a partir de '%s'\n", event_filename);
+    capture_print_status();
+    return true;
+}
+
+//Desarma; um evento em andamento é fechado com o que já foi gravado
+void capture_disarm(void) {
+    if (!armed) return;
+    if (in_event) end_event();
+    armed = false;
+    printf("Captura por eventos desarmada (%lu eventos).\n", (unsigned long)event_count);
+}
+
+bool capture_is_armed(void) {
+    return armed;
+}
+
+bool capture_in_event(void) {
+    return in_event;
+}
+
+uint32_t capture_event_count(void) {
+    return event_count;
+}
+
+bool capture_set_trigger(const capture_trigger_t *t) {
+    if (armed) {
+        printf("[AVISO] Desarme a captura antes de trocar o gatilho.\n");
+        return false;
+    }
+    if (t->type == CAPTURE_TRIGGER_AXIS && t->axis > 5) {
+        printf("[ERRO] Eixo deve estar entre 0 e 5\n");
+        return false;
+    }
+    trigger = *t;
+    trigger_sq = (uint32_t)trigger.threshold * trigger.threshold;
+    return true;
+}
+
+const capture_trigger_t *capture_get_trigger(void) {
+    return &trigger;
+}
+
+bool capture_set_window(uint32_t pre, uint32_t post) {
+    if (armed) {
+        printf("[AVISO] Desarme a captura antes de trocar a janela.\n");
+        return false;
+    }
+    if (pre > CAPTURE_PRE_MAX) {
+        printf("[ERRO] Janela pré deve ter no máximo %d amostras\n", CAPTURE_PRE_MAX);
+        return false;
+    }
+    pre_samples = pre;
+    post_samples = post;
+    return true;
+}
+
+void capture_get_window(uint32_t *pre, uint32_t *post) {
+    *pre = pre_samples;
+    *post = post_samples;
+}
+
+const char *capture_trigger_name(capture_trigger_type_t type) {
+    switch (type) {
+        case CAPTURE_TRIGGER_AXIS: return "eixo";
+        case CAPTURE_TRIGGER_ACCEL_MAG: return "aceleração";
+        default: return "giro";
+    }
+}
+
+void capture_print_status(void) {
+    if (trigger.type == CAPTURE_TRIGGER_AXIS) {
+        printf("Gatilho: |eixo %u| >= %u\n", trigger.axis, trigger.threshold);
+    } else {
+        printf("Gatilho: módulo %s >= %u\n", capture_trigger_name(trigger.type), trigger.threshold);
+    }
+    printf("Janela: %lu amostras antes + %lu depois (anel de %d)\n", (unsigned long)pre_samples,
+           (unsigned long)post_samples, CAPTURE_RING_SAMPLES);
+    if (armed) {
+        printf("Armada: %lu eventos%s\n", (unsigned long)event_count, in_event ? ", gravando evento" : "");
+    } else {
+        printf("Desarmada\n");
+    }
+}
@@ -0,0 +1,167 @@
+#include "../inc/decimator.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../inc/sdlogger.h"
+
+#define TAP_MASK (DECIM_TAPS_PER_PHASE - 1)
+#define Q15_ONE 32768
+
+_Static_assert((DECIM_TAPS_PER_PHASE & TAP_MASK) == 0, "DECIM_TAPS_PER_PHASE deve ser potência de 2");
+
+static uint8_t factor = 1;
+// phase_coef[p][j] = h[p + j * fator]: coeficientes que uma entrada de fase p
+// soma nas saídas j = 0 (a próxima) ... 15
+static int16_t phase_coef[DECIM_MAX_FACTOR][DECIM_TAPS_PER_PHASE];
+// prefill[j] = soma de h[k] para k >= (j + 1) * fator: peso do histórico
+// anterior à primeira amostra na saída j
+static int32_t prefill[DECIM_TAPS_PER_PHASE];
+
+static decimator_t states[SDLOGGER_MAX_SENSORS];
+static bool active = false;
+
+//Coeficiente k de 'taps': janela de Blackman sobre sinc com corte em fc
+//(ciclos por amostra de entrada)
+static float tap(int k, int taps, float fc) {
+    float t = (float)k - (float)(taps - 1) * 0.5f;
+    float sinc = t == 0.0f ? 2.0f * fc : sinf(2.0f * (float)M_PI * fc * t) / ((float)M_PI * t);
+    float x = 2.0f * (float)M_PI * (float)k / (float)(taps - 1);
+    return sinc * (0.42f - 0.5f * cosf(x) + 0.08f * cosf(2.0f * x));
+}
+
+//Corte em 0,5/fator, quantizado em Q15 com ganho DC exato
+static void design(uint8_t r) {
+    const int taps = DECIM_TAPS_PER_PHASE * r;
+    const float fc = 0.5f / (float)r;
+    float sum = 0.0f;
+    for (int k = 0; k < taps; k++) sum += tap(k, taps, fc);
+
+    int32_t total = 0;
+    for (int k = 0; k < taps; k++) {
+        int32_t q = (int32_t)lrintf(tap(k, taps, fc) * (float)Q15_ONE / sum);
+        phase_coef[k % r][k / r] = (int16_t)q;
+        total += q;
+    }
+    // O resto do arredondamento vai para o coeficiente central
+    phase_coef[(taps / 2) % r][(taps / 2) / r] += (int16_t)(Q15_ONE - total);
+
+    for (int j = 0; j < DECIM_TAPS_PER_PHASE; j++) {
+        int32_t s = 0;
+        for (int k = (j + 1) * r; k < taps; k++) s += phase_coef[k % r][k / r];
+        prefill[j] = s;
+    }
+}
+
+bool decimator_set_factor(uint8_t f) {
+    if (active) {
+        printf("[AVISO] Pare a gravação antes de trocar a decimação.\n");
+        return false;
+    }
+    if (f < 1 || f > DECIM_MAX_FACTOR) {
+        printf("[ERRO] Fator de decimação deve estar entre 1 e %d\n", DECIM_MAX_FACTOR);
+        return false;
+    }
+    factor = f;
+    if (factor > 1) design(factor);
+    return true;
+}
+
+uint8_t decimator_get_factor(void) {
+    return factor;
+}
+
+void decimator_reset(decimator_t *d) {
+    memset(d->acc, 0, sizeof d->acc);
+    d->phase = (uint8_t)(factor - 1);
+    d->head = 0;
+    d->primed = false;
+}
+
+static inline int16_t q15_to_sample(int32_t acc) {
+    int32_t v = (acc + (1 << 14)) >> 15;
+    if (v > INT16_MAX) return INT16_MAX;
+    if (v < INT16_MIN) return INT16_MIN;
+    return (int16_t)v;
+}
+
+bool decimator_push(decimator_t *d, const int16_t accel[3], const int16_t gyro[3], int16_t out_accel[3],
+                    int16_t out_gyro[3]) {
+    if (accel) {
+        memcpy(&d->last[0], accel, 3 * sizeof(int16_t));
+        memcpy(&d->last[3], gyro, 3 * sizeof(int16_t));
+    }
+    const int16_t *in = d->last;
+    const uint8_t head = d->head;
+
+    // Sem histórico, finge que o sinal estava parado na primeira amostra
+    if (!d->primed) {
+        for (int axis = 0; axis < DECIM_AXES; axis++) {
+            int32_t x = in[axis];
+            for (int j = 0; j < DECIM_TAPS_PER_PHASE; j++) d->acc[axis][(head + j) & TAP_MASK] = prefill[j] * x;
+        }
+        d->primed = true;
+    }
+
+    const int16_t *h = phase_coef[d->phase];
+    for (int axis = 0; axis < DECIM_AXES; axis++) {
+        int32_t x = in[axis];
+        int32_t *acc = d->acc[axis];
+        for (int j = 0; j < DECIM_TAPS_PER_PHASE; j++) acc[(head + j) & TAP_MASK] += h[j] * x;
+    }
+
+    if (d->phase > 0) {
+        d->phase--;
+        return false;
+    }
+    for (int i = 0; i < 3; i++) {
+        out_accel[i] = q15_to_sample(d->acc[i][head]);
+        out_gyro[i] = q15_to_sample(d->acc[3 + i][head]);
+    }
+    for (int axis = 0; axis < DECIM_AXES; axis++) d->acc[axis][head] = 0;
+    d->head = (uint8_t)((head + 1) & TAP_MASK);
+    d->phase = (uint8_t)(factor - 1);
+    return true;
+}
+
+void decimator_start(void) {
+    if (factor == 1) return;
+    char value[16];
+    snprintf(value, sizeof value, "%u", factor);
+    sdlogger_set_metadata("decimacao", value);
+    // Atraso de grupo em amostras de entrada: numero_amostra - atraso é o centro da janela
+    snprintf(value, sizeof value, "%.1f", (DECIM_TAPS_PER_PHASE * factor - 1) * 0.5);
+    sdlogger_set_metadata("decimacao_atraso", value);
+    for (int i = 0; i < SDLOGGER_MAX_SENSORS; i++) decimator_reset(&states[i]);
+    active = true;
+}
+
+//Sem sessão decimada, os próximos logs (inclusive de eventos) não levam os metadados
+void decimator_stop(void) {
+    active = false;
+    sdlogger_set_metadata("decimacao", NULL);
+    sdlogger_set_metadata("decimacao_atraso", NULL);
+}
+
+bool decimator_is_active(void) {
+    return active;
+}
+
+bool decimator_process(uint8_t sensor, const int16_t accel[3], const int16_t gyro[3], int16_t out_accel[3],
+                       int16_t out_gyro[3]) {
+    if (sensor >= SDLOGGER_MAX_SENSORS) return false;
+    return decimator_push(&states[sensor], accel, gyro, out_accel, out_gyro);
+}
+
+void decimator_print_status(uint32_t sample_rate_hz) {
+    if (factor == 1) {
+        printf("Decimação: desligada (log em %lu Hz)\n", (unsigned long)sample_rate_hz);
+        return;
+    }
+    float out_hz = (float)sample_rate_hz / (float)factor;
+    float delay_ms = (DECIM_TAPS_PER_PHASE * factor - 1) * 0.5f * 1000.0f / (float)sample_rate_hz;
+    printf("Decimação: fator %u, FIR de %u coeficientes em Q15\n", factor, DECIM_TAPS_PER_PHASE * factor);
+    printf("  log em %.2f Hz, banda útil até %.2f Hz, atraso de grupo %.2f ms\n", (double)out_hz,
+           (double)(out_hz / 3.0f), (double)delay_ms);
+}
@@ -35,8 +35,10 @@ static spi_t spis[] = {  // One for each SPI.
         .mosi_gpio = 19,
         .sck_gpio = 18,
 
-        // .baud_rate = 1000 * 1000
-        .baud_rate = 1000 * 1000
+        // Depois da inicialização (feita a 400 kHz). A 1 MHz o cartão limitava
+        // o modo disco USB e o xfer a ~100 KB/s; 12,5 MHz sai exato de 125 MHz
+        // (12 MHz com o clock de repouso, 48 MHz) e ainda tolera fios de protoboard.
+        .baud_rate = 12500 * 1000
         // .baud_rate = 25 * 1000 * 1000 // Actual frequency: 20833333.
     }};
 
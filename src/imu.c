@@ -2,51 +2,505 @@
 #include "hardware/i2c.h"
 #include "pico/stdlib.h"
 
+#include <stdio.h>
 
-static int addr = MPU6050_ADDR;
+#include "../inc/pio_i2c.h"
+#include "../inc/sdlogger.h"
 
-//Inicializa o sensor IMU MPU6050.
-void imu_init(void) {
-    i2c_init(I2C_PORT, 400 * 1000);
+
+// Sensor 0 é sempre o principal; os demais vêm da varredura em mpu6050_sensor_init
+static imu_dev_t devices[IMU_MAX_DEVICES] = { { I2C_PORT, MPU6050_ADDR } };
+static int device_count = 1;
+static imu_config_t config = IMU_CONFIG_DEFAULT;
+static imu_transport_t transport = IMU_TRANSPORT_HW;
+static bool fifo_on = false;
+static uint32_t fifo_overflows = 0;
+
+static const uint16_t accel_range_g[4] = { 2, 4, 8, 16 };
+static const uint16_t gyro_range_dps[4] = { 250, 500, 1000, 2000 };
+static const float gyro_lsb_per_dps[4] = { 131.0f, 65.5f, 32.8f, 16.4f };
+static const uint16_t dlpf_accel_hz[7] = { 260, 184, 94, 44, 21, 10, 5 };
+
+//O sensor está no barramento atendido pelo PIO?
+static bool on_pio(const imu_dev_t *dev) {
+    return transport == IMU_TRANSPORT_PIO && dev->bus == I2C_PORT;
+}
+
+static bool bus_write(const imu_dev_t *dev, const uint8_t *src, size_t len) {
+    if (on_pio(dev)) return pio_i2c_write(dev->addr, src, len);
+    return i2c_write_blocking(dev->bus, dev->addr, src, len, false) == (int)len;
+}
+
+static bool bus_read_reg(const imu_dev_t *dev, uint8_t reg, uint8_t *dst, size_t len) {
+    if (on_pio(dev)) return pio_i2c_read_reg(dev->addr, reg, dst, len);
+    return i2c_write_blocking(dev->bus, dev->addr, &reg, 1, true) == 1 &&
+           i2c_read_blocking(dev->bus, dev->addr, dst, len, false) == (int)len;
+}
+
+//Escreve um registrador de um IMU.
+static bool write_reg(const imu_dev_t *dev, uint8_t reg, uint8_t value) {
+    uint8_t buf[] = { reg, value };
+    return bus_write(dev, buf, 2);
+}
+
+//Escreve o mesmo registrador em todos os IMUs
+static bool write_reg_all(uint8_t reg, uint8_t value) {
+    bool ok = true;
+    for (int i = 0; i < device_count; i++) ok = write_reg(&devices[i], reg, value) && ok;
+    return ok;
+}
+
+//Confere WHO_AM_I; com timeout para não travar num barramento sem pull-up
+static bool probe(i2c_inst_t *bus, uint8_t addr) {
+    uint8_t reg = MPU6050_REG_WHO_AM_I, id = 0;
+    return i2c_write_timeout_us(bus, addr, &reg, 1, true, IMU_BURST_TIMEOUT_US) == 1 &&
+           i2c_read_timeout_us(bus, addr, &id, 1, false, IMU_BURST_TIMEOUT_US) == 1 &&
+           (id & 0x7E) == MPU6050_WHO_AM_I;
+}
+
+//Registra a configuração nos metadados dos próximos logs (escalas para o host)
+static void publish_metadata(void) {
+    char value[16];
+    snprintf(value, sizeof value, "%u", accel_range_g[config.accel_range]);
+    sdlogger_set_metadata("imu_accel_g", value);
+    snprintf(value, sizeof value, "%u", gyro_range_dps[config.gyro_range]);
+    sdlogger_set_metadata("imu_giro_dps", value);
+    snprintf(value, sizeof value, "%.0f", (double)imu_accel_lsb_per_g());
+    sdlogger_set_metadata("imu_accel_lsb_g", value);
+    snprintf(value, sizeof value, "%.1f", (double)imu_gyro_lsb_per_dps());
+    sdlogger_set_metadata("imu_giro_lsb_dps", value);
+    snprintf(value, sizeof value, "%u", config.dlpf);
+    sdlogger_set_metadata("imu_dlpf", value);
+    snprintf(value, sizeof value, "%lu", (unsigned long)imu_output_rate_hz());
+    sdlogger_set_metadata("imu_taxa_hz", value);
+    sdlogger_set_metadata("imu_clock", config.clock == IMU_CLOCK_PLL_GYRO_X ? "pll_x" : "interno");
+
+    char list[IMU_MAX_DEVICES * 10 + 1] = "";
+    size_t len = 0;
+    for (int i = 0; i < device_count; i++) {
+        len += (size_t)snprintf(list + len, sizeof list - len, "%si2c%u:0x%02x", i ? "," : "",
+                                i2c_hw_index(devices[i].bus), devices[i].addr);
+    }
+    sdlogger_set_metadata("imu_sensores", list);
+    sdlogger_set_metadata("imu_i2c", transport == IMU_TRANSPORT_PIO ? "pio" : "hw");
+}
+
+//Inicializa o barramento do IMU e procura outros sensores em 0x69 e no
+//barramento do display (que já deve ter sido iniciado por display_init).
+bool mpu6050_sensor_init(void) {
+    i2c_init(I2C_PORT, IMU_I2C_BAUD);
     gpio_set_function(I2C_SDA, GPIO_FUNC_I2C);
     gpio_set_function(I2C_SCL, GPIO_FUNC_I2C);
     gpio_pull_up(I2C_SDA);
     gpio_pull_up(I2C_SCL);
 
-    uint8_t buf[] = {MPU6050_REG_PWR_MGMT_1, 0x00};
-    i2c_write_blocking(I2C_PORT, addr, buf, 2, false);
+    const imu_dev_t candidates[] = {
+        { I2C_PORT, MPU6050_ADDR_ALT },
+        { IMU_I2C_PORT_AUX, MPU6050_ADDR },
+        { IMU_I2C_PORT_AUX, MPU6050_ADDR_ALT },
+    };
+    device_count = 1;
+    for (size_t i = 0; i < sizeof candidates / sizeof candidates[0]; i++) {
+        if (probe(candidates[i].bus, candidates[i].addr)) devices[device_count++] = candidates[i];
+    }
+
+    write_reg_all(MPU6050_REG_PWR_MGMT_1, 0x00);
     sleep_ms(100);
+    return imu_set_config(&config);
 }
 
-//Lê os dados brutos do acelerômetro e giroscópio do IMU.
-bool imu_read_raw(int16_t accel[3], int16_t gyro[3]) {
-    uint8_t buffer[6];
+int mpu6050_sensor_count(void) {
+    return device_count;
+}
 
-    uint8_t reg = MPU6050_REG_ACCEL_XOUT_H;
-    if (i2c_write_blocking(I2C_PORT, addr, &reg, 1, true) < 0) return false;
-    if (i2c_read_blocking(I2C_PORT, addr, buffer, 6, false) < 0) return false;
+const imu_dev_t *imu_device(int sensor) {
+    return sensor >= 0 && sensor < device_count ? &devices[sensor] : NULL;
+}
 
-    for (int i = 0; i < 3; i++)
-        accel[i] = (buffer[i * 2] << 8) | buffer[i * 2 + 1];
+//Enfileira no controlador a escrita do endereço do registrador e as 14
+//leituras (RESTART na primeira, STOP na última) sem esperar: o hardware
+//conduz a transferência enquanto a CPU atende o outro barramento.
+static void burst_begin(const imu_dev_t *dev) {
+    if (on_pio(dev)) {
+        pio_i2c_read_start(dev->addr, MPU6050_REG_ACCEL_XOUT_H, IMU_BURST_LEN);
+        return;
+    }
+    i2c_hw_t *hw = i2c_get_hw(dev->bus);
+    while (hw->rxflr) (void)hw->data_cmd;   // sobras de uma leitura abortada
+    hw->enable = 0;
+    hw->tar = dev->addr;
+    hw->enable = 1;
 
-    reg = MPU6050_REG_GYRO_XOUT_H;
-    if (i2c_write_blocking(I2C_PORT, addr, &reg, 1, true) < 0) return false;
-    if (i2c_read_blocking(I2C_PORT, addr, buffer, 6, false) < 0) return false;
+    hw->data_cmd = MPU6050_REG_ACCEL_XOUT_H;
+    for (int i = 0; i < IMU_BURST_LEN; i++) {
+        uint32_t cmd = I2C_IC_DATA_CMD_CMD_BITS;
+        if (i == 0) cmd |= I2C_IC_DATA_CMD_RESTART_BITS;
+        if (i == IMU_BURST_LEN - 1) cmd |= I2C_IC_DATA_CMD_STOP_BITS;
+        hw->data_cmd = cmd;
+    }
+}
 
-    for (int i = 0; i < 3; i++)
-        gyro[i] = (buffer[i * 2] << 8) | buffer[i * 2 + 1];
+//Burst ou quadro da FIFO: accel, temperatura e giro, big-endian
+static void decode_burst(const uint8_t *buffer, sensor_sample_t *out) {
+    for (int i = 0; i < 3; i++) {
+        out->accel[i] = (int16_t)((buffer[i * 2] << 8) | buffer[i * 2 + 1]);
+        out->gyro[i] = (int16_t)((buffer[8 + i * 2] << 8) | buffer[8 + i * 2 + 1]);
+    }
+    out->temp = (int16_t)((buffer[6] << 8) | buffer[7]);
+    out->ok = true;
+}
 
+//Espera os 14 bytes na FIFO de recepção (16 posições) e os decodifica
+//(no PIO, dorme até a interrupção de fim da transferência)
+static bool burst_finish(const imu_dev_t *dev, absolute_time_t deadline, sensor_sample_t *out) {
+    uint8_t buffer[IMU_BURST_LEN];
+    out->ok = false;
+    if (on_pio(dev)) {
+        if (!pio_i2c_read_finish(buffer, deadline)) return false;
+    } else {
+        i2c_hw_t *hw = i2c_get_hw(dev->bus);
+        while (hw->rxflr < IMU_BURST_LEN) {
+            if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+                (void)hw->clr_tx_abrt;   // NACK: o controlador descarta o resto dos comandos
+                return false;
+            }
+            if (time_reached(deadline)) return false;
+        }
+        for (int i = 0; i < IMU_BURST_LEN; i++) buffer[i] = (uint8_t)hw->data_cmd;
+    }
+    decode_burst(buffer, out);
     return true;
 }
 
-//Reseta o sensor IMU MPU6050 e o tira do modo sleep.
+//Lê todos os sensores: em cada rodada um por barramento, os dois em paralelo.
+bool mpu6050_sensor_read(sensor_sample_t out[SENSOR_MAX_DEVICES]) {
+    bool done[IMU_MAX_DEVICES] = { false };
+    bool all_ok = true;
+    int remaining = device_count;
+    while (remaining > 0) {
+        int round[NUM_I2CS];
+        for (int b = 0; b < NUM_I2CS; b++) round[b] = -1;
+        for (int i = 0; i < device_count; i++) {
+            int b = (int)i2c_hw_index(devices[i].bus);
+            if (!done[i] && round[b] < 0) round[b] = i;
+        }
+
+        absolute_time_t deadline = make_timeout_time_us(IMU_BURST_TIMEOUT_US);
+        for (int b = 0; b < NUM_I2CS; b++) {
+            if (round[b] >= 0) burst_begin(&devices[round[b]]);
+        }
+        // Os controladores são consultados antes; o PIO, que dorme até a
+        // interrupção, por último
+        for (int pass = 0; pass < 2; pass++) {
+            for (int b = 0; b < NUM_I2CS; b++) {
+                int i = round[b];
+                if (i < 0 || on_pio(&devices[i]) != (pass == 1)) continue;
+                if (!burst_finish(&devices[i], deadline, &out[i])) all_ok = false;
+                done[i] = true;
+                remaining--;
+            }
+        }
+    }
+    return all_ok;
+}
+
+//Lê os dados brutos do sensor principal.
+bool mpu6050_sensor_read_primary(sensor_sample_t *out) {
+    burst_begin(&devices[0]);
+    return burst_finish(&devices[0], make_timeout_time_us(IMU_BURST_TIMEOUT_US), out);
+}
+
+//Liga (zerando) ou desliga a FIFO do sensor principal; o reset só vale com
+//FIFO_EN de USER_CTRL em 0
+bool mpu6050_sensor_fifo_enable(bool on) {
+    const imu_dev_t *dev = &devices[0];
+    bool ok = write_reg(dev, MPU6050_REG_FIFO_EN, 0) &&
+              write_reg(dev, MPU6050_REG_USER_CTRL, MPU6050_USER_CTRL_FIFO_RESET);
+    if (on) {
+        ok = ok && write_reg(dev, MPU6050_REG_USER_CTRL, MPU6050_USER_CTRL_FIFO_EN) &&
+             write_reg(dev, MPU6050_REG_FIFO_EN, MPU6050_FIFO_SOURCES);
+    }
+    fifo_on = on && ok;
+    return ok;
+}
+
+//Lê só quadros completos; cheia além do último quadro inteiro, a FIFO já
+//sobrescreveu amostras e perdeu o alinhamento, então recomeça vazia
+int mpu6050_sensor_fifo_drain(sensor_sample_t *out, int max) {
+    const imu_dev_t *dev = &devices[0];
+    uint8_t count_bytes[2];
+    if (!bus_read_reg(dev, MPU6050_REG_FIFO_COUNT_H, count_bytes, sizeof count_bytes)) return -1;
+    int count = (count_bytes[0] << 8) | count_bytes[1];
+    if (count > (MPU6050_FIFO_SIZE / IMU_BURST_LEN) * IMU_BURST_LEN) {
+        fifo_overflows++;
+        return mpu6050_sensor_fifo_enable(true) ? 0 : -1;
+    }
+
+    int frames = count / IMU_BURST_LEN;
+    if (frames > max) frames = max;
+    const int chunk = on_pio(dev) ? 1 : IMU_FIFO_CHUNK_FRAMES;
+    uint8_t buffer[IMU_FIFO_CHUNK_FRAMES * IMU_BURST_LEN];
+    for (int n = 0; n < frames; n += chunk) {
+        int k = frames - n < chunk ? frames - n : chunk;
+        if (!bus_read_reg(dev, MPU6050_REG_FIFO_R_W, buffer, (size_t)(k * IMU_BURST_LEN))) return -1;
+        for (int i = 0; i < k; i++) decode_burst(&buffer[i * IMU_BURST_LEN], &out[n + i]);
+    }
+    return frames;
+}
+
+//Reseta os sensores IMU MPU6050, os tira do modo sleep e reaplica a configuração.
 void imu_reset()
 {
-    uint8_t buf[] = {0x6B, 0x80};
-    i2c_write_blocking(I2C_PORT, addr, buf, 2, false);
+    write_reg_all(MPU6050_REG_PWR_MGMT_1, 0x80);
     sleep_ms(100);
 
-    buf[1] = 0x00;
-    i2c_write_blocking(I2C_PORT, addr, buf, 2, false);
+    write_reg_all(MPU6050_REG_PWR_MGMT_1, 0x00);
     sleep_ms(10);
-}
\ No newline at end of file
+    imu_set_config(&config);
+}
+
+bool imu_set_transport(imu_transport_t t, uint32_t hz) {
+    imu_transport_t previous = transport;
+    if (t == IMU_TRANSPORT_PIO) {
+        if (pio_i2c_is_active()) {
+            pio_i2c_set_baudrate(hz);
+        } else if (!pio_i2c_init(I2C_SDA, I2C_SCL, hz)) {
+            return false;
+        }
+    } else if (pio_i2c_is_active()) {
+        pio_i2c_deinit();
+        gpio_set_function(I2C_SDA, GPIO_FUNC_I2C);
+        gpio_set_function(I2C_SCL, GPIO_FUNC_I2C);
+    }
+    transport = t;
+
+    // Confere que o sensor principal responde pelo novo caminho
+    uint8_t id = 0;
+    if (!bus_read_reg(&devices[0], MPU6050_REG_WHO_AM_I, &id, 1) || (id & 0x7E) != MPU6050_WHO_AM_I) {
+        printf("[ERRO] IMU não responde via %s\n", t == IMU_TRANSPORT_PIO ? "PIO" : "controlador I2C");
+        if (previous != t) imu_set_transport(previous, pio_i2c_get_baudrate());
+        return false;
+    }
+    publish_metadata();
+    return true;
+}
+
+imu_transport_t imu_get_transport(void) {
+    return transport;
+}
+
+//O divisor do PIO depende de clk_sys
+void imu_clock_changed(void) {
+    if (transport == IMU_TRANSPORT_PIO) pio_i2c_set_baudrate(pio_i2c_get_baudrate());
+}
+
+//Gera pulsos de SCL até o escravo soltar SDA (ele estava no meio de um byte
+//de leitura) e fecha com um STOP. Os pinos viram GPIO em dreno aberto:
+//saída em 0, e a direção escolhe entre puxar para baixo e soltar.
+static bool bus_clear(uint sda, uint scl) {
+    const uint half = IMU_RECOVERY_HALF_PERIOD_US;
+    gpio_set_function(sda, GPIO_FUNC_SIO);
+    gpio_set_function(scl, GPIO_FUNC_SIO);
+    gpio_set_dir(sda, GPIO_IN);
+    gpio_set_dir(scl, GPIO_IN);
+    gpio_put(sda, 0);
+    gpio_put(scl, 0);
+    sleep_us(half);
+
+    bool sda_stuck = !gpio_get(sda);
+    for (int i = 0; i < IMU_RECOVERY_PULSES && !gpio_get(sda); i++) {
+        gpio_set_dir(scl, GPIO_OUT);
+        sleep_us(half);
+        gpio_set_dir(scl, GPIO_IN);
+        sleep_us(half);
+    }
+
+    // STOP: SDA sobe com SCL alto
+    gpio_set_dir(scl, GPIO_OUT);
+    sleep_us(half);
+    gpio_set_dir(sda, GPIO_OUT);
+    sleep_us(half);
+    gpio_set_dir(scl, GPIO_IN);
+    sleep_us(half);
+    gpio_set_dir(sda, GPIO_IN);
+    sleep_us(half);
+
+    bool released = gpio_get(sda) && gpio_get(scl);
+    if (sda_stuck || !released) {
+        printf("[AVISO] I2C nos GPIO %u/%u: SDA %s, %s\n", sda, scl, sda_stuck ? "presa em 0" : "livre",
+               released ? "barramento liberado" : "barramento continua travado");
+    }
+    return released;
+}
+
+//Devolve os pinos ao controlador, reiniciado do zero
+static void bus_reinit(i2c_inst_t *bus, uint sda, uint scl) {
+    i2c_init(bus, IMU_I2C_BAUD);
+    gpio_set_function(sda, GPIO_FUNC_I2C);
+    gpio_set_function(scl, GPIO_FUNC_I2C);
+    gpio_pull_up(sda);
+    gpio_pull_up(scl);
+}
+
+bool mpu6050_sensor_recover(void) {
+    bool aux = false;
+    for (int i = 0; i < device_count; i++) aux = aux || devices[i].bus == IMU_I2C_PORT_AUX;
+
+    bool pio = transport == IMU_TRANSPORT_PIO;
+    uint32_t pio_hz = pio_i2c_get_baudrate();
+    if (pio) pio_i2c_deinit();
+    bool ok = bus_clear(I2C_SDA, I2C_SCL);
+    bus_reinit(I2C_PORT, I2C_SDA, I2C_SCL);
+    if (pio && !pio_i2c_init(I2C_SDA, I2C_SCL, pio_hz)) {
+        transport = IMU_TRANSPORT_HW;   // sem o PIO, segue no controlador
+        publish_metadata();
+    }
+    if (aux) {
+        ok = bus_clear(IMU_I2C_AUX_SDA, IMU_I2C_AUX_SCL) && ok;
+        bus_reinit(IMU_I2C_PORT_AUX, IMU_I2C_AUX_SDA, IMU_I2C_AUX_SCL);
+    }
+
+    imu_reset();
+    if (fifo_on) mpu6050_sensor_fifo_enable(true);
+
+    uint8_t id = 0;
+    return ok && bus_read_reg(&devices[0], MPU6050_REG_WHO_AM_I, &id, 1) && (id & 0x7E) == MPU6050_WHO_AM_I;
+}
+
+//Grava SMPLRT_DIV, CONFIG, GYRO_CONFIG, ACCEL_CONFIG e o clock num sensor, e
+//confere os quatro primeiros lendo-os de volta em sequência
+static bool device_write_config(const imu_dev_t *dev, const imu_config_t *c) {
+    const uint8_t expected[4] = { c->sample_div, c->dlpf, (uint8_t)(c->gyro_range << 3),
+                                  (uint8_t)(c->accel_range << 3) };
+    bool ok = write_reg(dev, MPU6050_REG_PWR_MGMT_1, (uint8_t)c->clock);
+    for (int i = 0; ok && i < 4; i++) ok = write_reg(dev, (uint8_t)(MPU6050_REG_SMPLRT_DIV + i), expected[i]);
+
+    uint8_t readback[4];
+    ok = ok && bus_read_reg(dev, MPU6050_REG_SMPLRT_DIV, readback, sizeof readback);
+    for (int i = 0; ok && i < 4; i++) ok = readback[i] == expected[i];
+    return ok;
+}
+
+//Configura todos os sensores ou nenhum: se um falha, os já gravados (e ele
+//mesmo) voltam à configuração anterior, que continua valendo
+bool imu_set_config(const imu_config_t *c) {
+    if (c->accel_range > 3 || c->gyro_range > 3 || c->dlpf > 6 || c->clock > IMU_CLOCK_PLL_GYRO_X) {
+        printf("[ERRO] Configuração do IMU inválida\n");
+        return false;
+    }
+    for (int d = 0; d < device_count; d++) {
+        if (!device_write_config(&devices[d], c)) {
+            printf("[ERRO] Falha ao configurar o IMU %d\n", d);
+            for (int r = 0; r <= d; r++) {
+                if (!device_write_config(&devices[r], &config)) {
+                    printf("[ERRO] IMU %d não voltou à configuração anterior\n", r);
+                }
+            }
+            return false;
+        }
+    }
+    config = *c;
+    publish_metadata();
+    return true;
+}
+
+//Menor escala que cobre o pedido (a maior, se nenhuma cobre)
+static uint8_t range_at_least(const uint16_t *ranges, uint16_t wanted) {
+    uint8_t i = 0;
+    while (i < 3 && ranges[i] < wanted) i++;
+    return i;
+}
+
+//Escalas e taxa pedidas; abaixo de 1 kHz liga o DLPF com banda abaixo de
+//metade da taxa, acima dele o desliga (base de 8 kHz)
+bool mpu6050_sensor_configure(const sensor_config_t *c) {
+    imu_config_t next = config;
+    if (c->accel_g) next.accel_range = range_at_least(accel_range_g, c->accel_g);
+    if (c->gyro_dps) next.gyro_range = range_at_least(gyro_range_dps, c->gyro_dps);
+    if (c->output_rate_hz) {
+        uint32_t base = 8000u;
+        if (c->output_rate_hz <= 1000u) {
+            base = 1000u;
+            next.dlpf = 6;
+            for (uint8_t i = 1; i <= 6; i++) {
+                if (dlpf_accel_hz[i] * 2u <= c->output_rate_hz) {
+                    next.dlpf = i;
+                    break;
+                }
+            }
+        } else {
+            next.dlpf = 0;
+        }
+        uint32_t div = base / c->output_rate_hz;   // taxa >= pedida
+        if (div > UINT8_MAX + 1u) div = UINT8_MAX + 1u;
+        next.sample_div = (uint8_t)(div ? div - 1 : 0);
+    }
+    return imu_set_config(&next);
+}
+
+static const char *const channel_names[SENSOR_CHANNELS] = { "accel_x", "accel_y", "accel_z", "giro_x",
+                                                            "giro_y",  "giro_z",  "temp" };
+
+const sensor_info_t *mpu6050_sensor_describe(void) {
+    static sensor_info_t info;
+    info.model = "MPU6050";
+    info.devices = (uint8_t)device_count;
+    info.channel_count = SENSOR_CHANNELS;
+    for (int i = 0; i < SENSOR_CHANNELS; i++) {
+        sensor_channel_t *ch = &info.channel[i];
+        ch->name = channel_names[i];
+        if (i < 3) {
+            ch->unit = SENSOR_UNIT_G;
+            ch->lsb_per_unit = imu_accel_lsb_per_g();
+            ch->offset = 0.0f;
+        } else if (i < 6) {
+            ch->unit = SENSOR_UNIT_DPS;
+            ch->lsb_per_unit = imu_gyro_lsb_per_dps();
+            ch->offset = 0.0f;
+        } else {
+            ch->unit = SENSOR_UNIT_CELSIUS;   // TEMP_OUT / 340 + 36,53
+            ch->lsb_per_unit = 340.0f;
+            ch->offset = 36.53f;
+        }
+    }
+    info.output_rate_hz = imu_output_rate_hz();
+    info.fifo_frames = MPU6050_FIFO_SIZE / IMU_BURST_LEN;
+    info.fifo_overflows = fifo_overflows;
+    return &info;
+}
+
+const imu_config_t *imu_get_config(void) {
+    return &config;
+}
+
+float imu_accel_lsb_per_g(void) {
+    return (float)(16384 >> config.accel_range);
+}
+
+float imu_gyro_lsb_per_dps(void) {
+    return gyro_lsb_per_dps[config.gyro_range];
+}
+
+//Taxa de atualização dos registradores de dados
+uint32_t imu_output_rate_hz(void) {
+    uint32_t gyro_rate = config.dlpf == 0 ? 8000u : 1000u;
+    return gyro_rate / (1u + config.sample_div);
+}
+
+void imu_print_config(void) {
+    printf("IMU MPU6050: +-%u g (%.0f LSB/g), +-%u graus/s (%.1f LSB/(graus/s))\n", accel_range_g[config.accel_range],
+           (double)imu_accel_lsb_per_g(), gyro_range_dps[config.gyro_range], (double)imu_gyro_lsb_per_dps());
+    printf("  DLPF %u (accel %u Hz), divisor %u: saída a %lu Hz, clock %s\n", config.dlpf, dlpf_accel_hz[config.dlpf],
+           config.sample_div, (unsigned long)imu_output_rate_hz(),
+           config.clock == IMU_CLOCK_PLL_GYRO_X ? "PLL do giroscópio X" : "oscilador interno");
+    if (transport == IMU_TRANSPORT_PIO) {
+        printf("  I2C%u: PIO + DMA a %lu kHz (%lu erros)\n", i2c_hw_index(I2C_PORT),
+               (unsigned long)(pio_i2c_get_baudrate() / 1000), (unsigned long)pio_i2c_errors());
+    } else {
+        printf("  I2C%u: controlador I2C\n", i2c_hw_index(I2C_PORT));
+    }
+    for (int i = 0; i < device_count; i++) {
+        printf("  sensor %d: i2c%u, endereço 0x%02x%s\n", i, i2c_hw_index(devices[i].bus), devices[i].addr,
+               i == 0 ? " (principal)" : "");
+    }
+}
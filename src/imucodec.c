@@ -0,0 +1,206 @@
+#include "../inc/imucodec.h"
+
+#include <string.h>
+
+#define PAYLOAD_BYTES (IMUCODEC_BLOCK_SIZE - sizeof(imucodec_block_header_t))
+#define RICE_QMAX 24       // quociente a partir do qual o valor vai em binário (escape)
+#define RICE_KMAX 24
+#define RICE_RESET 64      // N em que A e N caem pela metade (acompanha mudanças)
+#define RICE_INIT_SUM 16   // A inicial dos eixos (k = 4)
+#define RICE_SUM_CLAMP (1u << 20)
+
+// Bits do escape por canal: 32 para o número da amostra, 17 para a
+// diferença de dois int16 em zigzag
+static const uint8_t raw_bits[IMUCODEC_AXES + 1] = { 32, 17, 17, 17, 17, 17, 17 };
+
+static inline uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t u) {
+    return (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+}
+
+//Menor k com N * 2^k >= A (média dos valores recentes)
+static inline unsigned rice_k(const imucodec_rice_t *r) {
+    unsigned k = 0;
+    while ((r->n << k) < r->sum && k < RICE_KMAX) k++;
+    return k;
+}
+
+static inline void rice_update(imucodec_rice_t *r, uint32_t u) {
+    r->sum += u < RICE_SUM_CLAMP ? u : RICE_SUM_CLAMP;
+    if (++r->n == RICE_RESET) {
+        r->sum >>= 1;
+        r->n >>= 1;
+    }
+}
+
+static void rice_reset(imucodec_rice_t rice[IMUCODEC_AXES + 1]) {
+    rice[0].sum = 0;  // número da amostra: quase sempre +1, k = 0
+    rice[0].n = 1;
+    for (int ch = 1; ch <= IMUCODEC_AXES; ch++) {
+        rice[ch].sum = RICE_INIT_SUM;
+        rice[ch].n = 1;
+    }
+}
+
+/* Codificador */
+
+//Escreve os n bits menos significativos de v (n <= 25), do mais significativo ao menos
+static void put_bits(imucodec_state_t *s, uint32_t v, unsigned n) {
+    s->acc = (s->acc << n) | (v & ((1u << n) - 1u));
+    s->nbits += n;
+    while (s->nbits >= 8) {
+        s->nbits -= 8;
+        if (s->pos < PAYLOAD_BYTES) {
+            s->out[s->pos++] = (uint8_t)(s->acc >> s->nbits);
+        } else {
+            s->overflow = true;
+        }
+    }
+}
+
+static void rice_put(imucodec_state_t *s, int ch, uint32_t u) {
+    imucodec_rice_t *r = &s->rice[ch];
+    unsigned k = rice_k(r);
+    uint32_t q = u >> k;
+    if (q < RICE_QMAX) {
+        put_bits(s, ((1u << q) - 1u) << 1, q + 1);  // q uns e um zero
+        put_bits(s, u, k);
+    } else {
+        put_bits(s, (1u << RICE_QMAX) - 1u, RICE_QMAX);
+        put_bits(s, u >> 16, raw_bits[ch] - 16u);
+        put_bits(s, u, 16);
+    }
+    rice_update(r, u);
+}
+
+static void encode_sample(imucodec_state_t *s, const imucodec_sample_t *cur) {
+    rice_put(s, 0, zigzag((int32_t)(cur->sample - s->prev.sample - 1u)));
+    for (int a = 0; a < IMUCODEC_AXES; a++) {
+        rice_put(s, a + 1, zigzag((int32_t)cur->axis[a] - s->prev.axis[a]));
+    }
+}
+
+static void begin_block(imucodec_encoder_t *enc, const imucodec_sample_t *first) {
+    imucodec_state_t *s = &enc->st;
+    s->out = enc->block[enc->current] + sizeof(imucodec_block_header_t);
+    s->acc = 0;
+    s->nbits = 0;
+    s->pos = 0;
+    s->overflow = false;
+    s->count = 1;
+    s->first = *first;
+    s->prev = *first;
+    rice_reset(s->rice);
+}
+
+//Completa o cabeçalho, zera o resto do bloco e passa para o outro buffer
+static const uint8_t *close_block(imucodec_encoder_t *enc) {
+    imucodec_state_t *s = &enc->st;
+    uint8_t *block = enc->block[enc->current];
+    imucodec_block_header_t header = {
+        .magic = IMUCODEC_BLOCK_MAGIC,
+        .count = s->count,
+        .payload_bits = (uint16_t)(s->pos * 8u + s->nbits),
+        .first_sample = s->first.sample,
+    };
+    memcpy(header.first, s->first.axis, sizeof(header.first));
+    if (s->nbits) s->out[s->pos++] = (uint8_t)(s->acc << (8 - s->nbits));
+    memset(s->out + s->pos, 0, PAYLOAD_BYTES - s->pos);
+    memcpy(block, &header, sizeof(header));
+
+    s->count = 0;
+    enc->current ^= 1;
+    return block;
+}
+
+void imucodec_encoder_init(imucodec_encoder_t *enc) {
+    enc->current = 0;
+    enc->st.count = 0;
+}
+
+const uint8_t *imucodec_encode(imucodec_encoder_t *enc, uint32_t sample, const int16_t accel[3],
+                               const int16_t gyro[3]) {
+    imucodec_sample_t cur = {
+        .sample = sample,
+        .axis = { accel[0], accel[1], accel[2], gyro[0], gyro[1], gyro[2] },
+    };
+    imucodec_state_t *s = &enc->st;
+    if (s->count == 0) {
+        begin_block(enc, &cur);
+        return NULL;
+    }
+
+    // Se a amostra não cabe, o bloco fecha sem ela e ela abre o próximo
+    imucodec_state_t saved = *s;
+    encode_sample(s, &cur);
+    if (s->overflow || s->pos * 8u + s->nbits > PAYLOAD_BYTES * 8u) {
+        *s = saved;
+        const uint8_t *done = close_block(enc);
+        begin_block(enc, &cur);
+        return done;
+    }
+    s->prev = cur;
+    if (++s->count == IMUCODEC_MAX_SAMPLES) return close_block(enc);
+    return NULL;
+}
+
+const uint8_t *imucodec_flush(imucodec_encoder_t *enc) {
+    if (enc->st.count == 0) return NULL;
+    return close_block(enc);
+}
+
+/* Decodificador */
+
+typedef struct {
+    const uint8_t *data;
+    uint32_t pos;  // em bits
+    uint32_t end;
+    bool error;
+} bit_reader_t;
+
+static uint32_t get_bits(bit_reader_t *r, unsigned n) {
+    uint32_t v = 0;
+    if (r->pos + n > r->end) {
+        r->error = true;
+        return 0;
+    }
+    for (unsigned i = 0; i < n; i++, r->pos++) {
+        v = (v << 1) | ((r->data[r->pos >> 3] >> (7 - (r->pos & 7))) & 1u);
+    }
+    return v;
+}
+
+static uint32_t rice_get(bit_reader_t *r, imucodec_rice_t *rice, int ch) {
+    unsigned k = rice_k(&rice[ch]);
+    uint32_t q = 0;
+    while (q < RICE_QMAX && !r->error && get_bits(r, 1)) q++;
+    uint32_t u = (q < RICE_QMAX) ? ((q << k) | get_bits(r, k)) : get_bits(r, raw_bits[ch]);
+    rice_update(&rice[ch], u);
+    return u;
+}
+
+int imucodec_decode(const uint8_t block[IMUCODEC_BLOCK_SIZE], imucodec_sample_t *out, int max) {
+    imucodec_block_header_t header;
+    memcpy(&header, block, sizeof(header));
+    if (header.magic != IMUCODEC_BLOCK_MAGIC || header.count == 0 || header.count > IMUCODEC_MAX_SAMPLES ||
+        header.count > max || header.payload_bits > PAYLOAD_BYTES * 8u) {
+        return -1;
+    }
+
+    bit_reader_t r = { .data = block + sizeof(header), .pos = 0, .end = header.payload_bits, .error = false };
+    imucodec_rice_t rice[IMUCODEC_AXES + 1];
+    rice_reset(rice);
+    out[0].sample = header.first_sample;
+    memcpy(out[0].axis, header.first, sizeof(header.first));
+    for (int i = 1; i < header.count; i++) {
+        out[i].sample = out[i - 1].sample + 1u + (uint32_t)unzigzag(rice_get(&r, rice, 0));
+        for (int a = 0; a < IMUCODEC_AXES; a++) {
+            out[i].axis[a] = (int16_t)(out[i - 1].axis[a] + unzigzag(rice_get(&r, rice, a + 1)));
+        }
+    }
+    if (r.error || r.pos != r.end) return -1;
+    return header.count;
+}
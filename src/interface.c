@@ -1,8 +1,11 @@
 #include "../inc/interface.h"
 #include "../inc/ssd1306.h"
 #include "../inc/font.h"
+#include "../inc/telemetry.h"
 #include "pico/stdlib.h"
 #include "hardware/pwm.h"
+#include "hardware/clocks.h"
+#include "../inc/power.h"
 #include <stdio.h>
 
 // Variáveis globais para controle dos periféricos
@@ -20,23 +23,36 @@ static bool is_sd_accessing = false;
 static bool is_system_recording = false;
 static bool sd_is_mounted = false;
 
-// Controle de piscadas
-static uint32_t last_blink_time = 0;
-static bool blink_state = false;
+// Tabela de padrões do LED RGB, indexada por led_status_t
+static const led_pattern_t led_patterns[LED_STATUS_COUNT] = {
+    [LED_STATUS_OFF]          = { LED_PATTERN_OFF },
+    [LED_STATUS_INITIALIZING] = { LED_PATTERN_SOLID, 255, 160, 0 },
+    [LED_STATUS_READY]        = { LED_PATTERN_SOLID, 0, 255, 0 },
+    [LED_STATUS_NO_SD]        = { LED_PATTERN_SOLID, 255, 0, 255 },
+    [LED_STATUS_SD_BUSY]      = { LED_PATTERN_BREATHE, 255, 160, 0, 0, 0, 0, 1000 },
+    [LED_STATUS_RECORDING]    = { LED_PATTERN_ALTERNATE, 255, 0, 0, 0, 0, 255, 600, 50, true },
+    [LED_STATUS_SD_ACCESS]    = { LED_PATTERN_BLINK, 0, 0, 255, 0, 0, 0, 200, 50 },
+    [LED_STATUS_ERROR]        = { LED_PATTERN_BLINK, 255, 0, 255, 0, 0, 0, 600, 50 },
+    [LED_STATUS_USB_MSC]      = { LED_PATTERN_BREATHE, 0, 0, 255, 0, 0, 0, 2000 },
+};
+
+// Período mínimo do padrão quando o nível de telemetria chega a 100%
+static const uint16_t LED_MIN_PERIOD_MS = 150;
+
+// Estado do motor de padrões (compartilhado com a interrupção do timer)
+static repeating_timer_t led_timer;
+static volatile led_status_t led_status = LED_STATUS_OFF;
+static volatile uint8_t led_level = 0;
+static uint16_t led_phase_ms = 0;
+static led_status_t led_last_status = LED_STATUS_OFF;
+static uint led_slice_red, led_slice_green, led_slice_blue;
+
+static void rgb_led_init(void);
+static bool led_timer_callback(repeating_timer_t *rt);
 
 //Inicializa os pinos de LEDs e interrupções.
 void interface_init(void) {
-    gpio_init(LED_RED_PIN);
-    gpio_set_dir(LED_RED_PIN, GPIO_OUT);
-    gpio_put(LED_RED_PIN, false);
-    
-    gpio_init(LED_GREEN_PIN);
-    gpio_set_dir(LED_GREEN_PIN, GPIO_OUT);
-    gpio_put(LED_GREEN_PIN, false);
-    
-    gpio_init(LED_BLUE_PIN);
-    gpio_set_dir(LED_BLUE_PIN, GPIO_OUT);
-    gpio_put(LED_BLUE_PIN, false);
+    rgb_led_init();
     
     gpio_init(BUTTON_A_PIN);
     gpio_set_dir(BUTTON_A_PIN, GPIO_IN);
@@ -50,6 +66,13 @@ void interface_init(void) {
     gpio_set_irq_enabled_with_callback(BUTTON_B_PIN, GPIO_IRQ_EDGE_FALL, true, &button_irq_handler);
     
     buzzer_init();
+    
+    add_repeating_timer_ms(-LED_TICK_MS, led_timer_callback, NULL, &led_timer);
+}
+
+//Divisor que gera a base de 1 MHz usada pelo buzzer
+static float buzzer_clkdiv(void) {
+    return (float)clock_get_hz(clk_sys) / 1000000.0f;
 }
 
 //Inicializa o buzzer 
@@ -58,7 +81,7 @@ void buzzer_init(void) {
     buzzer_slice = pwm_gpio_to_slice_num(BUZZER_PIN);
     buzzer_channel = pwm_gpio_to_channel(BUZZER_PIN);
     
-    pwm_set_clkdiv(buzzer_slice, 125.0f);
+    pwm_set_clkdiv(buzzer_slice, buzzer_clkdiv());
     uint32_t wrap = 1000;
     pwm_set_wrap(buzzer_slice, wrap);
     pwm_set_chan_level(buzzer_slice, buzzer_channel, wrap / 2);
@@ -81,6 +104,7 @@ void buzzer_beep(uint16_t frequency, uint16_t duration_ms) {
 
 //Toca uma sequência de bips predefinida
 void buzzer_play_sequence(buzzer_sequence_t sequence) {
+    uint64_t start = time_us_64();
     switch (sequence) {
         case BUZZER_INIT:
             buzzer_beep(440, 100);
@@ -112,20 +136,109 @@ void buzzer_play_sequence(buzzer_sequence_t sequence) {
             buzzer_beep(800, 100);
             break;
     }
+    telemetry_record(TELEM_BUZZER, (uint32_t)(time_us_64() - start));
+}
+
+//Divisor para ~1 kHz de PWM com wrap LED_PWM_WRAP na frequência atual
+static float rgb_led_clkdiv(void) {
+    float div = (float)clock_get_hz(clk_sys) / (1000.0f * (LED_PWM_WRAP + 1));
+    return div < 1.0f ? 1.0f : div;
+}
+
+//Configura um pino de LED como saída PWM
+static uint rgb_led_pwm_init(uint pin) {
+    gpio_set_function(pin, GPIO_FUNC_PWM);
+    uint slice = pwm_gpio_to_slice_num(pin);
+    pwm_set_clkdiv(slice, rgb_led_clkdiv());
+    pwm_set_wrap(slice, LED_PWM_WRAP);
+    pwm_set_gpio_level(pin, 0);
+    pwm_set_enabled(slice, true);
+    return slice;
+}
+
+//Inicializa os três canais PWM do LED RGB
+static void rgb_led_init(void) {
+    led_slice_red = rgb_led_pwm_init(LED_RED_PIN);
+    led_slice_green = rgb_led_pwm_init(LED_GREEN_PIN);
+    led_slice_blue = rgb_led_pwm_init(LED_BLUE_PIN);
 }
 
-//Desliga todos os LEDs 
-static void rgb_led_turn_off_all(void) {
-    gpio_put(LED_RED_PIN, false);
-    gpio_put(LED_GREEN_PIN, false);
-    gpio_put(LED_BLUE_PIN, false);
+//Converte brilho 0-255 em nível PWM com correção quadrática (gama ~2)
+static inline uint16_t rgb_led_level(uint8_t value, uint8_t brightness) {
+    uint32_t v = ((uint32_t)value * brightness) / 255;
+    return (uint16_t)((v * v) >> 4);
 }
 
-//Define o estado individual dos LEDs 
-static void rgb_led_set_individual(bool red, bool green, bool blue) {
-    gpio_put(LED_RED_PIN, red);
-    gpio_put(LED_GREEN_PIN, green);
-    gpio_put(LED_BLUE_PIN, blue);
+//Define a cor do LED RGB com um fator de brilho
+static void rgb_led_set_color(uint8_t r, uint8_t g, uint8_t b, uint8_t brightness) {
+    pwm_set_gpio_level(LED_RED_PIN, rgb_led_level(r, brightness));
+    pwm_set_gpio_level(LED_GREEN_PIN, rgb_led_level(g, brightness));
+    pwm_set_gpio_level(LED_BLUE_PIN, rgb_led_level(b, brightness));
+}
+
+//Período efetivo do padrão, encurtado pelo nível de telemetria quando aplicável
+static uint16_t led_pattern_period(const led_pattern_t *p, uint8_t level) {
+    if (!p->rate_follows_level || p->period_ms <= LED_MIN_PERIOD_MS) {
+        return p->period_ms;
+    }
+    if (level > 100) level = 100;
+    return p->period_ms - (uint16_t)(((uint32_t)(p->period_ms - LED_MIN_PERIOD_MS) * level) / 100);
+}
+
+//Avança o padrão atual; executado na interrupção do timer a cada LED_TICK_MS
+static bool led_timer_callback(repeating_timer_t *rt) {
+    (void)rt;
+    led_status_t status = led_status;
+    const led_pattern_t *p = &led_patterns[status];
+
+    if (status != led_last_status) {
+        led_last_status = status;
+        led_phase_ms = 0;
+    }
+
+    uint16_t period = led_pattern_period(p, led_level);
+    if (period == 0) period = 1;
+    led_phase_ms += LED_TICK_MS;
+    if (led_phase_ms >= period) {
+        led_phase_ms -= period;
+        if (led_phase_ms >= period) led_phase_ms = 0;
+    }
+    bool first_part = led_phase_ms < ((uint32_t)period * p->duty_percent) / 100;
+
+    switch (p->type) {
+        case LED_PATTERN_SOLID:
+            rgb_led_set_color(p->r, p->g, p->b, 255);
+            break;
+        case LED_PATTERN_BLINK:
+            rgb_led_set_color(p->r, p->g, p->b, first_part ? 255 : 0);
+            break;
+        case LED_PATTERN_BREATHE: {
+            uint16_t half = period / 2;
+            uint16_t ramp = led_phase_ms < half ? led_phase_ms : period - led_phase_ms;
+            rgb_led_set_color(p->r, p->g, p->b, half ? (uint8_t)((ramp * 255u) / half) : 255);
+            break;
+        }
+        case LED_PATTERN_ALTERNATE:
+            if (first_part) {
+                rgb_led_set_color(p->r, p->g, p->b, 255);
+            } else {
+                rgb_led_set_color(p->r2, p->g2, p->b2, 255);
+            }
+            break;
+        case LED_PATTERN_OFF:
+        default:
+            rgb_led_set_color(0, 0, 0, 0);
+            break;
+    }
+    return true;
+}
+
+//Recalcula os divisores PWM do LED e do buzzer após troca de clock
+void interface_clock_changed(void) {
+    pwm_set_clkdiv(led_slice_red, rgb_led_clkdiv());
+    pwm_set_clkdiv(led_slice_green, rgb_led_clkdiv());
+    pwm_set_clkdiv(led_slice_blue, rgb_led_clkdiv());
+    pwm_set_clkdiv(buzzer_slice, buzzer_clkdiv());
 }
 
 //Manipulador de interrupção para os botões.
@@ -143,6 +256,7 @@ void button_irq_handler(uint gpio, uint32_t events) {
             last_button_b_time = current_time;
         }
     }
+    power_notify_wakeup();
 }
 
 //Verifica se o botão A foi pressionado 
@@ -163,58 +277,66 @@ bool button_b_get_pressed(void) {
     return false;
 }
 
+//Próximo evento dos botões: acorde A+B ou aperto isolado já fora da janela do acorde
+button_event_t button_get_event(void) {
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    bool a = button_a_pressed;
+    bool b = button_b_pressed;
+
+    if (a && b) {
+        uint32_t gap = last_button_a_time > last_button_b_time ? last_button_a_time - last_button_b_time
+                                                               : last_button_b_time - last_button_a_time;
+        if (gap <= BUTTON_CHORD_WINDOW_MS) {
+            button_a_pressed = false;
+            button_b_pressed = false;
+            return BUTTON_EVENT_AB;
+        }
+    }
+    if (a && now - last_button_a_time > BUTTON_CHORD_WINDOW_MS) {
+        button_a_pressed = false;
+        return BUTTON_EVENT_A;
+    }
+    if (b && now - last_button_b_time > BUTTON_CHORD_WINDOW_MS) {
+        button_b_pressed = false;
+        return BUTTON_EVENT_B;
+    }
+    return BUTTON_EVENT_NONE;
+}
+
 //Define o estado de acesso ao SD card 
 void interface_sd_access_indication(bool accessing) {
     is_sd_accessing = accessing;
 }
 
-//Atualiza o estado dos LEDs RGB com base no estado atual do sistema.
+//Seleciona o padrão do LED RGB com base no estado atual do sistema.
+//Apenas troca o índice da tabela; a animação roda na interrupção do timer.
 void interface_update_state(system_state_t state, bool sd_mounted, bool recording_active) {
     current_led_state = state;
     is_system_recording = recording_active;
     sd_is_mounted = sd_mounted;
-    uint32_t current_time = to_ms_since_boot(get_absolute_time());
-    
-    rgb_led_turn_off_all();
 
+    led_status_t status;
     if (current_led_state == STATE_ERROR) {
-        if (current_time - last_blink_time >= 300) {
-            blink_state = !blink_state;
-            rgb_led_set_individual(blink_state, false, blink_state);
-            last_blink_time = current_time;
-        }
+        status = LED_STATUS_ERROR;
     } else if (is_system_recording) {
-        if (current_time - last_blink_time >= 300) {
-            blink_state = !blink_state;
-            if (blink_state) {
-                rgb_led_set_individual(true, false, false);
-            } else {
-                rgb_led_set_individual(false, false, true);
-            }
-            last_blink_time = current_time;
-        }
+        status = LED_STATUS_RECORDING;
+    } else if (current_led_state == STATE_USB_MSC) {
+        status = LED_STATUS_USB_MSC;
     } else if (current_led_state == STATE_MOUNTING_SD || current_led_state == STATE_UNMOUNTING_SD) {
-        rgb_led_set_individual(true, true, false);
-        blink_state = false;
+        status = LED_STATUS_SD_BUSY;
     } else if (current_led_state == STATE_INITIALIZING) {
-        rgb_led_set_individual(true, true, false);
-        blink_state = false;
+        status = LED_STATUS_INITIALIZING;
     } else if (current_led_state == STATE_READY) {
-        if (sd_is_mounted) {
-            rgb_led_set_individual(false, true, false);
-            blink_state = false;
-        } else {
-            rgb_led_set_individual(true, false, true);
-            blink_state = false;
-        }
+        status = sd_is_mounted ? LED_STATUS_READY : LED_STATUS_NO_SD;
     } else if (is_sd_accessing) {
-        if (current_time - last_blink_time >= 100) {
-            blink_state = !blink_state;
-            gpio_put(LED_BLUE_PIN, blink_state);
-            last_blink_time = current_time;
-        }
+        status = LED_STATUS_SD_ACCESS;
     } else {
-        rgb_led_turn_off_all();
-        blink_state = false;
+        status = LED_STATUS_OFF;
     }
-}
\ No newline at end of file
+    led_status = status;
+}
+
+//Define o nível de telemetria (0-100%) codificado na taxa de piscada
+void interface_set_level(uint8_t percent) {
+    led_level = percent > 100 ? 100 : percent;
+}
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
 
@@ -6,13 +7,29 @@
 #include "pico/binary_info.h"
 #include "pico/bootrom.h"
 #include "hardware/i2c.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/systick.h"
 #include "../lib/FatFs_SPI/sd_driver/hw_config.h"
 
 #include "../inc/ssd1306.h"
 #include "../inc/font.h"
 #include "../inc/imu.h"
+#include "../inc/sensor.h"
 #include "../inc/sdlogger.h"
 #include "../inc/interface.h"
+#include "../inc/scheduler.h"
+#include "../inc/telemetry.h"
+#include "../inc/power.h"
+#include "../inc/shell.h"
+#include "../inc/capture.h"
+#include "../inc/spectrum.h"
+#include "../inc/orientation.h"
+#include "../inc/calibration.h"
+#include "../inc/tempcomp.h"
+#include "../inc/decimator.h"
+#include "../inc/pio_i2c.h"
+#include "../inc/usb_msc.h"
+#include "../inc/xfer.h"
 
 // CONFIGURAÇÕES DO DISPLAY
 #define I2C_PORT_DISP i2c1
@@ -21,10 +38,19 @@
 #define ENDERECO_DISP 0x3C
 
 // CONFIGURAÇÕES DO SISTEMA
+#define ORIENT_BENCH_UPDATES 2000
+#define DECIM_BENCH_SAMPLES 2000
+#define FIFO_BATCH_MAX 32   // quadros da FIFO do sensor processados por tick
 #define SAMPLE_RATE_HZ 10
-#define SAMPLE_INTERVAL_MS (1000 / SAMPLE_RATE_HZ)
+#define SAMPLE_RATE_MAX_HZ 1000
 #define DISPLAY_UPDATE_INTERVAL_MS 250
-#define SD_CHECK_INTERVAL_MS 500
+#define SD_CHECK_INTERVAL_MS 1000
+#define BUTTON_CHECK_INTERVAL_MS 50
+#define SERIAL_POLL_INTERVAL_MS 10
+#define INTERFACE_UPDATE_INTERVAL_MS 20
+#define TELEMETRY_STREAM_INTERVAL_MS 5000
+#define IMU_RECOVERY_AFTER_ERRORS 3   // leituras seguidas com falha antes de destravar o barramento
+#define IMU_RECOVERY_MAX_ATTEMPTS 3   // recuperações seguidas sem sucesso: para a gravação
 
 // VARIÁVEIS GLOBAIS
 static system_state_t current_state = STATE_INITIALIZING;
@@ -32,8 +58,17 @@ static bool is_recording = false;
 static bool sd_mounted = false;
 static uint32_t sample_count = 0;
 static uint32_t recording_start_time = 0;
-static const char *imu_log_filename = "imu_data.csv";
+static char imu_log_filename[FF_LFN_BUF] = "imu_data.csv";
+static uint32_t sample_rate_hz = SAMPLE_RATE_HZ;
 static ssd1306_t ssd;
+static int sample_task = SCHED_INVALID_TASK;
+static int telemetry_task = SCHED_INVALID_TASK;
+static bool telemetry_streaming = false;
+static bool event_mode = false;  // gravação arma a captura por eventos em vez do log contínuo
+static int logged_sensors = 1;    // sensores gravados no log desta sessão
+static uint8_t imu_failures = 0;  // leituras seguidas do sensor principal com falha
+static bool fifo_mode = false;    // tick esvazia a FIFO do sensor em vez de ler uma amostra
+static int usb_task = SCHED_INVALID_TASK;
 
 // ESTADOS PARA DISPLAY DO SD
 typedef enum {
@@ -58,13 +93,24 @@ void stop_recording(void);
 void toggle_recording(void);
 bool mount_sd(void);
 void unmount_sd(void);
-void process_serial_command(char cmd);
 void process_buttons(void);
 void capture_imu_sample(void);
+void task_sample(void);
+void task_serial(void);
+void task_interface(void);
+void task_sd_check(void);
+void task_display(void);
+void task_usb(void);
+void commands_init(void);
 
 int main(void) {
+    telemetry_init();
+    usb_msc_init();
     stdio_init_all();
-    sleep_ms(2000);
+    // Enumera e dá tempo de abrir o terminal; até o escalonador, o USB só é
+    // atendido nessas esperas e durante a calibração
+    usb_msc_wait_ms(2000, true);
+    calibration_set_wait_hook(usb_msc_task);
     
     printf("IMU DATALOGGER\n");
     printf("CEPEDI - TIC37 - Feira de Santana\n");
@@ -76,15 +122,25 @@ int main(void) {
     interface_init();
     
     buzzer_play_sequence(BUZZER_INIT);
-    sleep_ms(500);
+    usb_msc_wait_ms(500, false);
     
     printf("Inicializando IMU MPU6050...\n");
     bi_decl(bi_2pins_with_func(I2C_SDA, I2C_SCL, GPIO_FUNC_I2C));
-    imu_init();
+    bool sensor_ok = sensor_init();
     
-    int16_t test_acc[3], test_gyro[3];
-    if (imu_read_raw(test_acc, test_gyro)) {
+    sensor_sample_t test;
+    if (sensor_ok && sensor_read_primary(&test)) {
         printf("IMU inicializado com sucesso!\n");
+        // A compensação térmica entra antes da calibração, então carrega primeiro
+        if (tempcomp_load()) {
+            tempcomp_print_status();
+        }
+        // Sem calibração gravada, mede agora (recusa se o IMU estiver em movimento)
+        if (calibration_load()) {
+            calibration_print_status();
+        } else {
+            calibration_run(CALIB_DEFAULT_SAMPLES);
+        }
     } else {
         printf("Erro na inicialização do IMU!\n");
         current_state = STATE_ERROR;
@@ -96,65 +152,99 @@ int main(void) {
     }
     
     printf("SISTEMA PRONTO\n");
-    printf("Comandos: 's'=gravar, 'm'=montar SD (serial), 'h'=ajuda\n");
-    printf("Botões: A=gravar, B=SD (Montar/Desmontar)\n");
-    printf("Taxa de amostragem: %d Hz\n", SAMPLE_RATE_HZ);
+    printf("Comandos: 's'=gravar, 'm'=montar SD (serial), 'h'=ajuda (terminar com Enter)\n");
+    printf("Botões: A=gravar, B=SD (Montar/Desmontar), A+B=modo disco USB\n");
+    printf("Taxa de amostragem: %lu Hz\n", sample_rate_hz);
     
-    uint32_t last_display_update = 0;
-    uint32_t last_sample_time = 0;
-    uint32_t last_interface_update = 0;
-    uint32_t last_sd_check = 0;
-    uint32_t last_button_check = 0;
-
-    while (true) {
-        uint32_t current_time = to_ms_since_boot(get_absolute_time());
-        
-        if (current_time - last_interface_update >= 20) {
-            interface_update_state(current_state, sd_mounted, is_recording);
-            last_interface_update = current_time;
-        }
+    commands_init();
 
-        if (current_time - last_button_check >= 50) {
-            process_buttons();
-            last_button_check = current_time;
-        }
-        
-        int c = getchar_timeout_us(0);
-        if (c != PICO_ERROR_TIMEOUT) {
-            process_serial_command((char)c);
-        }
-        
-        if (current_time - last_display_update >= DISPLAY_UPDATE_INTERVAL_MS) {
-            display_update();
-            last_display_update = current_time;
+    sample_task = sched_add_task("amostra", task_sample, 1000 / SAMPLE_RATE_HZ, 5, 2000);
+    int buttons_task = sched_add_task("botoes", process_buttons, BUTTON_CHECK_INTERVAL_MS, 3, 500);
+    sched_add_task("serial", task_serial, SERIAL_POLL_INTERVAL_MS, 3, 500);
+    usb_task = sched_add_task("usb", task_usb, USB_TASK_INTERVAL_MS, 4, 5000);
+    sched_add_task("led", task_interface, INTERFACE_UPDATE_INTERVAL_MS, 2, 50);
+    sched_add_task("display", task_display, DISPLAY_UPDATE_INTERVAL_MS, 1, 30000);
+    sched_add_task("sd_check", task_sd_check, SD_CHECK_INTERVAL_MS, 1, 5000);
+    telemetry_task = sched_add_task("telemetria", telemetry_print, TELEMETRY_STREAM_INTERVAL_MS, 0, 20000);
+    sched_set_enabled(telemetry_task, false);
+    sched_set_wakeup_task(buttons_task);
+
+    power_init();
+
+    sched_run();
+    
+    return 0;
+}
+
+//Tarefa periódica de amostragem do IMU; mede jitter e amostras perdidas
+void task_sample(void) {
+    static uint64_t last_start = 0;
+    const uint32_t nominal_us = 1000000u / sample_rate_hz;
+    uint64_t now = time_us_64();
+
+    if (is_recording && last_start) {
+        uint32_t interval = (uint32_t)(now - last_start);
+        telemetry_record(TELEM_SAMPLE_JITTER,
+                         interval > nominal_us ? interval - nominal_us : nominal_us - interval);
+        if (interval >= nominal_us + nominal_us / 2) {
+            telemetry_count_dropped((interval + nominal_us / 2) / nominal_us - 1);
         }
-        
-        if (current_time - last_sample_time >= SAMPLE_INTERVAL_MS) {
-            capture_imu_sample();
-            last_sample_time = current_time;
+    }
+    last_start = is_recording ? now : 0;
+
+    capture_imu_sample();
+}
+
+//Tarefa de atualização do display, com medição de duração
+void task_display(void) {
+    uint64_t start = time_us_64();
+    display_update();
+    telemetry_record(TELEM_DISPLAY, (uint32_t)(time_us_64() - start));
+}
+
+//Tarefa de leitura não bloqueante da serial (shell de linha)
+void task_serial(void) {
+    shell_poll();
+}
+
+static void leave_usb_msc(void);
+
+//Tarefa do USB: shell (CDC), disco e sessão "xfer"; sai do modo disco quando
+//o PC ejeta
+void task_usb(void) {
+    usb_msc_task();
+    if (xfer_is_active()) {
+        xfer_poll();
+        if (!xfer_is_active()) {
+            sched_set_period_ms(usb_task, USB_TASK_INTERVAL_MS);
+            power_set_active(false);
         }
-        
-        if (current_time - last_sd_check >= 1000) {
-            bool previous_sd_state = sd_mounted;
-            if (sd_mounted) {
-                interface_sd_access_indication(true);
-                sd_mounted = check_sd_status();
-                interface_sd_access_indication(false);
-                
-                if (!sd_mounted && previous_sd_state) {
-                    if (is_recording) {
-                        stop_recording();
-                    }
-                    current_state = STATE_READY;
-                }
-            }
-            last_sd_check = current_time;
+    }
+    if (usb_msc_take_eject()) {
+        printf("Disco ejetado pelo PC.\n");
+        leave_usb_msc();
+    }
+}
+
+//Tarefa que seleciona o padrão do LED; a animação roda no timer
+void task_interface(void) {
+    interface_update_state(current_state, sd_mounted, is_recording);
+}
+
+//Tarefa que verifica periodicamente se o SD continua acessível
+void task_sd_check(void) {
+    if (!sd_mounted) return;
+
+    interface_sd_access_indication(true);
+    sd_mounted = check_sd_status();
+    interface_sd_access_indication(false);
+
+    if (!sd_mounted) {
+        if (is_recording) {
+            stop_recording();
         }
-        
-        sleep_us(500);
+        current_state = STATE_READY;
     }
-    
-    return 0;
 }
 
 //Verifica se o SD card está fisicamente presente e montado.
@@ -244,16 +334,38 @@ void display_update(void) {
                 break;
 
             case STATE_RECORDING:
+                if (capture_is_armed()) {
+                    ssd1306_draw_string(&ssd, capture_in_event() ? "EVENTO!" : "ARMADO", 36, 28);
+                    snprintf(line, sizeof(line), "Eventos: %lu", (unsigned long)capture_event_count());
+                    ssd1306_draw_string(&ssd, line, (128 - (strlen(line) * 8)) / 2, 38);
+                    snprintf(line, sizeof(line), "Amostras: %lu", sample_count);
+                    ssd1306_draw_string(&ssd, line, (128 - (strlen(line) * 8)) / 2, 48);
+                    break;
+                }
                 ssd1306_draw_string(&ssd, "GRAVANDO...", 20, 28);
 
                 snprintf(line, sizeof(line), "Amostras: %lu", sample_count);
                 ssd1306_draw_string(&ssd, line, (128 - (strlen(line) * 8)) / 2, 38);
 
-                uint32_t recording_time = (to_ms_since_boot(get_absolute_time()) - recording_start_time) / 1000;
-                snprintf(line, sizeof(line), "Tempo: %lus", recording_time);
+                uint8_t peak_axis;
+                uint32_t peak_mhz;
+                if (spectrum_is_active() && spectrum_dominant(&peak_axis, &peak_mhz)) {
+                    // Frequência dominante do último intervalo do espectro
+                    snprintf(line, sizeof(line), "Pico %lu.%luHz %c", (unsigned long)(peak_mhz / 1000),
+                             (unsigned long)(peak_mhz % 1000 / 100), "XYZ"[peak_axis]);
+                } else {
+                    uint32_t recording_time = (to_ms_since_boot(get_absolute_time()) - recording_start_time) / 1000;
+                    snprintf(line, sizeof(line), "Tempo: %lus", recording_time);
+                }
                 ssd1306_draw_string(&ssd, line, (128 - (strlen(line) * 8)) / 2, 48);
                 break;
 
+            case STATE_USB_MSC:
+                ssd1306_draw_string(&ssd, "MODO USB", 32, 28);
+                ssd1306_draw_string(&ssd, "SD no PC", 32, 38);
+                ssd1306_draw_string(&ssd, "A+B = Sair", 24, 48);
+                break;
+
             case STATE_ERROR:
                 ssd1306_draw_string(&ssd, "ERRO!", 44, 28);
                 ssd1306_draw_string(&ssd, "Verifique", (128 - (9 * 8)) / 2, 38); 
@@ -265,8 +377,32 @@ void display_update(void) {
     ssd1306_send_data(&ssd);
 }
 
+//Taxa das amostras da sessão: com FIFO, a de saída do sensor; sem, a do tick
+static uint32_t acquisition_rate_hz(void) {
+    return fifo_mode ? sensor_describe()->output_rate_hz : sample_rate_hz;
+}
+
+//Fecha o que start_recording abriu: log ou captura por eventos, espectro, orientação e temperatura
+static void stop_outputs(void) {
+    if (fifo_mode) sensor_fifo_enable(false);
+    if (capture_is_armed()) {
+        capture_disarm();
+    } else if (spectrum_get_mode() != SPECTRUM_ONLY) {
+        sdlogger_stop();
+    }
+    decimator_stop();
+    spectrum_stop();
+    orientation_stop();
+    tempcomp_stop();
+}
+
 //Inicia a gravação de dados do IMU no SD card.
 bool start_recording(void) {
+    if (usb_msc_is_active() || xfer_is_active()) {
+        printf("[AVISO] SD em uso pelo PC. Saia do modo USB antes de gravar.\n");
+        buzzer_play_sequence(BUZZER_ERROR);
+        return false;
+    }
     if (!sd_mounted) {
         current_state = STATE_ERROR;
         buzzer_play_sequence(BUZZER_ERROR);
@@ -274,10 +410,57 @@ bool start_recording(void) {
     }
     
     interface_sd_access_indication(true);
+    power_set_active(true);
     
-    if (sdlogger_start(imu_log_filename)) {
+    // Amostras (log contínuo ou eventos) e/ou espectro, conforme os modos
+    spectrum_mode_t spectrum = spectrum_get_mode();
+    bool started = true;
+    if (spectrum != SPECTRUM_ONLY) {
+        // Eventos, formato comprimido e FIFO gravam só o sensor principal
+        logged_sensors = 1;
+        if (!event_mode && sensor_count() > 1) {
+            if (sdlogger_get_format() == SDLOGGER_FORMAT_COMPRESSED) {
+                printf("[AVISO] Formato comprimido: só o sensor 0 será gravado.\n");
+            } else if (fifo_mode) {
+                printf("[AVISO] Modo FIFO: só o sensor 0 será gravado.\n");
+            } else {
+                logged_sensors = sensor_count();
+            }
+        }
+        // A decimação vale só para o log contínuo; eventos gravam na taxa de aquisição
+        if (event_mode && decimator_get_factor() > 1) {
+            printf("[AVISO] Captura por eventos: decimação ignorada.\n");
+        } else if (!event_mode) {
+            decimator_start();
+        }
+        started = sdlogger_set_sensors((uint8_t)logged_sensors) &&
+                  (event_mode ? capture_arm(imu_log_filename) : sdlogger_start(imu_log_filename));
+        // Iniciado antes do log para entrar nos metadados; sem o log, desfaz
+        if (!started) decimator_stop();
+    }
+    if (started && spectrum != SPECTRUM_OFF && !spectrum_start(imu_log_filename, acquisition_rate_hz())) {
+        stop_outputs();
+        started = false;
+    }
+    if (started && orientation_get_output() != ORIENT_OFF &&
+        !orientation_start(imu_log_filename, acquisition_rate_hz())) {
+        stop_outputs();
+        started = false;
+    }
+    if (started && !tempcomp_start(imu_log_filename)) {
+        stop_outputs();
+        started = false;
+    }
+    // Por último, para a FIFO não acumular durante a abertura dos arquivos
+    if (started && fifo_mode && !sensor_fifo_enable(true)) {
+        printf("[ERRO] Falha ao ligar a FIFO do sensor\n");
+        stop_outputs();
+        started = false;
+    }
+    if (started) {
         is_recording = true;
         sample_count = 0;
+        imu_failures = 0;
         recording_start_time = to_ms_since_boot(get_absolute_time());
         current_state = STATE_RECORDING;
         
@@ -287,6 +470,7 @@ bool start_recording(void) {
         return true;
     } else {
         interface_sd_access_indication(false);
+        power_set_active(false);
         current_state = STATE_ERROR;
         buzzer_play_sequence(BUZZER_ERROR);
         return false;
@@ -298,8 +482,9 @@ bool start_recording(void) {
 void stop_recording(void) {
     if (is_recording) {
         interface_sd_access_indication(true);
-        sdlogger_stop();
+        stop_outputs();
         is_recording = false;
+        power_set_active(false);
         current_state = STATE_READY;
         interface_sd_access_indication(false);
         buzzer_play_sequence(BUZZER_STOP_RECORDING);
@@ -320,6 +505,11 @@ bool mount_sd(void) {
     if (sd_mounted) {
         return true;
     }
+    if (usb_msc_is_active()) {
+        printf("[AVISO] SD em uso pelo PC. Saia do modo USB antes de montar.\n");
+        buzzer_play_sequence(BUZZER_ERROR);
+        return false;
+    }
     
     current_state = STATE_MOUNTING_SD; 
     sd_display_status = SD_STATE_MOUNTING;
@@ -354,6 +544,11 @@ void unmount_sd(void) {
     if (!sd_mounted) {
         return;
     }
+    if (xfer_is_active()) {
+        // A sessão tem arquivos abertos; o botão não derruba a transferência
+        buzzer_play_sequence(BUZZER_ERROR);
+        return;
+    }
     if (is_recording) {
         stop_recording();
     }
@@ -378,73 +573,926 @@ void unmount_sd(void) {
     interface_sd_access_indication(false);
 }
 
-//Processa comandos recebidos via serial.
-void process_serial_command(char cmd) {
-    switch (cmd) {
-        case 's':
+//Entrega o SD ao PC como disco USB. O FatFs é desmontado antes: enquanto o
+//disco estiver exposto, só o PC escreve no cartão.
+static bool enter_usb_msc(void) {
+    if (usb_msc_is_active()) return true;
+    if (is_recording) {
+        printf("[AVISO] Pare a gravação antes de entrar no modo USB.\n");
+        buzzer_play_sequence(BUZZER_ERROR);
+        return false;
+    }
+    if (xfer_is_active()) {
+        buzzer_play_sequence(BUZZER_ERROR);
+        return false;
+    }
+    if (!usb_msc_host_connected()) {
+        printf("[AVISO] Nenhum PC conectado ao USB.\n");
+        buzzer_play_sequence(BUZZER_ERROR);
+        return false;
+    }
+    unmount_sd();
+    interface_sd_access_indication(true);
+    bool ok = usb_msc_start(sd_get_by_num(0));
+    interface_sd_access_indication(false);
+    if (!ok) {
+        current_state = STATE_ERROR;
+        buzzer_play_sequence(BUZZER_ERROR);
+        return false;
+    }
+    // Clock pleno e tarefa do USB a cada 1 ms durante as cópias
+    power_set_active(true);
+    sched_set_period_ms(usb_task, USB_MSC_TASK_INTERVAL_MS);
+    current_state = STATE_USB_MSC;
+    buzzer_play_sequence(BUZZER_SD_UNMOUNT);
+    printf("Modo USB: SD exposto ao PC. Ejete o disco no PC (ou 'usb off' / A+B depois de ejetar).\n");
+    return true;
+}
+
+//Devolve o SD ao datalogger e remonta o FatFs (o PC pode ter alterado o cartão)
+static void leave_usb_msc(void) {
+    if (!usb_msc_is_active()) return;
+    usb_msc_stop();
+    sched_set_period_ms(usb_task, USB_TASK_INTERVAL_MS);
+    power_set_active(false);
+    current_state = STATE_READY;
+    printf("Modo USB encerrado.\n");
+    mount_sd();
+}
+
+//Comandos do shell serial. Os argumentos vêm de strtok(NULL, " ").
+static void cmd_record(void) {
+    toggle_recording();
+}
+
+static void cmd_mount(void) {
+    mount_sd();
+}
+
+static void cmd_unmount(void) {
+    unmount_sd();
+}
+
+//Executa uma função de sdlogger.c que exige o SD montado
+static bool cmd_require_sd(void) {
+    if (!sd_mounted) {
+        printf("SD não montado. Monte primeiro com 'm'.\n");
+        return false;
+    }
+    return true;
+}
+
+static void cmd_ls(void) {
+    if (!cmd_require_sd()) return;
+    interface_sd_access_indication(true);
+    run_ls();
+    interface_sd_access_indication(false);
+}
+
+static void cmd_cat(void) {
+    if (!cmd_require_sd()) return;
+    interface_sd_access_indication(true);
+    run_cat();
+    interface_sd_access_indication(false);
+}
+
+static void cmd_getfree(void) {
+    if (!cmd_require_sd()) return;
+    run_getfree();
+}
+
+static void cmd_format(void) {
+    if (is_recording) {
+        printf("[AVISO] Pare a gravação antes de formatar.\n");
+        return;
+    }
+    if (usb_msc_is_active()) {
+        printf("[AVISO] SD em uso pelo PC. Saia do modo USB antes de formatar.\n");
+        return;
+    }
+    interface_sd_access_indication(true);
+    run_format();
+    interface_sd_access_indication(false);
+}
+
+static void cmd_setrtc(void) {
+    run_setrtc();
+}
+
+//usb [on|off]: modo disco USB; sem argumento mostra o estado
+static void cmd_usb(void) {
+    const char *arg = strtok(NULL, " \t");
+    if (!arg) {
+        usb_msc_print_status();
+    } else if (strcmp(arg, "on") == 0) {
+        enter_usb_msc();
+    } else if (strcmp(arg, "off") == 0) {
+        if (!usb_msc_is_active()) {
+            printf("Modo USB já desligado.\n");
+            return;
+        }
+        leave_usb_msc();
+    } else {
+        printf("Uso: usb [on|off]\n");
+    }
+}
+
+//xfer: troca o CDC para o protocolo binário de transferência (xfer.h). O
+//cliente imulog_fetch manda este comando sozinho; o shell volta quando a
+//sessão termina.
+static void cmd_xfer(void) {
+    if (!cmd_require_sd()) return;
+    if (is_recording) {
+        printf("[AVISO] Pare a gravação antes de transferir arquivos.\n");
+        return;
+    }
+    if (!xfer_start()) return;
+    // Clock pleno e tarefa do USB a cada 1 ms durante a sessão
+    power_set_active(true);
+    sched_set_period_ms(usb_task, USB_MSC_TASK_INTERVAL_MS);
+}
+
+//Avisa se a taxa de amostragem não combina com a saída do sensor (leituras repetidas ou FIFO cheia)
+static void warn_imu_rate(void) {
+    uint32_t output_hz = sensor_describe()->output_rate_hz;
+    if (fifo_mode) {
+        if (output_hz > sample_rate_hz * FIFO_BATCH_MAX) {
+            printf("[AVISO] Saída do sensor (%lu Hz) acima de %d amostras por tick: a FIFO vai transbordar.\n",
+                   (unsigned long)output_hz, FIFO_BATCH_MAX);
+        }
+    } else if (sample_rate_hz > output_hz) {
+        printf("[AVISO] Taxa de amostragem acima da saída do IMU (%lu Hz): amostras repetidas.\n",
+               (unsigned long)output_hz);
+    }
+}
+
+//taxa <hz>: altera a taxa de amostragem
+static void cmd_rate(void) {
+    const char *arg = strtok(NULL, " \t");
+    if (!arg) {
+        printf("Taxa de amostragem: %lu Hz\n", sample_rate_hz);
+        return;
+    }
+    long hz = strtol(arg, NULL, 10);
+    if (hz < 1 || hz > SAMPLE_RATE_MAX_HZ) {
+        printf("[ERRO] Taxa deve estar entre 1 e %d Hz\n", SAMPLE_RATE_MAX_HZ);
+        return;
+    }
+    sample_rate_hz = (uint32_t)hz;
+    sched_set_period_us(sample_task, 1000000u / sample_rate_hz);
+    printf("Taxa de amostragem: %lu Hz\n", sample_rate_hz);
+    warn_imu_rate();
+}
+
+//arquivo <nome>: define o arquivo da próxima gravação
+static void cmd_file(void) {
+    const char *arg = strtok(NULL, " \t");
+    if (!arg) {
+        printf("Arquivo de log: %s\n", imu_log_filename);
+        return;
+    }
+    if (is_recording) {
+        printf("[AVISO] O novo nome vale a partir da próxima gravação.\n");
+    }
+    strncpy(imu_log_filename, arg, sizeof(imu_log_filename) - 1);
+    imu_log_filename[sizeof(imu_log_filename) - 1] = '\0';
+    printf("Arquivo de log: %s\n", imu_log_filename);
+}
+
+//formato [csv|bin|rice] [direto|buffer]: formato e modo de escrita do log
+static void cmd_log_format(void) {
+    const char *arg;
+    while ((arg = strtok(NULL, " \t")) != NULL) {
+        if (strcmp(arg, "csv") == 0) {
+            sdlogger_set_format(SDLOGGER_FORMAT_CSV);
+        } else if (strcmp(arg, "bin") == 0) {
+            sdlogger_set_format(SDLOGGER_FORMAT_BINARY);
+        } else if (strcmp(arg, "rice") == 0) {
+            sdlogger_set_format(SDLOGGER_FORMAT_COMPRESSED);
+        } else if (strcmp(arg, "direto") == 0 || strcmp(arg, "buffer") == 0) {
+            sdlogger_set_buffered(strcmp(arg, "buffer") == 0);
+        } else {
+            printf("Uso: formato [csv|bin|rice] [direto|buffer]\n");
+            return;
+        }
+    }
+    printf("Formato do log: %s, escrita %s\n",
+           sdlogger_format_name(sdlogger_get_format()),
+           sdlogger_is_buffered() ? "bufferizada (4 KiB)" : "direta");
+}
+
+//evento [on|off] [eixo <n> <limiar>|mag <limiar>|giro <limiar>] [janela <pre> <pos>]
+static void cmd_event(void) {
+    const char *arg;
+    while ((arg = strtok(NULL, " \t")) != NULL) {
+        capture_trigger_t trigger = *capture_get_trigger();
+        if (strcmp(arg, "on") == 0 || strcmp(arg, "off") == 0) {
+            event_mode = (strcmp(arg, "on") == 0);
+            if (is_recording) printf("[AVISO] O modo vale a partir da próxima gravação.\n");
+            continue;
+        }
+        if (strcmp(arg, "eixo") == 0) {
+            const char *axis = strtok(NULL, " \t");
+            trigger.type = CAPTURE_TRIGGER_AXIS;
+            trigger.axis = axis ? (uint8_t)strtoul(axis, NULL, 10) : 0xFF;
+        } else if (strcmp(arg, "mag") == 0) {
+            trigger.type = CAPTURE_TRIGGER_ACCEL_MAG;
+        } else if (strcmp(arg, "giro") == 0) {
+            trigger.type = CAPTURE_TRIGGER_GYRO_MAG;
+        } else if (strcmp(arg, "janela") == 0) {
+            const char *pre = strtok(NULL, " \t");
+            const char *post = strtok(NULL, " \t");
+            if (!pre || !post) {
+                printf("Uso: evento janela <pre> <pos>\n");
+                return;
+            }
+            if (!capture_set_window(strtoul(pre, NULL, 10), strtoul(post, NULL, 10))) return;
+            continue;
+        } else {
+            printf("Uso: evento [on|off] [eixo <n> <limiar>|mag <limiar>|giro <limiar>] [janela <pre> <pos>]\n");
+            return;
+        }
+        const char *threshold = strtok(NULL, " \t");
+        long value = threshold ? strtol(threshold, NULL, 10) : -1;
+        if (value < 1 || value > UINT16_MAX) {
+            printf("[ERRO] Limiar deve estar entre 1 e %d\n", UINT16_MAX);
+            return;
+        }
+        trigger.threshold = (uint16_t)value;
+        if (!capture_set_trigger(&trigger)) return;
+    }
+    printf("Captura por eventos %s\n", event_mode ? "ativada ('s' ou botão A arma)" : "desativada");
+    capture_print_status();
+}
+
+//espectro [off|junto|so] [256|512] [<seg>s|<ms>ms]: espectro de vibração
+static void cmd_spectrum(void) {
+    const char *arg;
+    while ((arg = strtok(NULL, " \t")) != NULL) {
+        if (is_recording) {
+            printf("[AVISO] Pare a gravação antes de configurar o espectro.\n");
+            return;
+        }
+        char *unit;
+        unsigned long value = strtoul(arg, &unit, 10);
+        if (strcmp(arg, "off") == 0) {
+            spectrum_set_mode(SPECTRUM_OFF);
+        } else if (strcmp(arg, "junto") == 0) {
+            spectrum_set_mode(SPECTRUM_WITH_RAW);
+        } else if (strcmp(arg, "so") == 0) {
+            spectrum_set_mode(SPECTRUM_ONLY);
+        } else if (unit != arg && *unit == '\0') {
+            if (!spectrum_set_points((uint16_t)value)) return;
+        } else if (unit != arg && (strcmp(unit, "s") == 0 || strcmp(unit, "ms") == 0)) {
+            if (!spectrum_set_interval_ms(strcmp(unit, "s") == 0 ? value * 1000u : value)) return;
+        } else {
+            printf("Uso: espectro [off|junto|so] [256|512] [<seg>s|<ms>ms]\n");
+            return;
+        }
+    }
+    spectrum_print_status();
+}
+
+//Ciclos de CPU por atualização do filtro de orientação, medidos com o SysTick
+//(contador decrescente de 24 bits no clock do processador)
+static void orientation_bench(uint32_t updates) {
+    static orientation_t o;
+    orientation_init(&o, sample_rate_hz, ORIENT_GYRO_LSB_PER_DPS, ORIENT_ACCEL_LSB_PER_G);
+    const int16_t level[3] = { 0, 0, 16384 };
+    orientation_update(&o, level, level);  // alinhamento inicial fora da medida
+    systick_hw->rvr = M0PLUS_SYST_RVR_BITS;
+    systick_hw->cvr = 0;
+    systick_hw->csr = M0PLUS_SYST_CSR_CLKSOURCE_BITS | M0PLUS_SYST_CSR_ENABLE_BITS;
+
+    uint32_t t0 = systick_hw->cvr;
+    uint32_t overhead = (t0 - systick_hw->cvr) & M0PLUS_SYST_RVR_BITS;
+    uint32_t min = UINT32_MAX, max = 0;
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < updates; i++) {
+        // Entradas variadas: giro em rotação lenta e acelerômetro perto de 1 g
+        int16_t accel[3] = { (int16_t)((i * 37u) % 2001u) - 1000, (int16_t)((i * 53u) % 801u) - 400, 16000 };
+        int16_t gyro[3] = { (int16_t)((i * 11u) % 601u) - 300, (int16_t)((i * 7u) % 201u) - 100, 25 };
+        t0 = systick_hw->cvr;
+        orientation_update(&o, accel, gyro);
+        uint32_t cycles = ((t0 - systick_hw->cvr) & M0PLUS_SYST_RVR_BITS) - overhead;
+        if (cycles < min) min = cycles;
+        if (cycles > max) max = cycles;
+        sum += cycles;
+    }
+    t0 = systick_hw->cvr;
+    int32_t euler[3];
+    orientation_euler_cdeg(&o, euler);
+    uint32_t euler_cycles = ((t0 - systick_hw->cvr) & M0PLUS_SYST_RVR_BITS) - overhead;
+    systick_hw->csr = 0;
+
+    uint32_t avg = (uint32_t)(sum / updates);
+    uint32_t clk = clock_get_hz(clk_sys);
+    printf("Filtro de orientação: %lu atualizações\n", (unsigned long)updates);
+    printf("  ciclos por atualização: min %lu, média %lu, max %lu\n", (unsigned long)min, (unsigned long)avg,
+           (unsigned long)max);
+    printf("  conversão para Euler: %lu ciclos\n", (unsigned long)euler_cycles);
+    printf("  taxa máxima (pior caso, CPU só no filtro): %lu Hz a %lu MHz, %lu Hz a %lu MHz\n",
+           (unsigned long)(clk / max), (unsigned long)(clk / 1000000u),
+           (unsigned long)((uint64_t)POWER_CLOCK_ACTIVE_KHZ * 1000u / max),
+           (unsigned long)(POWER_CLOCK_ACTIVE_KHZ / 1000u));
+}
+
+//orient [off|quat|euler] [decimação] | orient bench [n]: filtro de orientação
+static void cmd_orientation(void) {
+    const char *arg;
+    while ((arg = strtok(NULL, " \t")) != NULL) {
+        if (strcmp(arg, "bench") == 0) {
+            const char *n = strtok(NULL, " \t");
+            uint32_t updates = n ? strtoul(n, NULL, 10) : ORIENT_BENCH_UPDATES;
+            orientation_bench(updates ? updates : ORIENT_BENCH_UPDATES);
+            return;
+        }
+        if (is_recording) {
+            printf("[AVISO] Pare a gravação antes de configurar a orientação.\n");
+            return;
+        }
+        char *end;
+        unsigned long value = strtoul(arg, &end, 10);
+        if (strcmp(arg, "off") == 0) {
+            orientation_set_output(ORIENT_OFF);
+        } else if (strcmp(arg, "quat") == 0) {
+            orientation_set_output(ORIENT_QUATERNION);
+        } else if (strcmp(arg, "euler") == 0) {
+            orientation_set_output(ORIENT_EULER);
+        } else if (end != arg && *end == '\0' && value <= UINT16_MAX) {
+            if (!orientation_set_decimation((uint16_t)value)) return;
+        } else {
+            printf("Uso: orient [off|quat|euler] [decimação] | orient bench [n]\n");
+            return;
+        }
+    }
+    orientation_print_status();
+}
+
+//decim bench: ciclos por amostra de entrada do filtro de decimação (SysTick),
+//no fator atual (ou 10, se desligada)
+static void decimator_bench(uint32_t samples) {
+    uint8_t previous = decimator_get_factor();
+    if (previous == 1) decimator_set_factor(10);
+    static decimator_t d;
+    decimator_reset(&d);
+    int16_t out_accel[3], out_gyro[3];
+    systick_hw->rvr = M0PLUS_SYST_RVR_BITS;
+    systick_hw->cvr = 0;
+    systick_hw->csr = M0PLUS_SYST_CSR_CLKSOURCE_BITS | M0PLUS_SYST_CSR_ENABLE_BITS;
+
+    uint32_t t0 = systick_hw->cvr;
+    uint32_t overhead = (t0 - systick_hw->cvr) & M0PLUS_SYST_RVR_BITS;
+    uint32_t min = UINT32_MAX, max = 0, outputs = 0;
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < samples; i++) {
+        int16_t accel[3] = { (int16_t)((i * 37u) % 2001u) - 1000, (int16_t)((i * 53u) % 801u) - 400, 16000 };
+        int16_t gyro[3] = { (int16_t)((i * 11u) % 601u) - 300, (int16_t)((i * 7u) % 201u) - 100, 25 };
+        t0 = systick_hw->cvr;
+        bool ready = decimator_push(&d, accel, gyro, out_accel, out_gyro);
+        uint32_t cycles = ((t0 - systick_hw->cvr) & M0PLUS_SYST_RVR_BITS) - overhead;
+        if (i == 0) continue;  // a primeira amostra também preenche o histórico
+        if (ready) outputs++;
+        if (cycles < min) min = cycles;
+        if (cycles > max) max = cycles;
+        sum += cycles;
+    }
+    systick_hw->csr = 0;
+
+    uint32_t avg = (uint32_t)(sum / (samples - 1));
+    uint32_t clk = clock_get_hz(clk_sys);
+    printf("Decimação 1:%u: %lu amostras de entrada (%lu saídas)\n", decimator_get_factor(), (unsigned long)samples,
+           (unsigned long)outputs);
+    printf("  ciclos por amostra de entrada: min %lu, média %lu, max %lu\n", (unsigned long)min, (unsigned long)avg,
+           (unsigned long)max);
+    printf("  CPU a %lu Hz com %d sensor(es): %.2f%% a %lu MHz\n", (unsigned long)acquisition_rate_hz(),
+           sensor_count(), 100.0 * max * acquisition_rate_hz() * sensor_count() / clk,
+           (unsigned long)(clk / 1000000u));
+    if (previous == 1) decimator_set_factor(1);
+}
+
+//decim [off|<fator>|hz <taxa>] | decim bench [n]: decimação antes do log
+static void cmd_decimation(void) {
+    const char *arg = strtok(NULL, " \t");
+    if (arg && strcmp(arg, "bench") == 0) {
+        const char *n = strtok(NULL, " \t");
+        uint32_t samples = n ? strtoul(n, NULL, 10) : DECIM_BENCH_SAMPLES;
+        decimator_bench(samples > 1 ? samples : DECIM_BENCH_SAMPLES);
+        return;
+    }
+    if (arg) {
+        if (is_recording) {
+            printf("[AVISO] Pare a gravação antes de configurar a decimação.\n");
+            return;
+        }
+        char *end;
+        unsigned long value;
+        if (strcmp(arg, "off") == 0) {
+            value = 1;
+        } else if (strcmp(arg, "hz") == 0) {
+            const char *hz = strtok(NULL, " \t");
+            unsigned long out_hz = hz ? strtoul(hz, &end, 10) : 0;
+            if (!hz || *end != '\0' || out_hz == 0 || acquisition_rate_hz() % out_hz != 0) {
+                printf("[ERRO] A taxa do log deve dividir a de aquisição (%lu Hz)\n",
+                       (unsigned long)acquisition_rate_hz());
+                return;
+            }
+            value = acquisition_rate_hz() / out_hz;
+        } else {
+            value = strtoul(arg, &end, 10);
+            if (end == arg || *end != '\0') {
+                printf("Uso: decim [off|<fator>|hz <taxa>] | decim bench [n]\n");
+                return;
+            }
+        }
+        if (!decimator_set_factor(value <= DECIM_MAX_FACTOR ? (uint8_t)value : 0)) return;
+    }
+    decimator_print_status(acquisition_rate_hz());
+}
+
+//Depois de trocar escalas: offsets e filtro de orientação acompanham
+static void sensor_scale_changed(void) {
+    tempcomp_refresh();
+    calibration_refresh();
+    orientation_set_scale(sensor_gyro_lsb_per_dps(), sensor_accel_lsb_per_g());
+}
+
+//Posição de 'value' na sequência smallest, 2*smallest, 4*smallest, 8*smallest (-1 se fora)
+static int range_index(unsigned long value, unsigned long smallest) {
+    for (int i = 0; i < 4; i++) {
+        if (value == smallest << i) return i;
+    }
+    return -1;
+}
+
+//imu [accel 2|4|8|16] [giro 250|500|1000|2000] [dlpf 0-6] [div n] [clock int|pll]: configuração do sensor
+static void cmd_imu(void) {
+    imu_config_t cfg = *imu_get_config();
+    imu_transport_t transport = imu_get_transport();
+    uint32_t i2c_hz = pio_i2c_is_active() ? pio_i2c_get_baudrate() : IMU_PIO_I2C_HZ;
+    bool changed = false, bus_changed = false;
+    const char *arg;
+    while ((arg = strtok(NULL, " \t")) != NULL) {
+        if (is_recording) {
+            printf("[AVISO] Pare a gravação antes de configurar o IMU.\n");
+            return;
+        }
+        const char *value = strtok(NULL, " \t");
+        char *end = NULL;
+        unsigned long v = value ? strtoul(value, &end, 10) : 0;
+        int range = value ? range_index(v, strcmp(arg, "accel") == 0 ? 2 : 250) : -1;
+        if (strcmp(arg, "accel") == 0 && range >= 0) {
+            cfg.accel_range = (uint8_t)range;
+        } else if (strcmp(arg, "giro") == 0 && range >= 0) {
+            cfg.gyro_range = (uint8_t)range;
+        } else if (strcmp(arg, "dlpf") == 0 && value && *end == '\0' && v <= 6) {
+            cfg.dlpf = (uint8_t)v;
+        } else if (strcmp(arg, "div") == 0 && value && *end == '\0' && v <= UINT8_MAX) {
+            cfg.sample_div = (uint8_t)v;
+        } else if (strcmp(arg, "clock") == 0 && value && (strcmp(value, "int") == 0 || strcmp(value, "pll") == 0)) {
+            cfg.clock = strcmp(value, "pll") == 0 ? IMU_CLOCK_PLL_GYRO_X : IMU_CLOCK_INTERNAL;
+        } else if (strcmp(arg, "i2c") == 0 && value && (strcmp(value, "hw") == 0 || strcmp(value, "pio") == 0)) {
+            transport = strcmp(value, "pio") == 0 ? IMU_TRANSPORT_PIO : IMU_TRANSPORT_HW;
+            bus_changed = true;
+            continue;
+        } else if (strcmp(arg, "khz") == 0 && value && *end == '\0' && v * 1000 >= PIO_I2C_MIN_HZ &&
+                   v * 1000 <= PIO_I2C_MAX_HZ) {
+            i2c_hz = (uint32_t)v * 1000;
+            bus_changed = true;
+            continue;
+        } else {
+            printf("Uso: imu [accel 2|4|8|16] [giro 250|500|1000|2000] [dlpf 0-6] [div 0-255] [clock int|pll]\n"
+                   "        [i2c hw|pio] [khz 100-1000]\n");
+            return;
+        }
+        changed = true;
+    }
+    if (bus_changed) {
+        if (i2c_hz > IMU_PIO_I2C_HZ) {
+            printf("[AVISO] O MPU6050 é especificado até %u kHz.\n", IMU_PIO_I2C_HZ / 1000);
+        }
+        if (!imu_set_transport(transport, i2c_hz)) return;
+    }
+    if (changed) {
+        if (!imu_set_config(&cfg)) return;
+        sensor_scale_changed();
+    }
+    imu_print_config();
+    warn_imu_rate();
+}
+
+static const char *const unit_names[] = { "g", "graus/s", "graus C" };
+
+//sensor [fifo on|off] [accel <g>] [giro <graus/s>] [hz <taxa>]: descrição e
+//configuração independente do modelo
+static void cmd_sensor(void) {
+    sensor_config_t cfg = { 0 };
+    bool changed = false;
+    const char *arg;
+    while ((arg = strtok(NULL, " \t")) != NULL) {
+        if (is_recording) {
+            printf("[AVISO] Pare a gravação antes de configurar o sensor.\n");
+            return;
+        }
+        const char *value = strtok(NULL, " \t");
+        char *end = NULL;
+        unsigned long v = value ? strtoul(value, &end, 10) : 0;
+        bool number = value && *end == '\0' && v > 0;
+        if (strcmp(arg, "fifo") == 0 && value && (strcmp(value, "on") == 0 || strcmp(value, "off") == 0)) {
+            if (strcmp(value, "on") == 0 && sensor_describe()->fifo_frames == 0) {
+                printf("[ERRO] Sensor sem FIFO\n");
+                return;
+            }
+            fifo_mode = strcmp(value, "on") == 0;
+            continue;
+        } else if (strcmp(arg, "accel") == 0 && number && v <= UINT16_MAX) {
+            cfg.accel_g = (uint16_t)v;
+        } else if (strcmp(arg, "giro") == 0 && number && v <= UINT16_MAX) {
+            cfg.gyro_dps = (uint16_t)v;
+        } else if (strcmp(arg, "hz") == 0 && number) {
+            cfg.output_rate_hz = (uint32_t)v;
+        } else {
+            printf("Uso: sensor [fifo on|off] [accel <g>] [giro <graus/s>] [hz <taxa>]\n");
+            return;
+        }
+        changed = true;
+    }
+    if (changed) {
+        if (!sensor_configure(&cfg)) return;
+        sensor_scale_changed();
+    }
+
+    const sensor_info_t *info = sensor_describe();
+    printf("Sensor %s: %u dispositivo(s), saída a %lu Hz\n", info->model, info->devices,
+           (unsigned long)info->output_rate_hz);
+    for (int i = 0; i < info->channel_count; i++) {
+        const sensor_channel_t *ch = &info->channel[i];
+        printf("  %-8s %.1f LSB/%s", ch->name, (double)ch->lsb_per_unit, unit_names[ch->unit]);
+        if (ch->offset != 0.0f) printf(", %+.2f", (double)ch->offset);
+        printf("\n");
+    }
+    if (info->fifo_frames) {
+        printf("  FIFO: %u amostras, %s (%lu transbordos)\n", info->fifo_frames,
+               fifo_mode ? "esvaziada a cada tick" : "desligada", (unsigned long)info->fifo_overflows);
+    }
+    warn_imu_rate();
+}
+
+//calib [medir [n]|limpar]: offsets do IMU
+static void cmd_calibration(void) {
+    const char *arg = strtok(NULL, " \t");
+    if (!arg) {
+        calibration_print_status();
+        return;
+    }
+    if (is_recording) {
+        printf("[AVISO] Pare a gravação antes de calibrar.\n");
+        return;
+    }
+    if (strcmp(arg, "medir") == 0) {
+        const char *n = strtok(NULL, " \t");
+        calibration_run(n ? strtoul(n, NULL, 10) : CALIB_DEFAULT_SAMPLES);
+    } else if (strcmp(arg, "limpar") == 0) {
+        calibration_clear();
+    } else {
+        printf("Uso: calib [medir [n]|limpar]\n");
+    }
+}
+
+//Lê até três coeficientes (c1 [c2 [c3]]) do resto da linha
+static bool parse_coefficients(float coef[TEMPCOMP_ORDER]) {
+    int count = 0;
+    const char *arg;
+    while ((arg = strtok(NULL, " \t")) != NULL) {
+        char *end;
+        float v = strtof(arg, &end);
+        if (end == arg || *end != '\0' || count >= TEMPCOMP_ORDER) return false;
+        coef[count++] = v;
+    }
+    for (int k = count; k < TEMPCOMP_ORDER; k++) coef[k] = 0.0f;
+    return count > 0;
+}
+
+//tempcomp [on|off|ref <graus>|eixo <ax..gz> c1 [c2 [c3]]|salvar|limpar|registro on|off]
+static void cmd_tempcomp(void) {
+    const char *arg = strtok(NULL, " \t");
+    if (!arg) {
+        tempcomp_print_status();
+        return;
+    }
+    if (is_recording) {
+        printf("[AVISO] Pare a gravação antes de configurar a compensação térmica.\n");
+        return;
+    }
+    const char *value = strtok(NULL, " \t");
+    bool coefficients_changed = false;
+    if (strcmp(arg, "on") == 0 || strcmp(arg, "off") == 0) {
+        if (!tempcomp_set_enabled(strcmp(arg, "on") == 0)) return;
+        coefficients_changed = true;
+    } else if (strcmp(arg, "ref") == 0 && value) {
+        char *end;
+        float celsius = strtof(value, &end);
+        if (end == value || *end != '\0' || !tempcomp_set_ref(celsius)) return;
+        coefficients_changed = true;
+    } else if (strcmp(arg, "eixo") == 0 && value) {
+        int axis = tempcomp_axis_index(value);
+        float coef[TEMPCOMP_ORDER];
+        if (axis < 0 || !parse_coefficients(coef)) {
+            printf("Uso: tempcomp eixo ax|ay|az|gx|gy|gz c1 [c2 [c3]]\n");
+            return;
+        }
+        if (!tempcomp_set_axis(axis, coef)) return;
+        coefficients_changed = true;
+    } else if (strcmp(arg, "salvar") == 0) {
+        tempcomp_save();
+        return;
+    } else if (strcmp(arg, "limpar") == 0) {
+        tempcomp_clear();
+        coefficients_changed = true;
+    } else if (strcmp(arg, "registro") == 0 && value && (strcmp(value, "on") == 0 || strcmp(value, "off") == 0)) {
+        if (!tempcomp_set_logging(strcmp(value, "on") == 0)) return;
+    } else {
+        printf("Uso: tempcomp [on|off|ref <graus>|eixo <ax..gz> c1 [c2 [c3]]|salvar|limpar|registro on|off]\n");
+        return;
+    }
+    tempcomp_print_status();
+    if (coefficients_changed && calibration_is_valid()) {
+        printf("[AVISO] Refaça 'calib medir': a calibração atual foi medida com a compensação anterior.\n");
+    }
+}
+
+static void cmd_tasks(void) {
+    sched_print_stats();
+}
+
+//telem [on|off|reset]: imprime ou controla a telemetria
+static void cmd_telemetry(void) {
+    const char *arg = strtok(NULL, " \t");
+    if (!arg) {
+        telemetry_print();
+    } else if (strcmp(arg, "on") == 0 || strcmp(arg, "off") == 0) {
+        telemetry_streaming = (strcmp(arg, "on") == 0);
+        sched_set_enabled(telemetry_task, telemetry_streaming);
+        printf("Telemetria periódica %s\n", telemetry_streaming ? "ativada" : "desativada");
+    } else if (strcmp(arg, "reset") == 0) {
+        telemetry_reset();
+        sched_reset_stats();
+        power_reset_stats();
+    } else {
+        printf("Uso: telem [on|off|reset]\n");
+    }
+}
+
+//Atalho legado: alterna a telemetria periódica
+static void cmd_telemetry_toggle(void) {
+    telemetry_streaming = !telemetry_streaming;
+    sched_set_enabled(telemetry_task, telemetry_streaming);
+    printf("Telemetria periódica %s\n", telemetry_streaming ? "ativada" : "desativada");
+}
+
+static void cmd_power(void) {
+    power_print_stats();
+}
+
+static void cmd_help(void) {
+    shell_print_help();
+}
+
+static const shell_command_t shell_commands[] = {
+    { "gravar",    "s", cmd_record,           "Iniciar/Parar gravação do IMU" },
+    { "montar",    "m", cmd_mount,            "Montar SD card" },
+    { "desmontar", "u", cmd_unmount,          "Desmontar SD card" },
+    { "ls",        "l", cmd_ls,               "Listar arquivos no SD [dir]" },
+    { "cat",       NULL, cmd_cat,             "Mostrar <arquivo> [amostra|<seg>s] [linhas]" },
+    { "livre",     NULL, cmd_getfree,         "Espaço livre no SD" },
+    { "formatar",  NULL, cmd_format,          "Formatar o SD" },
+    { "rtc",       NULL, cmd_setrtc,          "Ajustar relógio: <dia> <mes> <aa> <hh> <mm> <ss>" },
+    { "usb",       NULL, cmd_usb,             "Modo disco USB: SD exposto ao PC [on|off]" },
+    { "xfer",      NULL, cmd_xfer,            "Transferência binária de arquivos (cliente imulog_fetch)" },
+    { "taxa",      NULL, cmd_rate,            "Taxa de amostragem [hz]" },
+    { "arquivo",   NULL, cmd_file,            "Nome do arquivo de log [nome]" },
+    { "formato",   NULL, cmd_log_format,      "Formato do log [csv|bin|rice] [direto|buffer]" },
+    { "evento",    NULL, cmd_event,           "Captura por eventos [on|off] [eixo <n>|mag|giro <limiar>] [janela <pre> <pos>]" },
+    { "espectro",  NULL, cmd_spectrum,        "Espectro de vibração [off|junto|so] [256|512] [<seg>s]" },
+    { "orient",    NULL, cmd_orientation,     "Orientação [off|quat|euler] [decimação] | bench [n]" },
+    { "decim",     NULL, cmd_decimation,      "Decimação antes do log [off|<fator>|hz <taxa>] | bench [n]" },
+    { "sensor",    NULL, cmd_sensor,          "Sensor: canais e escalas [fifo on|off] [accel <g>] [giro <graus/s>] [hz <taxa>]" },
+    { "imu",       NULL, cmd_imu,             "Configuração do IMU [accel <g>] [giro <graus/s>] [dlpf <0-6>] [div <n>] [clock int|pll] [i2c hw|pio] [khz <n>]" },
+    { "calib",     NULL, cmd_calibration,     "Calibração de offset do IMU [medir [n]|limpar]" },
+    { "tempcomp",  NULL, cmd_tempcomp,        "Compensação térmica [on|off|ref <graus>|eixo <ax..gz> c1 [c2 [c3]]|salvar|limpar|registro on|off]" },
+    { "tarefas",   "t", cmd_tasks,            "Estatísticas das tarefas (tempo, WCET, deadlines)" },
+    { "telem",     "d", cmd_telemetry,        "Telemetria de desempenho [on|off|reset]" },
+    { "D",         NULL, cmd_telemetry_toggle, "Liga/desliga telemetria periódica" },
+    { "energia",   "e", cmd_power,            "Energia: clock atual e ciclo de trabalho" },
+    { "ajuda",     "h", cmd_help,             "Mostrar ajuda" },
+};
+
+//Registra a tabela de comandos no shell serial
+void commands_init(void) {
+    shell_init(shell_commands, count_of(shell_commands));
+}
+
+//Verifica e processa o pressionamento dos botões.
+void process_buttons(void) {
+    switch (button_get_event()) {
+        case BUTTON_EVENT_A:
             toggle_recording();
             break;
-            
-        case 'm':
-            mount_sd();
-            break;
-            
-        case 'u':
-            unmount_sd();
-            break;
-            
-        case 'l':
+        case BUTTON_EVENT_B:
             if (sd_mounted) {
-                interface_sd_access_indication(true);
-                run_ls();
-                interface_sd_access_indication(false);
+                unmount_sd();
             } else {
-                printf("SD não montado. Monte primeiro com 'm'.\n");
+                mount_sd();
             }
             break;
-            
-        case 'h':
-            printf("\n=== COMANDOS DISPONÍVEIS ===\n");
-            printf("s - Iniciar/Parar gravação do IMU\n");
-            printf("m - Montar SD card (serial apenas)\n");
-            printf("u - Desmontar SD card (serial apenas)\n");
-            printf("l - Listar arquivos no SD\n");
-            printf("h - Mostrar ajuda\n");
-            printf("=============================\n\n");
+        case BUTTON_EVENT_AB:
+            if (usb_msc_is_active()) {
+                leave_usb_msc();
+            } else {
+                enter_usb_msc();
+            }
             break;
-            
         default:
-            printf("Comando não reconhecido. Digite 'h' para ajuda.\n");
             break;
     }
 }
 
-//Verifica e processa o pressionamento dos botões.
-void process_buttons(void) {
-    if (button_a_get_pressed()) {
-        toggle_recording();
+//Log decimado: cada sensor passa pelo seu filtro e só as saídas vão para o log,
+//com o número da amostra de aquisição mais recente. readings NULL é um tick
+//perdido em todos os sensores.
+static bool log_decimated(const sensor_sample_t *readings) {
+    bool success = true;
+    for (int i = 0; success && i < logged_sensors; i++) {
+        int16_t accel[3], gyro[3];
+        // Leitura perdida repete a anterior, para o filtro deste sensor não sair de fase
+        bool ok = readings && readings[i].ok;
+        if (readings && !ok) telemetry_count_dropped(1);
+        if (!decimator_process((uint8_t)i, ok ? readings[i].accel : NULL, ok ? readings[i].gyro : NULL, accel,
+                               gyro)) {
+            continue;
+        }
+        success = i == 0 ? sdlogger_log_sample(sample_count, accel, gyro)
+                         : sdlogger_log_sensor(sample_count, (uint8_t)i, accel, gyro);
     }
-    
-    if (button_b_get_pressed()) {
-        if (sd_mounted) {
-            unmount_sd();
+    return success;
+}
+
+//Amostras perdidas (leitura com falha, recuperação do barramento): a numeração
+//pula e, no log decimado, cada filtro recebe a entrada anterior repetida, para
+//os intervalos de saída e o estado do FIR seguirem o tempo. false em erro de escrita.
+static bool skip_samples(uint32_t count) {
+    bool success = true;
+    for (uint32_t k = 0; k < count; k++) {
+        sample_count++;
+        if (success && decimator_is_active()) success = log_decimated(NULL);
+    }
+    return success;
+}
+
+//Uma amostra (de todos os sensores do tick, ou um quadro da FIFO): compensação,
+//calibração, log e análises. O sensor 0 alimenta espectro, orientação e captura
+//de eventos; os outros só vão para o log. false em erro de escrita.
+static bool process_sample(sensor_sample_t *readings) {
+    int16_t *accel = readings[0].accel, *gyro = readings[0].gyro;
+    sample_count++;
+    // Temperatura antes da calibração: os offsets dela foram medidos já compensados
+    bool success = tempcomp_process(sample_count, readings[0].temp, accel, gyro);
+    calibration_apply(accel, gyro);
+    interface_sd_access_indication(true); 
+    uint64_t t0 = time_us_64();
+    if (spectrum_get_mode() != SPECTRUM_ONLY) {
+        if (capture_is_armed()) {
+            success = capture_process(sample_count, accel, gyro) && success;
+        } else if (decimator_is_active()) {
+            success = log_decimated(readings) && success;
         } else {
-            mount_sd();
+            bool logged = sdlogger_log_sample(sample_count, accel, gyro);
+            for (int i = 1; logged && i < logged_sensors; i++) {
+                if (!readings[i].ok) {
+                    telemetry_count_dropped(1);
+                    continue;
+                }
+                logged = sdlogger_log_sensor(sample_count, (uint8_t)i, readings[i].accel, readings[i].gyro);
+            }
+            success = logged && success;
+        }
+        telemetry_record(TELEM_SD_WRITE, (uint32_t)(time_us_64() - t0));
+    }
+    if (spectrum_is_active()) {
+        t0 = time_us_64();
+        success = spectrum_process(sample_count, accel) && success;
+        telemetry_record(TELEM_SPECTRUM, (uint32_t)(time_us_64() - t0));
+    }
+    success = orientation_process(sample_count, accel, gyro) && success;
+    interface_sd_access_indication(false);
+    return success;
+}
+
+//Destrava o barramento depois de falhas seguidas de leitura. A gravação
+//continua: a numeração das amostras pula o trecho perdido (o que marca a
+//lacuna em todos os formatos) e o CSV ganha uma linha '#'. Retorna false
+//quando é hora de desistir.
+static bool recover_imu_bus(void) {
+    static uint8_t failed_attempts = 0;
+    uint64_t t0 = time_us_64();
+    bool ok = sensor_recover();
+    uint32_t elapsed = (uint32_t)(time_us_64() - t0);
+    telemetry_record(TELEM_I2C_RECOVERY, elapsed);
+    telemetry_count_i2c_recovery(ok);
+
+    // Tempo da recuperação em amostras da taxa de aquisição. Sem FIFO, cada tick
+    // com falha já avançou a numeração (handle_read_failure); com ela, os quadros
+    // desses ticks somem no imu_reset e entram aqui
+    const uint32_t tick_us = 1000000u / sample_rate_hz;
+    const uint32_t nominal_us = 1000000u / acquisition_rate_hz();
+    uint64_t missed_us = elapsed + (fifo_mode ? (uint64_t)imu_failures * tick_us : 0);
+    uint32_t lost = (uint32_t)((missed_us + nominal_us / 2) / nominal_us);
+    uint32_t total = fifo_mode ? lost : lost + imu_failures;
+    imu_failures = 0;
+    if (!capture_is_armed()) {
+        char note[64];
+        snprintf(note, sizeof note, "falha_i2c perdidas=%lu recuperacao_us=%lu%s", (unsigned long)total,
+                 (unsigned long)elapsed, ok ? "" : " sem_sucesso");
+        sdlogger_log_note(note);
+    }
+    if (!skip_samples(lost)) return false;
+
+    if (ok) {
+        printf("[AVISO] Barramento I2C recuperado em %lu us (%lu amostras perdidas)\n", (unsigned long)elapsed,
+               (unsigned long)total);
+        failed_attempts = 0;
+        return true;
+    }
+    printf("[ERRO] IMU não respondeu após a recuperação do barramento\n");
+    if (++failed_attempts < IMU_RECOVERY_MAX_ATTEMPTS) return true;
+    failed_attempts = 0;
+    return false;
+}
+
+//Leitura do sensor principal falhou: depois de algumas seguidas, destrava o barramento.
+//Sem FIFO o tick perdido é uma amostra, e a numeração pula mesmo que a próxima
+//leitura volte antes da recuperação; com ela, os quadros esperam o próximo tick.
+static void handle_read_failure(void) {
+    telemetry_count_dropped(1);
+    bool success = fifo_mode || skip_samples(1);
+    if (!success || (++imu_failures >= IMU_RECOVERY_AFTER_ERRORS && !recover_imu_bus())) {
+        stop_recording();
+        current_state = STATE_ERROR;
+    }
+}
+
+//Modo FIFO: o tick esvazia a FIFO do sensor principal e cada quadro vira uma
+//amostra. Um transbordo zera a FIFO; o CSV ganha uma linha '#' no ponto.
+static void capture_fifo(void) {
+    static sensor_sample_t frames[FIFO_BATCH_MAX];
+    static uint32_t overflows_seen = 0;
+
+    uint64_t t0 = time_us_64();
+    int n = sensor_fifo_drain(frames, FIFO_BATCH_MAX);
+    telemetry_record(TELEM_IMU_READ, (uint32_t)(time_us_64() - t0));
+    if (n < 0) {
+        handle_read_failure();
+        return;
+    }
+    imu_failures = 0;
+    if (n == 0) {
+        uint32_t overflows = sensor_describe()->fifo_overflows;
+        if (overflows != overflows_seen) {
+            overflows_seen = overflows;
+            telemetry_count_dropped(1);
+            printf("[AVISO] FIFO do sensor transbordou na amostra %lu\n", (unsigned long)sample_count);
+            if (!capture_is_armed()) sdlogger_log_note("fifo_transbordou");
         }
     }
+    for (int i = 0; i < n; i++) {
+        if (!process_sample(&frames[i])) {
+            stop_recording();
+            current_state = STATE_ERROR;
+            return;
+        }
+    }
+    interface_set_level(sdlogger_buffer_fill_percent());
 }
 
 //Captura uma amostra de dados do IMU e a registra no SD card se a gravação estiver ativa.
 void capture_imu_sample(void) {
     if (!is_recording) return;
+    if (fifo_mode) {
+        capture_fifo();
+        return;
+    }
     
-    int16_t accel[3], gyro[3];
+    // Todos os sensores no mesmo tick
+    sensor_sample_t readings[SENSOR_MAX_DEVICES];
     
-    if (imu_read_raw(accel, gyro)) {
-        sample_count++;
-        interface_sd_access_indication(true); 
-        bool success = sdlogger_log_sample(sample_count, accel, gyro);
-        interface_sd_access_indication(false);
+    uint64_t t0 = time_us_64();
+    sensor_read(readings);
+    telemetry_record(TELEM_IMU_READ, (uint32_t)(time_us_64() - t0));
+    
+    if (readings[0].ok) {
+        imu_failures = 0;
+        bool success = process_sample(readings);
+        interface_set_level(sdlogger_buffer_fill_percent());
         
         if (!success) {
             stop_recording();
@@ -452,12 +1500,6 @@ void capture_imu_sample(void) {
             return;
         }
     } else {
-        static uint8_t error_count = 0;
-        error_count++;
-        if (error_count >= 5) {
-            stop_recording();
-            current_state = STATE_ERROR;
-            error_count = 0;
-        }
+        handle_read_failure();
     }
 }
\ No newline at end of file
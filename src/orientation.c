@@ -0,0 +1,263 @@
+#include "../inc/orientation.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "f_util.h"
+#include "ff.h"
+
+#define INTEGRAL_LIMIT (ORIENT_Q_ONE / 2)  // 0,5 rad/s de bias estimado no máximo
+
+static inline int32_t mul30(int32_t a, int32_t b) {
+    return (int32_t)(((int64_t)a * b + (1 << 29)) >> 30);
+}
+
+static inline uint32_t square(int16_t v) {
+    return (uint32_t)((int32_t)v * v);
+}
+
+static uint32_t isqrt32(uint32_t v) {
+    uint32_t r = 0;
+    for (uint32_t bit = 1u << 30; bit; bit >>= 2) {
+        if (v >= r + bit) {
+            v -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+    }
+    return r;
+}
+
+void orientation_init(orientation_t *o, uint32_t rate_hz, float gyro_lsb_per_dps, float accel_lsb_per_g) {
+    memset(o, 0, sizeof *o);
+    o->q[0] = ORIENT_Q_ONE;
+    const double half_dt = 0.5 / rate_hz;
+    o->gyro_half_dt = (int32_t)lrint(M_PI / 180.0 / gyro_lsb_per_dps * half_dt * 1099511627776.0);  // 2^40
+    o->kp_half_dt = (int32_t)lrint(ORIENT_KP * half_dt * ORIENT_Q_ONE);
+    o->ki_dt = (int32_t)lrint(ORIENT_KI / rate_hz * ORIENT_Q_ONE);
+    o->half_dt = (int32_t)lrint(half_dt * ORIENT_Q_ONE);
+    o->accel_min_sq = (uint32_t)(0.25f * accel_lsb_per_g * accel_lsb_per_g);
+    o->accel_max_sq = (uint32_t)(2.25f * accel_lsb_per_g * accel_lsb_per_g);
+}
+
+//Primeiro quatérnio: roll e pitch da gravidade, yaw zero (evita a convergência lenta)
+static void align(orientation_t *o, const int16_t accel[3]) {
+    float roll = atan2f(accel[1], accel[2]);
+    float pitch = atan2f(-accel[0], sqrtf((float)accel[1] * accel[1] + (float)accel[2] * accel[2]));
+    float cr = cosf(roll / 2), sr = sinf(roll / 2), cp = cosf(pitch / 2), sp = sinf(pitch / 2);
+    o->q[0] = (int32_t)lrintf(cr * cp * ORIENT_Q_ONE);
+    o->q[1] = (int32_t)lrintf(sr * cp * ORIENT_Q_ONE);
+    o->q[2] = (int32_t)lrintf(cr * sp * ORIENT_Q_ONE);
+    o->q[3] = (int32_t)lrintf(-sr * sp * ORIENT_Q_ONE);
+    o->aligned = true;
+}
+
+//Um passo do filtro: erro entre a gravidade medida e a estimada (produto
+//vetorial) corrige a velocidade angular, que integra o quatérnio
+void orientation_update(orientation_t *o, const int16_t accel[3], const int16_t gyro[3]) {
+    int32_t *q = o->q;
+    uint32_t norm_sq = square(accel[0]) + square(accel[1]) + square(accel[2]);
+    bool use_accel = norm_sq >= o->accel_min_sq && norm_sq <= o->accel_max_sq;
+    if (!o->aligned) {
+        if (use_accel) align(o, accel);
+        return;
+    }
+
+    // Meio ângulo girado nesta amostra, em Q30
+    int32_t h[3];
+    for (int i = 0; i < 3; i++) h[i] = (int32_t)(((int64_t)gyro[i] * o->gyro_half_dt + (1 << 9)) >> 10);
+
+    if (use_accel) {
+        int32_t inv = (int32_t)((uint32_t)ORIENT_Q_ONE / isqrt32(norm_sq));
+        int32_t ax = accel[0] * inv, ay = accel[1] * inv, az = accel[2] * inv;
+        int32_t vx = 2 * (mul30(q[1], q[3]) - mul30(q[0], q[2]));
+        int32_t vy = 2 * (mul30(q[0], q[1]) + mul30(q[2], q[3]));
+        int32_t vz = mul30(q[0], q[0]) - mul30(q[1], q[1]) - mul30(q[2], q[2]) + mul30(q[3], q[3]);
+        int32_t e[3] = {
+            mul30(ay, vz) - mul30(az, vy),
+            mul30(az, vx) - mul30(ax, vz),
+            mul30(ax, vy) - mul30(ay, vx),
+        };
+        for (int i = 0; i < 3; i++) {
+            int32_t acc = o->integral[i] + mul30(e[i], o->ki_dt);
+            if (acc > INTEGRAL_LIMIT) acc = INTEGRAL_LIMIT;
+            if (acc < -INTEGRAL_LIMIT) acc = -INTEGRAL_LIMIT;
+            o->integral[i] = acc;
+            h[i] += mul30(e[i], o->kp_half_dt);
+        }
+    }
+    for (int i = 0; i < 3; i++) h[i] += mul30(o->integral[i], o->half_dt);
+
+    // q += q * (0, h)
+    int32_t q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    q[0] = q0 - mul30(q1, h[0]) - mul30(q2, h[1]) - mul30(q3, h[2]);
+    q[1] = q1 + mul30(q0, h[0]) + mul30(q2, h[2]) - mul30(q3, h[1]);
+    q[2] = q2 + mul30(q0, h[1]) - mul30(q1, h[2]) + mul30(q3, h[0]);
+    q[3] = q3 + mul30(q0, h[2]) + mul30(q1, h[1]) - mul30(q2, h[0]);
+
+    // Norma perto de 1: um passo de Newton de 1/sqrt basta, sem divisão
+    int32_t n2 = mul30(q[0], q[0]) + mul30(q[1], q[1]) + mul30(q[2], q[2]) + mul30(q[3], q[3]);
+    int32_t scale = ORIENT_Q_ONE + ((ORIENT_Q_ONE - n2) >> 1);
+    for (int i = 0; i < 4; i++) q[i] = mul30(q[i], scale);
+}
+
+//Roll, pitch e yaw (sequência ZYX) em centésimos de grau
+void orientation_euler_cdeg(const orientation_t *o, int32_t euler[3]) {
+    const float k = 1.0f / ORIENT_Q_ONE;
+    float w = o->q[0] * k, x = o->q[1] * k, y = o->q[2] * k, z = o->q[3] * k;
+    float sinp = 2.0f * (w * y - z * x);
+    if (sinp > 1.0f) sinp = 1.0f;
+    if (sinp < -1.0f) sinp = -1.0f;
+    const float cdeg = 18000.0f / (float)M_PI;
+    euler[0] = (int32_t)lrintf(atan2f(2.0f * (w * x + y * z), 1.0f - 2.0f * (x * x + y * y)) * cdeg);
+    euler[1] = (int32_t)lrintf(asinf(sinp) * cdeg);
+    euler[2] = (int32_t)lrintf(atan2f(2.0f * (w * z + x * y), 1.0f - 2.0f * (y * y + z * z)) * cdeg);
+}
+
+/* Sessão de log */
+
+static orientation_output_t output = ORIENT_OFF;
+static uint16_t decimation = ORIENT_DECIMATION;
+static uint16_t decimation_count = 0;
+static float gyro_scale = ORIENT_GYRO_LSB_PER_DPS;
+static float accel_scale = ORIENT_ACCEL_LSB_PER_G;
+static orientation_t live;
+static bool active = false;
+static uint32_t lines_written = 0;
+static FIL ori_file;
+static char ori_filename[FF_LFN_BUF];
+
+static bool ori_write(const char *data, int len) {
+    UINT bw;
+    FRESULT res = f_write(&ori_file, data, (UINT)len, &bw);
+    if (res != FR_OK || bw != (UINT)len) {
+        printf("[ERRO] Falha ao escrever '%s': %s (%d)\n", ori_filename, FRESULT_str(res), res);
+        return false;
+    }
+    return true;
+}
+
+//Nome do arquivo de orientação: <base>_ori.csv
+static void orientation_path(const char *log_filename, char *out, size_t len) {
+    const char *dot = strrchr(log_filename, '.');
+    const char *slash = strrchr(log_filename, '/');
+    size_t base = (dot && (!slash || dot > slash)) ? (size_t)(dot - log_filename) : strlen(log_filename);
+    snprintf(out, len, "%.*s_ori.csv", (int)base, log_filename);
+}
+
+bool orientation_start(const char *log_filename, uint32_t sample_rate_hz) {
+    if (active) return true;
+    orientation_init(&live, sample_rate_hz, gyro_scale, accel_scale);
+    orientation_path(log_filename, ori_filename, sizeof ori_filename);
+    FRESULT res = f_open(&ori_file, ori_filename, FA_WRITE | FA_CREATE_ALWAYS);
+    if (res != FR_OK) {
+        printf("[ERRO] Falha ao abrir '%s': %s (%d)\n", ori_filename, FRESULT_str(res), res);
+        return false;
+    }
+    char header[256];
+    int n = snprintf(header, sizeof header, "# filtro=mahony\n# kp=%.3f\n# ki=%.3f\n# taxa_hz=%lu\n# decimacao=%u\n%s",
+                     (double)ORIENT_KP, (double)ORIENT_KI, (unsigned long)sample_rate_hz, decimation,
+                     output == ORIENT_QUATERNION ? "# escala=1073741824\nnumero_amostra,qw,qx,qy,qz\n"
+                                                 : "# unidade=centigraus\nnumero_amostra,roll,pitch,yaw\n");
+    if (!ori_write(header, n)) {
+        f_close(&ori_file);
+        return false;
+    }
+    decimation_count = 0;
+    lines_written = 0;
+    active = true;
+    printf("Orientação em '%s' (%s, uma linha a cada %u amostras)\n", ori_filename,
+           output == ORIENT_QUATERNION ? "quatérnios" : "Euler", decimation);
+    return true;
+}
+
+void orientation_stop(void) {
+    if (!active) return;
+    active = false;
+    FRESULT res = f_close(&ori_file);
+    if (res != FR_OK) {
+        printf("[ERRO] Falha ao fechar '%s': %s (%d)\n", ori_filename, FRESULT_str(res), res);
+        return;
+    }
+    printf("Orientação encerrada em '%s' (%lu linhas).\n", ori_filename, (unsigned long)lines_written);
+}
+
+bool orientation_is_active(void) {
+    return active;
+}
+
+//Atualiza o filtro a cada amostra e grava uma linha a cada 'decimação'
+bool orientation_process(uint32_t sample_num, const int16_t accel[3], const int16_t gyro[3]) {
+    if (!active) return true;
+    orientation_update(&live, accel, gyro);
+    if (++decimation_count < decimation || !live.aligned) return true;
+    decimation_count = 0;
+
+    char line[64];
+    int n;
+    if (output == ORIENT_QUATERNION) {
+        n = snprintf(line, sizeof line, "%lu,%ld,%ld,%ld,%ld\n", (unsigned long)sample_num, (long)live.q[0],
+                     (long)live.q[1], (long)live.q[2], (long)live.q[3]);
+    } else {
+        int32_t e[3];
+        orientation_euler_cdeg(&live, e);
+        n = snprintf(line, sizeof line, "%lu,%ld,%ld,%ld\n", (unsigned long)sample_num, (long)e[0], (long)e[1],
+                     (long)e[2]);
+    }
+    lines_written++;
+    return ori_write(line, n);
+}
+
+const orientation_t *orientation_current(void) {
+    return &live;
+}
+
+bool orientation_set_output(orientation_output_t out) {
+    if (active) {
+        printf("[AVISO] Pare a gravação antes de trocar a saída de orientação.\n");
+        return false;
+    }
+    output = out;
+    return true;
+}
+
+orientation_output_t orientation_get_output(void) {
+    return output;
+}
+
+bool orientation_set_decimation(uint16_t d) {
+    if (active) {
+        printf("[AVISO] Pare a gravação antes de trocar a decimação.\n");
+        return false;
+    }
+    if (d == 0) {
+        printf("[ERRO] Decimação deve ser de pelo menos 1\n");
+        return false;
+    }
+    decimation = d;
+    return true;
+}
+
+//Escalas do IMU (LSB por grau/s e por g) usadas na próxima sessão
+bool orientation_set_scale(float gyro_lsb_per_dps, float accel_lsb_per_g) {
+    if (active) {
+        printf("[AVISO] Pare a gravação antes de trocar a escala do IMU.\n");
+        return false;
+    }
+    gyro_scale = gyro_lsb_per_dps;
+    accel_scale = accel_lsb_per_g;
+    return true;
+}
+
+void orientation_print_status(void) {
+    static const char *const output_names[] = { "desligada", "quatérnios", "Euler (centésimos de grau)" };
+    printf("Orientação (Mahony, Kp=%.2f Ki=%.2f): %s, uma linha a cada %u amostras\n", (double)ORIENT_KP,
+           (double)ORIENT_KI, output_names[output], decimation);
+    if (!active || !live.aligned) return;
+    int32_t e[3];
+    orientation_euler_cdeg(&live, e);
+    printf("  roll %.2f  pitch %.2f  yaw %.2f graus\n", e[0] / 100.0, e[1] / 100.0, e[2] / 100.0);
+}
@@ -0,0 +1,293 @@
+#include "../inc/pio_i2c.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+#include "pio_i2c.pio.h"
+
+#define PIO_I2C_PIO pio0        // PIO1 tem o clock desligado em power.c
+#define PIO_I2C_PIO_IRQ PIO0_IRQ_0
+#define PIO_I2C_DMA_IRQ DMA_IRQ_1  // DMA_IRQ_0 é do driver do SD
+
+// Campos da palavra de comando (ver src/pio_i2c.pio)
+#define ICOUNT_LSB 10
+#define FINAL_LSB 9
+#define DATA_LSB 1
+#define NAK_LSB 0
+
+// START + endereço + registrador + RESTART + endereço + dados + STOP
+#define CMD_MAX (3 + 1 + 1 + 4 + 1 + PIO_I2C_MAX_LEN + 4)
+// A FIFO de recepção recebe também os bytes escritos
+#define RX_MAX (3 + PIO_I2C_MAX_LEN)
+
+typedef enum { XFER_IDLE, XFER_BUSY, XFER_DONE, XFER_ERROR } xfer_state_t;
+
+static bool active = false;
+static uint sm, offset;
+static uint pins[2];   // SDA, SCL
+static int dma_tx = -1, dma_rx = -1;
+static uint32_t baud = 0;
+
+static uint16_t cmd[CMD_MAX];
+static size_t cmd_len;
+static uint8_t rx[RX_MAX];
+static size_t rx_skip, rx_len;   // bytes de endereço/registrador a pular e bytes lidos
+static volatile xfer_state_t state = XFER_IDLE;
+static uint32_t error_count = 0;
+
+static void put(uint16_t word) {
+    cmd[cmd_len++] = word;
+}
+
+//Sequências de instruções da tabela set_scl_sda, precedidas do contador
+static void put_start(void) {
+    put(1u << ICOUNT_LSB);
+    put(pio_i2c_set_scl_sda_program_instructions[PIO_I2C_SC1_SD0]);
+    put(pio_i2c_set_scl_sda_program_instructions[PIO_I2C_SC0_SD0]);
+}
+
+static void put_restart(void) {
+    put(3u << ICOUNT_LSB);
+    put(pio_i2c_set_scl_sda_program_instructions[PIO_I2C_SC0_SD1]);
+    put(pio_i2c_set_scl_sda_program_instructions[PIO_I2C_SC1_SD1]);
+    put(pio_i2c_set_scl_sda_program_instructions[PIO_I2C_SC1_SD0]);
+    put(pio_i2c_set_scl_sda_program_instructions[PIO_I2C_SC0_SD0]);
+}
+
+static void put_stop(void) {
+    put(2u << ICOUNT_LSB);
+    put(pio_i2c_set_scl_sda_program_instructions[PIO_I2C_SC0_SD0]);
+    put(pio_i2c_set_scl_sda_program_instructions[PIO_I2C_SC1_SD0]);
+    put(pio_i2c_set_scl_sda_program_instructions[PIO_I2C_SC1_SD1]);
+}
+
+//Byte escrito: SDA liberado no ACK para o escravo responder
+static void put_write(uint8_t byte, bool final) {
+    put((uint16_t)((byte << DATA_LSB) | ((final ? 1u : 0u) << FINAL_LSB) | (1u << NAK_LSB)));
+}
+
+//Byte lido: ACK em todos menos o último, que leva NAK
+static void put_read(bool last) {
+    put((uint16_t)((0xFFu << DATA_LSB) | (last ? (1u << FINAL_LSB) | (1u << NAK_LSB) : 0u)));
+}
+
+//Escreve uma palavra de 16 bits na FIFO: com autopull de 16 a escrita tem
+//de ser de meia palavra, para o dado ficar na metade alta da OSR
+static void put_fifo(uint16_t word) {
+    *(io_rw_16 *)&PIO_I2C_PIO->txf[sm] = word;
+}
+
+//Para os canais de DMA, descarta as FIFOs, volta ao ponto de entrada e
+//fecha a transação com STOP
+static void abort_transfer(void) {
+    // RP2040-E13: abortar um canal com IRQ habilitada pode gerar uma IRQ falsa
+    dma_channel_set_irq1_enabled(dma_rx, false);
+    dma_channel_abort(dma_rx);
+    dma_channel_abort(dma_tx);
+    dma_channel_acknowledge_irq1(dma_rx);
+    dma_channel_set_irq1_enabled(dma_rx, true);
+
+    PIO pio = PIO_I2C_PIO;
+    pio_sm_drain_tx_fifo(pio, sm);
+    while (!pio_sm_is_rx_fifo_empty(pio, sm)) (void)pio_sm_get(pio, sm);
+    pio_sm_exec(pio, sm, pio_encode_jmp(offset + pio_i2c_offset_entry_point));
+    pio_interrupt_clear(pio, sm);
+
+    cmd_len = 0;
+    put_stop();
+    for (size_t i = 0; i < cmd_len; i++) put_fifo(cmd[i]);
+}
+
+//Fim da recepção: todos os bytes chegaram
+static void dma_irq_handler(void) {
+    if (dma_rx >= 0 && dma_channel_get_irq1_status(dma_rx)) {
+        dma_channel_acknowledge_irq1(dma_rx);
+        if (state == XFER_BUSY) state = XFER_DONE;
+        __sev();
+    }
+}
+
+//NAK inesperado: a máquina de estados parou em "irq wait"
+static void pio_irq_handler(void) {
+    if (pio_interrupt_get(PIO_I2C_PIO, sm)) {
+        if (state == XFER_BUSY) {
+            abort_transfer();
+            state = XFER_ERROR;
+        } else {
+            pio_interrupt_clear(PIO_I2C_PIO, sm);
+        }
+        __sev();
+    }
+}
+
+bool pio_i2c_init(uint pin_sda, uint pin_scl, uint32_t hz) {
+    if (active) return true;
+    if (pin_scl != pin_sda + 1) {
+        printf("[ERRO] PIO I2C exige SCL = SDA + 1\n");
+        return false;
+    }
+    PIO pio = PIO_I2C_PIO;
+    int claimed = pio_claim_unused_sm(pio, false);
+    if (claimed < 0 || !pio_can_add_program(pio, &pio_i2c_program)) {
+        if (claimed >= 0) pio_sm_unclaim(pio, (uint)claimed);
+        printf("[ERRO] Sem máquina de estados ou memória livre no PIO0\n");
+        return false;
+    }
+    sm = (uint)claimed;
+    pins[0] = pin_sda;
+    pins[1] = pin_scl;
+    offset = pio_add_program(pio, &pio_i2c_program);
+    dma_tx = dma_claim_unused_channel(true);
+    dma_rx = dma_claim_unused_channel(true);
+
+    baud = hz < PIO_I2C_MIN_HZ ? PIO_I2C_MIN_HZ : hz > PIO_I2C_MAX_HZ ? PIO_I2C_MAX_HZ : hz;
+    pio_i2c_program_init(pio, sm, offset, pin_sda, pin_scl, baud);
+
+    dma_channel_config c = dma_channel_get_default_config((uint)dma_tx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pio_get_dreq(pio, sm, true));
+    dma_channel_configure((uint)dma_tx, &c, &pio->txf[sm], cmd, 0, false);
+
+    c = dma_channel_get_default_config((uint)dma_rx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_dreq(&c, pio_get_dreq(pio, sm, false));
+    dma_channel_configure((uint)dma_rx, &c, rx, &pio->rxf[sm], 0, false);
+
+    dma_channel_set_irq1_enabled((uint)dma_rx, true);
+    irq_add_shared_handler(PIO_I2C_DMA_IRQ, dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(PIO_I2C_DMA_IRQ, true);
+
+    pio_set_irq0_source_enabled(pio, (enum pio_interrupt_source)((uint)pis_interrupt0 + sm), true);
+    irq_set_exclusive_handler(PIO_I2C_PIO_IRQ, pio_irq_handler);
+    irq_set_enabled(PIO_I2C_PIO_IRQ, true);
+
+    state = XFER_IDLE;
+    active = true;
+    return true;
+}
+
+//Devolve os recursos; o chamador escolhe a nova função dos pinos
+void pio_i2c_deinit(void) {
+    if (!active) return;
+    PIO pio = PIO_I2C_PIO;
+    if (state == XFER_BUSY) abort_transfer();
+    sleep_us(100);   // deixa o STOP sair
+
+    irq_set_enabled(PIO_I2C_PIO_IRQ, false);
+    irq_remove_handler(PIO_I2C_PIO_IRQ, pio_irq_handler);
+    pio_set_irq0_source_enabled(pio, (enum pio_interrupt_source)((uint)pis_interrupt0 + sm), false);
+    dma_channel_set_irq1_enabled((uint)dma_rx, false);
+    irq_remove_handler(PIO_I2C_DMA_IRQ, dma_irq_handler);
+
+    pio_sm_set_enabled(pio, sm, false);
+    gpio_set_oeover(pins[0], GPIO_OVERRIDE_NORMAL);
+    gpio_set_oeover(pins[1], GPIO_OVERRIDE_NORMAL);
+    pio_remove_program(pio, &pio_i2c_program, offset);
+    pio_sm_unclaim(pio, sm);
+    dma_channel_unclaim((uint)dma_tx);
+    dma_channel_unclaim((uint)dma_rx);
+    dma_tx = dma_rx = -1;
+    state = XFER_IDLE;
+    active = false;
+}
+
+bool pio_i2c_is_active(void) {
+    return active;
+}
+
+void pio_i2c_set_baudrate(uint32_t hz) {
+    baud = hz < PIO_I2C_MIN_HZ ? PIO_I2C_MIN_HZ : hz > PIO_I2C_MAX_HZ ? PIO_I2C_MAX_HZ : hz;
+    if (active) pio_sm_set_clkdiv(PIO_I2C_PIO, sm, (float)clock_get_hz(clk_sys) / (32.0f * (float)baud));
+}
+
+uint32_t pio_i2c_get_baudrate(void) {
+    return baud;
+}
+
+//Dispara os dois canais: a recepção primeiro, para não perder nenhum push
+static void transfer_start(size_t rx_count) {
+    while (dma_channel_is_busy((uint)dma_tx)) tight_loop_contents();   // STOP anterior ainda na fila
+    state = XFER_BUSY;
+    dma_channel_set_trans_count((uint)dma_rx, rx_count, false);
+    dma_channel_set_write_addr((uint)dma_rx, rx, true);
+    dma_channel_set_trans_count((uint)dma_tx, cmd_len, false);
+    dma_channel_set_read_addr((uint)dma_tx, cmd, true);
+}
+
+//Dorme até a interrupção de fim ou de erro; no prazo esgotado aborta
+static bool transfer_wait(absolute_time_t deadline) {
+    while (state == XFER_BUSY) {
+        if (time_reached(deadline)) {
+            irq_set_enabled(PIO_I2C_PIO_IRQ, false);
+            if (state == XFER_BUSY) {
+                abort_transfer();
+                state = XFER_ERROR;
+            }
+            irq_set_enabled(PIO_I2C_PIO_IRQ, true);
+            break;
+        }
+        best_effort_wfe_or_timeout(deadline);
+    }
+    bool ok = state == XFER_DONE;
+    if (!ok) error_count++;
+    state = XFER_IDLE;
+    return ok;
+}
+
+bool pio_i2c_read_start(uint8_t addr, uint8_t reg, size_t len) {
+    if (!active || state != XFER_IDLE || len == 0 || len > PIO_I2C_MAX_LEN) return false;
+    cmd_len = 0;
+    put_start();
+    put_write((uint8_t)(addr << 1), false);
+    put_write(reg, false);
+    put_restart();
+    put_write((uint8_t)((addr << 1) | 1u), false);
+    for (size_t i = 0; i < len; i++) put_read(i == len - 1);
+    put_stop();
+    rx_skip = 3;
+    rx_len = len;
+    transfer_start(rx_skip + rx_len);
+    return true;
+}
+
+bool pio_i2c_busy(void) {
+    return state == XFER_BUSY;
+}
+
+bool pio_i2c_read_finish(uint8_t *dst, absolute_time_t deadline) {
+    if (!active || state == XFER_IDLE) return false;
+    if (!transfer_wait(deadline)) return false;
+    memcpy(dst, rx + rx_skip, rx_len);
+    return true;
+}
+
+bool pio_i2c_read_reg(uint8_t addr, uint8_t reg, uint8_t *dst, size_t len) {
+    return pio_i2c_read_start(addr, reg, len) &&
+           pio_i2c_read_finish(dst, make_timeout_time_us(PIO_I2C_TIMEOUT_US));
+}
+
+bool pio_i2c_write(uint8_t addr, const uint8_t *src, size_t len) {
+    if (!active || state != XFER_IDLE || len == 0 || len > PIO_I2C_MAX_LEN) return false;
+    cmd_len = 0;
+    put_start();
+    put_write((uint8_t)(addr << 1), false);
+    for (size_t i = 0; i < len; i++) put_write(src[i], i == len - 1);
+    put_stop();
+    rx_skip = 1 + len;
+    rx_len = 0;
+    transfer_start(rx_skip);
+    return transfer_wait(make_timeout_time_us(PIO_I2C_TIMEOUT_US));
+}
+
+uint32_t pio_i2c_errors(void) {
+    return error_count;
+}
@@ -0,0 +1,132 @@
+#include "../inc/power.h"
+#include "../inc/interface.h"
+#include "../inc/imu.h"
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "hardware/structs/clocks.h"
+#include "hw_config.h"
+#include <stdio.h>
+
+// I2C do display (definido em main.c); reconfigurado após troca de clock
+#define POWER_I2C_DISP i2c1
+#define POWER_I2C_BAUD (400 * 1000)
+
+// Periféricos sem uso no datalogger: ADC, SPI1, PIO1, UART0/1 (stdio é USB).
+// Atenção: capture_adc_data_and_save() exige religar o clk_adc antes do uso.
+#define POWER_GATED_EN0 (CLOCKS_WAKE_EN0_CLK_ADC_ADC_BITS | CLOCKS_WAKE_EN0_CLK_SYS_ADC_BITS | \
+                         CLOCKS_WAKE_EN0_CLK_SYS_SPI1_BITS | CLOCKS_WAKE_EN0_CLK_PERI_SPI1_BITS | \
+                         CLOCKS_WAKE_EN0_CLK_SYS_PIO1_BITS)
+#define POWER_GATED_EN1 (CLOCKS_WAKE_EN1_CLK_SYS_UART0_BITS | CLOCKS_WAKE_EN1_CLK_PERI_UART0_BITS | \
+                         CLOCKS_WAKE_EN1_CLK_SYS_UART1_BITS | CLOCKS_WAKE_EN1_CLK_PERI_UART1_BITS)
+
+static bool clock_active = true;
+static volatile bool wakeup_pending = false;
+
+// Contabilidade de ciclo de trabalho
+static uint64_t stats_start_us = 0;
+static uint64_t idle_us = 0;
+static uint32_t wakeups_by_event = 0;
+
+//Desliga os clocks dos periféricos não utilizados
+static void power_gate_unused_clocks(void) {
+    clock_stop(clk_adc);
+    clocks_hw->wake_en0 &= ~POWER_GATED_EN0;
+    clocks_hw->wake_en1 &= ~POWER_GATED_EN1;
+    clocks_hw->sleep_en0 &= ~POWER_GATED_EN0;
+    clocks_hw->sleep_en1 &= ~POWER_GATED_EN1;
+}
+
+//Reaplica as taxas que dependem de clk_sys/clk_peri após uma troca de frequência
+static void power_reconfigure_peripherals(void) {
+    i2c_set_baudrate(I2C_PORT, POWER_I2C_BAUD);
+    i2c_set_baudrate(POWER_I2C_DISP, POWER_I2C_BAUD);
+    imu_clock_changed();
+    for (size_t i = 0; i < spi_get_num(); ++i) {
+        spi_t *pSPI = spi_get_by_num(i);
+        if (pSPI && pSPI->initialized) {
+            spi_set_baudrate(pSPI->hw_inst, pSPI->baud_rate);
+        }
+    }
+    interface_clock_changed();
+}
+
+//Inicializa o gerenciamento de energia: corta clocks ociosos e entra em modo reduzido
+void power_init(void) {
+    power_gate_unused_clocks();
+    power_reset_stats();
+    power_set_active(false);
+}
+
+//Seleciona frequência plena (gravação) ou reduzida (repouso)
+void power_set_active(bool active) {
+    if (active == clock_active) return;
+    uint32_t khz = active ? POWER_CLOCK_ACTIVE_KHZ : POWER_CLOCK_IDLE_KHZ;
+    if (!set_sys_clock_khz(khz, false)) {
+        printf("[AVISO] Frequência de %lu kHz não suportada\n", khz);
+        return;
+    }
+    clock_active = active;
+    power_reconfigure_peripherals();
+}
+
+bool power_is_active(void) {
+    return clock_active;
+}
+
+//Pode ser chamada de interrupções: acorda o laço principal antes do prazo
+void power_notify_wakeup(void) {
+    wakeup_pending = true;
+    __sev();
+}
+
+//Dorme com WFE até o prazo (alarme do timer) ou até um evento de wakeup
+bool power_idle_until(uint64_t deadline_us) {
+    uint64_t start = time_us_64();
+    absolute_time_t until = from_us_since_boot(deadline_us);
+    bool by_event = false;
+
+    while (!time_reached(until)) {
+        if (wakeup_pending) {
+            by_event = true;
+            break;
+        }
+        best_effort_wfe_or_timeout(until);
+    }
+    wakeup_pending = false;
+
+    idle_us += time_us_64() - start;
+    if (by_event) wakeups_by_event++;
+    return by_event;
+}
+
+//Fração do tempo com a CPU ativa, em milésimos
+uint32_t power_duty_permille(void) {
+    uint64_t total = time_us_64() - stats_start_us;
+    if (total == 0) return 1000;
+    uint64_t busy = total > idle_us ? total - idle_us : 0;
+    return (uint32_t)((busy * 1000u) / total);
+}
+
+//Imprime frequência atual e ciclo de trabalho medido
+void power_print_stats(void) {
+    uint32_t duty = power_duty_permille();
+    uint32_t elapsed_ms = (uint32_t)((time_us_64() - stats_start_us) / 1000u);
+    printf("\n=== ENERGIA ===\n");
+    printf("Clock do sistema: %lu kHz (%s)\n", clock_get_hz(clk_sys) / 1000,
+           clock_active ? "pleno" : "reduzido");
+    printf("Janela de medicao: %lu ms\n", elapsed_ms);
+    printf("Ciclo de trabalho: %lu.%lu%% ativo, %lu.%lu%% em WFE\n",
+           duty / 10, duty % 10, (1000 - duty) / 10, (1000 - duty) % 10);
+    printf("Despertares por evento: %lu\n", wakeups_by_event);
+    printf("Corrente media ~ I_ativo * %lu/1000 + I_sono * %lu/1000\n", duty, 1000 - duty);
+    printf("===============\n\n");
+}
+
+//Reinicia a janela de medição do ciclo de trabalho
+void power_reset_stats(void) {
+    stats_start_us = time_us_64();
+    idle_us = 0;
+    wakeups_by_event = 0;
+}
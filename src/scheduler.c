@@ -0,0 +1,174 @@
+#include "../inc/scheduler.h"
+#include "../inc/telemetry.h"
+#include "../inc/power.h"
+#include "pico/stdlib.h"
+#include <stdio.h>
+#include <string.h>
+
+static sched_task_t tasks[SCHED_MAX_TASKS];
+static int task_count = 0;
+static int wakeup_task = SCHED_INVALID_TASK;
+
+//Registra uma tarefa periódica. Retorna o identificador ou SCHED_INVALID_TASK.
+int sched_add_task(const char *name, sched_task_fn_t fn, uint32_t period_ms,
+                   uint8_t priority, uint32_t budget_us) {
+    if (task_count >= SCHED_MAX_TASKS || fn == NULL || period_ms == 0) {
+        printf("[ERRO] Não foi possível registrar a tarefa '%s'\n", name);
+        return SCHED_INVALID_TASK;
+    }
+    sched_task_t *t = &tasks[task_count];
+    memset(t, 0, sizeof(*t));
+    t->name = name;
+    t->fn = fn;
+    t->period_us = period_ms * 1000u;
+    t->priority = priority;
+    t->budget_us = budget_us;
+    t->enabled = true;
+    t->release_us = time_us_64() + t->period_us;
+    return task_count++;
+}
+
+//Altera o período de uma tarefa; a próxima liberação passa a contar de agora
+void sched_set_period_us(int id, uint32_t period_us) {
+    if (id < 0 || id >= task_count || period_us == 0) return;
+    tasks[id].period_us = period_us;
+    tasks[id].release_us = time_us_64() + tasks[id].period_us;
+}
+
+void sched_set_period_ms(int id, uint32_t period_ms) {
+    sched_set_period_us(id, period_ms * 1000u);
+}
+
+//Habilita ou desabilita uma tarefa
+void sched_set_enabled(int id, bool enabled) {
+    if (id < 0 || id >= task_count) return;
+    if (enabled && !tasks[id].enabled) {
+        tasks[id].release_us = time_us_64();
+    }
+    tasks[id].enabled = enabled;
+}
+
+//Antecipa a liberação de uma tarefa para agora
+void sched_release_now(int id) {
+    if (id < 0 || id >= task_count) return;
+    uint64_t now = time_us_64();
+    if (tasks[id].release_us > now) tasks[id].release_us = now;
+}
+
+//Tarefa liberada imediatamente quando um evento (ex.: botão) acorda a CPU
+void sched_set_wakeup_task(int id) {
+    wakeup_task = id;
+}
+
+const sched_task_t *sched_get_task(int id) {
+    if (id < 0 || id >= task_count) return NULL;
+    return &tasks[id];
+}
+
+int sched_task_count(void) {
+    return task_count;
+}
+
+//Escolhe a tarefa liberada de maior prioridade (empate: liberação mais antiga)
+static sched_task_t *sched_pick(uint64_t now) {
+    sched_task_t *best = NULL;
+    for (int i = 0; i < task_count; i++) {
+        sched_task_t *t = &tasks[i];
+        if (!t->enabled || t->release_us > now) continue;
+        if (!best || t->priority > best->priority ||
+            (t->priority == best->priority && t->release_us < best->release_us)) {
+            best = t;
+        }
+    }
+    return best;
+}
+
+//Executa no máximo uma tarefa liberada. Retorna false se nenhuma estava pronta.
+bool sched_run_once(void) {
+    uint64_t now = time_us_64();
+    sched_task_t *t = sched_pick(now);
+    if (!t) return false;
+
+    uint64_t release = t->release_us;
+    uint64_t start = time_us_64();
+    t->fn();
+    uint64_t end = time_us_64();
+
+    uint32_t duration = (uint32_t)(end - start);
+    uint32_t latency = (uint32_t)(start - release);
+    telemetry_record(TELEM_LOOP, duration);
+    t->runs++;
+    t->last_us = duration;
+    t->total_us += duration;
+    if (duration > t->wcet_us) t->wcet_us = duration;
+    if (latency > t->max_latency_us) t->max_latency_us = latency;
+    if (t->budget_us && duration > t->budget_us) t->overruns++;
+    if (end > release + t->period_us) t->deadline_misses++;
+
+    // Mantém a fase da tarefa; liberações que já passaram são descartadas
+    t->release_us = release + t->period_us;
+    while (t->release_us <= end) {
+        t->release_us += t->period_us;
+        t->skipped++;
+    }
+    return true;
+}
+
+//Instante da próxima liberação entre as tarefas habilitadas
+static uint64_t sched_next_release(void) {
+    uint64_t next = UINT64_MAX;
+    for (int i = 0; i < task_count; i++) {
+        if (tasks[i].enabled && tasks[i].release_us < next) {
+            next = tasks[i].release_us;
+        }
+    }
+    return next;
+}
+
+//Laço principal: executa as tarefas e dorme (WFE) até a próxima deadline
+void sched_run(void) {
+    while (true) {
+        if (sched_run_once()) continue;
+        uint64_t next = sched_next_release();
+        if (next == UINT64_MAX) {
+            tight_loop_contents();
+            continue;
+        }
+        if (power_idle_until(next)) {
+            sched_release_now(wakeup_task);
+        }
+    }
+}
+
+//Imprime as estatísticas de todas as tarefas
+void sched_print_stats(void) {
+    printf("\n=== TAREFAS ===\n");
+    printf("%-10s %7s %4s %7s %8s %7s %7s %7s %5s %5s %5s\n",
+           "nome", "per(ms)", "prio", "orc(us)", "exec", "med(us)", "wcet", "lat.max", "estou", "perde", "pula");
+    for (int i = 0; i < task_count; i++) {
+        const sched_task_t *t = &tasks[i];
+        uint32_t avg = t->runs ? (uint32_t)(t->total_us / t->runs) : 0;
+        printf("%-10s %7lu %4u %7lu %8lu %7lu %7lu %7lu %5lu %5lu %5lu%s\n",
+               t->name, t->period_us / 1000, t->priority, t->budget_us,
+               t->runs, avg, t->wcet_us, t->max_latency_us,
+               t->overruns, t->deadline_misses, t->skipped,
+               t->enabled ? "" : " (desab.)");
+    }
+    printf("estou = acima do orçamento, perde = deadline perdida, pula = liberações descartadas\n");
+    printf("===============\n\n");
+}
+
+//Zera as estatísticas acumuladas
+void sched_reset_stats(void) {
+    for (int i = 0; i < task_count; i++) {
+        sched_task_t *t = &tasks[i];
+        t->runs = 0;
+        t->last_us = 0;
+        t->wcet_us = 0;
+        t->total_us = 0;
+        t->max_latency_us = 0;
+        t->overruns = 0;
+        t->deadline_misses = 0;
+        t->skipped = 0;
+    }
+}
@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 
 #include "hardware/adc.h"
 #include "hardware/rtc.h"
@@ -15,10 +16,46 @@
 #include "my_debug.h"
 #include "rtc.h"
 
+#include "../inc/imucodec.h"
+
 // Variáveis estáticas para gerenciamento do arquivo de log
 static FIL log_file;
 static bool logging_active = false;
 static char current_log_filename[FF_LFN_BUF];
+static sdlogger_format_t log_format = SDLOGGER_FORMAT_CSV;
+static bool log_buffered = false;
+static uint8_t log_sensors = 1;
+
+// Linhas "# chave=valor\n" de sdlogger_set_metadata, gravadas em sdlogger_start
+static char log_metadata[SDLOGGER_METADATA_SIZE];
+static size_t log_metadata_len = 0;
+
+// Buffer do modo bufferizado. log_buffer_limit faz o primeiro f_write
+// terminar num limite de setor (o cabeçalho desalinha o arquivo)
+static uint8_t log_buffer[SDLOGGER_BUFFER_SIZE] __attribute__((aligned(4)));
+static UINT log_buffer_len = 0;
+static UINT log_buffer_limit = SDLOGGER_BUFFER_SIZE;
+
+// Compressor do formato SDLOGGER_FORMAT_COMPRESSED
+static imucodec_encoder_t log_encoder;
+
+// Índice esparso da sessão, gravado no arquivo lateral em sdlogger_stop
+static sdlogger_idx_entry_t log_index[SDLOGGER_INDEX_ENTRIES];
+static uint32_t log_index_count = 0;
+static uint32_t log_index_interval = SDLOGGER_INDEX_INTERVAL;
+static uint32_t log_records = 0;
+static uint32_t log_start_ms = 0;
+
+// Amostras que chegaram ao FatFs sem erro. As do buffer (modo bufferizado)
+// e as do bloco comprimido em montagem ainda podem se perder
+static uint32_t log_written = 0;
+static uint32_t log_buffer_records = 0;
+static uint32_t log_block_records = 0;
+
+// Tabela de fast seek e buffers de decodificação dos leitores (um por vez)
+static DWORD read_clmt[SDLOGGER_CLMT_LEN];
+static uint8_t read_block[IMUCODEC_BLOCK_SIZE] __attribute__((aligned(4)));
+static imucodec_sample_t read_samples[IMUCODEC_MAX_SAMPLES];
 
 // Funções de ajuda
 sd_card_t *sd_get_by_name(const char *const name) {
@@ -225,21 +262,127 @@ void run_ls() {
     f_closedir(&dj);
 }
 
+//Formato do log aberto pelo cabeçalho, início e tamanho dos registros
+//binários (não move a posição)
+static sdlogger_format_t file_format(FIL *fp, FSIZE_t *data_start, UINT *record_size) {
+    sdlogger_bin_header_t header;
+    UINT br = 0;
+    FSIZE_t pos = f_tell(fp);
+    sdlogger_format_t format = SDLOGGER_FORMAT_CSV;
+    *data_start = 0;
+    *record_size = sizeof(sdlogger_bin_record_t);
+    if (f_lseek(fp, 0) == FR_OK && f_read(fp, &header, sizeof(header), &br) == FR_OK && br == sizeof(header)) {
+        if (memcmp(header.magic, SDLOGGER_BIN_MAGIC, SDLOGGER_BIN_MAGIC_LEN) == 0) {
+            format = SDLOGGER_FORMAT_BINARY;
+            *data_start = header.header_size;
+            *record_size = header.record_size;
+        } else if (memcmp(header.magic, SDLOGGER_RICE_MAGIC, SDLOGGER_BIN_MAGIC_LEN) == 0) {
+            format = SDLOGGER_FORMAT_COMPRESSED;
+            *data_start = header.header_size;
+        }
+    }
+    f_lseek(fp, pos);
+    return format;
+}
+
+static void print_record(const imucodec_sample_t *s) {
+    printf("%lu,%d,%d,%d,%d,%d,%d\n", (unsigned long)s->sample, s->axis[0], s->axis[1], s->axis[2], s->axis[3],
+           s->axis[4], s->axis[5]);
+}
+
+//Lê um registro binário de record_size bytes; os campos de sdlogger_bin_sensor_record_t
+//que o registro não tem ficam zerados
+static bool read_bin_record(FIL *fp, UINT record_size, sdlogger_bin_sensor_record_t *rec) {
+    UINT want = record_size < sizeof(*rec) ? record_size : sizeof(*rec);
+    UINT br = 0;
+    memset(rec, 0, sizeof(*rec));
+    if (f_read(fp, rec, want, &br) != FR_OK || br != want) return false;
+    return record_size == want || f_lseek(fp, f_tell(fp) + (record_size - want)) == FR_OK;
+}
+
+//cat <arquivo> [amostra|<seg>s] [linhas]: com início, pula direto pelo índice
 void run_cat() {
     char *arg1 = strtok(NULL, " ");
     if (!arg1) {
         printf("Missing argument\n");
         return;
     }
+    const char *start_arg = strtok(NULL, " ");
+    const char *lines_arg = strtok(NULL, " ");
     FIL fil;
     FRESULT fr = f_open(&fil, arg1, FA_READ);
     if (FR_OK != fr) {
         printf("f_open error: %s (%d)\n", FRESULT_str(fr), fr);
         return;
     }
-    char buf[256];
-    while (f_gets(buf, sizeof buf, &fil)) {
-        printf("%s", buf);
+    // Logs binários e comprimidos saem como CSV
+    FSIZE_t data_start;
+    UINT record_size;
+    sdlogger_format_t format = file_format(&fil, &data_start, &record_size);
+    bool with_sensor = format == SDLOGGER_FORMAT_BINARY && record_size >= sizeof(sdlogger_bin_sensor_record_t);
+    if (format != SDLOGGER_FORMAT_CSV) {
+        printf("numero_amostra,accel_x,accel_y,accel_z,giro_x,giro_y,giro_z%s\n", with_sensor ? ",sensor" : "");
+        fr = f_lseek(&fil, data_start);
+    }
+    uint32_t skip_below = 0;  // amostras anteriores no primeiro bloco comprimido
+    if (FR_OK == fr && start_arg) {
+        char *unit;
+        uint32_t value = strtoul(start_arg, &unit, 10);
+        sdlogger_seek_by_t by = SDLOGGER_SEEK_SAMPLE;
+        if (*unit == 's') {
+            by = SDLOGGER_SEEK_TIME_MS;
+            value *= 1000;
+        } else {
+            skip_below = value;
+        }
+        fr = sdlogger_seek(&fil, arg1, by, value);
+    }
+    if (FR_INVALID_PARAMETER == fr) {
+        printf("[ERRO] '%s' termina antes de %s\n", arg1, start_arg);
+        f_close(&fil);
+        return;
+    }
+    if (FR_OK != fr) {
+        printf("sdlogger_seek error: %s (%d)\n", FRESULT_str(fr), fr);
+        f_close(&fil);
+        return;
+    }
+    uint32_t max_lines = lines_arg ? strtoul(lines_arg, NULL, 10) : UINT32_MAX;
+    uint32_t n = 0;
+    UINT br;
+    if (format == SDLOGGER_FORMAT_BINARY) {
+        sdlogger_bin_sensor_record_t rec;
+        for (; n < max_lines && read_bin_record(&fil, record_size, &rec); n++) {
+            const sdlogger_bin_record_t *r = &rec.base;
+            if (with_sensor) {
+                printf("%lu,%d,%d,%d,%d,%d,%d,%u\n", (unsigned long)r->sample, r->accel[0], r->accel[1], r->accel[2],
+                       r->gyro[0], r->gyro[1], r->gyro[2], rec.sensor);
+                continue;
+            }
+            imucodec_sample_t sample = {
+                .sample = r->sample,
+                .axis = { r->accel[0], r->accel[1], r->accel[2], r->gyro[0], r->gyro[1], r->gyro[2] },
+            };
+            print_record(&sample);
+        }
+    } else if (format == SDLOGGER_FORMAT_COMPRESSED) {
+        while (n < max_lines && f_read(&fil, read_block, sizeof read_block, &br) == FR_OK && br == sizeof read_block) {
+            int count = imucodec_decode(read_block, read_samples, IMUCODEC_MAX_SAMPLES);
+            if (count < 0) {
+                printf("# bloco inválido em %llu\n", (unsigned long long)(f_tell(&fil) - sizeof read_block));
+                continue;
+            }
+            for (int i = 0; i < count && n < max_lines; i++) {
+                if (read_samples[i].sample < skip_below) continue;
+                print_record(&read_samples[i]);
+                n++;
+            }
+        }
+    } else {
+        char buf[256];
+        for (; n < max_lines && f_gets(buf, sizeof buf, &fil); n++) {
+            printf("%s", buf);
+        }
     }
     fr = f_close(&fil);
     if (FR_OK != fr) {
@@ -299,6 +442,289 @@ void read_file(const char *filename_to_read) { // Renomear parâmetro para evita
 }
 
 
+//Escreve inteiros em decimal (mais rápido que f_printf no caminho de amostra)
+static char *format_uint(char *p, uint32_t v) {
+    char tmp[10];
+    int n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (n) *p++ = tmp[--n];
+    return p;
+}
+
+static char *format_int(char *p, int32_t v) {
+    if (v < 0) {
+        *p++ = '-';
+        return format_uint(p, (uint32_t)(-v));
+    }
+    return format_uint(p, (uint32_t)v);
+}
+
+//Escreve no log, direto no arquivo ou pelo buffer em RAM
+//f_write com novas tentativas. Uma falha do cartão (CRC, erro de escrita)
+//fica guardada no FIL e, sem limpar log_file.err, todas as escritas
+//seguintes do log falhariam; o setor pendente continua marcado e é
+//reenviado na próxima tentativa.
+static FRESULT log_f_write(const void *data, UINT len, UINT *bw) {
+    const BYTE *src = data;
+    FRESULT res = FR_OK;
+    *bw = 0;
+    for (int attempt = 0; attempt <= SDLOGGER_WRITE_RETRIES; attempt++) {
+        UINT n = 0;
+        log_file.err = 0;
+        res = f_write(&log_file, src + *bw, len - *bw, &n);
+        *bw += n;
+        if (res != FR_DISK_ERR) break;
+    }
+    if (res != FR_OK && *bw > 0) {
+        // Desfaz o pedaço que entrou, para o arquivo não ficar com meio registro
+        log_file.err = 0;
+        if (f_lseek(&log_file, f_tell(&log_file) - *bw) == FR_OK) f_truncate(&log_file);
+        *bw = 0;
+    }
+    return res;
+}
+
+//Escreve 'records' amostras (0 para cabeçalhos e notas). No modo
+//bufferizado, uma amostra conta para o buffer onde está o seu último byte.
+static bool log_write(const void *data, UINT len, uint32_t records) {
+    if (!log_buffered) {
+        UINT bw = 0;
+        FRESULT res = log_f_write(data, len, &bw);
+        if (res == FR_OK && bw == len) log_written += records;
+        if (res != FR_OK || bw != len) {
+            printf("[ERRO] Falha ao escrever no arquivo de log: %s (%d)\n", FRESULT_str(res), res);
+            return false;
+        }
+        return true;
+    }
+    const uint8_t *src = data;
+    while (len) {
+        UINT chunk = log_buffer_limit - log_buffer_len;
+        if (chunk > len) chunk = len;
+        memcpy(log_buffer + log_buffer_len, src, chunk);
+        log_buffer_len += chunk;
+        src += chunk;
+        len -= chunk;
+        //Registro inteiro no buffer: conta com ele, mesmo se for o que o enche
+        if (len == 0) log_buffer_records += records;
+        if (log_buffer_len == log_buffer_limit && !sdlogger_flush()) return false;
+    }
+    return true;
+}
+
+//Fecha o log mesmo depois de uma falha de escrita. O FatFs guarda o erro no
+//FIL e f_close falha sem liberar a entrada de FF_FS_LOCK, e aí todo f_open
+//seguinte do arquivo é recusado. Tenta de novo sem o erro; se o setor
+//pendente ainda não puder ser gravado, ele é descartado (FA_MODIFIED |
+//FA_DIRTY, internos do ff.c) para soltar o arquivo.
+static FRESULT log_close(void) {
+    FRESULT res = f_close(&log_file);
+    for (int attempt = 0; attempt < SDLOGGER_WRITE_RETRIES && res != FR_OK && log_file.obj.fs != NULL; attempt++) {
+        log_file.err = 0;
+        res = f_close(&log_file);
+    }
+    if (res != FR_OK && log_file.obj.fs != NULL) {
+        log_file.err = 0;
+        log_file.flag &= (BYTE)~0xC0;
+        f_close(&log_file);
+    }
+    return res;
+}
+
+//Nome do arquivo de índice: o nome completo do log seguido de SDLOGGER_IDX_EXT,
+//para voo.bin e voo.csv não dividirem o mesmo índice. false se o nome não
+//cabe em len: o log fica sem índice, em vez de usar um nome cortado
+bool sdlogger_index_path(const char *log_filename, char *out, size_t len) {
+    int n = snprintf(out, len, "%s%s", log_filename, SDLOGGER_IDX_EXT);
+    if (n < 0 || (size_t)n >= len) {
+        printf("[ERRO] Nome '%s' longo demais para o índice (%s); log sem índice\n", log_filename, SDLOGGER_IDX_EXT);
+        return false;
+    }
+    return true;
+}
+
+//Magic do log no formato dado, como no cabeçalho do índice (zeros para CSV)
+static void format_magic(sdlogger_format_t format, char magic[SDLOGGER_BIN_MAGIC_LEN]) {
+    memset(magic, 0, SDLOGGER_BIN_MAGIC_LEN);
+    if (format == SDLOGGER_FORMAT_BINARY) memcpy(magic, SDLOGGER_BIN_MAGIC, SDLOGGER_BIN_MAGIC_LEN);
+    if (format == SDLOGGER_FORMAT_COMPRESSED) memcpy(magic, SDLOGGER_RICE_MAGIC, SDLOGGER_BIN_MAGIC_LEN);
+}
+
+//Anota a posição do próximo registro a cada log_index_interval registros
+static void index_note(uint32_t sample_num) {
+    if (log_records++ % log_index_interval != 0) return;
+    if (log_index_count == SDLOGGER_INDEX_ENTRIES) {
+        // Tabela cheia: fica uma entrada a cada duas e o intervalo dobra
+        for (uint32_t i = 0; i < SDLOGGER_INDEX_ENTRIES / 2; i++) log_index[i] = log_index[2 * i];
+        log_index_count = SDLOGGER_INDEX_ENTRIES / 2;
+        log_index_interval *= 2;
+        if ((log_records - 1) % log_index_interval != 0) return;
+    }
+    sdlogger_idx_entry_t *e = &log_index[log_index_count++];
+    e->sample = sample_num;
+    e->time_ms = to_ms_since_boot(get_absolute_time()) - log_start_ms;
+    e->offset = (uint64_t)f_tell(&log_file) + (log_buffered ? log_buffer_len : 0);
+}
+
+//Grava o índice da sessão no arquivo lateral; log_size é o tamanho final do log
+static void index_write(FSIZE_t log_size) {
+    char path[FF_LFN_BUF];
+    if (!sdlogger_index_path(current_log_filename, path, sizeof path)) return;
+
+    FIL f;
+    FRESULT res = f_open(&f, path, FA_WRITE | FA_CREATE_ALWAYS);
+    if (res == FR_OK) {
+        sdlogger_idx_header_t header = {
+            .header_size = sizeof(sdlogger_idx_header_t),
+            .entry_size = sizeof(sdlogger_idx_entry_t),
+            .interval = log_index_interval,
+            .count = log_index_count,
+            .log_size = log_size,
+        };
+        memcpy(header.magic, SDLOGGER_IDX_MAGIC, SDLOGGER_BIN_MAGIC_LEN);
+        format_magic(log_format, header.log_magic);
+        UINT bw;
+        res = f_write(&f, &header, sizeof(header), &bw);
+        if (res == FR_OK) res = f_write(&f, log_index, log_index_count * sizeof(log_index[0]), &bw);
+        FRESULT close_res = f_close(&f);
+        if (res == FR_OK) res = close_res;
+    }
+    if (res != FR_OK) {
+        printf("[AVISO] Índice '%s' não gravado: %s (%d)\n", path, FRESULT_str(res), res);
+    }
+}
+
+static bool index_read_entry(FIL *f, const sdlogger_idx_header_t *header, uint32_t i, sdlogger_idx_entry_t *e) {
+    UINT br;
+    return f_lseek(f, header->header_size + (FSIZE_t)i * header->entry_size) == FR_OK &&
+           f_read(f, e, sizeof(*e), &br) == FR_OK && br == sizeof(*e);
+}
+
+//Busca binária no índice lateral do log aberto em fp (no formato dado):
+//entrada com chave igual a value ou, se não houver, a última antes dela (com
+//tempos repetidos, a primeira deles). Um índice de outro arquivo é ignorado.
+static bool index_lookup(FIL *fp, const char *log_filename, sdlogger_format_t format, sdlogger_seek_by_t by,
+                         uint32_t value, sdlogger_idx_entry_t *out) {
+    char path[FF_LFN_BUF];
+    if (!sdlogger_index_path(log_filename, path, sizeof path)) return false;
+    FIL f;
+    if (f_open(&f, path, FA_READ) != FR_OK) return false;
+
+    sdlogger_idx_header_t header;
+    char magic[SDLOGGER_BIN_MAGIC_LEN];
+    format_magic(format, magic);
+    UINT br;
+    bool found = false;
+    bool valid = f_read(&f, &header, sizeof(header), &br) == FR_OK && br == sizeof(header) &&
+                 memcmp(header.magic, SDLOGGER_IDX_MAGIC, SDLOGGER_BIN_MAGIC_LEN) == 0 &&
+                 header.header_size >= sizeof(header) && header.entry_size >= sizeof(sdlogger_idx_entry_t);
+    if (valid && (memcmp(header.log_magic, magic, sizeof magic) != 0 || header.log_size != f_size(fp))) {
+        printf("[AVISO] O índice '%s' é de outro log (formato ou tamanho diferente); ignorado.\n", path);
+        valid = false;
+    }
+    if (valid) {
+        // lo: primeira entrada com chave >= value
+        uint32_t lo = 0, hi = header.count;
+        bool ok = true;
+        while (ok && lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            ok = index_read_entry(&f, &header, mid, out);
+            uint32_t key = (by == SDLOGGER_SEEK_SAMPLE) ? out->sample : out->time_ms;
+            if (key < value) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (ok && lo < header.count && index_read_entry(&f, &header, lo, out)) {
+            found = ((by == SDLOGGER_SEEK_SAMPLE) ? out->sample : out->time_ms) == value;
+        }
+        if (ok && !found && lo > 0) found = index_read_entry(&f, &header, lo - 1, out);
+    }
+    f_close(&f);
+    return found;
+}
+
+//Posiciona fp (log aberto para leitura) no registro pedido: salta para a
+//entrada do índice com fast seek e avança no máximo um intervalo. Sem índice,
+//a busca por amostra percorre o arquivo desde a posição atual. Uma amostra
+//além do fim do log dá FR_INVALID_PARAMETER.
+FRESULT sdlogger_seek(FIL *fp, const char *log_filename, sdlogger_seek_by_t by, uint32_t value) {
+    // Mapa de clusters em RAM: f_lseek não percorre a FAT
+    read_clmt[0] = SDLOGGER_CLMT_LEN;
+    fp->cltbl = read_clmt;
+    if (f_lseek(fp, CREATE_LINKMAP) != FR_OK) fp->cltbl = NULL;  // fragmentado demais: seek normal
+
+    FSIZE_t data_start;
+    UINT record_size;
+    sdlogger_format_t format = file_format(fp, &data_start, &record_size);
+    sdlogger_idx_entry_t entry;
+    FRESULT res = FR_OK;
+    if (index_lookup(fp, log_filename, format, by, value, &entry)) {
+        if (entry.offset >= f_size(fp)) return FR_INVALID_PARAMETER;
+        res = f_lseek(fp, (FSIZE_t)entry.offset);
+    } else if (by == SDLOGGER_SEEK_TIME_MS) {
+        return FR_NO_FILE;  // sem índice não há tempo
+    }
+    if (res != FR_OK || by == SDLOGGER_SEEK_TIME_MS) return res;
+
+    // Chegar ao fim sem a amostra pedida é erro: ela está além do log
+
+    for (;;) {
+        FSIZE_t pos = f_tell(fp);
+        uint32_t sample;
+        if (format == SDLOGGER_FORMAT_BINARY) {
+            sdlogger_bin_sensor_record_t rec;
+            if (!read_bin_record(fp, record_size, &rec)) {
+                return f_error(fp) ? FR_DISK_ERR : FR_INVALID_PARAMETER;
+            }
+            sample = rec.base.sample;
+        } else if (format == SDLOGGER_FORMAT_COMPRESSED) {
+            // Para no bloco que contém a amostra; o leitor descarta as anteriores
+            UINT br;
+            res = f_read(fp, read_block, sizeof(read_block), &br);
+            if (res != FR_OK) return res;
+            if (br != sizeof(read_block)) return FR_INVALID_PARAMETER;
+            int count = imucodec_decode(read_block, read_samples, IMUCODEC_MAX_SAMPLES);
+            if (count <= 0) continue;
+            sample = read_samples[count - 1].sample;
+        } else {
+            char line[80];
+            if (!f_gets(line, sizeof line, fp)) return f_error(fp) ? FR_DISK_ERR : FR_INVALID_PARAMETER;
+            if (!isdigit((unsigned char)line[0])) continue;  // cabeçalho ou comentário
+            sample = strtoul(line, NULL, 10);
+        }
+        if (sample >= value) return f_lseek(fp, pos);
+    }
+}
+
+//Define (ou, com value NULL, remove) um metadado dos próximos logs
+bool sdlogger_set_metadata(const char *key, const char *value) {
+    size_t key_len = strlen(key);
+    for (char *line = log_metadata; *line; line = strchr(line, '\n') + 1) {
+        if (strncmp(line + 2, key, key_len) == 0 && line[2 + key_len] == '=') {
+            char *next = strchr(line, '\n') + 1;
+            memmove(line, next, strlen(next) + 1);
+            log_metadata_len -= (size_t)(next - line);
+            break;
+        }
+    }
+    if (!value) return true;
+
+    int n = snprintf(log_metadata + log_metadata_len, sizeof(log_metadata) - log_metadata_len, "# %s=%s\n", key,
+                     value);
+    if (n < 0 || (size_t)n >= sizeof(log_metadata) - log_metadata_len) {
+        log_metadata[log_metadata_len] = '\0';
+        printf("[ERRO] Sem espaço para o metadado '%s' (%d bytes no total)\n", key, SDLOGGER_METADATA_SIZE);
+        return false;
+    }
+    log_metadata_len += (size_t)n;
+    return true;
+}
+
 //Inicia a sessão de log do IMU
 bool sdlogger_start(const char *log_filename) {
     if (logging_active) {
@@ -306,6 +732,11 @@ bool sdlogger_start(const char *log_filename) {
         return false;
     }
 
+    if (log_format == SDLOGGER_FORMAT_COMPRESSED && log_sensors > 1) {
+        printf("[ERRO] O formato comprimido grava um sensor só: use csv ou bin com %u sensores.\n", log_sensors);
+        return false;
+    }
+
     // Copia o nome do arquivo para a variável estática
     strncpy(current_log_filename, log_filename, sizeof(current_log_filename) - 1);
     current_log_filename[sizeof(current_log_filename) - 1] = '\0'; // Garante null termination
@@ -316,44 +747,237 @@ bool sdlogger_start(const char *log_filename) {
         return false;
     }
 
-    // Escreve o cabeçalho CSV conforme o enunciado 
-    f_printf(&log_file, "numero_amostra,accel_x,accel_y,accel_z,giro_x,giro_y,giro_z\n");
+    // Um índice antigo com o mesmo nome não vale para o novo log
+    char index_path[FF_LFN_BUF];
+    if (sdlogger_index_path(current_log_filename, index_path, sizeof index_path)) f_unlink(index_path);
+
+    log_buffer_len = 0;
+    log_buffer_limit = SDLOGGER_BUFFER_SIZE;
+    log_index_count = 0;
+    log_index_interval = SDLOGGER_INDEX_INTERVAL;
+    log_records = 0;
+    log_written = log_buffer_records = log_block_records = 0;
+    log_start_ms = to_ms_since_boot(get_absolute_time());
     logging_active = true;
-    printf("Log iniciado em '%s'\n", current_log_filename);
+
+    bool ok;
+    if (log_format == SDLOGGER_FORMAT_BINARY) {
+        sdlogger_bin_header_t header = {
+            .header_size = (uint16_t)(sizeof(sdlogger_bin_header_t) + log_metadata_len),
+            .record_size = log_sensors > 1 ? sizeof(sdlogger_bin_sensor_record_t) : sizeof(sdlogger_bin_record_t),
+        };
+        memcpy(header.magic, SDLOGGER_BIN_MAGIC, SDLOGGER_BIN_MAGIC_LEN);
+        ok = log_write(&header, sizeof(header), 0) && log_write(log_metadata, (UINT)log_metadata_len, 0);
+    } else if (log_format == SDLOGGER_FORMAT_COMPRESSED) {
+        // O cabeçalho ocupa um bloco: os blocos comprimidos ficam alinhados a setor
+        static const uint8_t pad[IMUCODEC_BLOCK_SIZE - sizeof(sdlogger_bin_header_t)];
+        _Static_assert(SDLOGGER_METADATA_SIZE <= sizeof(pad), "metadados não cabem no bloco de cabeçalho");
+        sdlogger_bin_header_t header = {
+            .header_size = IMUCODEC_BLOCK_SIZE,
+            .record_size = IMUCODEC_BLOCK_SIZE,
+        };
+        memcpy(header.magic, SDLOGGER_RICE_MAGIC, SDLOGGER_BIN_MAGIC_LEN);
+        imucodec_encoder_init(&log_encoder);
+        ok = log_write(&header, sizeof(header), 0) && log_write(log_metadata, (UINT)log_metadata_len, 0) &&
+             log_write(pad, (UINT)(sizeof(pad) - log_metadata_len), 0);
+    } else {
+        // Escreve o cabeçalho CSV conforme o enunciado 
+        static const char csv_header[] = "numero_amostra,accel_x,accel_y,accel_z,giro_x,giro_y,giro_z";
+        const char *end = log_sensors > 1 ? ",sensor\n" : "\n";
+        ok = log_write(log_metadata, (UINT)log_metadata_len, 0) &&
+             log_write(csv_header, sizeof(csv_header) - 1, 0) && log_write(end, (UINT)strlen(end), 0);
+    }
+    // O cabeçalho vai para o cartão já na abertura: um buffer que se perca
+    // depois não leva junto o cabeçalho e deixa o arquivo ilegível
+    ok = ok && sdlogger_flush();
+    if (!ok) {
+        log_close();
+        logging_active = false;
+        return false;
+    }
+    printf("Log iniciado em '%s' (%s, %s)\n", current_log_filename, sdlogger_format_name(log_format),
+           log_buffered ? "bufferizado" : "direto");
     return true;
 }
 
-//Loga uma amostra do IMU no arquivo CSV
+//Loga uma amostra do IMU no arquivo
 bool sdlogger_log_sample(uint32_t sample_num, int16_t accel[3], int16_t gyro[3]) { 
+    return sdlogger_log_sensor(sample_num, 0, accel, gyro);
+}
+
+//Loga a amostra de um dos sensores; com mais de um, as linhas de uma mesma
+//amostra vêm seguidas, começando pelo sensor 0
+bool sdlogger_log_sensor(uint32_t sample_num, uint8_t sensor, int16_t accel[3], int16_t gyro[3]) {
     if (!logging_active) {
         printf("[AVISO] O logger não está ativo. Inicie o log antes de gravar amostras.\n");
         return false;
     }
 
+    if (log_format == SDLOGGER_FORMAT_COMPRESSED) {
+        const uint8_t *block = imucodec_encode(&log_encoder, sample_num, accel, gyro);
+        // O bloco completo pode ter fechado sem a amostra atual
+        uint32_t in_block = ++log_block_records - log_encoder.st.count;
+        log_block_records = log_encoder.st.count;
+        bool ok = !block || log_write(block, IMUCODEC_BLOCK_SIZE, in_block);
+        index_note(sample_num);  // depois da escrita: aponta para o bloco em montagem
+        return ok;
+    }
+
+    // O índice aponta só para o início de uma amostra (primeiro sensor)
+    if (sensor == 0) index_note(sample_num);
+    if (log_format == SDLOGGER_FORMAT_BINARY) {
+        sdlogger_bin_sensor_record_t rec = {
+            .base = {
+                .sample = sample_num,
+                .accel = { accel[0], accel[1], accel[2] },
+                .gyro = { gyro[0], gyro[1], gyro[2] },
+            },
+            .sensor = sensor,
+        };
+        return log_write(&rec, log_sensors > 1 ? sizeof(rec) : sizeof(rec.base), sensor == 0);
+    }
+
     // Formata a linha de dados conforme o enunciado [cite: 26, 47]
-    FRESULT res = f_printf(&log_file, "%lu,%d,%d,%d,%d,%d,%d\n",
-                           sample_num,
-                           accel[0], accel[1], accel[2],
-                           gyro[0], gyro[1], gyro[2]); 
+    char line[64];
+    char *p = format_uint(line, sample_num);
+    for (int i = 0; i < 3; i++) {
+        *p++ = ',';
+        p = format_int(p, accel[i]);
+    }
+    for (int i = 0; i < 3; i++) {
+        *p++ = ',';
+        p = format_int(p, gyro[i]);
+    }
+    if (log_sensors > 1) {
+        *p++ = ',';
+        p = format_uint(p, sensor);
+    }
+    *p++ = '\n';
+    return log_write(line, (UINT)(p - line), sensor == 0);
+}
 
-    if (res < 0) { // f_printf retorna o número de bytes escritos ou um erro negativo
-        printf("[ERRO] Falha ao escrever no arquivo de log: %s (%d)\n", FRESULT_str((FRESULT)res), (FRESULT)res);
-        return false;
+bool sdlogger_log_note(const char *text) {
+    if (!logging_active || log_format != SDLOGGER_FORMAT_CSV) return true;
+    char line[96];
+    int len = snprintf(line, sizeof line, "# %s\n", text);
+    if (len < 0) return false;
+    if ((size_t)len >= sizeof line) {
+        len = sizeof line - 1;
+        line[len - 1] = '\n';
     }
-    return true;
+    return log_write(line, (UINT)len, 0);
 }
 
 //Para a sessão de log
 void sdlogger_stop() {
     if (logging_active) {
-        f_close(&log_file); // Fecha o arquivo
+        if (log_format == SDLOGGER_FORMAT_COMPRESSED) {
+            const uint8_t *block = imucodec_flush(&log_encoder);
+            if (block) log_write(block, IMUCODEC_BLOCK_SIZE, log_block_records);
+            log_block_records = 0;
+        }
+        sdlogger_flush();
+        FSIZE_t log_size = f_size(&log_file);
+        FRESULT res = log_close();
         logging_active = false;
-        printf("Log encerrado para '%s'.\n", current_log_filename);
+        if (res != FR_OK) {
+            //Sem o f_close o tamanho do arquivo no diretório não foi atualizado
+            printf("[ERRO] Falha ao fechar '%s': %s (%d)\n", current_log_filename, FRESULT_str(res), res);
+            log_written = 0;
+            return;
+        }
+        index_write(log_size);
+        uint32_t lost = log_records - log_written;
+        if (log_sensors > 1) {
+            printf("Log encerrado para '%s' (%lu amostras de %u sensores, índice a cada %lu).\n",
+                   current_log_filename, (unsigned long)log_written, log_sensors, (unsigned long)log_index_interval);
+        } else {
+            printf("Log encerrado para '%s' (%lu registros, índice a cada %lu).\n", current_log_filename,
+                   (unsigned long)log_written, (unsigned long)log_index_interval);
+        }
+        if (lost) printf("[AVISO] %lu amostras perdidas em falhas de escrita.\n", (unsigned long)lost);
     } else {
         printf("[AVISO] O logger não estava ativo para ser parado.\n");
     }
 }
 
+uint32_t sdlogger_records_written(void) {
+    return log_written;
+}
+
+//Ocupação (0-100%) do buffer ainda não gravado no cartão
+uint8_t sdlogger_buffer_fill_percent(void) {
+    if (!logging_active) return 0;
+    if (log_buffered) return (uint8_t)(log_buffer_len * 100 / SDLOGGER_BUFFER_SIZE);
+    return (uint8_t)((f_tell(&log_file) % FF_MAX_SS) * 100 / FF_MAX_SS);
+}
+
+//Número de sensores dos próximos logs (linhas seguidas por amostra)
+bool sdlogger_set_sensors(uint8_t count) {
+    if (logging_active) {
+        printf("[AVISO] Pare o log antes de trocar o número de sensores.\n");
+        return false;
+    }
+    if (count < 1 || count > SDLOGGER_MAX_SENSORS) {
+        printf("[ERRO] Número de sensores deve estar entre 1 e %d\n", SDLOGGER_MAX_SENSORS);
+        return false;
+    }
+    log_sensors = count;
+    return true;
+}
+
+//Seleciona o formato das próximas sessões de log
+bool sdlogger_set_format(sdlogger_format_t format) {
+    if (logging_active) {
+        printf("[AVISO] Pare o log antes de trocar o formato.\n");
+        return false;
+    }
+    log_format = format;
+    return true;
+}
+
+sdlogger_format_t sdlogger_get_format(void) {
+    return log_format;
+}
+
+const char *sdlogger_format_name(sdlogger_format_t format) {
+    switch (format) {
+        case SDLOGGER_FORMAT_BINARY: return "binário";
+        case SDLOGGER_FORMAT_COMPRESSED: return "comprimido";
+        default: return "CSV";
+    }
+}
+
+//Liga/desliga o buffer em RAM das próximas sessões de log
+bool sdlogger_set_buffered(bool buffered) {
+    if (logging_active) {
+        printf("[AVISO] Pare o log antes de trocar o modo de escrita.\n");
+        return false;
+    }
+    log_buffered = buffered;
+    return true;
+}
+
+bool sdlogger_is_buffered(void) {
+    return log_buffered;
+}
+
+//Grava no arquivo o conteúdo pendente do buffer em RAM
+bool sdlogger_flush(void) {
+    if (!logging_active || log_buffer_len == 0) return true;
+    UINT bw = 0;
+    FRESULT res = log_f_write(log_buffer, log_buffer_len, &bw);
+    bool ok = (res == FR_OK && bw == log_buffer_len);
+    if (ok) log_written += log_buffer_records;
+    log_buffer_records = 0;
+    log_buffer_len = 0;
+    log_buffer_limit = SDLOGGER_BUFFER_SIZE - (UINT)(f_tell(&log_file) % FF_MAX_SS);
+    if (!ok) {
+        printf("[ERRO] Falha ao escrever no arquivo de log: %s (%d)\n", FRESULT_str(res), res);
+    }
+    return ok;
+}
+
 // Função de ajuda do CLI (mantida como está)
 void run_help() {
     printf("\nComandos disponíveis:\n\n");
@@ -0,0 +1,98 @@
+#include "../inc/shell.h"
+#include "pico/stdlib.h"
+#include <stdio.h>
+#include <string.h>
+
+static const shell_command_t *command_table = NULL;
+static size_t command_count = 0;
+
+static char line_buffer[SHELL_LINE_MAX];
+static size_t line_length = 0;
+static bool line_overflow = false;
+
+//Registra a tabela de comandos
+void shell_init(const shell_command_t *commands, size_t count) {
+    command_table = commands;
+    command_count = count;
+    line_length = 0;
+    line_overflow = false;
+}
+
+//Procura um comando pelo nome ou pelo atalho
+static const shell_command_t *shell_find(const char *name) {
+    for (size_t i = 0; i < command_count; i++) {
+        const shell_command_t *c = &command_table[i];
+        if (strcmp(c->name, name) == 0 || (c->alias && strcmp(c->alias, name) == 0)) {
+            return c;
+        }
+    }
+    return NULL;
+}
+
+//Executa um único comando já separado (sem ';')
+static void shell_execute_one(char *command) {
+    char *name = strtok(command, " \t");
+    if (!name) return;
+
+    const shell_command_t *c = shell_find(name);
+    if (c) {
+        c->handler();
+    } else {
+        printf("Comando '%s' não reconhecido. Digite 'ajuda'.\n", name);
+    }
+    // Descarta argumentos não consumidos para não vazar estado do strtok
+    while (strtok(NULL, " \t")) {
+    }
+}
+
+//Executa uma linha com um ou mais comandos separados por ';'
+void shell_execute(char *line) {
+    char *cursor = line;
+    while (cursor) {
+        char *next = strchr(cursor, ';');
+        if (next) *next++ = '\0';
+        shell_execute_one(cursor);
+        cursor = next;
+    }
+}
+
+//Lê a serial sem bloquear e executa as linhas completas.
+//Processa no máximo SHELL_MAX_CHARS_PER_POLL caracteres por chamada.
+void shell_poll(void) {
+    for (int n = 0; n < SHELL_MAX_CHARS_PER_POLL; n++) {
+        int c = getchar_timeout_us(0);
+        if (c == PICO_ERROR_TIMEOUT) return;
+
+        if (c == '\r' || c == '\n') {
+            if (line_overflow) {
+                printf("[ERRO] Linha maior que %d caracteres descartada\n", SHELL_LINE_MAX - 1);
+            } else if (line_length > 0) {
+                line_buffer[line_length] = '\0';
+                shell_execute(line_buffer);
+            }
+            line_length = 0;
+            line_overflow = false;
+        } else if (c == '\b' || c == 0x7F) {
+            if (line_length > 0) line_length--;
+        } else if (line_length < SHELL_LINE_MAX - 1) {
+            line_buffer[line_length++] = (char)c;
+        } else {
+            line_overflow = true;
+        }
+    }
+}
+
+//Lista os comandos registrados
+void shell_print_help(void) {
+    printf("\n=== COMANDOS DISPONÍVEIS ===\n");
+    for (size_t i = 0; i < command_count; i++) {
+        const shell_command_t *c = &command_table[i];
+        if (c->alias) {
+            printf("%-10s (%s) %s\n", c->name, c->alias, c->help);
+        } else {
+            printf("%-14s %s\n", c->name, c->help);
+        }
+    }
+    printf("Vários comandos por linha: separe com ';' (ex.: taxa 50; arquivo voo1.csv; s)\n");
+    printf("=============================\n\n");
+}
@@ -0,0 +1,398 @@
+#include "../inc/spectrum.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "f_util.h"
+#include "ff.h"
+
+// Com todos os componentes abaixo disso, um estágio (ganho máximo 2 em
+// módulo) não transborda int16; acima, o estágio divide por 2 e o expoente
+// do bloco aumenta. Como é potência de 2, basta o OU dos módulos.
+#define SCALE_LIMIT 8192
+#define INPUT_LIMIT 32000
+
+typedef struct {
+    int16_t re;
+    int16_t im;
+} cplx_t;
+
+typedef enum {
+    PHASE_IDLE,
+    PHASE_FFT,      // um passo por amostra: janela, estágios, acúmulo
+    PHASE_REPORT,   // um eixo por amostra
+    PHASE_WRITE
+} phase_t;
+
+static spectrum_mode_t mode = SPECTRUM_OFF;
+static uint16_t points = SPECTRUM_MAX_POINTS;
+static uint8_t log2_points = 9;
+static uint32_t interval_ms = SPECTRUM_INTERVAL_MS;
+
+// Tabelas Q15: cos/sen de 2*pi*k/SPECTRUM_MAX_POINTS e janela de Hann de 'points'
+static int16_t twiddle_cos[SPECTRUM_MAX_POINTS / 2];
+static int16_t twiddle_sin[SPECTRUM_MAX_POINTS / 2];
+static int16_t window[SPECTRUM_MAX_POINTS];
+static uint16_t window_points = 0;
+
+// Quadros de entrada em buffer duplo: um enche enquanto o outro é transformado
+static int16_t frames[2][SPECTRUM_AXES][SPECTRUM_MAX_POINTS];
+static int32_t frame_sum[2][SPECTRUM_AXES];
+static uint32_t frame_last_sample[2];
+static uint8_t fill_frame = 0;
+static uint16_t fill = 0;
+
+// Transformada em andamento
+static cplx_t work[SPECTRUM_MAX_POINTS];
+static phase_t phase = PHASE_IDLE;
+static uint8_t job_frame = 0;
+static uint8_t job_axis = 0;
+static uint8_t job_step = 0;    // 0 janela, 1..log2_points estágios, log2_points+1 acúmulo
+static uint8_t job_shift = 0;   // estágios divididos por 2 neste quadro
+static uint32_t job_peak = 0;   // OU dos módulos dos componentes após o último passo
+
+// Potência por raia somada nos quadros do intervalo, já sem as escalas dos estágios
+static uint64_t power[SPECTRUM_AXES][SPECTRUM_MAX_POINTS / 2 + 1];
+static uint32_t frames_done = 0;
+static uint32_t frames_per_report = 1;
+static uint32_t frames_late = 0;
+
+static bool active = false;
+static uint32_t rate_hz = 0;
+static spectrum_report_t report;
+static spectrum_report_t pending;
+static bool report_valid = false;
+static uint32_t reports_written = 0;
+static FIL spec_file;
+static char spec_filename[FF_LFN_BUF];
+
+static int16_t q15(double v) {
+    return (int16_t)lrint(v * 32767.0);
+}
+
+//Recalcula as tabelas quando o número de pontos muda
+static void tables_init(void) {
+    if (window_points == points) return;
+    for (int k = 0; k < SPECTRUM_MAX_POINTS / 2; k++) {
+        twiddle_cos[k] = q15(cos(2.0 * M_PI * k / SPECTRUM_MAX_POINTS));
+        twiddle_sin[k] = q15(sin(2.0 * M_PI * k / SPECTRUM_MAX_POINTS));
+    }
+    for (int n = 0; n < points; n++) {
+        window[n] = q15(0.5 * (1.0 - cos(2.0 * M_PI * n / points)));
+    }
+    window_points = points;
+}
+
+static uint16_t bit_reverse(uint16_t v, uint8_t bits) {
+    uint16_t r = 0;
+    for (uint8_t i = 0; i < bits; i++, v >>= 1) r = (uint16_t)((r << 1) | (v & 1u));
+    return r;
+}
+
+//Tira a média do quadro, aplica a janela e copia em ordem de bits invertida
+static void fft_window(const int16_t *x, int32_t sum) {
+    int32_t mean = sum / points;
+    uint32_t peak = 0;
+    for (uint16_t n = 0; n < points; n++) {
+        int32_t v = x[n] - mean;
+        if (v > INPUT_LIMIT) v = INPUT_LIMIT;
+        if (v < -INPUT_LIMIT) v = -INPUT_LIMIT;
+        v = (v * window[n] + 0x4000) >> 15;
+        work[bit_reverse(n, log2_points)] = (cplx_t){ (int16_t)v, 0 };
+        peak |= (uint32_t)abs(v);
+    }
+    job_shift = 0;
+    job_peak = peak;
+}
+
+//Um estágio de borboletas radix-2 (decimação no tempo), com escala de bloco
+static void fft_stage(uint8_t s) {
+    const uint16_t half = (uint16_t)(1u << s);
+    const uint16_t stride = (uint16_t)(SPECTRUM_MAX_POINTS / (2u * half));
+    const int scale = job_peak >= SCALE_LIMIT;
+    uint32_t peak = 0;
+    for (uint16_t start = 0; start < points; start += 2u * half) {
+        for (uint16_t k = 0; k < half; k++) {
+            int32_t wr = twiddle_cos[k * stride];
+            int32_t wi = twiddle_sin[k * stride];
+            cplx_t *a = &work[start + k];
+            cplx_t *b = &work[start + k + half];
+            // b * e^(-i*theta)
+            int32_t tr = (b->re * wr + b->im * wi + 0x4000) >> 15;
+            int32_t ti = (b->im * wr - b->re * wi + 0x4000) >> 15;
+            int32_t r0 = (a->re + tr) >> scale, i0 = (a->im + ti) >> scale;
+            int32_t r1 = (a->re - tr) >> scale, i1 = (a->im - ti) >> scale;
+            a->re = (int16_t)r0;
+            a->im = (int16_t)i0;
+            b->re = (int16_t)r1;
+            b->im = (int16_t)i1;
+            peak |= (uint32_t)abs(r0) | (uint32_t)abs(i0) | (uint32_t)abs(r1) | (uint32_t)abs(i1);
+        }
+    }
+    job_shift = (uint8_t)(job_shift + scale);
+    job_peak = peak;
+}
+
+static void fft_accumulate(uint8_t axis) {
+    for (uint16_t k = 0; k <= points / 2; k++) {
+        uint32_t p = (uint32_t)(work[k].re * work[k].re) + (uint32_t)(work[k].im * work[k].im);
+        power[axis][k] += (uint64_t)p << (2u * job_shift);
+    }
+}
+
+//Resume o intervalo de um eixo. Com a janela de Hann (potência média 3/8) e
+//o espectro de um lado só, o valor quadrático médio é 16 * soma / (3 N^2).
+static void report_axis(uint8_t axis) {
+    const uint64_t *p = power[axis];
+    const uint16_t half = points / 2;
+    const uint16_t band_width = half / SPECTRUM_BANDS;
+    const float norm = 16.0f / (3.0f * (float)points * (float)points * (float)frames_done);
+
+    uint64_t total = 0;
+    uint16_t kmax = 1;
+    for (uint8_t b = 0; b < SPECTRUM_BANDS; b++) {
+        uint64_t sum = 0;
+        for (uint16_t k = b ? b * band_width : 1; k < (b + 1u) * band_width; k++) {
+            sum += p[k];
+            if (p[k] > p[kmax]) kmax = k;
+        }
+        pending.band_rms[axis][b] = (uint32_t)lrintf(sqrtf((float)sum * norm));
+        total += sum;
+    }
+    pending.rms[axis] = (uint32_t)lrintf(sqrtf((float)total * norm));
+
+    // Pico refinado por parábola sobre as amplitudes das raias vizinhas
+    float m0 = sqrtf((float)p[kmax - 1]), m1 = sqrtf((float)p[kmax]), m2 = sqrtf((float)p[kmax + 1]);
+    float denom = m0 - 2.0f * m1 + m2;
+    float delta = denom != 0.0f ? 0.5f * (m0 - m2) / denom : 0.0f;
+    if (delta > 0.5f) delta = 0.5f;
+    if (delta < -0.5f) delta = -0.5f;
+    pending.peak_mhz[axis] = (uint32_t)lrintf(((float)kmax + delta) * (float)rate_hz * 1000.0f / (float)points);
+    pending.peak_rms[axis] = (uint32_t)lrintf(sqrtf((float)(p[kmax - 1] + p[kmax] + p[kmax + 1]) * norm));
+}
+
+static bool report_write(void) {
+    bool ok = true;
+    for (uint8_t a = 0; a < SPECTRUM_AXES && ok; a++) {
+        char line[160];
+        int n = snprintf(line, sizeof line, "%lu,%u,%lu,%lu,%lu", (unsigned long)pending.sample, a,
+                         (unsigned long)pending.peak_mhz[a], (unsigned long)pending.peak_rms[a],
+                         (unsigned long)pending.rms[a]);
+        for (uint8_t b = 0; b < SPECTRUM_BANDS; b++) {
+            n += snprintf(line + n, sizeof line - (size_t)n, ",%lu", (unsigned long)pending.band_rms[a][b]);
+        }
+        line[n++] = '\n';
+        UINT bw;
+        FRESULT res = f_write(&spec_file, line, (UINT)n, &bw);
+        if (res != FR_OK || bw != (UINT)n) {
+            printf("[ERRO] Falha ao escrever '%s': %s (%d)\n", spec_filename, FRESULT_str(res), res);
+            ok = false;
+        }
+    }
+    report = pending;
+    report_valid = true;
+    reports_written++;
+    memset(power, 0, sizeof power);
+    frames_done = 0;
+    return ok;
+}
+
+//Avança um passo da transformada ou do resumo pendente
+static bool step(void) {
+    switch (phase) {
+        case PHASE_FFT:
+            if (job_step == 0) {
+                fft_window(frames[job_frame][job_axis], frame_sum[job_frame][job_axis]);
+            } else if (job_step <= log2_points) {
+                fft_stage((uint8_t)(job_step - 1));
+            } else {
+                fft_accumulate(job_axis);
+            }
+            if (++job_step <= log2_points + 1) break;
+            job_step = 0;
+            if (++job_axis < SPECTRUM_AXES) break;
+            job_axis = 0;
+            phase = (++frames_done == frames_per_report) ? PHASE_REPORT : PHASE_IDLE;
+            pending.sample = frame_last_sample[job_frame];
+            break;
+        case PHASE_REPORT:
+            report_axis(job_axis);
+            if (++job_axis == SPECTRUM_AXES) phase = PHASE_WRITE;
+            break;
+        case PHASE_WRITE:
+            phase = PHASE_IDLE;
+            return report_write();
+        default:
+            break;
+    }
+    return true;
+}
+
+bool spectrum_process(uint32_t sample_num, const int16_t accel[3]) {
+    if (!active) return true;
+
+    for (uint8_t a = 0; a < SPECTRUM_AXES; a++) {
+        frames[fill_frame][a][fill] = accel[a];
+        frame_sum[fill_frame][a] += accel[a];
+    }
+    if (++fill < points) return phase == PHASE_IDLE || step();
+
+    // Quadro completo; se o anterior ainda não terminou, termina agora
+    bool ok = true;
+    if (phase != PHASE_IDLE) frames_late++;
+    while (phase != PHASE_IDLE) ok = step() && ok;
+    frame_last_sample[fill_frame] = sample_num;
+    job_frame = fill_frame;
+    job_axis = 0;
+    job_step = 0;
+    phase = PHASE_FFT;
+    fill_frame ^= 1;
+    fill = 0;
+    memset(frame_sum[fill_frame], 0, sizeof frame_sum[fill_frame]);
+    return ok;
+}
+
+//Nome do arquivo de espectro: <base>_fft.csv
+static void spectrum_path(const char *log_filename, char *out, size_t len) {
+    const char *dot = strrchr(log_filename, '.');
+    const char *slash = strrchr(log_filename, '/');
+    size_t base = (dot && (!slash || dot > slash)) ? (size_t)(dot - log_filename) : strlen(log_filename);
+    snprintf(out, len, "%.*s_fft.csv", (int)base, log_filename);
+}
+
+bool spectrum_start(const char *log_filename, uint32_t sample_rate_hz) {
+    if (active) return true;
+    tables_init();
+    rate_hz = sample_rate_hz;
+    frames_per_report = (uint32_t)(((uint64_t)interval_ms * rate_hz / 1000u + points / 2u) / points);
+    if (frames_per_report == 0) frames_per_report = 1;
+
+    spectrum_path(log_filename, spec_filename, sizeof spec_filename);
+    FRESULT res = f_open(&spec_file, spec_filename, FA_WRITE | FA_CREATE_ALWAYS);
+    if (res != FR_OK) {
+        printf("[ERRO] Falha ao abrir '%s': %s (%d)\n", spec_filename, FRESULT_str(res), res);
+        return false;
+    }
+    // Metadados '# chave=valor' antes do cabeçalho, como lidos por imulog_convert
+    char header[320];
+    int n = snprintf(header, sizeof header,
+                     "# pontos_fft=%u\n# janela=hann\n# taxa_hz=%lu\n# quadros_por_linha=%lu\n"
+                     "# largura_banda_mhz=%lu\nnumero_amostra,eixo,pico_mhz,pico_rms,rms",
+                     points, (unsigned long)rate_hz, (unsigned long)frames_per_report,
+                     (unsigned long)((uint64_t)rate_hz * 1000u / (2u * SPECTRUM_BANDS)));
+    for (int b = 0; b < SPECTRUM_BANDS; b++) n += snprintf(header + n, sizeof header - (size_t)n, ",banda_%d", b);
+    header[n++] = '\n';
+    UINT bw;
+    res = f_write(&spec_file, header, (UINT)n, &bw);
+    if (res != FR_OK || bw != (UINT)n) {
+        printf("[ERRO] Falha ao escrever '%s': %s (%d)\n", spec_filename, FRESULT_str(res), res);
+        f_close(&spec_file);
+        return false;
+    }
+
+    memset(power, 0, sizeof power);
+    memset(frame_sum, 0, sizeof frame_sum);
+    fill_frame = 0;
+    fill = 0;
+    phase = PHASE_IDLE;
+    frames_done = 0;
+    frames_late = 0;
+    reports_written = 0;
+    report_valid = false;
+    active = true;
+    printf("Espectro em '%s' (%u pontos, uma linha a cada %lu quadros)\n", spec_filename, points,
+           (unsigned long)frames_per_report);
+    return true;
+}
+
+//Encerra a sessão; quadros de um intervalo incompleto são descartados
+void spectrum_stop(void) {
+    if (!active) return;
+    active = false;
+    FRESULT res = f_close(&spec_file);
+    if (res != FR_OK) {
+        printf("[ERRO] Falha ao fechar '%s': %s (%d)\n", spec_filename, FRESULT_str(res), res);
+        return;
+    }
+    printf("Espectro encerrado em '%s' (%lu linhas por eixo, %lu quadros atrasados).\n", spec_filename,
+           (unsigned long)reports_written, (unsigned long)frames_late);
+}
+
+bool spectrum_is_active(void) {
+    return active;
+}
+
+const spectrum_report_t *spectrum_last_report(void) {
+    return report_valid ? &report : NULL;
+}
+
+//Eixo com maior amplitude no pico do último intervalo
+bool spectrum_dominant(uint8_t *axis, uint32_t *peak_mhz) {
+    if (!report_valid) return false;
+    uint8_t best = 0;
+    for (uint8_t a = 1; a < SPECTRUM_AXES; a++) {
+        if (report.peak_rms[a] > report.peak_rms[best]) best = a;
+    }
+    *axis = best;
+    *peak_mhz = report.peak_mhz[best];
+    return true;
+}
+
+bool spectrum_set_mode(spectrum_mode_t m) {
+    if (active) {
+        printf("[AVISO] Pare a gravação antes de trocar o modo do espectro.\n");
+        return false;
+    }
+    mode = m;
+    return true;
+}
+
+spectrum_mode_t spectrum_get_mode(void) {
+    return mode;
+}
+
+bool spectrum_set_points(uint16_t n) {
+    if (active) {
+        printf("[AVISO] Pare a gravação antes de trocar o tamanho da FFT.\n");
+        return false;
+    }
+    if (n != 256 && n != 512) {
+        printf("[ERRO] A FFT deve ter 256 ou 512 pontos\n");
+        return false;
+    }
+    points = n;
+    log2_points = (n == 256) ? 8 : 9;
+    return true;
+}
+
+uint16_t spectrum_get_points(void) {
+    return points;
+}
+
+bool spectrum_set_interval_ms(uint32_t ms) {
+    if (active) {
+        printf("[AVISO] Pare a gravação antes de trocar o intervalo do espectro.\n");
+        return false;
+    }
+    if (ms < 100 || ms > 3600000u) {
+        printf("[ERRO] Intervalo deve estar entre 0,1 e 3600 s\n");
+        return false;
+    }
+    interval_ms = ms;
+    return true;
+}
+
+void spectrum_print_status(void) {
+    static const char *const mode_names[] = { "desligado", "junto com as amostras", "só espectro" };
+    printf("Espectro: %s, FFT de %u pontos (Hann), uma linha a cada %lu ms\n", mode_names[mode], points,
+           (unsigned long)interval_ms);
+    if (!report_valid) return;
+    static const char axis_names[SPECTRUM_AXES] = { 'X', 'Y', 'Z' };
+    for (uint8_t a = 0; a < SPECTRUM_AXES; a++) {
+        printf("  %c: pico %lu.%03lu Hz (rms %lu), rms total %lu\n", axis_names[a],
+               (unsigned long)(report.peak_mhz[a] / 1000), (unsigned long)(report.peak_mhz[a] % 1000),
+               (unsigned long)report.peak_rms[a], (unsigned long)report.rms[a]);
+    }
+}
@@ -0,0 +1,164 @@
+#include "../inc/telemetry.h"
+#include "pico/stdlib.h"
+#include <malloc.h>
+#include <stdio.h>
+#include <string.h>
+
+// Símbolos do linker do RP2040 (heap entre __end__ e __StackLimit)
+extern char __end__;
+extern char __StackLimit;
+extern char __StackBottom;
+extern char __StackTop;
+
+#define STACK_PAINT 0xA5A5A5A5u
+
+static const char *const metric_names[TELEM_METRIC_COUNT] = {
+    [TELEM_SAMPLE_JITTER] = "jitter_amostra",
+    [TELEM_IMU_READ]      = "leitura_imu",
+    [TELEM_SD_WRITE]      = "escrita_sd",
+    [TELEM_DISPLAY]       = "display",
+    [TELEM_BUZZER]        = "buzzer",
+    [TELEM_LOOP]          = "laco",
+    [TELEM_SPECTRUM]      = "espectro",
+    [TELEM_I2C_RECOVERY]  = "recupera_i2c",
+};
+
+static telem_hist_t hists[TELEM_METRIC_COUNT];
+static uint32_t dropped_samples = 0;
+static uint32_t i2c_recoveries = 0;
+static uint32_t i2c_recovery_failures = 0;
+
+//Pinta a parte livre da pilha para medir a marca d'água depois
+static void telemetry_paint_stack(void) {
+    uint32_t marker;
+    uint32_t *p = (uint32_t *)&__StackBottom;
+    uint32_t *limit = (uint32_t *)((uintptr_t)&marker - 64);
+    while (p < limit) {
+        *p++ = STACK_PAINT;
+    }
+}
+
+//Inicializa os contadores; deve ser chamada no início do main()
+void telemetry_init(void) {
+    telemetry_paint_stack();
+    telemetry_reset();
+}
+
+//Índice do bucket log2 de um valor
+static inline uint32_t telemetry_bucket(uint32_t us) {
+    uint32_t b = us ? 32u - (uint32_t)__builtin_clz(us) : 0u;
+    return b < TELEM_BUCKETS ? b : TELEM_BUCKETS - 1;
+}
+
+//Registra uma medição de tempo
+void telemetry_record(telem_metric_t metric, uint32_t us) {
+    if (metric >= TELEM_METRIC_COUNT) return;
+    telem_hist_t *h = &hists[metric];
+    h->count++;
+    h->sum_us += us;
+    if (us < h->min_us) h->min_us = us;
+    if (us > h->max_us) h->max_us = us;
+    h->buckets[telemetry_bucket(us)]++;
+}
+
+void telemetry_count_dropped(uint32_t samples) {
+    dropped_samples += samples;
+}
+
+uint32_t telemetry_dropped(void) {
+    return dropped_samples;
+}
+
+//O tempo de cada recuperação vai em TELEM_I2C_RECOVERY; aqui só o resultado
+void telemetry_count_i2c_recovery(bool ok) {
+    i2c_recoveries++;
+    if (!ok) i2c_recovery_failures++;
+}
+
+const telem_hist_t *telemetry_get(telem_metric_t metric) {
+    if (metric >= TELEM_METRIC_COUNT) return NULL;
+    return &hists[metric];
+}
+
+//Percentil aproximado: limite superior do bucket que contém o percentil
+uint32_t telemetry_percentile(telem_metric_t metric, uint8_t percent) {
+    const telem_hist_t *h = telemetry_get(metric);
+    if (!h || h->count == 0) return 0;
+    uint32_t target = (uint32_t)(((uint64_t)h->count * percent + 99) / 100);
+    if (target == 0) target = 1;
+    uint32_t acc = 0;
+    for (uint32_t i = 0; i < TELEM_BUCKETS; i++) {
+        acc += h->buckets[i];
+        if (acc >= target) {
+            uint32_t upper = i ? (1u << i) - 1u : 0u;
+            return (i == TELEM_BUCKETS - 1 || upper > h->max_us) ? h->max_us : upper;
+        }
+    }
+    return h->max_us;
+}
+
+//Memória livre no heap (bytes)
+uint32_t telemetry_free_heap(void) {
+    struct mallinfo mi = mallinfo();
+    uint32_t total = (uint32_t)(&__StackLimit - &__end__);
+    return total - (uint32_t)mi.uordblks;
+}
+
+//Maior uso de pilha observado desde telemetry_init (bytes)
+uint32_t telemetry_stack_high_water(void) {
+    const uint32_t *p = (const uint32_t *)&__StackBottom;
+    const uint32_t *top = (const uint32_t *)&__StackTop;
+    while (p < top && *p == STACK_PAINT) {
+        p++;
+    }
+    return (uint32_t)((uintptr_t)top - (uintptr_t)p);
+}
+
+//Imprime o histograma compacto (apenas buckets não vazios)
+static void telemetry_print_hist(const telem_hist_t *h) {
+    printf("    ");
+    for (uint32_t i = 0; i < TELEM_BUCKETS; i++) {
+        if (!h->buckets[i]) continue;
+        if (i == 0) {
+            printf("[0]:%lu ", h->buckets[i]);
+        } else {
+            printf("[<%lu]:%lu ", 1ul << i, h->buckets[i]);
+        }
+    }
+    printf("\n");
+}
+
+//Imprime todas as métricas
+void telemetry_print(void) {
+    printf("\n=== TELEMETRIA (us) ===\n");
+    printf("%-15s %8s %7s %7s %7s %7s %8s\n", "metrica", "n", "min", "media", "p50", "p99", "max");
+    for (int m = 0; m < TELEM_METRIC_COUNT; m++) {
+        const telem_hist_t *h = &hists[m];
+        uint32_t avg = h->count ? (uint32_t)(h->sum_us / h->count) : 0;
+        printf("%-15s %8lu %7lu %7lu %7lu %7lu %8lu\n", metric_names[m], h->count,
+               h->count ? h->min_us : 0, avg,
+               telemetry_percentile(m, 50), telemetry_percentile(m, 99), h->max_us);
+        if (m == TELEM_SAMPLE_JITTER || m == TELEM_SD_WRITE) {
+            telemetry_print_hist(h);
+        }
+    }
+    printf("Amostras perdidas: %lu\n", dropped_samples);
+    if (i2c_recoveries) {
+        printf("Recuperações do I2C: %lu (%lu sem sucesso)\n", i2c_recoveries, i2c_recovery_failures);
+    }
+    printf("Heap livre: %lu bytes\n", telemetry_free_heap());
+    printf("Pilha (marca d'agua): %lu de %lu bytes\n", telemetry_stack_high_water(),
+           (uint32_t)(&__StackTop - &__StackBottom));
+    printf("=======================\n\n");
+}
+
+//Zera todas as métricas
+void telemetry_reset(void) {
+    memset(hists, 0, sizeof(hists));
+    for (int m = 0; m < TELEM_METRIC_COUNT; m++) {
+        hists[m].min_us = UINT32_MAX;
+    }
+    dropped_samples = 0;
+    i2c_recoveries = 0;
+    i2c_recovery_failures = 0;
+}
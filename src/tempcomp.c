@@ -0,0 +1,353 @@
+#include "../inc/tempcomp.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ff.h"
+#include "f_util.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "pico/stdlib.h"
+
+#include "../inc/crc32.h"
+#include "../inc/sdlogger.h"
+#include "../inc/sensor.h"
+
+// Setor antes do da calibração (o último)
+#define TEMPCOMP_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - 2 * FLASH_SECTOR_SIZE)
+#define TEMPCOMP_MAGIC 0x504D4354u  // "TCMP"
+#define TEMPCOMP_VERSION 2  // 2: escalas em LSB por unidade, não mais índices do MPU6050
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;       // sizeof(tempcomp_t)
+    tempcomp_t data;
+    uint32_t crc;        // CRC32 de tudo o que vem antes
+} tempcomp_record_t;
+
+_Static_assert(sizeof(tempcomp_record_t) <= FLASH_PAGE_SIZE, "registro de compensação maior que uma página");
+
+static const char *const axis_names[6] = { "ax", "ay", "az", "gx", "gy", "gz" };
+
+static tempcomp_t tc;
+static int16_t offsets[6];            // offsets atuais, escala atual
+static int32_t last_temp_q8 = INT32_MIN;
+
+// Janela em andamento
+static int32_t temp_sum;
+static int32_t axis_sum[6];
+static uint16_t window_count;
+
+// Registro da varredura
+static bool logging = false;
+static bool active = false;
+static uint32_t lines_written = 0;
+static FIL temp_file;
+static char temp_filename[FF_LFN_BUF];
+
+int32_t tempcomp_celsius_q8(int16_t temp_raw) {
+    return (int32_t)temp_raw * (1 << TEMPCOMP_TEMP_FRAC) / TEMPCOMP_LSB_PER_C +
+           TEMPCOMP_OFFSET_CC * (1 << TEMPCOMP_TEMP_FRAC) / 100;
+}
+
+//off(dT) = ((c3 dT + c2) dT + c1) dT, coeficientes em Q24 e dT em Q8;
+//o acumulador fica em Q24 e é saturado a cada passo
+static int32_t poly_lsb(const int32_t c[TEMPCOMP_ORDER], int32_t dt_q8) {
+    const int64_t limit = (int64_t)1 << 46;
+    int64_t acc = 0;
+    for (int k = TEMPCOMP_ORDER - 1; k >= 0; k--) {
+        acc = ((acc * dt_q8) >> TEMPCOMP_TEMP_FRAC) + c[k];
+        if (acc > limit) acc = limit;
+        if (acc < -limit) acc = -limit;
+    }
+    acc = (acc * dt_q8) >> TEMPCOMP_TEMP_FRAC;
+    acc = (acc + (1 << (TEMPCOMP_COEF_FRAC - 1))) >> TEMPCOMP_COEF_FRAC;
+    if (acc > INT16_MAX) return INT16_MAX;
+    if (acc < INT16_MIN) return INT16_MIN;
+    return (int32_t)acc;
+}
+
+//Offsets numa temperatura (Q8), na escala atual do sensor
+static void compute_offsets(int32_t temp_q8, int16_t out[6]) {
+    const int32_t max_dt = TEMPCOMP_MAX_DELTA_C << TEMPCOMP_TEMP_FRAC;
+    int32_t dt = temp_q8 - tc.ref_q8;
+    if (dt > max_dt) dt = max_dt;
+    if (dt < -max_dt) dt = -max_dt;
+    const float accel_lsb = sensor_accel_lsb_per_g(), gyro_lsb = sensor_gyro_lsb_per_dps();
+    for (int i = 0; i < 6; i++) {
+        int32_t v = poly_lsb(tc.coef[i], dt);
+        out[i] = i < 3 ? sensor_rescale(v, tc.accel_lsb_per_g, accel_lsb)
+                       : sensor_rescale(v, tc.gyro_lsb_per_dps, gyro_lsb);
+    }
+}
+
+bool tempcomp_offsets_at(int16_t temp_raw, int16_t out[6]) {
+    if (!tc.enabled) return false;
+    compute_offsets(tempcomp_celsius_q8(temp_raw), out);
+    return true;
+}
+
+//Publica o estado nos metadados dos próximos logs
+static void publish_metadata(void) {
+    if (!tc.enabled) {
+        sdlogger_set_metadata("tempcomp_ref_c", NULL);
+        sdlogger_set_metadata("tempcomp", "off");
+        return;
+    }
+    char value[16];
+    sdlogger_set_metadata("tempcomp", "on");
+    snprintf(value, sizeof value, "%.2f", tc.ref_q8 / (double)(1 << TEMPCOMP_TEMP_FRAC));
+    sdlogger_set_metadata("tempcomp_ref_c", value);
+}
+
+void tempcomp_refresh(void) {
+    if (tc.enabled && last_temp_q8 != INT32_MIN) {
+        compute_offsets(last_temp_q8, offsets);
+    } else {
+        memset(offsets, 0, sizeof offsets);
+    }
+    publish_metadata();
+}
+
+bool tempcomp_load(void) {
+    const tempcomp_record_t *rec = (const tempcomp_record_t *)(XIP_BASE + TEMPCOMP_FLASH_OFFSET);
+    bool valid = rec->magic == TEMPCOMP_MAGIC && rec->version == TEMPCOMP_VERSION &&
+                 rec->size == sizeof(tempcomp_t) && rec->crc == crc32_update(0, rec, offsetof(tempcomp_record_t, crc));
+    if (valid) {
+        tc = rec->data;
+    } else {
+        memset(&tc, 0, sizeof tc);
+        tc.ref_q8 = TEMPCOMP_OFFSET_CC * (1 << TEMPCOMP_TEMP_FRAC) / 100;
+    }
+    tempcomp_refresh();
+    return valid;
+}
+
+//Mesmo esquema de calibration.c: apaga o setor e grava uma página com o XIP desligado
+bool tempcomp_save(void) {
+    static uint8_t page[FLASH_PAGE_SIZE];
+    memset(page, 0xFF, sizeof page);
+    tempcomp_record_t rec = {
+        .magic = TEMPCOMP_MAGIC,
+        .version = TEMPCOMP_VERSION,
+        .size = sizeof(tempcomp_t),
+        .data = tc,
+    };
+    rec.crc = crc32_update(0, &rec, offsetof(tempcomp_record_t, crc));
+    memcpy(page, &rec, sizeof rec);
+
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_erase(TEMPCOMP_FLASH_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(TEMPCOMP_FLASH_OFFSET, page, FLASH_PAGE_SIZE);
+    restore_interrupts(irq);
+
+    if (memcmp((const void *)(XIP_BASE + TEMPCOMP_FLASH_OFFSET), page, sizeof rec) != 0) {
+        printf("[ERRO] Falha ao gravar a compensação térmica na flash\n");
+        return false;
+    }
+    printf("Compensação térmica gravada na flash.\n");
+    return true;
+}
+
+void tempcomp_clear(void) {
+    memset(&tc, 0, sizeof tc);
+    tc.ref_q8 = TEMPCOMP_OFFSET_CC * (1 << TEMPCOMP_TEMP_FRAC) / 100;
+    tempcomp_refresh();
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_erase(TEMPCOMP_FLASH_OFFSET, FLASH_SECTOR_SIZE);
+    restore_interrupts(irq);
+    printf("Compensação térmica apagada.\n");
+}
+
+bool tempcomp_set_ref(float celsius) {
+    if (!(celsius > -40.0f && celsius < 85.0f)) {
+        printf("[ERRO] Temperatura de referência fora de -40 a 85 graus\n");
+        return false;
+    }
+    tc.ref_q8 = (int32_t)lrintf(celsius * (float)(1 << TEMPCOMP_TEMP_FRAC));
+    tempcomp_refresh();
+    return true;
+}
+
+bool tempcomp_set_axis(int axis, const float coef[TEMPCOMP_ORDER]) {
+    if (axis < 0 || axis >= 6) return false;
+    for (int k = 0; k < TEMPCOMP_ORDER; k++) {
+        if (!(fabsf(coef[k]) <= TEMPCOMP_MAX_COEF)) {
+            printf("[ERRO] Coeficiente c%d fora de +-%.0f LSB/grau^%d\n", k + 1, (double)TEMPCOMP_MAX_COEF, k + 1);
+            return false;
+        }
+    }
+    // Todos os eixos de um sensor compartilham a escala: a última definida vale
+    if (axis < 3) {
+        tc.accel_lsb_per_g = sensor_accel_lsb_per_g();
+    } else {
+        tc.gyro_lsb_per_dps = sensor_gyro_lsb_per_dps();
+    }
+    for (int k = 0; k < TEMPCOMP_ORDER; k++) {
+        tc.coef[axis][k] = (int32_t)lrintf(coef[k] * (float)(1 << TEMPCOMP_COEF_FRAC));
+    }
+    tempcomp_refresh();
+    return true;
+}
+
+int tempcomp_axis_index(const char *name) {
+    for (int i = 0; i < 6; i++) {
+        if (strcmp(name, axis_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+bool tempcomp_set_enabled(bool on) {
+    if (active) {
+        printf("[AVISO] Pare a gravação antes de ligar ou desligar a compensação térmica.\n");
+        return false;
+    }
+    tc.enabled = on;
+    tempcomp_refresh();
+    return true;
+}
+
+bool tempcomp_is_enabled(void) {
+    return tc.enabled;
+}
+
+static bool temp_write(const char *data, int len) {
+    UINT bw;
+    FRESULT res = f_write(&temp_file, data, (UINT)len, &bw);
+    if (res != FR_OK || bw != (UINT)len) {
+        printf("[ERRO] Falha ao escrever '%s': %s (%d)\n", temp_filename, FRESULT_str(res), res);
+        return false;
+    }
+    return true;
+}
+
+//Nome do arquivo da varredura: <base>_temp.csv
+static void tempcomp_path(const char *log_filename, char *out, size_t len) {
+    const char *dot = strrchr(log_filename, '.');
+    const char *slash = strrchr(log_filename, '/');
+    size_t base = (dot && (!slash || dot > slash)) ? (size_t)(dot - log_filename) : strlen(log_filename);
+    snprintf(out, len, "%.*s_temp.csv", (int)base, log_filename);
+}
+
+bool tempcomp_set_logging(bool on) {
+    if (active) {
+        printf("[AVISO] Pare a gravação antes de trocar o registro de temperatura.\n");
+        return false;
+    }
+    logging = on;
+    return true;
+}
+
+bool tempcomp_start(const char *log_filename) {
+    if (active) return true;
+    last_temp_q8 = INT32_MIN;   // a primeira leitura da sessão define os offsets
+    temp_sum = 0;
+    memset(axis_sum, 0, sizeof axis_sum);
+    window_count = 0;
+    lines_written = 0;
+    if (!logging) {
+        active = true;
+        return true;
+    }
+    tempcomp_path(log_filename, temp_filename, sizeof temp_filename);
+    FRESULT res = f_open(&temp_file, temp_filename, FA_WRITE | FA_CREATE_ALWAYS);
+    if (res != FR_OK) {
+        printf("[ERRO] Falha ao abrir '%s': %s (%d)\n", temp_filename, FRESULT_str(res), res);
+        return false;
+    }
+    char header[192];
+    int n = snprintf(header, sizeof header,
+                     "# janela=%u\n# accel_lsb_g=%.1f\n# giro_lsb_dps=%.1f\n# unidade_temp=centigraus\n"
+                     "numero_amostra,temp_cc,accel_x,accel_y,accel_z,giro_x,giro_y,giro_z\n",
+                     TEMPCOMP_WINDOW, (double)sensor_accel_lsb_per_g(), (double)sensor_gyro_lsb_per_dps());
+    if (!temp_write(header, n)) {
+        f_close(&temp_file);
+        return false;
+    }
+    active = true;
+    printf("Varredura de temperatura em '%s' (médias de %u amostras brutas)\n", temp_filename, TEMPCOMP_WINDOW);
+    return true;
+}
+
+void tempcomp_stop(void) {
+    if (!active) return;
+    active = false;
+    if (!logging) return;
+    FRESULT res = f_close(&temp_file);
+    if (res != FR_OK) {
+        printf("[ERRO] Falha ao fechar '%s': %s (%d)\n", temp_filename, FRESULT_str(res), res);
+        return;
+    }
+    printf("Varredura de temperatura encerrada em '%s' (%lu linhas).\n", temp_filename,
+           (unsigned long)lines_written);
+}
+
+static inline int16_t sub_sat(int16_t v, int16_t offset) {
+    int32_t r = (int32_t)v - offset;
+    if (r > INT16_MAX) return INT16_MAX;
+    if (r < INT16_MIN) return INT16_MIN;
+    return (int16_t)r;
+}
+
+//Média arredondada da janela
+static int32_t window_mean(int32_t sum) {
+    return (sum >= 0 ? sum + TEMPCOMP_WINDOW / 2 : sum - TEMPCOMP_WINDOW / 2) / TEMPCOMP_WINDOW;
+}
+
+bool tempcomp_process(uint32_t sample_num, int16_t temp_raw, int16_t accel[3], int16_t gyro[3]) {
+    bool ok = true;
+    temp_sum += temp_raw;
+    for (int i = 0; i < 3; i++) {
+        axis_sum[i] += accel[i];
+        axis_sum[3 + i] += gyro[i];
+    }
+    if (++window_count >= TEMPCOMP_WINDOW) {
+        int16_t mean_raw = (int16_t)window_mean(temp_sum);
+        last_temp_q8 = tempcomp_celsius_q8(mean_raw);
+        if (tc.enabled) compute_offsets(last_temp_q8, offsets);
+
+        if (active && logging) {
+            int32_t cc = (int32_t)mean_raw * 100 / TEMPCOMP_LSB_PER_C + TEMPCOMP_OFFSET_CC;
+            char line[96];
+            int n = snprintf(line, sizeof line, "%lu,%ld", (unsigned long)sample_num, (long)cc);
+            for (int i = 0; i < 6; i++) n += snprintf(line + n, sizeof line - (size_t)n, ",%ld",
+                                                      (long)window_mean(axis_sum[i]));
+            line[n++] = '\n';
+            lines_written++;
+            ok = temp_write(line, n);
+        }
+        temp_sum = 0;
+        memset(axis_sum, 0, sizeof axis_sum);
+        window_count = 0;
+    }
+
+    // Antes da primeira janela vale a temperatura desta leitura
+    if (tc.enabled && last_temp_q8 == INT32_MIN) {
+        last_temp_q8 = tempcomp_celsius_q8(temp_raw);
+        compute_offsets(last_temp_q8, offsets);
+    }
+    if (tc.enabled) {
+        for (int i = 0; i < 3; i++) {
+            accel[i] = sub_sat(accel[i], offsets[i]);
+            gyro[i] = sub_sat(gyro[i], offsets[3 + i]);
+        }
+    }
+    return ok;
+}
+
+void tempcomp_print_status(void) {
+    printf("Compensação térmica: %s, referência %.2f graus, registro %s\n", tc.enabled ? "ligada" : "desligada",
+           tc.ref_q8 / (double)(1 << TEMPCOMP_TEMP_FRAC), logging ? "ligado" : "desligado");
+    if (last_temp_q8 != INT32_MIN) {
+        printf("  temperatura do die: %.2f graus\n", last_temp_q8 / (double)(1 << TEMPCOMP_TEMP_FRAC));
+    }
+    const double scale = 1.0 / (double)(1 << TEMPCOMP_COEF_FRAC);
+    for (int i = 0; i < 6; i++) {
+        printf("  %s: %.6g %.6g %.6g LSB/grau^k (a %.1f LSB/%s), offset atual %d LSB\n", axis_names[i],
+               tc.coef[i][0] * scale, tc.coef[i][1] * scale, tc.coef[i][2] * scale,
+               (double)(i < 3 ? tc.accel_lsb_per_g : tc.gyro_lsb_per_dps), i < 3 ? "g" : "(graus/s)", offsets[i]);
+    }
+}
@@ -0,0 +1,105 @@
+#include <string.h>
+
+#include "tusb.h"
+#include "pico/unique_id.h"
+
+// Descritores USB do dispositivo composto: CDC (shell/stdio) + MSC (disco).
+// Com o TinyUSB ligado direto ao executável, pico_stdio_usb deixa de fornecer
+// os seus; o CDC continua sendo a interface 0, a que o stdio usa.
+
+// VID/PID de desenvolvimento (os dos exemplos do TinyUSB); o PID muda com as
+// classes habilitadas para o host não reaproveitar o driver de outra combinação
+#define USB_VID 0xCafe
+#define USB_PID (0x4000 | (CFG_TUD_CDC << 0) | (CFG_TUD_MSC << 1))
+#define USB_BCD 0x0200
+
+enum {
+    ITF_NUM_CDC = 0,
+    ITF_NUM_CDC_DATA,
+    ITF_NUM_MSC,
+    ITF_NUM_TOTAL
+};
+
+#define EPNUM_CDC_NOTIF 0x81
+#define EPNUM_CDC_OUT   0x02
+#define EPNUM_CDC_IN    0x82
+#define EPNUM_MSC_OUT   0x03
+#define EPNUM_MSC_IN    0x83
+
+#define CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_CDC_DESC_LEN + TUD_MSC_DESC_LEN)
+
+enum {
+    STRID_LANGID = 0,
+    STRID_MANUFACTURER,
+    STRID_PRODUCT,
+    STRID_SERIAL,
+    STRID_CDC,
+    STRID_MSC
+};
+
+static const tusb_desc_device_t desc_device = {
+    .bLength = sizeof(tusb_desc_device_t),
+    .bDescriptorType = TUSB_DESC_DEVICE,
+    .bcdUSB = USB_BCD,
+    // Composto com IAD (o CDC ocupa duas interfaces)
+    .bDeviceClass = TUSB_CLASS_MISC,
+    .bDeviceSubClass = MISC_SUBCLASS_COMMON,
+    .bDeviceProtocol = MISC_PROTOCOL_IAD,
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor = USB_VID,
+    .idProduct = USB_PID,
+    .bcdDevice = 0x0100,
+    .iManufacturer = STRID_MANUFACTURER,
+    .iProduct = STRID_PRODUCT,
+    .iSerialNumber = STRID_SERIAL,
+    .bNumConfigurations = 1
+};
+
+static const uint8_t desc_configuration[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0x00, 250),
+    TUD_CDC_DESCRIPTOR(ITF_NUM_CDC, STRID_CDC, EPNUM_CDC_NOTIF, 8, EPNUM_CDC_OUT, EPNUM_CDC_IN, 64),
+    TUD_MSC_DESCRIPTOR(ITF_NUM_MSC, STRID_MSC, EPNUM_MSC_OUT, EPNUM_MSC_IN, 64),
+};
+
+static const char *const string_desc[] = {
+    [STRID_MANUFACTURER] = "CEPEDI TIC37",
+    [STRID_PRODUCT] = "IMU Datalogger",
+    [STRID_SERIAL] = NULL,  // id único da flash
+    [STRID_CDC] = "IMU Datalogger Shell",
+    [STRID_MSC] = "IMU Datalogger SD",
+};
+
+const uint8_t *tud_descriptor_device_cb(void) {
+    return (const uint8_t *)&desc_device;
+}
+
+const uint8_t *tud_descriptor_configuration_cb(uint8_t index) {
+    (void)index;
+    return desc_configuration;
+}
+
+//Strings em UTF-16; só ASCII nas tabelas acima
+const uint16_t *tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
+    (void)langid;
+    static uint16_t desc_str[32];
+    char serial[2 * PICO_UNIQUE_BOARD_ID_SIZE_BYTES + 1];
+    uint8_t len;
+
+    if (index == STRID_LANGID) {
+        desc_str[1] = 0x0409;  // inglês (EUA)
+        len = 1;
+    } else {
+        if (index >= sizeof string_desc / sizeof string_desc[0]) return NULL;
+        const char *str = string_desc[index];
+        if (index == STRID_SERIAL) {
+            pico_get_unique_board_id_string(serial, sizeof serial);
+            str = serial;
+        }
+        if (!str) return NULL;
+        len = (uint8_t)strlen(str);
+        if (len > 31) len = 31;
+        for (uint8_t i = 0; i < len; i++) desc_str[1 + i] = (uint8_t)str[i];
+    }
+    desc_str[0] = (uint16_t)((TUSB_DESC_STRING << 8) | (2 * len + 2));
+    return desc_str;
+}
@@ -0,0 +1,184 @@
+#include "../inc/usb_msc.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "hardware/spi.h"
+#include "pico/stdlib.h"
+#include "tusb.h"
+#include "diskio.h"
+
+#define SECTOR_SIZE 512
+
+static sd_card_t *card = NULL;     // NULL: modo desligado, PC vê o leitor sem mídia
+static bool media_changed = false; // avisa o PC (UNIT ATTENTION) ao expor o cartão
+static bool eject_requested = false;
+
+// Estatísticas da sessão
+static uint64_t start_us;
+static uint64_t bytes_read;
+static uint64_t bytes_written;
+static uint64_t read_us;           // tempo gasto lendo o SD
+static uint32_t read_errors;
+static uint32_t write_errors;
+
+void usb_msc_init(void) {
+    tusb_init();
+}
+
+void usb_msc_task(void) {
+    tud_task();
+}
+
+bool usb_msc_host_connected(void) {
+    return tud_mounted();
+}
+
+void usb_msc_wait_ms(uint32_t ms, bool until_terminal) {
+    absolute_time_t deadline = make_timeout_time_ms(ms);
+    while (!time_reached(deadline)) {
+        tud_task();
+        if (until_terminal && tud_cdc_connected()) return;
+        sleep_us(100);
+    }
+}
+
+bool usb_msc_start(sd_card_t *pSD) {
+    if (card) return true;
+    // A desmontagem marca o cartão como não inicializado; inicia de novo
+    if (pSD->init(pSD) & (STA_NOINIT | STA_NODISK)) {
+        printf("[ERRO] SD não responde\n");
+        return false;
+    }
+    sd_read_ahead_invalidate(pSD);
+    start_us = time_us_64();
+    bytes_read = bytes_written = read_us = 0;
+    read_errors = write_errors = 0;
+    eject_requested = false;
+    media_changed = true;
+    card = pSD;
+    return true;
+}
+
+void usb_msc_stop(void) {
+    if (!card) return;
+    sd_read_ahead_invalidate(card);
+    card = NULL;
+    eject_requested = false;
+}
+
+bool usb_msc_is_active(void) {
+    return card != NULL;
+}
+
+bool usb_msc_take_eject(void) {
+    if (!eject_requested) return false;
+    eject_requested = false;
+    return true;
+}
+
+void usb_msc_print_status(void) {
+    printf("USB: %s\n", tud_mounted() ? "conectado a um PC" : "sem PC");
+    if (!card) {
+        printf("Disco USB: desligado (SD com o FatFs do datalogger)\n");
+        return;
+    }
+    uint32_t elapsed_s = (uint32_t)((time_us_64() - start_us) / 1000000u);
+    printf("Disco USB: SD %s exposto há %lu s, %lu MiB\n", card->pcName, (unsigned long)elapsed_s,
+           (unsigned long)(card->sectors / 2048));
+    printf("  lidos %lu KiB, gravados %lu KiB, SPI do SD a %lu kHz\n", (unsigned long)(bytes_read / 1024),
+           (unsigned long)(bytes_written / 1024), (unsigned long)(spi_get_baudrate(card->spi->hw_inst) / 1000));
+    if (read_us > 0) {
+        printf("  leitura do SD: %lu KiB/s (janela de %d setores)\n",
+               (unsigned long)(bytes_read * 1000000u / 1024u / read_us), SD_READ_AHEAD_BLOCKS);
+    }
+    printf("  erros: leitura %lu, gravação %lu\n", (unsigned long)read_errors, (unsigned long)write_errors);
+}
+
+// Callbacks do TinyUSB (rodam dentro de tud_task, na tarefa do USB)
+
+void tud_msc_inquiry_cb(uint8_t lun, uint8_t vendor_id[8], uint8_t product_id[16], uint8_t product_rev[4]) {
+    (void)lun;
+    memcpy(vendor_id, "CEPEDI  ", 8);
+    memcpy(product_id, "IMU Datalogger  ", 16);
+    memcpy(product_rev, "1.0 ", 4);
+}
+
+bool tud_msc_test_unit_ready_cb(uint8_t lun) {
+    if (!card) {
+        tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, 0x3A, 0x00);  // sem mídia
+        return false;
+    }
+    if (media_changed) {
+        media_changed = false;
+        tud_msc_set_sense(lun, SCSI_SENSE_UNIT_ATTENTION, 0x28, 0x00);  // mídia trocada
+        return false;
+    }
+    return true;
+}
+
+void tud_msc_capacity_cb(uint8_t lun, uint32_t *block_count, uint16_t *block_size) {
+    (void)lun;
+    *block_count = card ? (uint32_t)card->sectors : 0;
+    *block_size = SECTOR_SIZE;
+}
+
+//Ejetar no PC encerra o modo (a tarefa do USB remonta o FatFs)
+bool tud_msc_start_stop_cb(uint8_t lun, uint8_t power_condition, bool start, bool load_eject) {
+    (void)lun;
+    (void)power_condition;
+    if (load_eject && !start && card) eject_requested = true;
+    return true;
+}
+
+bool tud_msc_is_writable_cb(uint8_t lun) {
+    (void)lun;
+    return true;
+}
+
+//O TinyUSB entrega pedaços de até CFG_TUD_MSC_EP_BUFSIZE bytes, em setores inteiros
+int32_t tud_msc_read10_cb(uint8_t lun, uint32_t lba, uint32_t offset, void *buffer, uint32_t bufsize) {
+    if (!card) {
+        tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, 0x3A, 0x00);
+        return -1;
+    }
+    uint64_t t0 = time_us_64();
+    int status = sd_read_blocks_ahead(card, buffer, lba + offset / SECTOR_SIZE, bufsize / SECTOR_SIZE);
+    read_us += time_us_64() - t0;
+    if (status != SD_BLOCK_DEVICE_ERROR_NONE) {
+        read_errors++;
+        tud_msc_set_sense(lun, SCSI_SENSE_MEDIUM_ERROR, 0x11, 0x00);  // erro de leitura
+        return -1;
+    }
+    bytes_read += bufsize;
+    return (int32_t)bufsize;
+}
+
+int32_t tud_msc_write10_cb(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t *buffer, uint32_t bufsize) {
+    if (!card) {
+        tud_msc_set_sense(lun, SCSI_SENSE_NOT_READY, 0x3A, 0x00);
+        return -1;
+    }
+    int status = card->write_blocks(card, buffer, lba + offset / SECTOR_SIZE, bufsize / SECTOR_SIZE);
+    if (status != SD_BLOCK_DEVICE_ERROR_NONE) {
+        write_errors++;
+        tud_msc_set_sense(lun, SCSI_SENSE_MEDIUM_ERROR, 0x0C, 0x00);  // erro de gravação
+        return -1;
+    }
+    bytes_written += bufsize;
+    return (int32_t)bufsize;
+}
+
+//Demais comandos SCSI sem tratamento no TinyUSB
+int32_t tud_msc_scsi_cb(uint8_t lun, const uint8_t scsi_cmd[16], void *buffer, uint16_t bufsize) {
+    (void)buffer;
+    (void)bufsize;
+    switch (scsi_cmd[0]) {
+        case SCSI_CMD_PREVENT_ALLOW_MEDIUM_REMOVAL:
+            // Nada a travar: o cartão só volta ao datalogger por comando ou ejeção
+            return 0;
+        default:
+            tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x20, 0x00);  // comando inválido
+            return -1;
+    }
+}
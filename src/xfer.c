@@ -0,0 +1,440 @@
+#include "../inc/xfer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "tusb.h"
+#include "ff.h"
+#include "../lib/FatFs_SPI/sd_driver/spi.h"
+
+#include "../inc/crc32.h"
+
+#define HEADER_SIZE sizeof(xfer_header_t)
+#define WINDOW_BYTES ((uint64_t)XFER_WINDOW_FRAMES * XFER_MAX_PAYLOAD)
+#define REPLY_PAYLOAD_MAX 16    // maior resposta curta: xfer_entry_t
+
+static bool active = false;
+static bool closing = false;     // BYE recebido: termina depois de enviar a resposta
+static bool host_was_connected;
+static uint32_t last_request_ms;
+
+// Pedido em montagem
+static uint8_t rx_frame[HEADER_SIZE + XFER_MAX_REQUEST + XFER_CRC_SIZE];
+static uint32_t rx_len;
+
+// Quadro sendo copiado para a FIFO do CDC e resposta curta na fila
+static uint8_t tx_frame[HEADER_SIZE + XFER_MAX_PAYLOAD + XFER_CRC_SIZE] __attribute__((aligned(4)));
+static uint32_t tx_len, tx_pos;
+static uint8_t reply_frame[HEADER_SIZE + REPLY_PAYLOAD_MAX + XFER_CRC_SIZE];
+static uint32_t reply_len;       // 0: nenhuma resposta pendente
+
+// READ em andamento
+static FIL file;
+static bool reading = false;
+static uint16_t read_seq;
+static uint64_t read_end;
+static uint64_t next_offset;     // próximo byte a enviar
+static uint64_t acked;           // tudo antes disso chegou ao host
+static uint64_t sent_max;        // maior offset já enviado (antes de um reenvio)
+static bool eof_sent;
+static uint32_t progress_ms;     // último avanço do ACK
+
+// LIST em andamento
+static DIR dir;
+static FILINFO pending_entry;    // lida mas sem espaço no quadro anterior
+static bool have_pending;
+static bool listing = false;
+static uint16_t list_seq;
+static uint32_t list_frames;
+
+// Estatísticas da sessão
+static uint64_t bytes_sent;
+static uint32_t retransmits;
+static uint32_t crc_errors;
+
+static uint32_t now_ms(void) {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+//Completa cabeçalho e CRC de um quadro cujo payload já está no lugar;
+//retorna o tamanho total
+static uint32_t seal_frame(uint8_t *frame, uint8_t type, uint8_t status, uint16_t seq,
+                           uint16_t length, uint64_t offset) {
+    xfer_header_t h = {
+        .magic = XFER_MAGIC, .type = type, .status = status,
+        .seq = seq, .length = length, .offset = offset
+    };
+    memcpy(frame, &h, HEADER_SIZE);
+    uint32_t crc = crc32_update(0, frame, HEADER_SIZE + length);
+    memcpy(frame + HEADER_SIZE + length, &crc, XFER_CRC_SIZE);
+    return HEADER_SIZE + length + XFER_CRC_SIZE;
+}
+
+static void queue_reply(uint8_t type, uint8_t status, uint16_t seq, const void *payload, uint16_t length,
+                        uint64_t offset) {
+    if (length) memcpy(reply_frame + HEADER_SIZE, payload, length);
+    reply_len = seal_frame(reply_frame, type | XFER_REPLY, status, seq, length, offset);
+}
+
+static uint8_t status_of(FRESULT fr) {
+    switch (fr) {
+        case FR_OK:
+            return XFER_ST_OK;
+        case FR_NO_FILE:
+        case FR_NO_PATH:
+        case FR_INVALID_NAME:
+            return XFER_ST_NOT_FOUND;
+        default:
+            return XFER_ST_IO_ERROR;
+    }
+}
+
+static void stop_operations(void) {
+    if (reading) {
+        f_close(&file);
+        reading = false;
+    }
+    if (listing) {
+        f_closedir(&dir);
+        listing = false;
+    }
+}
+
+//Caminho do payload (sem terminador no fio)
+static void copy_path(char *dst, const uint8_t *src, uint32_t len) {
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+static void fill_entry(xfer_entry_t *e, const FILINFO *fno, uint8_t name_len) {
+    e->size = fno->fsize;
+    e->fdate = fno->fdate;
+    e->ftime = fno->ftime;
+    e->attrib = fno->fattrib;
+    e->name_len = name_len;
+}
+
+static void start_list(const xfer_header_t *h, const uint8_t *payload) {
+    char path[XFER_MAX_REQUEST + 1];
+    copy_path(path, payload, h->length);
+    stop_operations();
+    FRESULT fr = f_opendir(&dir, path);
+    if (fr != FR_OK) {
+        queue_reply(XFER_LIST, status_of(fr), h->seq, NULL, 0, 0);
+        return;
+    }
+    listing = true;
+    have_pending = false;
+    list_seq = h->seq;
+    list_frames = 0;
+}
+
+static void stat_file(const xfer_header_t *h, const uint8_t *payload) {
+    char path[XFER_MAX_REQUEST + 1];
+    copy_path(path, payload, h->length);
+    FILINFO fno;
+    FRESULT fr = f_stat(path, &fno);
+    if (fr != FR_OK) {
+        queue_reply(XFER_STAT, status_of(fr), h->seq, NULL, 0, 0);
+        return;
+    }
+    xfer_entry_t e;
+    fill_entry(&e, &fno, 0);
+    queue_reply(XFER_STAT, XFER_ST_OK, h->seq, &e, sizeof e, 0);
+}
+
+static void start_read(const xfer_header_t *h, const uint8_t *payload) {
+    xfer_read_t req;
+    char path[XFER_MAX_REQUEST + 1];
+    stop_operations();
+    if (h->length <= sizeof req) {
+        queue_reply(XFER_READ, XFER_ST_BAD_REQUEST, h->seq, NULL, 0, h->offset);
+        return;
+    }
+    memcpy(&req, payload, sizeof req);
+    copy_path(path, payload + sizeof req, h->length - sizeof req);
+
+    FRESULT fr = f_open(&file, path, FA_READ);
+    if (fr != FR_OK) {
+        queue_reply(XFER_READ, status_of(fr), h->seq, NULL, 0, h->offset);
+        return;
+    }
+    uint64_t size = f_size(&file);
+    if (h->offset > size) {
+        f_close(&file);
+        queue_reply(XFER_READ, XFER_ST_BAD_REQUEST, h->seq, NULL, 0, h->offset);
+        return;
+    }
+    read_end = (req.length > size - h->offset) ? size : h->offset + req.length;
+    read_seq = h->seq;
+    next_offset = acked = sent_max = h->offset;
+    eof_sent = false;
+    progress_ms = now_ms();
+    reading = true;
+}
+
+//Volta a enviar a partir de 'offset' (NAK ou confirmação atrasada)
+static void rewind_read(uint64_t offset) {
+    next_offset = offset;
+    eof_sent = false;
+    progress_ms = now_ms();
+    retransmits++;
+}
+
+static void handle_request(const xfer_header_t *h, const uint8_t *payload) {
+    last_request_ms = now_ms();
+    switch (h->type) {
+        case XFER_HELLO: {
+            // Um cliente novo (ou reconectado) descarta o que estava em andamento
+            stop_operations();
+            xfer_hello_t hello = { XFER_VERSION, XFER_MAX_PAYLOAD, XFER_WINDOW_FRAMES, 0 };
+            queue_reply(XFER_HELLO, XFER_ST_OK, h->seq, &hello, sizeof hello, 0);
+            break;
+        }
+        case XFER_LIST:
+            start_list(h, payload);
+            break;
+        case XFER_STAT:
+            stat_file(h, payload);
+            break;
+        case XFER_READ:
+            start_read(h, payload);
+            break;
+        case XFER_ACK:
+            // Depois de um reenvio, ACKs de quadros anteriores a ele ainda valem
+            if (reading && h->seq == read_seq && h->offset > acked && h->offset <= sent_max) {
+                acked = h->offset;
+                if (next_offset < acked) next_offset = acked;
+                progress_ms = now_ms();
+            }
+            if (reading && eof_sent && acked == read_end) {
+                f_close(&file);
+                reading = false;
+            }
+            break;
+        case XFER_NAK:
+            if (reading && h->seq == read_seq && h->offset >= acked && h->offset <= sent_max) {
+                acked = h->offset;
+                rewind_read(h->offset);
+            }
+            break;
+        case XFER_BYE:
+            stop_operations();
+            queue_reply(XFER_BYE, XFER_ST_OK, h->seq, NULL, 0, 0);
+            closing = true;
+            break;
+        default:
+            queue_reply(h->type, XFER_ST_BAD_REQUEST, h->seq, NULL, 0, 0);
+            break;
+    }
+}
+
+//Lê o que o CDC tiver e atende cada pedido completo. Cabeçalho inválido
+//descarta um byte por vez até achar o próximo XFER_MAGIC.
+static void receive(void) {
+    for (;;) {
+        xfer_header_t h;
+        uint32_t want = HEADER_SIZE - rx_len;
+        if (rx_len >= HEADER_SIZE) {
+            memcpy(&h, rx_frame, HEADER_SIZE);
+            want = HEADER_SIZE + h.length + XFER_CRC_SIZE - rx_len;
+        }
+        uint32_t got = tud_cdc_read(rx_frame + rx_len, want);
+        if (got == 0) return;
+        rx_len += got;
+        if (rx_len < HEADER_SIZE) continue;
+
+        memcpy(&h, rx_frame, HEADER_SIZE);
+        if (h.magic != XFER_MAGIC || h.length > XFER_MAX_REQUEST) {
+            rx_len--;
+            memmove(rx_frame, rx_frame + 1, rx_len);
+            continue;
+        }
+        uint32_t total = HEADER_SIZE + h.length + XFER_CRC_SIZE;
+        if (rx_len < total) continue;
+
+        uint32_t crc;
+        memcpy(&crc, rx_frame + HEADER_SIZE + h.length, XFER_CRC_SIZE);
+        if (crc == crc32_update(0, rx_frame, HEADER_SIZE + h.length)) {
+            handle_request(&h, rx_frame + HEADER_SIZE);
+        } else {
+            crc_errors++;
+        }
+        rx_len = 0;
+    }
+}
+
+//Monta o próximo quadro da listagem; o último leva XFER_ST_EOF
+static void next_list_frame(void) {
+    uint8_t *p = tx_frame + HEADER_SIZE;
+    uint32_t len = 0;
+    uint8_t status = XFER_ST_OK;
+    for (;;) {
+        if (!have_pending) {
+            FRESULT fr = f_readdir(&dir, &pending_entry);
+            if (fr != FR_OK) {
+                status = XFER_ST_IO_ERROR;
+                break;
+            }
+            if (pending_entry.fname[0] == '\0') {
+                status = XFER_ST_EOF;
+                break;
+            }
+            have_pending = true;
+        }
+        size_t name_len = strlen(pending_entry.fname);
+        if (name_len > UINT8_MAX) name_len = UINT8_MAX;
+        if (len + sizeof(xfer_entry_t) + name_len > XFER_MAX_PAYLOAD) break;
+        xfer_entry_t e;
+        fill_entry(&e, &pending_entry, (uint8_t)name_len);
+        memcpy(p + len, &e, sizeof e);
+        memcpy(p + len + sizeof e, pending_entry.fname, name_len);
+        len += sizeof e + name_len;
+        have_pending = false;
+    }
+    // offset = número do quadro, para o host notar um quadro perdido
+    tx_len = seal_frame(tx_frame, XFER_LIST | XFER_REPLY, status, list_seq, (uint16_t)len, list_frames++);
+    tx_pos = 0;
+    if (status != XFER_ST_OK) {
+        f_closedir(&dir);
+        listing = false;
+    }
+}
+
+//Monta o próximo quadro de dados, se a janela permitir. O primeiro vai até
+//a fronteira de 4 KiB, para os seguintes lerem setores inteiros do SD.
+static bool next_data_frame(void) {
+    if (next_offset >= read_end) {
+        if (eof_sent) return false;
+        tx_len = seal_frame(tx_frame, XFER_READ | XFER_REPLY, XFER_ST_EOF, read_seq, 0, read_end);
+        tx_pos = 0;
+        eof_sent = true;
+        return true;
+    }
+    if (next_offset - acked >= WINDOW_BYTES) return false;
+
+    uint32_t n = XFER_MAX_PAYLOAD - (uint32_t)(next_offset % XFER_MAX_PAYLOAD);
+    if (n > read_end - next_offset) n = (uint32_t)(read_end - next_offset);
+    FRESULT fr = FR_OK;
+    if (f_tell(&file) != next_offset) fr = f_lseek(&file, next_offset);
+    UINT br = 0;
+    if (fr == FR_OK) fr = f_read(&file, tx_frame + HEADER_SIZE, n, &br);
+    if (fr != FR_OK) {
+        tx_len = seal_frame(tx_frame, XFER_READ | XFER_REPLY, XFER_ST_IO_ERROR, read_seq, 0, next_offset);
+        tx_pos = 0;
+        f_close(&file);
+        reading = false;
+        return true;
+    }
+    if (br == 0) {
+        // Arquivo encolheu depois do pedido: termina onde ele acaba
+        read_end = next_offset;
+        return next_data_frame();
+    }
+    tx_len = seal_frame(tx_frame, XFER_READ | XFER_REPLY, XFER_ST_OK, read_seq, (uint16_t)br, next_offset);
+    tx_pos = 0;
+    next_offset += br;
+    if (next_offset > sent_max) sent_max = next_offset;
+    bytes_sent += br;
+    return true;
+}
+
+//Copia quadros para a FIFO do CDC até ela encher ou faltar o que enviar.
+//Respostas curtas passam na frente dos dados, entre um quadro e outro.
+static void send(void) {
+    for (;;) {
+        if (tx_pos < tx_len) {
+            tx_pos += tud_cdc_write(tx_frame + tx_pos, tx_len - tx_pos);
+            if (tx_pos < tx_len) break;
+        }
+        if (reply_len) {
+            memcpy(tx_frame, reply_frame, reply_len);
+            tx_len = reply_len;
+            tx_pos = 0;
+            reply_len = 0;
+        } else if (listing) {
+            next_list_frame();
+        } else if (!reading || !next_data_frame()) {
+            break;
+        }
+    }
+    tud_cdc_write_flush();
+}
+
+static bool has_work(void) {
+    return tx_pos < tx_len || reply_len || listing
+        || (reading && !eof_sent && next_offset - acked < WINDOW_BYTES);
+}
+
+//Mantém o USB andando enquanto o SD lê um quadro (spi_transfer espera o DMA)
+static void spi_wait_usb(void) {
+    tud_task();
+}
+
+static void finish(const char *reason) {
+    stop_operations();
+    spi_set_wait_hook(NULL);
+    active = false;
+    closing = false;
+    rx_len = tx_len = tx_pos = reply_len = 0;
+    stdio_set_driver_enabled(&stdio_usb, true);
+    printf("Transferência encerrada (%s): %lu KiB enviados, %lu reenvios, %lu pedidos com CRC inválido\n",
+           reason, (unsigned long)(bytes_sent / 1024), (unsigned long)retransmits, (unsigned long)crc_errors);
+}
+
+bool xfer_start(void) {
+    if (active) return true;
+    if (!tud_mounted()) {
+        printf("[AVISO] Nenhum PC conectado ao USB.\n");
+        return false;
+    }
+    printf("Transferência binária (protocolo v%d): use o imulog_fetch no PC.\n", XFER_VERSION);
+    stdio_flush();
+    // Daqui em diante só quadros no CDC: printf e o shell ficam sem a serial USB
+    stdio_set_driver_enabled(&stdio_usb, false);
+    spi_set_wait_hook(spi_wait_usb);
+    rx_len = tx_len = tx_pos = reply_len = 0;
+    bytes_sent = 0;
+    retransmits = crc_errors = 0;
+    host_was_connected = tud_cdc_connected();
+    last_request_ms = now_ms();
+    closing = false;
+    active = true;
+    return true;
+}
+
+bool xfer_is_active(void) {
+    return active;
+}
+
+void xfer_poll(void) {
+    if (!active) return;
+    uint64_t deadline = time_us_64() + XFER_SLICE_US;
+    for (;;) {
+        tud_task();
+        bool connected = tud_cdc_connected();
+        if (!tud_mounted() || (host_was_connected && !connected)) {
+            finish("host desconectado");
+            return;
+        }
+        host_was_connected |= connected;
+        receive();
+        send();
+        if (closing && tx_pos == tx_len && !reply_len) {
+            finish("BYE");
+            return;
+        }
+        if (!has_work() || time_us_64() >= deadline) break;
+    }
+
+    uint32_t now = now_ms();
+    // Sem ACK novo: os quadros depois do último confirmado se perderam
+    if (reading && acked < next_offset && now - progress_ms >= XFER_RETRY_MS) {
+        rewind_read(acked);
+    }
+    if (now - last_request_ms >= XFER_IDLE_TIMEOUT_MS) {
+        finish("sem pedidos do host");
+    }
+}